@@ -0,0 +1,23 @@
+; Exercises the string heap by repeatedly replacing strings and arrays of varying lengths held in global variables.
+; Run it using M98 P"heapstress.g" N<iterations>. See README.md for more information.
+
+var iterationsToRun = { exists(param.N) ? param.N : 2000 }
+var startTime = { state.upTime + state.msUpTime / 1000 }
+var text = ""
+
+if !exists(global.heapStressStrings)
+	global heapStressStrings = { vector(32, "") }
+	global heapStressArray = { vector(1, "") }
+
+while iterations < var.iterationsToRun
+	; Build a string of up to 32 characters followed by the iteration number, so the spaces needed vary between 8 and about 40 bytes
+	set var.text = "x"
+	while iterations < random(6)
+		set var.text = { var.text ^ var.text }
+	set global.heapStressStrings[random(32)] = { var.text ^ iterations }
+
+	; Every eighth iteration replace the array as well, which frees a larger space
+	if mod(iterations, 8) == 0
+		set global.heapStressArray = { vector(random(40) + 1, var.text) }
+
+echo "heap stress: " ^ var.iterationsToRun ^ " iterations in " ^ (state.upTime + state.msUpTime / 1000 - var.startTime) ^ "s"
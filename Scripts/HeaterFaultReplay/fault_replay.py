@@ -0,0 +1,231 @@
+# Replays heater traces through the model residual fault detection selected by M570 D1, either from logged CSV files or from
+# simulated heaters with and without faults. See README.md for more information.
+# Only the Python standard library is used.
+
+import argparse
+import csv
+import math
+import os
+import random
+
+SAMPLE_INTERVAL = 0.25              # HeatSampleIntervalMillis
+AMBIENT = 25.0                      # NormalAmbientTemperature
+RESIDUAL_CORRECTION_TIME = 3.0      # LocalHeater::ResidualCorrectionTime
+RESIDUAL_NOISE_TIME = 30.0          # LocalHeater::ResidualNoiseTime
+MIN_RESIDUAL_NOISE = 0.05           # LocalHeater::MinResidualNoise
+RESIDUAL_SIGNIFICANCE = 4.0         # LocalHeater::ResidualSignificance
+RESIDUAL_WARMUP_TIME = 2.0          # LocalHeater::ResidualWarmupTime
+
+FAULTS = ("none", "heater-loose", "sensor-loose", "stuck-on", "fan-failed")
+
+class Model:
+    # The FopDt parameters, as set by M307 R, K, E, D and S
+    def __init__(self, heating_rate, cooling_rate, fan_cooling_rate, exponent, dead_time, max_pwm):
+        self.heating_rate = heating_rate
+        self.cooling_rate = cooling_rate
+        self.fan_cooling_rate = fan_cooling_rate
+        self.exponent = exponent
+        self.dead_time = dead_time
+        self.max_pwm = max_pwm
+
+    def scaled(self, factor):
+        return Model(self.heating_rate * factor, self.cooling_rate / factor, self.fan_cooling_rate / factor,
+                     self.exponent, self.dead_time * factor, self.max_pwm)
+
+    def cooling(self, rise, fan_pwm):
+        rise *= 0.01
+        adjusted = -((-rise) ** self.exponent) if rise < 0 else rise ** self.exponent
+        return self.cooling_rate * adjusted + rise * self.fan_cooling_rate * fan_pwm
+
+    def net_heating_rate(self, rise, fan_pwm, pwm):
+        return self.heating_rate * pwm - self.cooling(rise, fan_pwm)
+
+    def required_pwm(self, rise, fan_pwm):
+        return self.cooling(rise, fan_pwm) / self.heating_rate
+
+class ResidualDetector:
+    # LocalHeater::DoResidualStep and the fault check that Spin does with its result
+    def __init__(self, model, max_excursion, max_fault_time):
+        self.model = model
+        self.max_excursion = max_excursion
+        self.max_fault_time = max_fault_time
+        self.valid = False
+        self.fault_count = 0
+        self.worst = 0.0
+
+    def invalidate(self):
+        # A bad reading or a gap in the trace, or the heater was switched off
+        self.valid = False
+        self.fault_count = 0
+
+    def step(self, temperature, pwm, fan_pwm, extrusion_pwm):
+        # Return the significant residual and whether the firmware would raise a fault.
+        # pwm, fan_pwm and extrusion_pwm are the values that applied during the sample interval that ended with this reading.
+        m = self.model
+        dead_time = max(m.dead_time, SAMPLE_INTERVAL)
+        residual = 0.0
+        if not self.valid:
+            self.temperature = self.reading = temperature
+            self.last_residual = 0.0
+            self.noise_variance = MIN_RESIDUAL_NOISE ** 2
+            self.warmup = int(RESIDUAL_WARMUP_TIME * dead_time / SAMPLE_INTERVAL + 1.0)
+            self.valid = True
+        else:
+            rate = m.net_heating_rate(self.temperature - AMBIENT, fan_pwm, max(pwm - extrusion_pwm, 0.0))
+            self.temperature += rate * SAMPLE_INTERVAL
+            self.reading += (self.temperature - self.reading) * min(SAMPLE_INTERVAL / dead_time, 1.0)
+            residual = temperature - self.reading
+            correction = residual * SAMPLE_INTERVAL / (RESIDUAL_CORRECTION_TIME * dead_time)
+            self.temperature += correction
+            self.reading += correction
+
+            noise_limit = RESIDUAL_SIGNIFICANCE * max(math.sqrt(self.noise_variance), MIN_RESIDUAL_NOISE)
+            change = residual - self.last_residual
+            self.last_residual = residual
+            if abs(change) < noise_limit:
+                self.noise_variance += (0.5 * change ** 2 - self.noise_variance) * (SAMPLE_INTERVAL / RESIDUAL_NOISE_TIME)
+            if self.warmup != 0:
+                self.warmup -= 1
+                residual = 0.0
+            elif abs(residual) < noise_limit:
+                residual = 0.0
+
+        self.worst = max(self.worst, abs(residual))
+        if abs(residual) > self.max_excursion:
+            self.fault_count += 1
+        elif self.fault_count != 0:
+            self.fault_count -= 1
+        return residual, self.fault_count * SAMPLE_INTERVAL > self.max_fault_time
+
+def replay(rows, detector):
+    # rows are (time, temperature or None, pwm, fan_pwm, extrusion_pwm), where the PWM values are those set after the reading was taken.
+    # Return the time at which the firmware would raise a fault, or None, and the residual at that time.
+    last_time = None
+    last = None
+    for row in rows:
+        t, temperature = row[0], row[1]
+        if temperature is None or (last_time is not None and t - last_time > 1.5 * SAMPLE_INTERVAL):
+            detector.invalidate()
+        if temperature is not None:
+            pwm, fan_pwm, extrusion_pwm = last[2:] if last is not None else row[2:]
+            residual, fault = detector.step(temperature, pwm, fan_pwm, extrusion_pwm)
+            if fault:
+                return t, residual
+        last_time = t
+        last = row
+    return None, None
+
+def read_trace(filename):
+    # Read a CSV file with columns time, temperature, pwm and optionally fan and extrusion. An empty temperature is a bad reading.
+    rows = []
+    with open(filename, newline="") as f:
+        for record in csv.DictReader(f):
+            temperature = record.get("temperature", "").strip()
+            rows.append((float(record["time"]),
+                         float(temperature) if temperature else None,
+                         float(record["pwm"]),
+                         float(record.get("fan") or 0.0),
+                         float(record.get("extrusion") or 0.0)))
+    return rows
+
+def write_trace(filename, rows):
+    with open(filename, "w", newline="") as f:
+        writer = csv.writer(f)
+        writer.writerow(("time", "temperature", "pwm", "fan", "extrusion"))
+        for t, temperature, pwm, fan_pwm, extrusion_pwm in rows:
+            writer.writerow((f"{t:.2f}", f"{temperature:.2f}", f"{pwm:.4f}", f"{fan_pwm:.3f}", f"{extrusion_pwm:.3f}"))
+
+def simulate(model, plant_model, fault, args, rng):
+    # Heat to the target, turn the fan on, start extruding and then apply the fault. The sensor reads the block temperature one dead time late.
+    # The controller holds the temperature using the model plus proportional and integral terms; it doesn't need to be good, only to be what was logged.
+    block = AMBIENT
+    sensor_body = AMBIENT
+    delay_line = [AMBIENT] * max(1, round(plant_model.dead_time / SAMPLE_INTERVAL))
+    temperature = AMBIENT
+    integral = 0.0
+    kp = 0.7 / (model.heating_rate * model.dead_time)
+    rows = []
+    for i in range(round(args.duration / SAMPLE_INTERVAL)):
+        t = i * SAMPLE_INTERVAL
+        fan_pwm = args.fan_pwm if t >= args.fan_time else 0.0
+        extrusion_pwm = args.extrusion_pwm if t >= args.extrusion_time else 0.0
+        faulty = fault != "none" and t >= args.fault_start
+
+        error = args.target - temperature
+        integral = min(max(integral + error * kp * SAMPLE_INTERVAL / (2.0 * model.dead_time), -0.2), 0.2)
+        pwm = model.required_pwm(args.target - AMBIENT, fan_pwm) + kp * error + integral + extrusion_pwm
+        pwm = min(max(pwm, 0.0), model.max_pwm)
+        rows.append((t, temperature, pwm, fan_pwm, extrusion_pwm))
+
+        # The plant: what really happens during the next sample interval
+        plant_pwm = plant_model.max_pwm if faulty and fault == "stuck-on" else pwm
+        plant_fan_pwm = 0.0 if faulty and fault == "fan-failed" else fan_pwm
+        heating_factor = 0.3 if faulty and fault == "heater-loose" else 1.0
+        rate = (plant_model.heating_rate * heating_factor * plant_pwm - plant_model.cooling(block - AMBIENT, plant_fan_pwm)
+                - extrusion_pwm * plant_model.heating_rate)
+        block += rate * SAMPLE_INTERVAL
+        delay_line.append(block)
+        reading = delay_line.pop(0)
+        if faulty and fault == "sensor-loose":
+            # The sensor has slipped out of the block and cools towards ambient
+            sensor_body += (AMBIENT - sensor_body) * SAMPLE_INTERVAL / 20.0
+        else:
+            sensor_body = reading
+        temperature = sensor_body + rng.gauss(0.0, args.noise)
+    return rows
+
+def main():
+    parser = argparse.ArgumentParser(description="Replay heater traces through model residual fault detection")
+    parser.add_argument("traces", nargs="*", help="CSV files to replay; if none are given, simulated traces are used")
+    parser.add_argument("-R", "--heating-rate", type=float, default=2.43, help="M307 R parameter (C/sec)")
+    parser.add_argument("-K", "--cooling-rate", type=float, nargs=2, default=[0.56, 0.24], help="M307 K parameters: basic and fan cooling rates (C/sec)")
+    parser.add_argument("-E", "--exponent", type=float, default=1.35, help="M307 E parameter")
+    parser.add_argument("-D", "--dead-time", type=float, default=5.5, help="M307 D parameter (seconds)")
+    parser.add_argument("-S", "--max-pwm", type=float, default=1.0, help="M307 S parameter")
+    parser.add_argument("-T", "--max-excursion", type=float, default=15.0, help="M570 T parameter (C)")
+    parser.add_argument("-P", "--fault-time", type=float, default=5.0, help="M570 P parameter (seconds)")
+    parser.add_argument("-t", "--target", type=float, default=210.0, help="simulation: target temperature")
+    parser.add_argument("-d", "--duration", type=float, default=480.0, help="simulation: simulated time (seconds)")
+    parser.add_argument("-m", "--mismatch", type=float, default=1.0, help="simulation: the real heater is this factor faster (and its dead time this factor longer) than the model says")
+    parser.add_argument("-n", "--noise", type=float, default=0.05, help="simulation: standard deviation of the sensor noise (C)")
+    parser.add_argument("-f", "--fault", choices=FAULTS, nargs="+", default=list(FAULTS), help="simulation: faults to simulate")
+    parser.add_argument("--fault-start", dest="fault_start", type=float, default=300.0, help="simulation: when the fault happens (seconds)")
+    parser.add_argument("--fan-time", type=float, default=120.0, help="simulation: turn on the fan at this time (seconds)")
+    parser.add_argument("--fan-pwm", type=float, default=1.0, help="simulation: fan PWM to use after --fan-time")
+    parser.add_argument("--extrusion-time", type=float, default=200.0, help="simulation: start extruding at this time (seconds)")
+    parser.add_argument("--extrusion-pwm", type=float, default=0.1, help="simulation: extrusion feedforward PWM (M309) after --extrusion-time")
+    parser.add_argument("--seed", type=int, default=1, help="simulation: random number seed")
+    parser.add_argument("--save", metavar="DIR", help="simulation: also write each simulated trace to a CSV file in this directory")
+    args = parser.parse_args()
+
+    model = Model(args.heating_rate, args.cooling_rate[0], args.cooling_rate[1], args.exponent, args.dead_time, args.max_pwm)
+    print(f"heater model R{args.heating_rate} K{args.cooling_rate[0]}:{args.cooling_rate[1]} E{args.exponent} D{args.dead_time} S{args.max_pwm}, "
+          f"allowed excursion {args.max_excursion}C, fault trigger time {args.fault_time}s")
+
+    if args.traces:
+        for filename in args.traces:
+            detector = ResidualDetector(model, args.max_excursion, args.fault_time)
+            fault_at, residual = replay(read_trace(filename), detector)
+            if fault_at is None:
+                print(f"{filename}: no fault, largest significant residual {detector.worst:.1f}C")
+            else:
+                print(f"{filename}: fault at {fault_at:.1f}s, residual {residual:.1f}C")
+        return
+
+    plant_model = model.scaled(args.mismatch)
+    print(f"simulated target {args.target}C, mismatch {args.mismatch}, noise {args.noise}C, fault at {args.fault_start}s")
+    for fault in args.fault:
+        rows = simulate(model, plant_model, fault, args, random.Random(args.seed))
+        if args.save is not None:
+            write_trace(os.path.join(args.save, f"{fault}.csv"), rows)
+        detector = ResidualDetector(model, args.max_excursion, args.fault_time)
+        fault_at, residual = replay(rows, detector)
+        if fault_at is None:
+            print(f"{fault:>12}: no fault, largest significant residual {detector.worst:.1f}C")
+        elif fault == "none" or fault_at < args.fault_start:
+            print(f"{fault:>12}: false fault at {fault_at:.1f}s, residual {residual:.1f}C")
+        else:
+            print(f"{fault:>12}: fault {fault_at - args.fault_start:.1f}s after it happened, residual {residual:.1f}C")
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,181 @@
+# Simulates a heater that follows the first-order-plus-dead-time model used by RRF and compares the PID
+# controller with the model-predictive controller selected by M307 B2. See README.md for more information.
+# Only the Python standard library is used.
+
+import argparse
+
+SAMPLE_INTERVAL = 0.25              # HeatSampleIntervalMillis
+AMBIENT = 25.0                      # NormalAmbientTemperature
+CLOSE_ENOUGH = 1.0                  # TemperatureCloseEnough
+PREDICTIVE_RESPONSE_TIME = 1.0      # LocalHeater::PredictiveResponseTime
+PREDICTIVE_DISTURBANCE_TIME = 4.0   # LocalHeater::PredictiveDisturbanceTime
+
+class Model:
+    # The FopDt parameters, as set by M307 R, K, E, D and S
+    def __init__(self, heating_rate, cooling_rate, fan_cooling_rate, exponent, dead_time, max_pwm):
+        self.heating_rate = heating_rate
+        self.cooling_rate = cooling_rate
+        self.fan_cooling_rate = fan_cooling_rate
+        self.exponent = exponent
+        self.dead_time = dead_time
+        self.max_pwm = max_pwm
+
+    def scaled(self, factor):
+        return Model(self.heating_rate * factor, self.cooling_rate / factor, self.fan_cooling_rate / factor,
+                     self.exponent, self.dead_time * factor, self.max_pwm)
+
+    def cooling(self, rise, fan_pwm):
+        rise *= 0.01
+        adjusted = -((-rise) ** self.exponent) if rise < 0 else rise ** self.exponent
+        return self.cooling_rate * adjusted + rise * self.fan_cooling_rate * fan_pwm
+
+    def net_heating_rate(self, rise, fan_pwm, pwm):
+        return self.heating_rate * pwm - self.cooling(rise, fan_pwm)
+
+    def required_pwm(self, rise, fan_pwm):
+        return self.cooling(rise, fan_pwm) / self.heating_rate
+
+    def pid_parameters(self, target, load_mode):
+        # FopDt::CalcPidConstants
+        rise = max(target - AMBIENT, 1.0)
+        per_degree = self.cooling(rise, 0.2) / rise
+        kp = 0.7 / (self.heating_rate * self.dead_time)
+        if load_mode:
+            recip_ti = per_degree ** 0.25 / (1.14 * self.dead_time ** 0.75)
+        else:
+            recip_ti = per_degree ** 0.5 / self.dead_time ** 0.5
+        return kp, recip_ti, self.dead_time * 0.7
+
+class Plant:
+    # The real heater: the block heats and cools as the model says, and the sensor reads the block temperature one dead time late
+    def __init__(self, model):
+        self.model = model
+        self.block = AMBIENT
+        self.delay_line = [AMBIENT] * max(1, round(model.dead_time / SAMPLE_INTERVAL))
+
+    def step(self, pwm, fan_pwm, extrusion_loss):
+        rate = self.model.net_heating_rate(self.block - AMBIENT, fan_pwm, pwm) - extrusion_loss
+        self.block += rate * SAMPLE_INTERVAL
+        self.delay_line.append(self.block)
+        return self.delay_line.pop(0)
+
+class PidController:
+    # The PID branch of LocalHeater::Spin, including the fan feedforward applied by LocalHeater::FeedForwardAdjustment
+    def __init__(self, model):
+        self.model = model
+        self.history = []
+        self.i_accumulator = 0.0
+        self.stable = False
+
+    def fan_changed(self, target, change):
+        if self.stable:
+            self.i_accumulator += (target - AMBIENT) * 0.01 * self.model.fan_cooling_rate * change / self.model.heating_rate
+
+    def step(self, temperature, target, extrusion_pwm, fan_pwm):
+        error = target - temperature
+        if error <= CLOSE_ENOUGH:
+            self.stable = True
+        derivative = 0.0
+        if len(self.history) == 4:
+            derivative = (temperature - self.history.pop(0)) / (4 * SAMPLE_INTERVAL)
+        self.history.append(temperature)
+        kp, recip_ti, td = self.model.pid_parameters(target, self.stable or abs(error) < 3.0)
+        p_plus_d = kp * (error - td * derivative)
+        expected = self.model.required_pwm(temperature - AMBIENT, 0.0)
+        if p_plus_d + expected > self.model.max_pwm:
+            if not self.stable and error > 0 and derivative > 0:
+                self.i_accumulator = expected
+            return self.model.max_pwm
+        if p_plus_d + expected < 0.0:
+            return 0.0
+        self.i_accumulator = min(max(self.i_accumulator + error * kp * recip_ti * SAMPLE_INTERVAL, 0.0), self.model.max_pwm)
+        return min(max(p_plus_d + self.i_accumulator + extrusion_pwm, 0.0), self.model.max_pwm)
+
+class PredictiveController:
+    # LocalHeater::DoPredictiveStep
+    def __init__(self, model):
+        self.model = model
+        self.valid = False
+
+    def fan_changed(self, target, change):
+        pass
+
+    def step(self, temperature, target, extrusion_pwm, fan_pwm):
+        m = self.model
+        dead_time = max(m.dead_time, SAMPLE_INTERVAL)
+        if not self.valid:
+            self.predicted = self.reading = temperature
+            self.disturbance = 0.0
+            self.valid = True
+        else:
+            error = temperature - self.reading
+            self.predicted += error
+            self.reading = temperature
+            self.disturbance = min(max(self.disturbance - error / (PREDICTIVE_DISTURBANCE_TIME * dead_time),
+                                       -0.5 * m.heating_rate), 0.5 * m.heating_rate)
+        rise = self.predicted - AMBIENT
+        holding = m.required_pwm(rise, fan_pwm) + self.disturbance / m.heating_rate
+        pwm = holding + (target - self.predicted) / (PREDICTIVE_RESPONSE_TIME * dead_time * m.heating_rate) + extrusion_pwm
+        pwm = min(max(pwm, 0.0), m.max_pwm)
+        self.predicted += (m.net_heating_rate(rise, fan_pwm, max(pwm - extrusion_pwm, 0.0)) - self.disturbance) * SAMPLE_INTERVAL
+        self.reading += (self.predicted - self.reading) * min(SAMPLE_INTERVAL / dead_time, 1.0)
+        return pwm
+
+def run(controller, plant_model, args):
+    plant = Plant(plant_model)
+    fan_pwm = 0.0
+    temperature = AMBIENT
+    peak = AMBIENT
+    settled_at = None
+    worst_disturbance_error = 0.0
+    steps = round(args.duration / SAMPLE_INTERVAL)
+    for i in range(steps):
+        t = i * SAMPLE_INTERVAL
+        if args.fan_time is not None and t >= args.fan_time and fan_pwm != args.fan_pwm:
+            controller.fan_changed(args.target, args.fan_pwm - fan_pwm)
+            fan_pwm = args.fan_pwm
+        extruding = args.extrusion_time is not None and t >= args.extrusion_time
+        extrusion_pwm = args.extrusion_pwm if extruding else 0.0
+        pwm = controller.step(temperature, args.target, extrusion_pwm, fan_pwm)
+        temperature = plant.step(pwm, fan_pwm, args.extrusion_pwm * plant_model.heating_rate if extruding else 0.0)
+
+        disturbed = (args.fan_time is not None and t >= args.fan_time) or extruding
+        if disturbed:
+            worst_disturbance_error = max(worst_disturbance_error, abs(temperature - args.target))
+        else:
+            peak = max(peak, temperature)
+            if abs(temperature - args.target) > args.band:
+                settled_at = None
+            elif settled_at is None:
+                settled_at = t
+    return settled_at, peak - args.target, worst_disturbance_error, temperature - args.target
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare PID and model-predictive heater control on a simulated heater")
+    parser.add_argument("-R", "--heating-rate", type=float, default=2.43, help="M307 R parameter (C/sec)")
+    parser.add_argument("-K", "--cooling-rate", type=float, nargs=2, default=[0.56, 0.24], help="M307 K parameters: basic and fan cooling rates (C/sec)")
+    parser.add_argument("-E", "--exponent", type=float, default=1.35, help="M307 E parameter")
+    parser.add_argument("-D", "--dead-time", type=float, default=5.5, help="M307 D parameter (seconds)")
+    parser.add_argument("-S", "--max-pwm", type=float, default=1.0, help="M307 S parameter")
+    parser.add_argument("-t", "--target", type=float, default=210.0, help="target temperature")
+    parser.add_argument("-d", "--duration", type=float, default=600.0, help="simulated time (seconds)")
+    parser.add_argument("-b", "--band", type=float, default=1.0, help="the heater counts as settled when it stays within this many degrees of the target")
+    parser.add_argument("-m", "--mismatch", type=float, default=1.0, help="the real heater is this factor faster (and its dead time this factor longer) than the model says")
+    parser.add_argument("--fan-time", type=float, help="turn on the fan at this time (seconds)")
+    parser.add_argument("--fan-pwm", type=float, default=1.0, help="fan PWM to use after --fan-time")
+    parser.add_argument("--extrusion-time", type=float, help="start extruding at this time (seconds)")
+    parser.add_argument("--extrusion-pwm", type=float, default=0.1, help="extrusion feedforward PWM (M309) after --extrusion-time")
+    args = parser.parse_args()
+
+    model = Model(args.heating_rate, args.cooling_rate[0], args.cooling_rate[1], args.exponent, args.dead_time, args.max_pwm)
+    plant_model = model.scaled(args.mismatch)
+    print(f"heater model R{args.heating_rate} K{args.cooling_rate[0]}:{args.cooling_rate[1]} E{args.exponent} D{args.dead_time} S{args.max_pwm}, "
+          f"target {args.target}C, mismatch {args.mismatch}")
+    for name, controller in (("PID", PidController(model)), ("predictive", PredictiveController(model))):
+        settled_at, overshoot, disturbance_error, final_error = run(controller, plant_model, args)
+        settled = f"{settled_at:.1f}s" if settled_at is not None else "never"
+        print(f"{name:>10}: settled within {args.band}C after {settled}, overshoot {max(overshoot, 0.0):.1f}C, "
+              f"worst error after disturbance {disturbance_error:.1f}C, final error {final_error:.2f}C")
+
+if __name__ == "__main__":
+    main()
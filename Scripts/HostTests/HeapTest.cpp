@@ -0,0 +1,205 @@
+// Tests the string heap in src/Platform/Heap.cpp: reuse of freed spaces from the free lists, and incremental garbage collection.
+// A pseudo-random mix of allocations and releases is run with a garbage collection step after each one, as RepRap::Spin does. After every step the heap
+// must pass its own integrity check and every live object must still hold the data written to it, which shows that the handles were adjusted correctly.
+// Pointers are 8 bytes long on the host, so spaces shorter than 16 bytes aren't put on the free lists as they are on the firmware's 32-bit targets.
+
+#include <Platform/Heap.h>
+#include <Platform/Platform.h>
+#include <cstdio>
+#include <vector>
+
+static unsigned int failures = 0;
+
+static void Check(bool ok, const char *what)
+{
+	if (!ok)
+	{
+		printf("FAILED: %s\n", what);
+		++failures;
+	}
+}
+
+struct HeapStats
+{
+	unsigned int heapAllocated, heapUsed, gcCycles, gcSteps, freeListHits;
+};
+
+// Get the statistics from the M122 report, which also resets the per-report counts
+static HeapStats GetStats()
+{
+	Platform p;
+	Heap::Diagnostics(0, p);
+	HeapStats stats;
+	unsigned int handlesAllocated, handlesUsed, recyclable, misses;
+	const bool ok = sscanf(p.messages.c_str(), "Heap OK, handles allocated/used %u/%u, heap memory allocated/used/recyclable %u/%u/%u, gc cycles %u\nGC steps %u",
+							&handlesAllocated, &handlesUsed, &stats.heapAllocated, &stats.heapUsed, &recyclable, &stats.gcCycles, &stats.gcSteps) == 7
+					&& sscanf(strstr(p.messages.c_str(), "hits/misses"), "hits/misses %u/%u", &stats.freeListHits, &misses) == 2;
+	Check(ok, "diagnostics report");
+	return stats;
+}
+
+// An object that the test has allocated on the heap, in the same way as StringHandle does
+struct TestObject
+{
+	Heap::IndexSlot *slot;
+	size_t length;
+	uint8_t seed;
+};
+
+static std::vector<TestObject> objects;
+
+static TestObject Allocate(size_t length, uint8_t seed)
+{
+	WriteLocker locker(Heap::heapLock);
+	Heap::IndexSlot * const slot = Heap::AllocateHandle();
+	Heap::StorageSpace * const space = Heap::AllocateSpace(sizeof(Heap::StorageSpace) + length);
+	for (size_t i = 0; i < length; ++i)
+	{
+		space->data[i] = (char)(seed + i * 7);
+	}
+	slot->storage = space;
+	return TestObject { slot, length, seed };
+}
+
+static void Release(const TestObject& obj)
+{
+	ReadLocker locker(Heap::heapLock);
+	Heap::DeleteSlot(obj.slot);
+}
+
+static bool CheckObjects()
+{
+	std::string errmsg;
+	if (!Heap::CheckIntegrity(StringRef(errmsg)))
+	{
+		printf("FAILED: %s\n", errmsg.c_str());
+		return false;
+	}
+	for (const TestObject& obj : objects)
+	{
+		const char *data = obj.slot->storage->data;
+		for (size_t i = 0; i < obj.length; ++i)
+		{
+			if (data[i] != (char)(obj.seed + i * 7))
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static uint32_t randomState = 12345;
+
+static uint32_t Random(uint32_t range)
+{
+	randomState = randomState * 1664525u + 1013904223u;
+	return (randomState >> 8) % range;
+}
+
+int main()
+{
+	// A released space is reused for an allocation of the same length
+	{
+		const TestObject a = Allocate(38, 1), b = Allocate(38, 2);
+		const Heap::StorageSpace * const aSpace = a.slot->storage;
+		Release(a);
+		const TestObject c = Allocate(38, 3);
+		Check(c.slot->storage == aSpace, "space of the same length is reused");
+		Check(GetStats().freeListHits == 1, "free list hit is counted");
+		objects.push_back(b);
+		objects.push_back(c);
+	}
+
+	// A long released space is split to satisfy a shorter allocation, and the remainder is reused
+	{
+		const TestObject a = Allocate(398, 4), b = Allocate(10, 5);
+		const char * const aSpace = (const char *)a.slot->storage;
+		Release(a);
+		const TestObject c = Allocate(198, 6), d = Allocate(198, 7);
+		Check((const char *)c.slot->storage == aSpace, "long space is split");
+		Check((const char *)d.slot->storage == aSpace + 200, "remainder of a split space is reused");
+		objects.push_back(b);
+		objects.push_back(c);
+		objects.push_back(d);
+		Check(CheckObjects(), "objects in reused spaces");
+	}
+
+	// Fragment the heap and collect it in steps. Between steps the heap must be walkable and the objects intact.
+	{
+		for (unsigned int i = 0; i < 400; ++i)
+		{
+			objects.push_back(Allocate(1 + Random(120), (uint8_t)i));
+		}
+		for (size_t i = objects.size(); i-- != 0; )
+		{
+			if (i % 3 != 0)
+			{
+				Release(objects[i]);
+				objects.erase(objects.begin() + i);
+			}
+		}
+		const unsigned int cyclesBefore = GetStats().gcCycles;
+		unsigned int steps = 0;
+		bool ok = true;
+		do
+		{
+			Heap::Spin();
+			++steps;
+			ok = ok && CheckObjects();
+		} while (GetStats().gcCycles == cyclesBefore && steps < 10000);
+		Check(ok, "objects intact between garbage collection steps");
+		Check(steps > 10, "garbage collection of a fragmented heap is split into steps");
+		printf("Compacted %u fragmented heap blocks in %u steps\n", GetStats().heapAllocated/2048, steps);
+	}
+
+	// Random churn, with a garbage collection step after each change as in RepRap::Spin
+	{
+		size_t maxLiveBytes = 0, liveBytes = 0;
+		for (const TestObject& obj : objects)
+		{
+			liveBytes += obj.length;
+		}
+		bool ok = true;
+		for (unsigned int i = 0; i < 200000 && ok; ++i)
+		{
+			if (objects.size() < 50 || (objects.size() < 400 && Random(2) == 0))
+			{
+				// Mostly short strings, some longer ones
+				const size_t length = (Random(8) == 0) ? 64 + Random(400) : 1 + Random(40);
+				objects.push_back(Allocate(length, (uint8_t)i));
+				liveBytes += length;
+				maxLiveBytes = max(maxLiveBytes, liveBytes);
+			}
+			else
+			{
+				const size_t n = Random(objects.size());
+				Release(objects[n]);
+				liveBytes -= objects[n].length;
+				objects[n] = objects.back();
+				objects.pop_back();
+			}
+			Heap::Spin();
+			if (i % 101 == 0)
+			{
+				ok = CheckObjects();
+			}
+			if (i % 10007 == 0)
+			{
+				WriteLocker locker(Heap::heapLock);
+				Heap::GarbageCollect();
+				ok = ok && CheckObjects();
+			}
+		}
+		Check(ok, "objects intact during random churn");
+
+		const HeapStats stats = GetStats();
+		printf("Random churn: up to %u bytes of live data, %u bytes of heap blocks, %u free list hits, %u garbage collection cycles\n",
+				(unsigned int)maxLiveBytes, stats.heapAllocated, stats.freeListHits, stats.gcCycles);
+		Check(stats.freeListHits > 10000, "most allocations reuse freed spaces");
+		Check(stats.heapAllocated <= 2 * maxLiveBytes + 4 * 2048, "heap does not keep growing");
+	}
+
+	printf("%s: %u failures\n", __FILE__, failures);
+	return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,67 @@
+// Tests the conditional GET and immutable file checks in src/Networking/HttpCacheValidation.cpp
+
+#include <Networking/HttpCacheValidation.h>
+#include <cstdio>
+#include <cstdlib>
+
+static unsigned int failures = 0;
+
+static void Check(bool ok, const char *what)
+{
+	if (!ok)
+	{
+		printf("FAILED: %s\n", what);
+		++failures;
+	}
+}
+
+int main()
+{
+	// The firmware's clock has no time zone and HTTP dates are in GMT, so run the tests in UTC
+	setenv("TZ", "UTC", 1);
+	tzset();
+
+	struct tm fileTime;
+	memset(&fileTime, 0, sizeof(fileTime));
+	fileTime.tm_year = 2026 - 1900;
+	fileTime.tm_mon = 9;
+	fileTime.tm_mday = 19;
+	fileTime.tm_hour = 12;
+	const time_t lastModified = mktime(&fileTime);				// Mon, 19 Oct 2026 12:00:00 GMT
+	const char *const eTag = "\"6a9c7b33-1f40\"";
+
+	// If-None-Match
+	Check(HttpCacheValidation::IsNotModified("\"6a9c7b33-1f40\"", nullptr, eTag, lastModified), "exact ETag matches");
+	Check(HttpCacheValidation::IsNotModified("W/\"6a9c7b33-1f40\"", nullptr, eTag, lastModified), "weak ETag matches");
+	Check(HttpCacheValidation::IsNotModified("\"11111111-10\", \"6a9c7b33-1f40\"", nullptr, eTag, lastModified), "ETag in a list matches");
+	Check(HttpCacheValidation::IsNotModified("*", nullptr, eTag, lastModified), "* matches any ETag");
+	Check(!HttpCacheValidation::IsNotModified("\"6a9c7b33-1f41\"", nullptr, eTag, lastModified), "ETag of a different size does not match");
+	Check(!HttpCacheValidation::IsNotModified("\"6a9c7b33-1f40\"", nullptr, "\"6a9c7b34-1f40\"", lastModified), "ETag of a later version does not match");
+
+	// If-None-Match takes precedence over If-Modified-Since
+	Check(!HttpCacheValidation::IsNotModified("\"11111111-10\"", "Mon, 19 Oct 2026 12:00:00 GMT", eTag, lastModified), "If-Modified-Since ignored when If-None-Match does not match");
+
+	// If-Modified-Since
+	Check(HttpCacheValidation::IsNotModified(nullptr, "Mon, 19 Oct 2026 12:00:00 GMT", eTag, lastModified), "not modified since its own time");
+	Check(HttpCacheValidation::IsNotModified(nullptr, "Tue, 20 Oct 2026 08:30:00 GMT", eTag, lastModified), "not modified since a later time");
+	Check(!HttpCacheValidation::IsNotModified(nullptr, "Mon, 19 Oct 2026 11:59:59 GMT", eTag, lastModified), "modified since an earlier time");
+	Check(!HttpCacheValidation::IsNotModified(nullptr, "yesterday", eTag, lastModified), "unparsable date is ignored");
+	Check(!HttpCacheValidation::IsNotModified(nullptr, "Tue, 20 Oct 2026 08:30:00 GMT", eTag, 0), "file with no time is always sent");
+	Check(!HttpCacheValidation::IsNotModified(nullptr, nullptr, eTag, lastModified), "unconditional request is always sent");
+
+	// Immutable files
+	Check(HttpCacheValidation::IsImmutableFile("js/app.6a9c7b33.js"), "hashed script is immutable");
+	Check(HttpCacheValidation::IsImmutableFile("assets/index-1d7bcee1.css"), "hashed style sheet is immutable");
+	Check(HttpCacheValidation::IsImmutableFile("fonts/materialdesignicons-webfont.a1b2c3d4e5f6a7b8.woff2"), "font with a long hash is immutable");
+	Check(HttpCacheValidation::IsImmutableFile("js/APP.6A9C7B33.JS"), "extension and hash are case insensitive");
+	Check(!HttpCacheValidation::IsImmutableFile("js/app.6a9c7b3.js"), "7 digit hash is not enough");
+	Check(!HttpCacheValidation::IsImmutableFile("data.6a9c7b33.json"), "hashed JSON file may change");
+	Check(!HttpCacheValidation::IsImmutableFile("6a9c7b33.js"), "name that is all hash has no separator");
+	Check(!HttpCacheValidation::IsImmutableFile("js/app_6a9c7b33.js"), "hash must follow . or -");
+	Check(!HttpCacheValidation::IsImmutableFile("js/app.js"), "unhashed script may change");
+	Check(!HttpCacheValidation::IsImmutableFile("index.html"), "page may change");
+	Check(!HttpCacheValidation::IsImmutableFile("README"), "name with no extension");
+
+	printf("%s: %u failures\n", __FILE__, failures);
+	return (failures == 0) ? 0 : 1;
+}
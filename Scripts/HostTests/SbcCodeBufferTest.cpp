@@ -0,0 +1,202 @@
+// Tests the storage of codes received from the SBC in src/SBC/SbcCodeBuffer.cpp.
+// Codes of random lengths are stored for random channels, processed, and discarded as when a channel is invalidated, in a random order.
+// Each code must come back intact and in order for its channel, the space reported to the SBC must be honoured, and no segments may be lost.
+
+#include <SBC/SbcCodeBuffer.h>
+#include <cstdio>
+#include <deque>
+#include <vector>
+
+static unsigned int failures = 0;
+
+static void Check(bool ok, const char *what)
+{
+	if (!ok)
+	{
+		printf("FAILED: %s\n", what);
+		++failures;
+	}
+}
+
+struct TestCode
+{
+	uint32_t id;
+	uint16_t length;
+	bool isBlock;
+};
+
+static std::vector<uint32_t> MakeCode(const TestCode& code)
+{
+	std::vector<uint32_t> data(code.length/sizeof(uint32_t));
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		data[i] = code.id * 1000 + i;
+	}
+	return data;
+}
+
+static bool CodeMatches(const BufferedCodeHeader *header, const TestCode& code)
+{
+	if (header->length != code.length || !header->isPending || header->blockIndex != ((code.isBlock) ? 0 : NotACodeBlock))
+	{
+		return false;
+	}
+	const char * const data = reinterpret_cast<const char *>(header) + sizeof(BufferedCodeHeader);
+	if (((uintptr_t)data & 3) != 0)
+	{
+		return false;
+	}
+	const std::vector<uint32_t> expected = MakeCode(code);
+	return memcmp(data, expected.data(), code.length) == 0;
+}
+
+static uint32_t randomState = 54321;
+
+static uint32_t Random(uint32_t range)
+{
+	randomState = randomState * 1664525u + 1013904223u;
+	return (randomState >> 8) % range;
+}
+
+int main()
+{
+	static SbcCodeBuffer buffer;
+	buffer.Init();
+	Check(buffer.GetNumFreeSegments() == SbcCodeBuffer::NumSegments && buffer.GetSpace() == SpiCodeBufferSize, "all free after Init");
+
+	// Codes of one channel fill a segment before the next one is used
+	{
+		const TestCode small { 1, 60, false };
+		const std::vector<uint32_t> data = MakeCode(small);
+		const size_t perSegment = SpiCodeSegmentSize/(sizeof(BufferedCodeHeader) + small.length);
+		for (size_t i = 0; i < perSegment; ++i)
+		{
+			buffer.Store(2, reinterpret_cast<const char *>(data.data()), small.length, false);
+		}
+		Check(buffer.GetNumFreeSegments() == SbcCodeBuffer::NumSegments - 1, "codes share a segment");
+		buffer.Store(2, reinterpret_cast<const char *>(data.data()), small.length, false);
+		Check(buffer.GetNumFreeSegments() == SbcCodeBuffer::NumSegments - 2, "next segment used when the last one is full");
+		Check(buffer.GetFirst(3) == nullptr, "other channels are empty");
+		Check(buffer.Discard(2) && !buffer.Discard(2), "discard reports whether there were codes");
+		Check(buffer.GetNumFreeSegments() == SbcCodeBuffer::NumSegments && buffer.GetFirst(2) == nullptr, "discard frees the segments");
+	}
+
+	// The longest code block fits in a segment, and a longer one is refused
+	{
+		const TestCode longest { 2, (uint16_t)MaxCodeBlockLength, true }, tooLong { 3, (uint16_t)(MaxCodeBlockLength + 4), true };
+		const std::vector<uint32_t> longestData = MakeCode(longest), tooLongData = MakeCode(tooLong);
+		Check(buffer.Store(0, reinterpret_cast<const char *>(longestData.data()), longest.length, true), "longest code block is stored");
+		Check(!buffer.Store(0, reinterpret_cast<const char *>(tooLongData.data()), tooLong.length, true), "code block longer than a segment is refused");
+		Check(buffer.GetFirst(0) != nullptr && CodeMatches(buffer.GetFirst(0), longest), "longest code block is intact");
+		Check(buffer.RemoveFirst(0), "removing the only code in a segment frees it");
+		Check(buffer.GetNumFreeSegments() == SbcCodeBuffer::NumSegments, "all free after removing the only code");
+	}
+
+	// Random stores, removals and discards on several channels
+	std::deque<TestCode> expected[NumGCodeChannels];
+	uint32_t nextId = 10;
+	unsigned int numStored = 0, numRefused = 0, numDiscarded = 0;
+	bool codesOk = true, spaceOk = true, segmentsOk = true;
+	for (unsigned int i = 0; i < 500000; ++i)
+	{
+		const size_t chan = Random(4) * 3;								// use a few channels spread over the range
+		const uint32_t action = Random(100);
+		if (action < 55)
+		{
+			// Store a code. Most are short but some are code blocks up to the maximum length.
+			const bool isBlock = Random(10) == 0;
+			const uint16_t length = (isBlock) ? 4 * (1 + Random(MaxCodeBlockLength/4)) : 4 * (2 + Random(20));
+			const TestCode code { nextId++, length, isBlock };
+			const std::vector<uint32_t> data = MakeCode(code);
+			const uint16_t reportedSpace = buffer.GetSpace();
+			const unsigned int freeBefore = buffer.GetNumFreeSegments();
+			if (buffer.Store(chan, reinterpret_cast<const char *>(data.data()), length, isBlock))
+			{
+				expected[chan].push_back(code);
+				++numStored;
+			}
+			else
+			{
+				// A code that fits in the space we reported must be stored unless it had to go in another channel's partly full segment, which only happens when no segments are free
+				if (freeBefore != 0 && sizeof(BufferedCodeHeader) + length <= reportedSpace)
+				{
+					spaceOk = false;
+				}
+				++numRefused;
+
+				// When no segments are free, a code as long as the space we reported must fit at the end of the codes of some channel
+				if (freeBefore == 0 && reportedSpace >= sizeof(BufferedCodeHeader) + 4)
+				{
+					const TestCode probe { nextId++, (uint16_t)((reportedSpace - sizeof(BufferedCodeHeader)) & ~3u), false };
+					const std::vector<uint32_t> probeData = MakeCode(probe);
+					bool stored = false;
+					for (size_t c = 0; c < NumGCodeChannels && !stored; ++c)
+					{
+						if (!expected[c].empty() && buffer.Store(c, reinterpret_cast<const char *>(probeData.data()), probe.length, false))
+						{
+							expected[c].push_back(probe);
+							stored = true;
+						}
+					}
+					spaceOk = spaceOk && stored;
+				}
+			}
+		}
+		else if (action < 98)
+		{
+			// Process the next code of the channel
+			BufferedCodeHeader * const header = buffer.GetFirst(chan);
+			if (expected[chan].empty())
+			{
+				codesOk = codesOk && header == nullptr;
+			}
+			else
+			{
+				codesOk = codesOk && header != nullptr && CodeMatches(header, expected[chan].front());
+				expected[chan].pop_front();
+				const unsigned int freeBefore = buffer.GetNumFreeSegments();
+				const bool freed = buffer.RemoveFirst(chan);
+				segmentsOk = segmentsOk && buffer.GetNumFreeSegments() == freeBefore + ((freed) ? 1 : 0);
+			}
+		}
+		else
+		{
+			// Invalidate the channel
+			segmentsOk = segmentsOk && buffer.Discard(chan) == !expected[chan].empty();
+			expected[chan].clear();
+			++numDiscarded;
+		}
+
+		// Whenever every channel is empty, every segment must be free
+		bool allEmpty = true;
+		for (const std::deque<TestCode>& codes : expected)
+		{
+			allEmpty = allEmpty && codes.empty();
+		}
+		if (allEmpty)
+		{
+			segmentsOk = segmentsOk && buffer.GetNumFreeSegments() == SbcCodeBuffer::NumSegments;
+		}
+	}
+	printf("Stored %u codes, refused %u, discarded channels %u times\n", numStored, numRefused, numDiscarded);
+	Check(codesOk, "codes are returned intact and in order for each channel");
+	Check(spaceOk, "codes that fit in the reported space are stored");
+	Check(segmentsOk, "segments are freed when their codes have been processed or discarded");
+	Check(numRefused != 0, "the buffer was filled");
+
+	// Processing everything that is left frees every segment
+	for (size_t chan = 0; chan < NumGCodeChannels; ++chan)
+	{
+		while (!expected[chan].empty())
+		{
+			codesOk = buffer.GetFirst(chan) != nullptr && CodeMatches(buffer.GetFirst(chan), expected[chan].front());
+			expected[chan].pop_front();
+			buffer.RemoveFirst(chan);
+		}
+	}
+	Check(codesOk, "remaining codes are intact");
+	Check(buffer.GetNumFreeSegments() == SbcCodeBuffer::NumSegments && buffer.GetSpace() == SpiCodeBufferSize, "all free at the end");
+
+	printf("%s: %u failures\n", __FILE__, failures);
+	return (failures == 0) ? 0 : 1;
+}
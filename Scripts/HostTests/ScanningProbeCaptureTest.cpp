@@ -0,0 +1,101 @@
+// Replays simulated scanning probe rows through src/Movement/BedProbing/ScanningProbeCapture.cpp and checks that each grid point height is
+// measured at the grid point, whichever direction the probe crossed it in
+
+#include <Movement/BedProbing/ScanningProbeCapture.h>
+#include <string>
+
+uint32_t hostMillis = 0;
+
+static unsigned int failures = 0;
+
+static void Check(bool ok, const char *what, size_t point = 0)
+{
+	if (!ok)
+	{
+		printf("FAILED: %s (point %u)\n", what, (unsigned int)point);
+		++failures;
+	}
+}
+
+// The simulated bed slopes along the row, and the readings have some noise and occasional spikes
+constexpr float Slope = 0.01;
+constexpr float Noise = 0.002;
+
+static float BedHeight(float x)
+{
+	return 0.2 + Slope * x;
+}
+
+static uint32_t randomState = 1;
+
+static float Reading(float x)
+{
+	randomState = randomState * 1103515245u + 12345u;
+	const unsigned int r = (randomState >> 16) & 0x7FFF;
+	if (r % 50 == 0)
+	{
+		return BedHeight(x) + 0.5;							// a spike, which should be rejected as an outlier
+	}
+	return BedHeight(x) + Noise * ((float)r/16384.0 - 1.0);
+}
+
+// Scan a row of points at the specified spacing from x = 0, forwards or backwards, taking a reading every 2ms as the firmware does
+static void ScanRow(ScanningProbeCapture& capture, size_t numPoints, float spacing, float speed, bool reverse)
+{
+	constexpr float SampleInterval = 0.002;
+	const float length = spacing * (float)(numPoints - 1);
+	capture.StartRow(0, 0.0, spacing, (reverse) ? numPoints - 1 : 0, (reverse) ? 0 : numPoints - 1);
+	for (float travelled = 0.0; travelled <= length; travelled += speed * SampleInterval)
+	{
+		const float x = (reverse) ? length - travelled : travelled;
+		capture.AddSample(x, Reading(x));
+	}
+	hostMillis += (uint32_t)(1000.0 * length/speed);
+	capture.FinishRow();
+}
+
+static void CheckRow(ScanningProbeCapture& capture, size_t numPoints, float spacing, float tolerance, const char *what)
+{
+	// The end points are only crossed for half their width, so they are biased whatever we do. Check the others.
+	for (size_t i = 1; i + 1 < numPoints; ++i)
+	{
+		float height;
+		const bool ok = capture.GetPointHeight(i, height);
+		Check(ok, what, i);
+		if (ok)
+		{
+			Check(fabsf(height - BedHeight(spacing * (float)i)) <= tolerance, what, i);
+		}
+	}
+}
+
+int main()
+{
+	for (ScanningProbeCapture::Mode mode : { ScanningProbeCapture::Mode::average, ScanningProbeCapture::Mode::median })
+	{
+		ScanningProbeCapture capture(mode);
+
+		// Many more readings than we can keep for each point. A capture that kept only the latest readings would be biased by up to half
+		// a point spacing times the slope, i.e. 0.05mm, in opposite directions on forward and reverse rows.
+		for (float speed : { 20.0f, 50.0f, 137.0f })
+		{
+			ScanRow(capture, 7, 10.0, speed, false);
+			CheckRow(capture, 7, 10.0, 0.004, "forward row of many readings per point is centred");
+			ScanRow(capture, 7, 10.0, speed, true);
+			CheckRow(capture, 7, 10.0, 0.004, "reverse row of many readings per point is centred");
+		}
+
+		// Fewer readings than we can keep for each point, so we keep them all
+		ScanRow(capture, 7, 1.0, 100.0, false);
+		CheckRow(capture, 7, 1.0, 0.004, "forward row of few readings per point is centred");
+		ScanRow(capture, 7, 1.0, 100.0, true);
+		CheckRow(capture, 7, 1.0, 0.004, "reverse row of few readings per point is centred");
+
+		std::string stats;
+		capture.AppendStats(StringRef(stats));
+		printf("%s: %s", (mode == ScanningProbeCapture::Mode::average) ? "average" : "median", stats.c_str());
+	}
+
+	printf("%s: %u failures\n", __FILE__, failures);
+	return (failures == 0) ? 0 : 1;
+}
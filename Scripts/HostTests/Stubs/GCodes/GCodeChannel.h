@@ -0,0 +1,10 @@
+// Minimal replacement for src/GCodes/GCodeChannel.h, which uses NamedEnum from RRFLibraries
+
+#ifndef SCRIPTS_HOSTTESTS_STUBS_GCODES_GCODECHANNEL_H_
+#define SCRIPTS_HOSTTESTS_STUBS_GCODES_GCODECHANNEL_H_
+
+#include <RepRapFirmware.h>
+
+constexpr size_t NumGCodeChannels = 14;			// the number of values of GCodeChannel
+
+#endif /* SCRIPTS_HOSTTESTS_STUBS_GCODES_GCODECHANNEL_H_ */
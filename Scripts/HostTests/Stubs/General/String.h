@@ -0,0 +1,31 @@
+// Minimal replacement for RRFLibraries src/General/String.h
+
+#ifndef SCRIPTS_HOSTTESTS_STUBS_GENERAL_STRING_H_
+#define SCRIPTS_HOSTTESTS_STUBS_GENERAL_STRING_H_
+
+#include <RepRapFirmware.h>
+
+// Only the members that the tested code uses. The length isn't limited.
+template<size_t N> class String
+{
+public:
+	StringRef GetRef() noexcept { return StringRef(str); }
+	const char *c_str() const noexcept { return str.c_str(); }
+	void copy(const char *s) noexcept { str = s; }
+	// This has no format attribute, because the firmware passes size_t values for %u, which is only correct on its 32-bit targets
+	int catf(const char *fmt, ...) noexcept
+	{
+		char buf[256];
+		va_list vargs;
+		va_start(vargs, fmt);
+		const int ret = vsnprintf(buf, sizeof(buf), fmt, vargs);
+		va_end(vargs);
+		str += buf;
+		return ret;
+	}
+
+private:
+	std::string str;
+};
+
+#endif /* SCRIPTS_HOSTTESTS_STUBS_GENERAL_STRING_H_ */
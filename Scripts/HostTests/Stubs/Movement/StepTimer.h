@@ -0,0 +1,22 @@
+// Minimal replacement for src/Movement/StepTimer.h. The step clock counts microseconds of host time.
+
+#ifndef SCRIPTS_HOSTTESTS_STUBS_MOVEMENT_STEPTIMER_H_
+#define SCRIPTS_HOSTTESTS_STUBS_MOVEMENT_STEPTIMER_H_
+
+#include <RepRapFirmware.h>
+#include <chrono>
+
+constexpr uint32_t StepClockRate = 1000000;
+
+class StepTimer
+{
+public:
+	typedef uint32_t Ticks;
+
+	static Ticks GetTimerTicks() noexcept
+	{
+		return (Ticks)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+};
+
+#endif /* SCRIPTS_HOSTTESTS_STUBS_MOVEMENT_STEPTIMER_H_ */
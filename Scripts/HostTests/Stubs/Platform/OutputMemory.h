@@ -0,0 +1,21 @@
+// Minimal replacement for src/Platform/OutputMemory.h. The firmware's OutputBuffer is one of a chain of fixed size buffers from a pool;
+// this one just appends to a string, which the tests can inspect.
+
+#ifndef SCRIPTS_HOSTTESTS_STUBS_PLATFORM_OUTPUTMEMORY_H_
+#define SCRIPTS_HOSTTESTS_STUBS_PLATFORM_OUTPUTMEMORY_H_
+
+#include <string>
+
+// Only the members that the tested code uses
+class OutputBuffer
+{
+public:
+	size_t cat(char c) noexcept { data += c; return 1; }
+
+	const std::string& GetData() const noexcept { return data; }
+
+private:
+	std::string data;
+};
+
+#endif /* SCRIPTS_HOSTTESTS_STUBS_PLATFORM_OUTPUTMEMORY_H_ */
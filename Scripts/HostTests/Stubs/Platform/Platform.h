@@ -0,0 +1,26 @@
+// Minimal replacement for src/Platform/Platform.h. Messages are appended to a string that the tests can inspect.
+
+#ifndef SCRIPTS_HOSTTESTS_STUBS_PLATFORM_PLATFORM_H_
+#define SCRIPTS_HOSTTESTS_STUBS_PLATFORM_PLATFORM_H_
+
+#include <RepRapFirmware.h>
+
+// Only the members that the tested code uses
+class Platform
+{
+public:
+	void Message(MessageType, const char *message) noexcept { messages += message; }
+	void MessageF(MessageType, const char *fmt, ...) noexcept __attribute__ ((format (printf, 3, 4)))
+	{
+		char buf[256];
+		va_list vargs;
+		va_start(vargs, fmt);
+		vsnprintf(buf, sizeof(buf), fmt, vargs);
+		va_end(vargs);
+		messages += buf;
+	}
+
+	std::string messages;
+};
+
+#endif /* SCRIPTS_HOSTTESTS_STUBS_PLATFORM_PLATFORM_H_ */
@@ -0,0 +1 @@
+// Replacement for src/Platform/RepRap.h, which the tested code includes but doesn't use
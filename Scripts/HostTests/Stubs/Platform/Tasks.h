@@ -0,0 +1,19 @@
+// Minimal replacement for src/Platform/Tasks.h. Permanent allocations come from the host heap and are never freed.
+
+#ifndef SCRIPTS_HOSTTESTS_STUBS_PLATFORM_TASKS_H_
+#define SCRIPTS_HOSTTESTS_STUBS_PLATFORM_TASKS_H_
+
+#include <RepRapFirmware.h>
+#include <new>
+
+enum class MemoryTag : uint8_t { objectModel, heat };
+
+namespace Tasks
+{
+	inline void *AllocPermanent(size_t sz, MemoryTag, std::align_val_t align = (std::align_val_t)__STDCPP_DEFAULT_NEW_ALIGNMENT__) noexcept
+	{
+		return ::operator new(sz, align);
+	}
+}
+
+#endif /* SCRIPTS_HOSTTESTS_STUBS_PLATFORM_TASKS_H_ */
@@ -0,0 +1,40 @@
+// Minimal replacement for RRFLibraries src/RTOSIface/RTOSIface.h. The tests are single threaded, so the locks only check that the write lock is held where it must be.
+
+#ifndef SCRIPTS_HOSTTESTS_STUBS_RTOSIFACE_RTOSIFACE_H_
+#define SCRIPTS_HOSTTESTS_STUBS_RTOSIFACE_RTOSIFACE_H_
+
+#include <RepRapFirmware.h>
+#include <cstdlib>
+
+class ReadWriteLock
+{
+public:
+	void CheckHasWriteLock() noexcept
+	{
+		if (numWriteLocks == 0)
+		{
+			printf("FAILED: write lock not held\n");
+			abort();
+		}
+	}
+
+	unsigned int numWriteLocks = 0;
+};
+
+class ReadLocker
+{
+public:
+	explicit ReadLocker(ReadWriteLock&) noexcept { }
+};
+
+class WriteLocker
+{
+public:
+	explicit WriteLocker(ReadWriteLock& p_lock) noexcept : lock(p_lock) { ++lock.numWriteLocks; }
+	~WriteLocker() noexcept { --lock.numWriteLocks; }
+
+private:
+	ReadWriteLock& lock;
+};
+
+#endif /* SCRIPTS_HOSTTESTS_STUBS_RTOSIFACE_RTOSIFACE_H_ */
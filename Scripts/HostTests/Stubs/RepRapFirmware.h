@@ -0,0 +1,102 @@
+// Minimal replacement for src/RepRapFirmware.h, so that firmware code that doesn't depend on the hardware or the RTOS can be compiled on the host.
+// Add only what the tests need, copying the definitions from the firmware where possible.
+
+#ifndef SCRIPTS_HOSTTESTS_STUBS_REPRAPFIRMWARE_H_
+#define SCRIPTS_HOSTTESTS_STUBS_REPRAPFIRMWARE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdarg>
+#include <cstdlib>
+#include <cmath>
+#include <cinttypes>
+#include <cstring>
+#include <cctype>
+#include <ctime>
+#include <strings.h>
+#include <string>
+
+// eCv annotations used in firmware declarations
+#define _ecv_array
+#define _ecv_null
+#define null
+
+// Features of the firmware that the tested code is conditional on
+#define SUPPORT_HTTP			1
+#define HAS_MASS_STORAGE		1
+#define SUPPORT_OBJECT_MODEL	1
+#define HAS_SBC_INTERFACE		1
+
+typedef unsigned int MovementSystemNumber;
+typedef uint32_t FileHandle;
+
+// From src/Config/Configuration.h
+constexpr size_t StringLength256 = 256;
+constexpr size_t MaxAxis0GridPoints = 41;
+constexpr size_t MaxScanningProbeSamplesPerPoint = 12;
+
+// From CANlib src/RRF3Common.h
+constexpr float ABS_ZERO = -273.15;
+constexpr float BadErrorTemperature = 2000.0;
+
+typedef uint32_t MessageType;
+
+class Platform;
+
+#define RRF_ASSERT(_expr) do { if (!(_expr)) { printf("FAILED: assertion at %s line %d\n", __FILE__, __LINE__); abort(); } } while (false)
+
+template<class T> constexpr T min(T a, T b) noexcept { return (a < b) ? a : b; }
+template<class T> constexpr T max(T a, T b) noexcept { return (a > b) ? a : b; }
+
+// From RRFLibraries src/General/StringFunctions.h and SafeStrptime.h
+inline bool StringEqualsIgnoreCase(const char *s1, const char *s2) noexcept { return strcasecmp(s1, s2) == 0; }
+inline const char *SafeStrptime(const char *buf, const char *format, struct tm *timeptr) noexcept { return strptime(buf, format, timeptr); }
+
+// From RRFLibraries
+inline void memcpyu32(uint32_t *dst, const uint32_t *src, size_t numWords) noexcept { memcpy(dst, src, numWords * sizeof(uint32_t)); }
+
+// The tests are single threaded
+class TaskCriticalSectionLocker
+{
+public:
+	TaskCriticalSectionLocker() noexcept { }
+};
+
+// The tests set this to simulate the passage of time
+extern uint32_t hostMillis;
+inline uint32_t millis() noexcept { return hostMillis; }
+
+// Only the members that the tested code uses
+class StringRef
+{
+public:
+	explicit StringRef(std::string& s) noexcept : str(s) { }
+	void Clear() const noexcept { str.clear(); }
+	int printf(const char *fmt, ...) const noexcept __attribute__ ((format (printf, 2, 3)))
+	{
+		char buf[256];
+		va_list vargs;
+		va_start(vargs, fmt);
+		const int ret = vsnprintf(buf, sizeof(buf), fmt, vargs);
+		va_end(vargs);
+		str = buf;
+		return ret;
+	}
+	bool cat(char c) const noexcept { str += c; return false; }
+	int catf(const char *fmt, ...) const noexcept
+	{
+		char buf[256];
+		va_list vargs;
+		va_start(vargs, fmt);
+		const int ret = vsnprintf(buf, sizeof(buf), fmt, vargs);
+		va_end(vargs);
+		str += buf;
+		return ret;
+	}
+
+private:
+	std::string& str;
+};
+
+#endif /* SCRIPTS_HOSTTESTS_STUBS_REPRAPFIRMWARE_H_ */
@@ -0,0 +1,94 @@
+// Tests the assembly of MQTT telemetry batches in src/Networking/MQTT/TelemetryBatch.h
+
+#include <Networking/MQTT/TelemetryBatch.h>
+#include <cstdio>
+#include <string>
+
+static unsigned int failures = 0;
+
+static void Check(bool ok, const char *what)
+{
+	if (!ok)
+	{
+		printf("FAILED: %s\n", what);
+		++failures;
+	}
+}
+
+static bool AddValue(TelemetryBatch& batch, const char *key, const char *value, uint8_t qos, bool commit)
+{
+	const size_t keyLength = strlen(key), valueLength = strlen(value);
+	const size_t entryLength = TelemetryBatch::EntryLength(keyLength, valueLength);
+	if (!batch.Fits(entryLength))
+	{
+		return false;
+	}
+	memcpy(batch.StartEntry(key, keyLength), value, valueLength);
+	if (commit)
+	{
+		batch.CommitEntry(entryLength, qos);
+	}
+	return true;
+}
+
+static std::string Finish(TelemetryBatch& batch)
+{
+	const size_t length = batch.Finish();
+	return std::string(batch.GetData(), length);
+}
+
+int main()
+{
+	char buffer[32];
+
+	// A new batch is empty
+	{
+		TelemetryBatch batch(buffer, sizeof(buffer));
+		Check(batch.IsEmpty(), "new batch is empty");
+	}
+
+	// Values that are started but not committed because they haven't changed leave the batch empty, so nothing is published
+	{
+		TelemetryBatch batch(buffer, sizeof(buffer));
+		Check(AddValue(batch, "a", "1", 0, false), "unchanged value fits");
+		Check(AddValue(batch, "b", "22", 0, false), "second unchanged value fits");
+		Check(batch.IsEmpty(), "batch of unchanged values is empty");
+	}
+
+	// Committed values make a JSON object, and unchanged values in between are left out
+	{
+		TelemetryBatch batch(buffer, sizeof(buffer));
+		AddValue(batch, "a", "1", 0, true);
+		AddValue(batch, "b", "[2,3]", 0, false);
+		AddValue(batch, "c", "\"x\"", 1, true);
+		Check(!batch.IsEmpty(), "batch with committed values is not empty");
+		Check(Finish(batch) == "{\"a\":1,\"c\":\"x\"}", "batch is a JSON object of the committed values");
+		Check(batch.GetQos() == 1, "batch QOS is the highest of the committed values");
+	}
+
+	// An entry that exactly fills the buffer fits, one more byte does not
+	{
+		TelemetryBatch batch(buffer, sizeof(buffer));
+		const std::string value(sizeof(buffer) - 1 - TelemetryBatch::EntryLength(1, 0), '9');
+		Check(AddValue(batch, "k", value.c_str(), 0, true), "entry that fills the buffer fits");
+		Check(Finish(batch).size() == sizeof(buffer), "full batch uses the whole buffer");
+		batch.Clear();
+		const std::string longer = value + '9';
+		Check(!AddValue(batch, "k", longer.c_str(), 0, true), "entry too long for the buffer does not fit");
+		Check(batch.IsEmpty(), "batch is still empty after an entry did not fit");
+	}
+
+	// Clearing starts a new batch
+	{
+		TelemetryBatch batch(buffer, sizeof(buffer));
+		AddValue(batch, "a", "1", 2, true);
+		batch.Clear();
+		Check(batch.IsEmpty(), "cleared batch is empty");
+		Check(batch.GetQos() == 0, "cleared batch has QOS 0");
+		AddValue(batch, "b", "2", 0, true);
+		Check(Finish(batch) == "{\"b\":2}", "batch after clearing holds only the new value");
+	}
+
+	printf("%s: %u failures\n", __FILE__, failures);
+	return (failures == 0) ? 0 : 1;
+}
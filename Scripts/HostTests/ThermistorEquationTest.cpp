@@ -0,0 +1,111 @@
+// Tests the Steinhart-Hart equation and the thermistor lookup table in src/Heating/Sensors/ThermistorEquation.cpp.
+// Run with no arguments to check some common thermistors, or with the T, B, C and R values reported by M308 S<n> to check your own, e.g.
+//   ./ThermistorEquationTest 100000 4725 7.06e-8 4700
+
+#include <Heating/Sensors/ThermistorEquation.h>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static unsigned int failures = 0;
+
+static void Check(bool ok, const char *what)
+{
+	if (!ok)
+	{
+		printf("FAILED: %s\n", what);
+		++failures;
+	}
+}
+
+// From src/Heating/Sensors/Thermistor.cpp, for a 12-bit ADC
+constexpr int32_t OversampledAdcRange = 1 << (12 + 2);
+constexpr size_t MaxLookupTableSize = 256;							// Thermistor::MaxLookupTableSize
+constexpr float MaxError = 0.35;									// the largest difference we accept between the table and the direct calculation
+
+// Build the table for the specified thermistor and compare the temperature from it with the direct calculation at every ADC reading in the range of the table,
+// using the same conversion from reading to resistance as Thermistor::Poll
+static void CheckThermistor(float r25, float beta, float c, float seriesR)
+{
+	ThermistorEquation equation;
+	equation.SetParameters(r25, beta, c);
+
+	Check(fabsf(equation.CalcTemperature(r25) - 25.0) < 0.01, "temperature at R25 is 25C");
+	Check(fabsf(equation.CalcTemperature(equation.CalcResistance(200.0)) - 200.0) < 0.01, "resistance and temperature calculations are inverses");
+
+	uint32_t firstIndex;
+	const size_t size = equation.GetLookupTableSize(firstIndex);
+	Check(size > 1 && size <= MaxLookupTableSize, "table size");
+	std::vector<float> table(size);
+	equation.FillLookupTable(table.data(), firstIndex, size);
+
+	float temperature;
+	Check(!ThermistorEquation::LookupTemperature(nullptr, firstIndex, size, r25, temperature), "no table");
+	Check(!ThermistorEquation::LookupTemperature(table.data(), firstIndex, size, equation.CalcResistance(ThermistorEquation::LookupTableMaxTemperature + 100.0), temperature),
+			"resistance below the range of the table");
+	Check(!ThermistorEquation::LookupTemperature(table.data(), firstIndex, size, equation.CalcResistance(ThermistorEquation::LookupTableMinTemperature - 50.0), temperature),
+			"resistance above the range of the table");
+
+	unsigned int numReadings = 0, numBad = 0;
+	float worstError = 0.0, worstTemperature = 0.0, worstStep = 0.0;
+	for (int32_t reading = 1; reading < OversampledAdcRange - 1; ++reading)
+	{
+		const float resistance = seriesR * (float)reading/(float)(OversampledAdcRange - reading);
+		const float expected = equation.CalcTemperature(resistance);
+		if (expected < ThermistorEquation::LookupTableMinTemperature || expected > ThermistorEquation::LookupTableMaxTemperature)
+		{
+			continue;
+		}
+		++numReadings;
+		if (!ThermistorEquation::LookupTemperature(table.data(), firstIndex, size, resistance, temperature))
+		{
+			++numBad;
+			continue;
+		}
+
+		// Report the change in temperature caused by the smallest change in the reading alongside the worst error, for comparison
+		const float step = fabsf(equation.CalcTemperature(seriesR * (float)(reading + 1)/(float)(OversampledAdcRange - reading - 1)) - expected);
+		const float error = fabsf(temperature - expected);
+		if (error > MaxError)
+		{
+			++numBad;
+		}
+		if (error > worstError)
+		{
+			worstError = error;
+			worstTemperature = expected;
+			worstStep = step;
+		}
+	}
+
+	printf("T%.0f B%.0f C%.2e R%.0f: %u entries, %u ADC readings between %.0fC and %.0fC, worst error %.3fC at %.1fC where one ADC step is %.3fC\n",
+			(double)r25, (double)beta, (double)c, (double)seriesR, (unsigned int)size, numReadings,
+			(double)ThermistorEquation::LookupTableMinTemperature, (double)ThermistorEquation::LookupTableMaxTemperature,
+			(double)worstError, (double)worstTemperature, (double)worstStep);
+	Check(numReadings > 1000, "readings in the range of the table");
+	Check(numBad == 0, "every reading in the range of the table is looked up to within MaxError");
+}
+
+int main(int argc, char **argv)
+{
+	if (argc == 5)
+	{
+		CheckThermistor(atof(argv[1]), atof(argv[2]), atof(argv[3]), atof(argv[4]));
+	}
+	else
+	{
+		CheckThermistor(100000.0, 4725.0, 7.06e-8, 4700.0);			// the RRF default thermistor, E3D
+		CheckThermistor(100000.0, 4388.0, 0.0, 4700.0);				// Semitec 104GT-2
+		CheckThermistor(10000.0, 3435.0, 0.0, 2200.0);				// low resistance thermistor
+		CheckThermistor(500000.0, 4723.0, 1.196220e-7, 4700.0);		// high temperature thermistor
+
+		// A thermistor whose resistance rises with temperature can't use the table
+		ThermistorEquation equation;
+		equation.SetParameters(100000.0, -4725.0, 0.0);
+		uint32_t firstIndex;
+		Check(equation.GetLookupTableSize(firstIndex) == 0, "no table for a negative beta");
+	}
+
+	printf("%s: %u failures\n", __FILE__, failures);
+	return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,141 @@
+// Tests the WebSocket handshake and framing in src/Networking/WebSocket.cpp
+
+#include <Networking/WebSocket.h>
+#include <Platform/OutputMemory.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+static unsigned int failures = 0;
+
+static void Check(bool ok, const char *what)
+{
+	if (!ok)
+	{
+		printf("FAILED: %s\n", what);
+		++failures;
+	}
+}
+
+static std::string AcceptKey(const char *clientKey)
+{
+	std::string s;
+	WebSocket::MakeAcceptKey(clientKey, StringRef(s));
+	return s;
+}
+
+static std::string FrameHeader(WebSocket::Opcode opcode, bool isFinal, size_t payloadLength)
+{
+	OutputBuffer buf;
+	WebSocket::AppendFrameHeader(&buf, opcode, isFinal, payloadLength);
+	return buf.GetData();
+}
+
+// Feed bytes to a frame reader and return the number of bytes consumed when it reported a complete frame, or 0 if it didn't
+static size_t Feed(WebSocketFrameReader& reader, const std::string& bytes, char *buffer, size_t bufferSize)
+{
+	for (size_t i = 0; i < bytes.size(); ++i)
+	{
+		if (reader.ProcessByte((uint8_t)bytes[i], buffer, bufferSize))
+		{
+			return i + 1;
+		}
+	}
+	return 0;
+}
+
+int main()
+{
+	// Sec-WebSocket-Accept values. The first is the example in RFC 6455 section 1.3. The GUID makes the hashed data 60 bytes long for a
+	// standard 24 character key, so the SHA-1 padding needs a second block; the 19 character key fills the first block exactly.
+	Check(AcceptKey("dGhlIHNhbXBsZSBub25jZQ==") == "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=", "RFC 6455 accept key");
+	Check(AcceptKey("x3JJHMbDL1EzLkh9GBhXDw==") == "HSmrc0sMlYUkAGmm5OPpG2HaGWk=", "second accept key");
+	Check(AcceptKey("abcdefghijklmnopqrs") == "e5nfl7ayxOkM7i0NSGMv++0gU/w=", "accept key for 55 bytes of hashed data");
+	Check(AcceptKey("") == "Kfh9QIsMVZcl6xEPYxPHzW8SZ8w=", "accept key for an empty key");
+
+	// Frame headers, RFC 6455 section 5.2
+	Check(FrameHeader(WebSocket::text, true, 5) == std::string("\x81\x05", 2), "short text frame header");
+	Check(FrameHeader(WebSocket::text, true, 125) == std::string("\x81\x7D", 2), "longest single byte length");
+	Check(FrameHeader(WebSocket::binary, true, 126) == std::string("\x82\x7E\x00\x7E", 4), "shortest 16-bit length");
+	Check(FrameHeader(WebSocket::text, true, 65535) == std::string("\x81\x7E\xFF\xFF", 4), "longest 16-bit length");
+	Check(FrameHeader(WebSocket::text, true, 65536) == std::string("\x81\x7F\x00\x00\x00\x00\x00\x01\x00\x00", 10), "shortest 64-bit length");
+	Check(FrameHeader(WebSocket::text, false, 10) == std::string("\x01\x0A", 2), "first fragment is not final");
+	Check(FrameHeader(WebSocket::continuation, true, 0) == std::string("\x80\x00", 2), "final continuation frame");
+	Check(FrameHeader(WebSocket::pong, true, 0) == std::string("\x8A\x00", 2), "pong frame");
+
+	char buffer[100];
+
+	// The masked "Hello" frame in RFC 6455 section 5.7
+	{
+		WebSocketFrameReader reader;
+		const std::string frame("\x81\x85\x37\xFA\x21\x3D\x7F\x9F\x4D\x51\x58", 11);
+		Check(Feed(reader, frame, buffer, sizeof(buffer)) == frame.size(), "masked frame completes on its last byte");
+		Check(reader.GetOpcode() == WebSocket::text && reader.IsFinal(), "masked frame is a final text frame");
+		Check(std::string(buffer, reader.GetStoredLength()) == "Hello", "masked frame is unmasked");
+		Check(!reader.IsTruncated(), "masked frame is not truncated");
+	}
+
+	// Unmasked frames, fragmentation and back to back frames
+	{
+		WebSocketFrameReader reader;
+		const std::string first("\x01\x03Hel", 5), last("\x80\x02lo", 4);
+		Check(Feed(reader, first, buffer, sizeof(buffer)) == first.size(), "first fragment completes");
+		Check(reader.GetOpcode() == WebSocket::text && !reader.IsFinal(), "first fragment is a text frame that is not final");
+		Check(std::string(buffer, reader.GetStoredLength()) == "Hel", "first fragment payload");
+		Check(Feed(reader, last, buffer, sizeof(buffer)) == last.size(), "last fragment completes");
+		Check(reader.GetOpcode() == WebSocket::continuation && reader.IsFinal(), "last fragment is a final continuation frame");
+		Check(std::string(buffer, reader.GetStoredLength()) == "lo", "last fragment payload");
+	}
+
+	// A masked ping with no payload is complete when the mask has been received
+	{
+		WebSocketFrameReader reader;
+		const std::string frame("\x89\x80\x01\x02\x03\x04", 6);
+		Check(Feed(reader, frame, buffer, sizeof(buffer)) == frame.size(), "empty masked ping completes after the mask");
+		Check(reader.GetOpcode() == WebSocket::ping && reader.GetStoredLength() == 0, "empty masked ping");
+	}
+
+	// 16-bit and 64-bit lengths, and payloads too long for the buffer
+	{
+		std::string payload;
+		for (size_t i = 0; i < 300; ++i)
+		{
+			payload += (char)('a' + i % 26);
+		}
+		const uint8_t mask[4] = { 0x12, 0x34, 0x56, 0x78 };
+		std::string frame("\x82\xFE\x01\x2C", 4);
+		frame.append((const char *)mask, 4);
+		for (size_t i = 0; i < payload.size(); ++i)
+		{
+			frame += (char)(payload[i] ^ mask[i & 3]);
+		}
+		WebSocketFrameReader reader;
+		Check(Feed(reader, frame, buffer, sizeof(buffer)) == frame.size(), "masked frame with 16-bit length completes on its last byte");
+		Check(reader.IsTruncated() && reader.GetStoredLength() == sizeof(buffer), "long payload is truncated to the buffer size");
+		Check(std::string(buffer, sizeof(buffer)) == payload.substr(0, sizeof(buffer)), "start of truncated payload is unmasked");
+
+		const std::string next("\x81\x02OK", 4);
+		Check(Feed(reader, next, buffer, sizeof(buffer)) == next.size() && std::string(buffer, reader.GetStoredLength()) == "OK", "frame after a truncated frame");
+		Check(!reader.IsTruncated(), "frame after a truncated frame is not truncated");
+	}
+	{
+		const size_t length = 70000;
+		std::string frame = FrameHeader(WebSocket::binary, true, length);
+		frame.append(length, 'x');
+		WebSocketFrameReader reader;
+		Check(Feed(reader, frame, buffer, sizeof(buffer)) == frame.size(), "frame with 64-bit length completes on its last byte");
+		Check(reader.GetOpcode() == WebSocket::binary && reader.IsTruncated() && reader.GetStoredLength() == sizeof(buffer), "frame with 64-bit length is truncated");
+	}
+
+	// Reset discards a partly received frame
+	{
+		WebSocketFrameReader reader;
+		Feed(reader, std::string("\x81\x85\x37\xFA", 4), buffer, sizeof(buffer));
+		reader.Reset();
+		const std::string frame("\x81\x02hi", 4);
+		Check(Feed(reader, frame, buffer, sizeof(buffer)) == frame.size() && std::string(buffer, reader.GetStoredLength()) == "hi", "frame after reset");
+	}
+
+	printf("%s: %u failures\n", __FILE__, failures);
+	return (failures == 0) ? 0 : 1;
+}
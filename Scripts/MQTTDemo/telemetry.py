@@ -0,0 +1,60 @@
+# Subscribes to the object model telemetry published by the RRF MQTT client and checks that each
+# message is valid JSON. Run echo.py first to start the broker. See README.md for more information
+# about the demonstration this Python script is a part of.
+
+import json
+import sys
+import time
+
+import paho.mqtt.client as mqtt
+
+from colorama import Fore
+from colorama import Style
+
+HOST = "localhost"
+PORT = 1884
+USERNAME = "test-echo"
+PASSWORD = "test-echo-pswd"
+CLIENT_ID = "telemetry"
+
+# Subscribe to everything except the topics used by the echo demo
+TOPICS = sys.argv[1:] or ["#"]
+IGNORED_TOPICS = ("topic-duet", "topic-echo")
+
+counts = {}
+start_time = time.time()
+
+def on_connect(client, userdata, flags, rc):
+    if rc == 0:
+        for topic in TOPICS:
+            print(f"{Fore.CYAN}telemetry: subscribing to topic '{topic}'...{Style.RESET_ALL}")
+            client.subscribe(topic)
+    else:
+        print(f"{Fore.CYAN}telemetry: connect failed, result code: {rc}{Style.RESET_ALL}")
+
+def on_message(client, userdata, msg):
+    if msg.topic in IGNORED_TOPICS:
+        return
+    counts[msg.topic] = counts.get(msg.topic, 0) + 1
+    rate = counts[msg.topic] / max(time.time() - start_time, 1)
+    try:
+        value = json.loads(msg.payload)
+        summary = json.dumps(value)[:100]
+        colour = Fore.CYAN
+    except ValueError as e:
+        summary = f"invalid JSON ({e}): {msg.payload[:100]!r}"
+        colour = Fore.RED
+    print(f"{colour}telemetry: '{msg.topic}' QOS {msg.qos}, {len(msg.payload)} bytes, {rate:.2f}/s: {summary}{Style.RESET_ALL}")
+
+def main():
+    client = mqtt.Client(CLIENT_ID)
+    client.username_pw_set(USERNAME, PASSWORD)
+    client.on_connect = on_connect
+    client.on_message = on_message
+
+    print(f"{Fore.CYAN}telemetry: connecting to '{HOST}' on port '{PORT}' as '{CLIENT_ID}'...{Style.RESET_ALL}")
+    client.connect(HOST, PORT)
+    client.loop_forever()
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,72 @@
+# Prints how the statically allocated RAM of a RepRapFirmware build is divided between subsystems, using the
+# same subsystem names as the memory report in M122 and boards[0].memory in the object model.
+# See README.md for more information. Only the Python standard library and the GNU binutils are used.
+
+import argparse
+import collections
+import re
+import subprocess
+import sys
+
+# Source directories and the subsystems they are accounted to. Directories not listed count as "other".
+SUBSYSTEMS = (
+    ("Movement", "move"),
+    ("Networking", "network"),
+    ("Heating", "heat"),
+    ("Fans", "heat"),
+    ("Storage", "storage"),
+    ("ObjectModel", "objectModel"),
+    ("CAN", "can"),
+)
+
+# nm symbol types for initialised and uninitialised data
+DATA_TYPES = "bBdDsS"
+
+def subsystem_of(location):
+    path = location.replace("\\", "/")
+    for directory, name in SUBSYSTEMS:
+        if f"/src/{directory}/" in path:
+            return name
+    return "other"
+
+def read_symbols(nm, elf):
+    # Return a list of (size, type, name, location) tuples for the data symbols in the ELF file
+    try:
+        output = subprocess.run([nm, "--print-size", "--size-sort", "--line-numbers", "--demangle", elf],
+                                check=True, capture_output=True, text=True).stdout
+    except (OSError, subprocess.CalledProcessError) as e:
+        sys.exit(f"failed to run {nm}: {e}")
+    symbols = []
+    for line in output.splitlines():
+        match = re.match(r"^[0-9a-fA-F]+ ([0-9a-fA-F]+) (\w) ([^\t]+)\t?(.*)$", line)
+        if match and match.group(2) in DATA_TYPES:
+            symbols.append((int(match.group(1), 16), match.group(2), match.group(3), match.group(4)))
+    return symbols
+
+def main():
+    parser = argparse.ArgumentParser(description="Print the static RAM used by each subsystem of a RepRapFirmware build")
+    parser.add_argument("elf", help="firmware ELF file, e.g. Duet3Firmware_MB6HC.elf")
+    parser.add_argument("--nm", default="arm-none-eabi-nm", help="nm program to use")
+    parser.add_argument("-r", "--ram", type=int, default=0, help="RAM size of the MCU in Kbytes, to show what is left for dynamic allocation")
+    parser.add_argument("-t", "--top", type=int, default=5, help="number of largest symbols to list for each subsystem")
+    args = parser.parse_args()
+
+    totals = collections.Counter()
+    largest = collections.defaultdict(list)
+    for size, _, name, location in read_symbols(args.nm, args.elf):
+        subsystem = subsystem_of(location)
+        totals[subsystem] += size
+        largest[subsystem].append((size, name))
+
+    grand_total = sum(totals.values())
+    print(f"{'subsystem':<12} {'bytes':>8} {'%':>6}")
+    for subsystem, total in totals.most_common():
+        print(f"{subsystem:<12} {total:>8} {100 * total / max(grand_total, 1):>6.1f}")
+        for size, name in sorted(largest[subsystem], reverse=True)[:args.top]:
+            print(f"    {size:>8} {name[:100]}")
+    print(f"{'total':<12} {grand_total:>8}")
+    if args.ram:
+        print(f"{'remaining':<12} {args.ram * 1024 - grand_total:>8} of {args.ram}K, for stacks, pools and the heap")
+
+if __name__ == "__main__":
+    main()
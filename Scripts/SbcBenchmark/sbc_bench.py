@@ -0,0 +1,232 @@
+# Stands in for the Duet Software Framework (DSF) on a Raspberry Pi connected to a Duet in SBC mode, and measures how quickly
+# G-codes can be transferred to the firmware over SPI. See README.md for more information.
+# DSF must be stopped before running this script.
+
+import argparse
+import collections
+import struct
+import sys
+import time
+import zlib
+
+import spidev
+import RPi.GPIO as GPIO
+
+FORMAT_CODE = 0x5F
+FORMAT_CODE_STANDALONE = 0x60
+
+RESPONSE_SUCCESS = 1
+RESPONSE_BAD_RESPONSE = 0xFEFEFEFE
+
+DEFAULT_TRANSFER_SIZE = 8192        # maximum transfer size until the transfer parameters have been negotiated
+DEFAULT_CODE_BUFFER_SPACE = 4096    # initial size of the code buffer in the firmware
+
+# Requests sent by the firmware
+FW_RESEND_PACKET = 0
+FW_CODE_BUFFER_UPDATE = 2
+FW_MESSAGE = 3
+FW_EXECUTE_MACRO = 4
+FW_CHECK_FILE_EXISTS = 17
+FW_TRANSFER_PARAMETERS = 26
+
+# Requests sent by us
+SBC_CODE = 2
+SBC_MACRO_COMPLETED = 7
+SBC_CHECK_FILE_EXISTS_RESULT = 22
+SBC_TRANSFER_PARAMETERS = 29
+SBC_CODE_BLOCK = 30
+
+SBC_CHANNEL = 8
+MAX_CODE_BLOCK_LENGTH = 508          # a code block must fit in one 512-byte segment of the code buffer, less its 4-byte header
+CODE_FLAG_HAS_MAJOR_NUMBER = 1
+DATA_TYPE_INT = 0
+
+HEADER_FORMAT = "<BBHHHII"           # TransferHeader
+PACKET_FORMAT = "<HHHH"              # PacketHeader
+
+def pad(data):
+    return data + bytes(-len(data) % 4)
+
+def make_header(num_packets, protocol_version, sequence_number, data):
+    header = struct.pack("<BBHHHI", FORMAT_CODE, num_packets, protocol_version, sequence_number, len(data), zlib.crc32(data))
+    return header + struct.pack("<I", zlib.crc32(header))
+
+def make_dwell_code(channel):
+    # Binary encoding of G4 P0 on the given channel
+    code = struct.pack("<BBBciiIi", channel, CODE_FLAG_HAS_MAJOR_NUMBER, 1, b"G", 4, -1, 0, 0)
+    return code + struct.pack("<cBHi", b"P", DATA_TYPE_INT, 0, 0)
+
+def make_dwell_block(channel, num_codes):
+    # Code block holding num_codes copies of G4 P0. Each code after the first has a record with the file position and
+    # line number deltas followed by one int16 parameter delta, padded to 4 bytes
+    block = struct.pack("<BBBcBBHiiIi", channel, CODE_FLAG_HAS_MAJOR_NUMBER, 1, b"G", num_codes, 0, 0, 4, -1, 0, 0)
+    block += struct.pack("<cBBBi", b"P", DATA_TYPE_INT, 0, 0, 0)
+    return block + struct.pack("<HBBhH", 0, 1, 0, 0, 0) * (num_codes - 1)
+
+class Benchmark:
+    def __init__(self, args):
+        self.args = args
+        self.spi = spidev.SpiDev()
+        self.spi.open(args.bus, args.device)
+        self.spi.mode = 0
+        self.spi.max_speed_hz = args.frequency
+        GPIO.setmode(GPIO.BCM)
+        GPIO.setup(args.ready_pin, GPIO.IN)
+        self.ready_level = not GPIO.input(args.ready_pin)   # assume that the firmware is waiting for us to start the first transfer
+
+        self.sequence_number = 0
+        self.packet_id = 0
+        self.pending = []                                   # packets to send in the next transfer
+        self.history = collections.deque(maxlen=2)          # packets sent in the last two transfers, indexed by id
+        self.transfer_size = DEFAULT_TRANSFER_SIZE
+        self.pipelined = False
+        self.negotiated = None                              # transfer size and pipelining to use once our parameters have been sent
+        self.buffer_space = DEFAULT_CODE_BUFFER_SPACE
+        self.codes = [make_dwell_code(channel) for channel in args.channels]
+        self.blocks = [make_dwell_block(channel, args.block) for channel in args.channels] if args.block > 1 else None
+        self.next_channel = 0                               # index of the channel to send the next code or block on
+
+        self.codes_sent = self.packets_resent = 0
+        self.transfers = self.bytes_sent = self.bytes_received = self.errors = 0
+
+    def wait_until_ready(self):
+        # The firmware toggles the transfer ready pin when it has set up the next SPI exchange
+        deadline = time.monotonic() + 4
+        while GPIO.input(self.args.ready_pin) == self.ready_level:
+            if time.monotonic() > deadline:
+                raise TimeoutError("timeout waiting for the transfer ready pin")
+        self.ready_level = not self.ready_level
+
+    def exchange(self, data):
+        self.wait_until_ready()
+        return bytes(self.spi.xfer2(list(data)))
+
+    def add_packet(self, request, data):
+        packet = struct.pack(PACKET_FORMAT, request, self.packet_id, len(data), 0) + pad(data)
+        self.pending.append((self.packet_id, packet))
+        self.packet_id = (self.packet_id + 1) & 0xFFFF
+
+    def fill_codes(self):
+        # Send as many codes as the firmware has room for, in blocks if we may. Successive codes or blocks go to the
+        # channels given on the command line in turn
+        size = len(self.pending_data())
+        if self.blocks is not None and self.args.protocol >= 7:
+            while self.codes_sent + self.args.block <= self.args.count:
+                block = self.blocks[self.next_channel]
+                if self.buffer_space < 4 + len(block) or size + 8 + len(block) > self.transfer_size:
+                    return
+                self.add_packet(SBC_CODE_BLOCK, block)
+                self.buffer_space -= 4 + len(block)
+                size += 8 + len(block)
+                self.codes_sent += self.args.block
+                self.next_channel = (self.next_channel + 1) % len(self.blocks)
+        while self.codes_sent < self.args.count:
+            code = self.codes[self.next_channel]
+            if self.buffer_space < 4 + len(code) or size + 8 + len(code) > self.transfer_size:
+                return
+            self.add_packet(SBC_CODE, code)
+            self.buffer_space -= 4 + len(code)
+            size += 8 + len(code)
+            self.codes_sent += 1
+            self.next_channel = (self.next_channel + 1) % len(self.codes)
+
+    def pending_data(self):
+        return b"".join(packet for _, packet in self.pending)
+
+    def do_transfer(self):
+        data = self.pending_data()
+        self.sequence_number = (self.sequence_number + 1) & 0xFFFF
+        header = make_header(len(self.pending), self.args.protocol, self.sequence_number, data)
+
+        rx_header = self.exchange(header)
+        format_code, num_packets, protocol_version, _, data_length, crc_data, crc_header = struct.unpack(HEADER_FORMAT, rx_header)
+        if format_code == FORMAT_CODE_STANDALONE:
+            sys.exit("the firmware is running in standalone mode")
+        ok = format_code == FORMAT_CODE and crc_header == zlib.crc32(rx_header[:12])
+        response = struct.unpack("<I", self.exchange(struct.pack("<I", RESPONSE_SUCCESS if ok else RESPONSE_BAD_RESPONSE)))[0]
+        if not ok or response != RESPONSE_SUCCESS:
+            self.errors += 1
+            return
+
+        rx_data = b""
+        if data_length != 0 or data:
+            rx_data = self.exchange(data.ljust(max(data_length, len(data)), b"\0"))[:data_length]
+            ok = zlib.crc32(rx_data) == crc_data
+            response = struct.unpack("<I", self.exchange(struct.pack("<I", RESPONSE_SUCCESS if ok else RESPONSE_BAD_RESPONSE)))[0]
+            if not ok or response != RESPONSE_SUCCESS:
+                self.errors += 1
+                return
+
+        self.transfers += 1
+        self.bytes_sent += len(data)
+        self.bytes_received += len(rx_data)
+        self.history.append(dict(self.pending))
+        self.pending = []
+        if self.negotiated is not None:
+            # The firmware has our transfer parameters now, so both sides switch to the negotiated ones
+            self.transfer_size, self.pipelined = self.negotiated
+            self.negotiated = None
+            print(f"negotiated transfer size {self.transfer_size}, {'pipelined' if self.pipelined else 'not pipelined'}")
+        self.process_packets(rx_data, num_packets)
+
+    def process_packets(self, data, num_packets):
+        offset = 0
+        for _ in range(num_packets):
+            request, _, length, resend_id = struct.unpack_from(PACKET_FORMAT, data, offset)
+            offset += 8
+            payload = data[offset:offset + length]
+            offset += length + (-length % 4)
+
+            if request == FW_RESEND_PACKET:
+                # When transfers are pipelined the firmware asks for packets of the transfer before the last one
+                sent = self.history[0] if self.pipelined and len(self.history) > 1 else self.history[-1]
+                if resend_id in sent:
+                    self.pending.append((resend_id, sent[resend_id]))
+                    self.packets_resent += 1
+            elif request == FW_CODE_BUFFER_UPDATE:
+                self.buffer_space = struct.unpack_from("<H", payload)[0]
+            elif request == FW_EXECUTE_MACRO:
+                # We don't have any macro files, so report that each one failed
+                self.add_packet(SBC_MACRO_COMPLETED, struct.pack("<B?H", payload[0], True, 0))
+            elif request == FW_CHECK_FILE_EXISTS:
+                self.add_packet(SBC_CHECK_FILE_EXISTS_RESULT, struct.pack("<?BH", False, 0, 0))
+            elif request == FW_TRANSFER_PARAMETERS:
+                max_size, num_buffers = struct.unpack_from("<HB", payload)
+                self.negotiated = (min(max_size, self.args.transfer_size), min(num_buffers, self.args.buffers) > 1)
+                self.add_packet(SBC_TRANSFER_PARAMETERS, struct.pack("<HBB", self.args.transfer_size, self.args.buffers, 0))
+
+    def run(self):
+        start = time.monotonic()
+        try:
+            while self.codes_sent < self.args.count:
+                self.fill_codes()
+                self.do_transfer()
+                if self.args.delay:
+                    time.sleep(self.args.delay / 1000)
+        finally:
+            elapsed = time.monotonic() - start
+            GPIO.cleanup()
+            self.spi.close()
+        print(f"protocol version {self.args.protocol}: {self.codes_sent} codes in {elapsed:.2f}s ({self.codes_sent / elapsed:.0f} codes/s), {self.packets_resent} packets resent")
+        print(f"{self.transfers} transfers ({self.transfers / elapsed:.0f}/s), {self.bytes_sent} bytes sent, {self.bytes_received} bytes received, {self.errors} errors")
+
+def main():
+    parser = argparse.ArgumentParser(description="Measure the G-code throughput of the SPI link to a Duet in SBC mode")
+    parser.add_argument("-n", "--count", type=int, default=10000, help="number of codes (G4 P0) to send")
+    parser.add_argument("-p", "--protocol", type=int, choices=(6, 7), default=7, help="protocol version to announce")
+    parser.add_argument("-s", "--transfer-size", type=int, default=16384, help="maximum transfer size to announce in protocol version 7")
+    parser.add_argument("-b", "--buffers", type=int, default=2, help="number of transfer buffers to announce in protocol version 7")
+    parser.add_argument("-k", "--block", type=int, default=1, help="number of codes to send in each code block in protocol version 7, or 1 to send single codes")
+    parser.add_argument("-c", "--channels", type=int, nargs="+", default=[SBC_CHANNEL], help="G-code channels to send the codes to in turn, e.g. 8 0 1 for SBC, HTTP and Telnet")
+    parser.add_argument("-d", "--delay", type=float, default=0, help="delay between transfers in ms")
+    parser.add_argument("--bus", type=int, default=0, help="SPI bus")
+    parser.add_argument("--device", type=int, default=0, help="SPI chip select")
+    parser.add_argument("--frequency", type=int, default=8000000, help="SPI frequency in Hz")
+    parser.add_argument("--ready-pin", type=int, default=25, help="BCM number of the GPIO pin connected to the transfer ready pin")
+    args = parser.parse_args()
+    if args.block < 1 or len(make_dwell_block(SBC_CHANNEL, args.block)) > MAX_CODE_BLOCK_LENGTH:
+        parser.error("a code block must hold between 1 and 60 codes")
+    Benchmark(args).run()
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,147 @@
+# Connects to the WebSocket endpoint of a Duet running in standalone mode and prints the
+# object model updates and G-code replies that it pushes. See README.md for more information.
+# Only the Python standard library is used.
+
+import argparse
+import base64
+import hashlib
+import json
+import os
+import socket
+import struct
+import sys
+import urllib.parse
+import urllib.request
+
+WEBSOCKET_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+OP_CONTINUATION = 0x0
+OP_TEXT = 0x1
+OP_CLOSE = 0x8
+OP_PING = 0x9
+OP_PONG = 0xA
+
+def connect(host, password):
+    # Log in using rr_connect and return the session key, or 0 if the firmware didn't issue one
+    query = urllib.parse.urlencode({"password": password, "sessionKey": "yes"})
+    with urllib.request.urlopen(f"http://{host}/rr_connect?{query}", timeout=5) as response:
+        reply = json.load(response)
+    if reply.get("err", 1) != 0:
+        sys.exit(f"rr_connect failed: {reply}")
+    return reply.get("sessionKey", 0)
+
+def recv_exact(sock, length):
+    data = b""
+    while len(data) < length:
+        chunk = sock.recv(length - len(data))
+        if not chunk:
+            raise ConnectionError("connection closed by the Duet")
+        data += chunk
+    return data
+
+def upgrade(host, session_key):
+    # Perform the opening handshake and return the connected socket
+    hostname, _, port = host.partition(":")
+    sock = socket.create_connection((hostname, int(port or 80)), timeout=10)
+    key = base64.b64encode(os.urandom(16)).decode()
+    request = (f"GET /rr_ws?sessionKey={session_key} HTTP/1.1\r\n"
+               f"Host: {host}\r\n"
+               "Upgrade: websocket\r\n"
+               "Connection: Upgrade\r\n"
+               f"Sec-WebSocket-Key: {key}\r\n"
+               "Sec-WebSocket-Version: 13\r\n"
+               "\r\n")
+    sock.sendall(request.encode())
+
+    header = b""
+    while not header.endswith(b"\r\n\r\n"):
+        header += recv_exact(sock, 1)
+    lines = header.decode(errors="replace").split("\r\n")
+    if not lines[0].startswith("HTTP/1.1 101"):
+        sys.exit(f"upgrade rejected: {lines[0]}")
+    expected = base64.b64encode(hashlib.sha1((key + WEBSOCKET_GUID).encode()).digest()).decode()
+    accept = [line.split(":", 1)[1].strip() for line in lines if line.lower().startswith("sec-websocket-accept:")]
+    if accept != [expected]:
+        sys.exit(f"bad Sec-WebSocket-Accept header: {accept}")
+    return sock
+
+def send_frame(sock, opcode, payload=b""):
+    # Frames sent by a client must be masked
+    mask = os.urandom(4)
+    header = bytes([0x80 | opcode])
+    if len(payload) < 126:
+        header += bytes([0x80 | len(payload)])
+    elif len(payload) < 65536:
+        header += bytes([0x80 | 126]) + struct.pack(">H", len(payload))
+    else:
+        header += bytes([0x80 | 127]) + struct.pack(">Q", len(payload))
+    masked = bytes(b ^ mask[i % 4] for i, b in enumerate(payload))
+    sock.sendall(header + mask + masked)
+
+def recv_frame(sock):
+    first, second = recv_exact(sock, 2)
+    length = second & 0x7F
+    if length == 126:
+        length = struct.unpack(">H", recv_exact(sock, 2))[0]
+    elif length == 127:
+        length = struct.unpack(">Q", recv_exact(sock, 8))[0]
+    return first & 0x0F, (first & 0x80) != 0, recv_exact(sock, length)
+
+def describe(message):
+    # Summarise a pushed message on one line
+    try:
+        obj = json.loads(message)
+    except ValueError as e:
+        return f"invalid JSON ({e}): {message[:80]!r}"
+    if "reply" in obj:
+        return f"G-code reply: {obj['reply']!r}"
+    if "err" in obj:
+        return f"command rejected: {obj}"
+    key = obj.get("key") or "(whole model)"
+    kind = "live values" if obj.get("flags", "").find("f") >= 0 else "full"
+    return f"{key} [{kind}], {len(message)} bytes"
+
+def main():
+    parser = argparse.ArgumentParser(description="Print object model updates pushed by a Duet over a WebSocket")
+    parser.add_argument("host", help="host name or IP address of the Duet, optionally followed by :port")
+    parser.add_argument("-p", "--password", default="", help="board password, if one has been set using M551")
+    parser.add_argument("-g", "--gcode", action="append", default=[], help="G-code command to send after connecting (may be repeated)")
+    parser.add_argument("-n", "--count", type=int, default=0, help="stop after receiving this many messages")
+    parser.add_argument("-v", "--verbose", action="store_true", help="print each message in full")
+    args = parser.parse_args()
+
+    session_key = connect(args.host, args.password)
+    sock = upgrade(args.host, session_key)
+    sock.settimeout(None)
+    print(f"connected to {args.host}, session key {session_key}")
+
+    for command in args.gcode:
+        send_frame(sock, OP_TEXT, command.encode())
+
+    received = 0
+    fragments = b""
+    try:
+        while args.count == 0 or received < args.count:
+            opcode, final, payload = recv_frame(sock)
+            if opcode == OP_PING:
+                send_frame(sock, OP_PONG, payload)
+                continue
+            if opcode == OP_CLOSE:
+                print("the Duet closed the connection")
+                return
+            if opcode in (OP_TEXT, OP_CONTINUATION):
+                fragments += payload
+                if not final:
+                    continue
+                message = fragments.decode(errors="replace")
+                fragments = b""
+                received += 1
+                print(message if args.verbose else describe(message))
+        send_frame(sock, OP_CLOSE, struct.pack(">H", 1000))
+    except KeyboardInterrupt:
+        send_frame(sock, OP_CLOSE, struct.pack(">H", 1000))
+    finally:
+        sock.close()
+
+if __name__ == "__main__":
+    main()
@@ -11,6 +11,7 @@
 
 #include "CanMotion.h"
 #include "CommandProcessor.h"
+#include "ExpansionManager.h"
 #include "CanMessageGenericConstructor.h"
 #include <CanMessageBuffer.h>
 #include <CanMessageGenericTables.h>
@@ -101,6 +102,10 @@ static uint8_t currentTimeSyncMarker = 0xFF;
 static bool inExpansionMode = false;
 static bool inTestMode = false;
 static bool mainBoardAcknowledgedAnnounce = false;
+static bool mainBoardAcceptsAggregatedStatus = false;
+static CanMessageBuffer *aggregatedStatusBuf = nullptr;			// the board status message that we are appending status reports to, or nullptr
+static size_t aggregatedStatusOffset = 0;						// offset of the StatusReportsHeader in aggregatedStatusBuf
+static unsigned int statusReportsAggregated = 0, statusReportsSentSeparately = 0;
 #endif
 
 //#define CAN_DEBUG
@@ -414,11 +419,87 @@ void CanInterface::RaiseEvent(EventType type, uint16_t param, uint8_t device, co
 	CanInterface::SendMessageNoReplyNoFree(&buf);
 }
 
-void CanInterface::MainBoardAcknowledgedAnnounce() noexcept
+void CanInterface::MainBoardAcknowledgedAnnounce(bool acceptsAggregatedStatus) noexcept
 {
+	mainBoardAcceptsAggregatedStatus = acceptsAggregatedStatus;
 	mainBoardAcknowledgedAnnounce = true;
 }
 
+// Start sending the regular status reports. The buffer holds our board status message. If the main board accepts aggregated status reports then
+// the reports we send until FinishStatusReports is called are appended to it where they fit, otherwise we send it straight away.
+// These functions are only called by the Heat task.
+void CanInterface::StartStatusReports(CanMessageBuffer *boardStatusBuf) noexcept
+{
+	if (mainBoardAcceptsAggregatedStatus)
+	{
+		aggregatedStatusOffset = GetStatusReportsOffset(boardStatusBuf->msg.boardStatus);
+		if (aggregatedStatusOffset + sizeof(StatusReportsHeader) < sizeof(CanMessage))
+		{
+			StatusReportsHeader * const hdr = reinterpret_cast<StatusReportsHeader*>(reinterpret_cast<uint8_t*>(&boardStatusBuf->msg) + aggregatedStatusOffset);
+			hdr->marker = StatusReportsMarker;
+			hdr->numReports = 0;
+			boardStatusBuf->dataLength = aggregatedStatusOffset + sizeof(StatusReportsHeader);
+			aggregatedStatusBuf = boardStatusBuf;
+			return;
+		}
+	}
+	SendMessageNoReplyNoFree(boardStatusBuf);
+}
+
+// Send a regular status report, or append it to our board status message if we can. On return the buffer is available to use again.
+void CanInterface::SendStatusReportNoFree(CanMessageBuffer *buf) noexcept
+{
+	if (aggregatedStatusBuf != nullptr)
+	{
+		StatusReportKind kind;
+		switch (buf->id.MsgType())
+		{
+		case CanMessageType::driversStatusReport:		kind = StatusReportKind::driversStatus; break;
+		case CanMessageType::heatersStatusReport:		kind = StatusReportKind::heatersStatus; break;
+		case CanMessageType::fansReport:				kind = StatusReportKind::fansReport; break;
+		default:										kind = StatusReportKind::none; break;
+		}
+
+		if (kind != StatusReportKind::none && aggregatedStatusBuf->dataLength + sizeof(StatusReportSection) + buf->dataLength <= sizeof(CanMessage))
+		{
+			uint8_t * const data = reinterpret_cast<uint8_t*>(&aggregatedStatusBuf->msg);
+			StatusReportSection * const section = reinterpret_cast<StatusReportSection*>(data + aggregatedStatusBuf->dataLength);
+			section->kind = (uint8_t)kind;
+			section->length = buf->dataLength;
+			memcpy(data + aggregatedStatusBuf->dataLength + sizeof(StatusReportSection), &buf->msg, buf->dataLength);
+			aggregatedStatusBuf->dataLength += sizeof(StatusReportSection) + buf->dataLength;
+			++reinterpret_cast<StatusReportsHeader*>(data + aggregatedStatusOffset)->numReports;
+			++statusReportsAggregated;
+			return;
+		}
+	}
+
+	++statusReportsSentSeparately;
+	if (buf->id.Dst() == CanId::BroadcastAddress)
+	{
+		SendBroadcastNoFree(buf);
+	}
+	else
+	{
+		SendMessageNoReplyNoFree(buf);
+	}
+}
+
+// Send our board status message with the status reports that we appended to it
+void CanInterface::FinishStatusReports() noexcept
+{
+	if (aggregatedStatusBuf != nullptr)
+	{
+		CanMessageBuffer * const buf = aggregatedStatusBuf;
+		aggregatedStatusBuf = nullptr;
+		if (reinterpret_cast<const StatusReportsHeader*>(reinterpret_cast<const uint8_t*>(&buf->msg) + aggregatedStatusOffset)->numReports == 0)
+		{
+			buf->dataLength = aggregatedStatusOffset;
+		}
+		SendMessageNoReplyNoFree(buf);
+	}
+}
+
 #endif
 
 // Allocate a CAN request ID
@@ -1404,6 +1485,19 @@ void CanInterface::Diagnostics(MessageType mtype) noexcept
 	}
 
 	reprap.GetPlatform().MessageF(mtype, "Tx timeouts%s\n", str.c_str());
+
+#if SUPPORT_REMOTE_COMMANDS
+	if (inExpansionMode)
+	{
+		p.MessageF(mtype, "Status reports aggregated %u, sent separately %u, main board %s them\n",
+					statusReportsAggregated, statusReportsSentSeparately, (mainBoardAcceptsAggregatedStatus) ? "aggregates" : "doesn't aggregate");
+		statusReportsAggregated = statusReportsSentSeparately = 0;
+	}
+	else
+#endif
+	{
+		reprap.GetExpansion().StatusReportDiagnostics(mtype);
+	}
 	longestWaitTime = 0;
 	longestWaitMessageType = 0;
 	peakTimeSyncTxDelay = 0;
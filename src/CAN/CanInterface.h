@@ -32,6 +32,42 @@ namespace CanInterface
 	void Shutdown() noexcept;
 	inline CanAddress GetCurrentMasterAddress() noexcept { return CanId::MasterAddress; }		// currently fixed, but might change in future
 
+	// Aggregated status reports.
+	// An expansion board may append the other status reports that it sends at regular intervals to its board status message, so that the main board
+	// receives fewer CAN-FD frames from each board per interval. Sensor temperature reports are broadcast rather than sent to the main board, because
+	// other boards may use them, so they are never appended. The appended reports start at the end of the analog handle data
+	// with a StatusReportsHeader, followed by numReports StatusReportSection headers each followed by the data of the corresponding message.
+	// The main board tells expansion boards that it accepts aggregated reports by sending AnnounceAckAcceptsAggregatedStatus as the request ID of its
+	// announce acknowledgement. Older firmware sends zero, in which case we send each report in a message of its own.
+	constexpr CanRequestId AnnounceAckAcceptsAggregatedStatus = 1;
+	constexpr uint8_t StatusReportsMarker = 0xA5;
+
+	enum class StatusReportKind : uint8_t
+	{
+		none = 0,
+		driversStatus,
+		heatersStatus,
+		fansReport,
+		sensorTemperatures					// we don't send this one because sensor temperatures are broadcast, but the main board still accepts it
+	};
+
+	struct StatusReportsHeader
+	{
+		uint8_t marker;						// StatusReportsMarker
+		uint8_t numReports;					// number of appended reports
+	};
+
+	struct StatusReportSection
+	{
+		uint8_t kind;						// a StatusReportKind
+		uint8_t length;						// length of the message data that follows
+	};
+
+	inline size_t GetStatusReportsOffset(const CanMessageBoardStatus& msg) noexcept
+	{
+		return msg.GetAnalogHandlesOffset() + msg.numAnalogHandles * sizeof(AnalogHandleData);
+	}
+
 #if SUPPORT_REMOTE_COMMANDS
 	bool InExpansionMode() noexcept;
 	bool InTestMode() noexcept;
@@ -39,7 +75,10 @@ namespace CanInterface
 
 	void SendAnnounce(CanMessageBuffer *buf) noexcept;
 	void RaiseEvent(EventType type, uint16_t param, uint8_t device, const char *format, va_list vargs) noexcept;
-	void MainBoardAcknowledgedAnnounce() noexcept;
+	void MainBoardAcknowledgedAnnounce(bool acceptsAggregatedStatus) noexcept;
+	void StartStatusReports(CanMessageBuffer *boardStatusBuf) noexcept;
+	void SendStatusReportNoFree(CanMessageBuffer *buf) noexcept;
+	void FinishStatusReports() noexcept;
 #endif
 
 	CanRequestId AllocateRequestId(CanAddress destination, CanMessageBuffer *buf) noexcept;
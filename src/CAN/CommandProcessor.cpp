@@ -479,7 +479,7 @@ void CommandProcessor::ProcessReceivedMessage(CanMessageBuffer *buf) noexcept
 				return;							// no reply needed
 
 			case CanMessageType::acknowledgeAnnounce:
-				CanInterface::MainBoardAcknowledgedAnnounce();
+				CanInterface::MainBoardAcknowledgedAnnounce(buf->msg.acknowledgeAnnounce.requestId == CanInterface::AnnounceAckAcceptsAggregatedStatus);
 				return;
 
 			case CanMessageType::updateFirmware:
@@ -701,6 +701,13 @@ void CommandProcessor::ProcessReceivedMessage(CanMessageBuffer *buf) noexcept
 #endif
 		{
 			// Handle messages received in normal operation mode
+			if (   id == CanMessageType::boardStatusReport || id == CanMessageType::driversStatusReport || id == CanMessageType::heatersStatusReport
+				|| id == CanMessageType::fansReport || id == CanMessageType::sensorTemperaturesReport
+			   )
+			{
+				reprap.GetExpansion().StatusFrameReceived();
+			}
+
 			switch (id)
 			{
 			case CanMessageType::inputStateChanged:
@@ -721,7 +728,7 @@ void CommandProcessor::ProcessReceivedMessage(CanMessageBuffer *buf) noexcept
 				break;
 
 			case CanMessageType::driversStatusReport:
-				reprap.GetExpansion().ProcessDriveStatusReport(buf);
+				reprap.GetExpansion().ProcessDriveStatusReport(buf->id.Src(), buf->msg.driversStatus);
 				break;
 
 			case CanMessageType::boardStatusReport:
@@ -14,6 +14,8 @@
 #include <Platform/Platform.h>
 #include <Platform/Event.h>
 #include <GCodes/GCodeBuffer/GCodeBuffer.h>
+#include <Heating/Heat.h>
+#include <Fans/FansManager.h>
 
 ReadWriteLock ExpansionManager::boardsLock;
 
@@ -119,7 +121,8 @@ ExpansionBoardData::ExpansionBoardData() noexcept
 {
 }
 
-ExpansionManager::ExpansionManager() noexcept : numExpansionBoards(0), numBoardsFlashing(0), lastIndexSearched(0), lastAddressFound(0)
+ExpansionManager::ExpansionManager() noexcept : numExpansionBoards(0), numBoardsFlashing(0), lastIndexSearched(0), lastAddressFound(0),
+	statusFramesReceived(0), statusReportsReceived(0), whenStatusStatsReset(0)
 {
 	// The boards table array is initialised by its constructor. Note, boards[0] is not used.
 }
@@ -221,7 +224,8 @@ void ExpansionManager::ProcessAnnouncement(CanMessageBuffer *buf, bool isNewForm
 		UpdateBoardState(src, BoardState::running);
 
 		// Tell the sending board that we don't need any more announcements from it
-		buf->SetupRequestMessage<CanMessageAcknowledgeAnnounce>(0, CanInterface::GetCanAddress(), src);
+		// Use the request ID to tell it that we accept status reports appended to its board status messages
+		buf->SetupRequestMessage<CanMessageAcknowledgeAnnounce>(CanInterface::AnnounceAckAcceptsAggregatedStatus, CanInterface::GetCanAddress(), src);
 		CanInterface::SendMessageNoReplyNoFree(buf);
 	}
 }
@@ -273,16 +277,84 @@ void ExpansionManager::ProcessBoardStatusReport(const CanMessageBuffer *buf) noe
 			reprap.GetPlatform().GetEndstops().HandleRemoteAnalogZProbeValueChange(address, data.handle.u.parts.major, data.handle.u.parts.minor, data.reading);
 		}
 	}
+
+	ProcessAggregatedStatusReports(address, buf, CanInterface::GetStatusReportsOffset(msg));
+}
+
+// Process the status reports that an expansion board appended to its board status message
+void ExpansionManager::ProcessAggregatedStatusReports(CanAddress address, const CanMessageBuffer *buf, size_t offset) noexcept
+{
+	const uint8_t * const data = reinterpret_cast<const uint8_t*>(&buf->msg);
+	if (offset + sizeof(CanInterface::StatusReportsHeader) > buf->dataLength || data[offset] != CanInterface::StatusReportsMarker)
+	{
+		return;											// the board didn't append any
+	}
+
+	const unsigned int numReports = reinterpret_cast<const CanInterface::StatusReportsHeader*>(data + offset)->numReports;
+	offset += sizeof(CanInterface::StatusReportsHeader);
+	for (unsigned int i = 0; i < numReports && offset + sizeof(CanInterface::StatusReportSection) <= buf->dataLength; ++i)
+	{
+		const CanInterface::StatusReportSection section = *reinterpret_cast<const CanInterface::StatusReportSection*>(data + offset);
+		offset += sizeof(CanInterface::StatusReportSection);
+		if (offset + section.length > buf->dataLength)
+		{
+			break;
+		}
+
+		// Copy the report so that it is correctly aligned, and so that any fields the sender didn't include read as zero
+		CanMessage msg;
+		memcpy(&msg, data + offset, section.length);
+		memset(reinterpret_cast<uint8_t*>(&msg) + section.length, 0, sizeof(msg) - section.length);
+		offset += section.length;
+
+		switch ((CanInterface::StatusReportKind)section.kind)
+		{
+		case CanInterface::StatusReportKind::driversStatus:
+			ProcessDriveStatusReport(address, msg.driversStatus);
+			break;
+
+		case CanInterface::StatusReportKind::heatersStatus:
+			reprap.GetHeat().ProcessRemoteHeatersReport(address, msg.heatersStatusBroadcast);
+			break;
+
+		case CanInterface::StatusReportKind::fansReport:
+			reprap.GetFansManager().ProcessRemoteFanRpms(address, msg.fansReport);
+			break;
+
+		case CanInterface::StatusReportKind::sensorTemperatures:
+			reprap.GetHeat().ProcessRemoteSensorsReport(address, msg.sensorTemperaturesBroadcast);
+			break;
+
+		default:
+			continue;									// a kind of report that we don't know about
+		}
+		++statusReportsReceived;
+	}
+}
+
+// Report how many status messages we received and how many status reports they carried, then reset the counts
+void ExpansionManager::StatusReportDiagnostics(MessageType mtype) noexcept
+{
+	const uint32_t now = millis();
+	const float seconds = (float)(now - whenStatusStatsReset) * 0.001;
+	const unsigned int framesReceived = statusFramesReceived, reportsReceived = statusReportsReceived;
+	statusFramesReceived = statusReportsReceived = 0;
+	whenStatusStatsReset = now;
+
+	if (seconds > 0.0 && reportsReceived != 0)
+	{
+		reprap.GetPlatform().MessageF(mtype, "Status messages received %u (%.1f/s) carrying %u reports (%.1f/s), reduction %.0f%%\n",
+										framesReceived, (double)(framesReceived/seconds), reportsReceived, (double)(reportsReceived/seconds),
+										(double)(100.0 * (float)(reportsReceived - framesReceived)/(float)reportsReceived));
+	}
 }
 
 // Process a drive status report
-void ExpansionManager::ProcessDriveStatusReport(const CanMessageBuffer *buf) noexcept
+void ExpansionManager::ProcessDriveStatusReport(CanAddress address, const CanMessageDriversStatus& msg) noexcept
 {
-	const CanAddress address = buf->id.Src();
 	ExpansionBoardData& board = boards[address];
 	if (board.HasDrivers())
 	{
-		const CanMessageDriversStatus& msg = buf->msg.driversStatus;
 		for (size_t driver = 0; driver < min<size_t>(board.numDrivers, msg.numDriversReported); ++driver)
 		{
 			DriverData& dd = board.driverData[driver];
@@ -58,7 +58,9 @@ public:
 
 	void ProcessAnnouncement(CanMessageBuffer *buf, bool isNewFormat) noexcept;
 	void ProcessBoardStatusReport(const CanMessageBuffer *buf) noexcept;
-	void ProcessDriveStatusReport(const CanMessageBuffer *buf) noexcept;
+	void ProcessDriveStatusReport(CanAddress address, const CanMessageDriversStatus& msg) noexcept;
+	void StatusFrameReceived() noexcept { ++statusFramesReceived; ++statusReportsReceived; }
+	void StatusReportDiagnostics(MessageType mtype) noexcept;
 
 	// Firmware update and related functions
 	GCodeResult ResetRemote(uint32_t boardAddress, GCodeBuffer& gb, const StringRef& reply) THROWS(GCodeException);
@@ -82,6 +84,7 @@ private:
 
 	const ExpansionBoardData& FindIndexedBoard(unsigned int index) const noexcept;
 	void UpdateBoardState(CanAddress address, BoardState newState) noexcept;
+	void ProcessAggregatedStatusReports(CanAddress address, const CanMessageBuffer *buf, size_t offset) noexcept;
 
 	static ReadWriteLock boardsLock;
 
@@ -89,6 +92,9 @@ private:
 	unsigned int numBoardsFlashing;
 	mutable volatile unsigned int lastIndexSearched;		// the last board index we searched for, or 0 if invalid
 	mutable volatile unsigned int lastAddressFound;			// if lastIndexSearched is nonzero, this is the corresponding board address we found
+	unsigned int statusFramesReceived;						// number of status messages received since the last diagnostics report
+	unsigned int statusReportsReceived;						// number of status reports received since then, including those appended to board status messages
+	uint32_t whenStatusStatsReset;
 	ExpansionBoardData boards[CanId::MaxCanAddress + 1];	// the first entry is a dummy one
 };
 
@@ -105,11 +105,33 @@ constexpr float DefaultGridSpacing = 20.0;				// Default bed probing grid spacin
 static_assert(MaxCalibrationPoints <= MaxProbePoints, "MaxCalibrationPoints must be <= MaxProbePoints");
 
 constexpr size_t MaxScanningProbeCalibrationPoints = 33;	// The maximum number of heights we measure when calibrating a scanning probe. Use an odd number.
+constexpr size_t MaxScanningProbeSamplesPerPoint = 12;		// The maximum number of readings we keep for each grid point when capturing a stream of scanning probe readings
+constexpr uint32_t ScanningProbeSampleInterval = 2;		// The interval in milliseconds between readings when capturing a stream of scanning probe readings
 
 // SD card
 constexpr uint32_t SdCardDetectDebounceMillis = 200;	// How long we give the SD card to settle in the socket
 constexpr unsigned int MaxSdCardTries = 5;				// Number of read or write attempts before giving up
 constexpr uint32_t SdCardRetryDelay = 20;				// Number of milliseconds delay between SD transfer retries. We now double for each retry.
+constexpr size_t DefaultMacroCacheFileSize = 2048;		// Default maximum size of a macro file that M473 allows to be held in the macro file cache
+constexpr size_t MaxMacroCacheSize = 65536;				// Maximum amount of RAM that M473 may allocate to the macro file cache
+constexpr size_t DefaultWebCacheFileSize = 16384;		// Default maximum size of a web file that is held in the web file cache
+constexpr size_t MaxWebCacheSize = 131072;				// Maximum amount of RAM that may be allocated to the web file cache
+constexpr size_t MinSpareRamForWebCache = 32768;		// When sizing the web file cache automatically, leave at least this much never-used RAM
+#if SAME70
+constexpr size_t DefaultNumUploadBuffers = 4;			// Default number of buffers used to pipeline writing uploaded files to the SD card, which M590 can change
+constexpr size_t DefaultUploadBufferSize = 32768;		// Default size of each upload buffer, which must be a power of 2 so that writes are aligned to clusters
+constexpr size_t MaxUploadBufferSize = 65536;			// Maximum upload buffer size that M590 allows
+#elif SAME5x
+constexpr size_t DefaultNumUploadBuffers = 3;
+constexpr size_t DefaultUploadBufferSize = 16384;
+constexpr size_t MaxUploadBufferSize = 32768;
+#else
+constexpr size_t DefaultNumUploadBuffers = 2;
+constexpr size_t DefaultUploadBufferSize = 8192;
+constexpr size_t MaxUploadBufferSize = 16384;
+#endif
+constexpr size_t MaxUploadBuffers = 8;					// Maximum number of upload buffers that M590 allows
+constexpr size_t MinSpareRamForUploadBuffers = 32768;	// Only allocate the upload buffers if at least this much never-used RAM would remain
 
 // Z probing
 constexpr float DefaultZProbeTriggerHeight = 0.7;		// Millimetres
@@ -177,6 +199,8 @@ constexpr size_t RESERVED_OUTPUT_BUFFERS = 4;			// Number of reserved output buf
 # error Unsupported processor
 #endif
 
+constexpr size_t MAX_OUTPUT_BUFFER_COUNT = 160;			// The most OutputBuffer instances that M590 may ask for
+
 constexpr size_t maxQueuedCodes = 16;					// How many codes can be queued?
 
 #if SAME70 || SAME5x
@@ -194,6 +218,53 @@ constexpr unsigned int MaxFilaments = 20;
 constexpr unsigned int MaxFilaments = 8;
 #endif
 
+// Compiled object model paths. Each one uses about 110 bytes of statically-allocated RAM.
+#if SAME70
+constexpr size_t NumCompiledObjectModelPaths = 16;		// How many object model paths we keep the compiled form of
+#elif SAME5x
+constexpr size_t NumCompiledObjectModelPaths = 12;
+#else
+constexpr size_t NumCompiledObjectModelPaths = 6;
+#endif
+constexpr size_t MaxCompiledPathLength = 47;			// Longer paths are looked up without compiling them
+constexpr size_t MaxCompiledPathSteps = 6;				// How many levels of a path we record
+
+// Object model change tracking for delta reports. Each slot uses 12 bytes of statically-allocated RAM. Must be a power of 2.
+#if SAME70
+constexpr size_t NumObjectModelChangeSlots = 512;
+#elif SAME5x
+constexpr size_t NumObjectModelChangeSlots = 256;
+#else
+constexpr size_t NumObjectModelChangeSlots = 64;
+#endif
+
+constexpr size_t ObjectModelChunkSize = 3 * OUTPUT_BUFFER_SIZE;	// Approximate size of each chunk of a large object model response sent over HTTP
+
+// Cache of recent object model responses. The storage is allocated from the heap when the first response is stored.
+#if SAME70
+constexpr size_t NumCachedModelResponses = 6;
+constexpr size_t ModelResponseCacheSlotSize = 2048;		// Longer responses are not cached
+#elif SAME5x
+constexpr size_t NumCachedModelResponses = 4;
+constexpr size_t ModelResponseCacheSlotSize = 1536;
+#else
+constexpr size_t NumCachedModelResponses = 2;
+constexpr size_t ModelResponseCacheSlotSize = 1024;
+#endif
+constexpr uint32_t ModelResponseCacheTime = 200;		// How long in milliseconds we may return a cached response for, because live values are not covered by the sequence numbers
+
+// Sensor histories reported in the object model. Each temperature sensor and each fan with a tacho gets a history until the memory is used up.
+// A history of 10 minutes uses about 3.7K of RAM, allocated from the heap when the first reading is recorded.
+constexpr uint32_t SensorHistorySeconds = 600;			// How long a history we keep
+constexpr size_t MaxUnchunkedHistorySamples = 40;		// The most samples of each history we return in a report that is not generated in chunks, e.g. by M409
+#if SAME70
+constexpr size_t SensorHistoryMemory = 32 * 1024;		// How much RAM all the histories together may use
+#elif SAME5x
+constexpr size_t SensorHistoryMemory = 12 * 1024;
+#else
+constexpr size_t SensorHistoryMemory = 0;				// Not enough RAM for sensor histories
+#endif
+
 constexpr size_t MaxLaserPixelsPerMove = 8;				// How many S parameters you can use on a single G1 command when laser engraving
 
 // Move system
@@ -285,6 +356,10 @@ constexpr size_t MaxThumbnails = 4;						// Maximum number of thumbnail images r
 constexpr size_t MaxExpectedWebDirFilenameLength = MaxFilenameLength - 20;
 static_assert(MaxExpectedWebDirFilenameLength + strlen(WEB_DIR) + strlen(".gz") <= MaxFilenameLength);
 
+// Web files whose names include a content hash (e.g. "js/app.6a9c7b33.js") never change, so we allow browsers to cache them for this many seconds without revalidating them.
+// Set this to zero to make browsers revalidate them like other web files.
+constexpr uint32_t ImmutableWebFileMaxAge = 365 * 24 * 60 * 60;
+
 #define UPLOAD_EXTENSION ".part"					// Extension to a filename for a file being uploaded
 
 #define DEFAULT_LOG_FILE "eventlog.txt"
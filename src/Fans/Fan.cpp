@@ -26,6 +26,7 @@ constexpr ObjectModelTableEntry Fan::objectModelTable[] =
 	{ "actualValue",		OBJECT_MODEL_FUNC(self->GetPwm(), 2), 															ObjectModelEntryFlags::live },
 	{ "blip",				OBJECT_MODEL_FUNC(0.001f * (float)self->blipTime, 2), 											ObjectModelEntryFlags::none },
 	{ "frequency",			OBJECT_MODEL_FUNC((int32_t)self->GetPwmFrequency()), 											ObjectModelEntryFlags::none },
+	{ "history",			OBJECT_MODEL_FUNC_IF(context.WantHistory(), self->rpmHistory), 									ObjectModelEntryFlags::live },
 	{ "max",				OBJECT_MODEL_FUNC(self->maxVal, 2), 															ObjectModelEntryFlags::none },
 	{ "min",				OBJECT_MODEL_FUNC(self->minVal, 2), 															ObjectModelEntryFlags::none },
 	{ "name",				OBJECT_MODEL_FUNC(self->name.c_str()), 															ObjectModelEntryFlags::none },
@@ -40,7 +41,7 @@ constexpr ObjectModelTableEntry Fan::objectModelTable[] =
 	{ "sensors",			OBJECT_MODEL_FUNC(self->sensorsMonitored),														ObjectModelEntryFlags::none },	// empty if not thermostatic
 };
 
-constexpr uint8_t Fan::objectModelTableDescriptor[] = { 2, 9, 4 };
+constexpr uint8_t Fan::objectModelTableDescriptor[] = { 2, 10, 4 };
 
 DEFINE_GET_OBJECT_MODEL_TABLE(Fan)
 
@@ -51,11 +52,19 @@ Fan::Fan(unsigned int fanNum) noexcept
 	  val(0.0),
 	  minVal(DefaultMinFanPwm),
 	  maxVal(1.0),										// 100% maximum fan speed
-	  blipTime(DefaultFanBlipTime)
+	  blipTime(DefaultFanBlipTime),
+	  rpmHistory(nullptr)
 {
 	triggerTemperatures[0] = triggerTemperatures[1] = DefaultHotEndFanTemperature;
 }
 
+// Record the RPM in the history, to the nearest 10. A fan that has no tacho never gets a history. Called only by the Heat task, once per heater sample.
+void Fan::RecordHistory() noexcept
+{
+	const int32_t rpm = GetRPM();
+	SensorHistory::Record(rpmHistory, (float)rpm, rpm >= 0, 10.0, 0);
+}
+
 // Set or report the parameters for this fan
 // If 'mcode' is an M-code used to set parameters for the f (which should only ever be 106)
 // then search for parameters used to configure the fan. If any are found, perform appropriate actions and return true.
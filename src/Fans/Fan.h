@@ -11,6 +11,7 @@
 #include <RepRapFirmware.h>
 #include <ObjectModel/ObjectModel.h>
 #include <Hardware/IoPorts.h>
+#include <Platform/SensorHistory.h>
 
 #if SUPPORT_CAN_EXPANSION
 # include <CanMessageFormats.h>
@@ -24,7 +25,7 @@ public:
 	explicit Fan(unsigned int fanNum) noexcept;
 	Fan(const Fan& _ecv_from) = delete;
 
-	virtual ~Fan() noexcept override { }
+	virtual ~Fan() noexcept override { delete rpmHistory; }
 	virtual bool Check(bool checkSensors) noexcept = 0;						// update the fan PWM returning true if it is a thermostatic fan that is on
 	virtual GCodeResult SetPwmFrequency(PwmFrequency freq, const StringRef& reply) noexcept = 0;
 	virtual bool IsEnabled() const noexcept = 0;
@@ -54,6 +55,7 @@ public:
 	float GetConfiguredPwm() const noexcept { return val; }			// returns the configured PWM. Actual PWM may be different, e.g. due to blipping or for thermostatic fans.
 
 	GCodeResult SetPwm(float speed, const StringRef& reply) noexcept;
+	void RecordHistory() noexcept;											// record the RPM in the history, called only by the Heat task
 	bool HasMonitoredSensors() const noexcept { return sensorsMonitored.IsNonEmpty(); }
 	unsigned int GetNumber() const { return fanNumber; }
 	const char *_ecv_array GetName() const noexcept { return name.c_str(); }
@@ -79,6 +81,7 @@ protected:
 	float triggerTemperatures[2];
 	uint32_t blipTime;										// how long we blip the fan for, in milliseconds
 	SensorsBitmap sensorsMonitored;
+	SensorHistory *_ecv_null rpmHistory;					// recent RPM readings, or nullptr if we have none
 
 	String<MaxFanNameLength> name;
 };
@@ -216,6 +216,26 @@ float FansManager::SetFansValue(FansBitmap whichFans, float speed) noexcept
 	return pwmChange;
 }
 
+// Return the average of the PWMs that the specified fans are actually running at, counting missing fans as off
+float FansManager::GetAveragePwm(FansBitmap whichFans) const noexcept
+{
+	float totalPwm = 0.0;
+	if (!whichFans.IsEmpty())
+	{
+		whichFans.Iterate([this, &totalPwm](unsigned int i, unsigned int) noexcept
+							{
+								const auto fan = FindFan(i);
+								if (fan.IsNotNull())
+								{
+									totalPwm += fan->GetPwm();
+								}
+							}
+						 );
+		totalPwm /= whichFans.CountSetBits();
+	}
+	return totalPwm;
+}
+
 // Check if the given fan can be controlled manually so that DWC can decide whether or not to show the corresponding fan
 // controls. This is the case if no thermostatic control is enabled and if the fan was configured at least once before.
 bool FansManager::IsFanControllable(size_t fanNum) const noexcept
@@ -238,6 +258,19 @@ int32_t FansManager::GetFanRPM(size_t fanNum) const noexcept
 	return (fan.IsNull()) ? -1 : fan->GetRPM();
 }
 
+// Record the fan RPMs in their histories. Called only by the Heat task, once per heater sample.
+void FansManager::RecordHistory() noexcept
+{
+	ReadLocker lock(fansLock);
+	for (Fan *f : fans)
+	{
+		if (f != nullptr)
+		{
+			f->RecordHistory();
+		}
+	}
+}
+
 // Initialise fans. Call this only once, and only during initialisation.
 void FansManager::Init() noexcept
 {
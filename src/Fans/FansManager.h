@@ -35,9 +35,11 @@ public:
 	GCodeResult SetFanValue(size_t fanNum, float speed, const StringRef& reply) noexcept;
 	float SetFanValue(size_t fanNum, float speed) noexcept;
 	float SetFansValue(FansBitmap whichFans, float speed) noexcept;
+	float GetAveragePwm(FansBitmap whichFans) const noexcept;
 	bool IsFanControllable(size_t fanNum) const noexcept;
 	const char *_ecv_array GetFanName(size_t fanNum) const noexcept;
 	int32_t GetFanRPM(size_t fanNum) const noexcept;
+	void RecordHistory() noexcept;
 #if SUPPORT_CAN_EXPANSION
 	void ProcessRemoteFanRpms(CanAddress src, const CanMessageFansReport& msg) noexcept;
 #endif
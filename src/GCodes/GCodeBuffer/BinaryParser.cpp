@@ -39,6 +39,81 @@ void BinaryParser::Put(const uint32_t *data, size_t len) noexcept
 	gb.CurrentFileMachineState().lineNumber = header->lineNumber;
 }
 
+// Decode a code from a block of similar codes, overwriting any existing content. The codes must be decoded in order starting at index 0.
+// We keep the values of the last code decoded in the block itself, so that we only need to apply the differences for the next one.
+// CAUTION! This may be called with the task scheduler suspended, so don't do anything that might block or take more than a few microseconds to execute
+void BinaryParser::PutFromBlock(CodeBlockHeader *block, size_t index) noexcept
+{
+	static constexpr float PowersOf10[MaxCodeBlockDecimals + 1] = { 1.0f, 10.0f, 100.0f, 1000.0f, 10000.0f, 100000.0f, 1000000.0f };
+
+	CodeBlockParameter * const blockParams = reinterpret_cast<CodeBlockParameter*>(block + 1);
+	if (index != 0)
+	{
+		const char *recordStart = reinterpret_cast<const char*>(blockParams + block->numParameters) + (index - 1) * CodeBlockRecordSize(block->numParameters);
+		const CodeBlockRecord *record = reinterpret_cast<const CodeBlockRecord*>(recordStart);
+		const int16_t *deltas = reinterpret_cast<const int16_t*>(record + 1);
+		block->filePosition += record->filePositionDelta;
+		block->lineNumber += record->lineNumberDelta;
+		for (size_t i = 0; i < block->numParameters; i++)
+		{
+			blockParams[i].value += deltas[i];
+		}
+	}
+
+	CodeHeader * const code = reinterpret_cast<CodeHeader*>(gb.buffer);
+	code->channel = block->channel;
+	code->flags = block->flags;
+	code->numParameters = block->numParameters;
+	code->letter = block->letter;
+	code->majorCode = block->majorCode;
+	code->minorCode = block->minorCode;
+	code->filePosition = block->filePosition;
+	code->lineNumber = block->lineNumber;
+
+	CodeParameter * const params = reinterpret_cast<CodeParameter*>(code + 1);
+	for (size_t i = 0; i < block->numParameters; i++)
+	{
+		params[i].letter = blockParams[i].letter;
+		params[i].type = blockParams[i].type;
+		params[i].padding = 0;
+		if (blockParams[i].type == DataType::Float)
+		{
+			params[i].floatValue = (float)blockParams[i].value / PowersOf10[blockParams[i].decimals];
+		}
+		else
+		{
+			params[i].intValue = blockParams[i].value;
+		}
+	}
+
+	bufferLength = sizeof(CodeHeader) + block->numParameters * sizeof(CodeParameter);
+	gb.bufferState = GCodeBufferState::parsingGCode;
+	gb.LatestMachineState().g53Active = (header->flags & CodeFlags::EnforceAbsolutePosition) != 0;
+	gb.CurrentFileMachineState().lineNumber = header->lineNumber;
+}
+
+// Check that a code block received from the SBC can be decoded safely
+/*static*/ bool BinaryParser::IsValidCodeBlock(const CodeBlockHeader *block, size_t length) noexcept
+{
+	if (length < sizeof(CodeBlockHeader) || length > MaxCodeBlockLength
+		|| block->numCodes == 0 || block->numCodes > MaxCodesPerBlock
+		|| sizeof(CodeHeader) + block->numParameters * sizeof(CodeParameter) > MaxCodeBufferSize
+		|| length != sizeof(CodeBlockHeader) + block->numParameters * sizeof(CodeBlockParameter) + (block->numCodes - 1) * CodeBlockRecordSize(block->numParameters))
+	{
+		return false;
+	}
+
+	const CodeBlockParameter *params = reinterpret_cast<const CodeBlockParameter*>(block + 1);
+	for (size_t i = 0; i < block->numParameters; i++)
+	{
+		if ((params[i].type != DataType::Int && params[i].type != DataType::UInt && params[i].type != DataType::Float) || params[i].decimals > MaxCodeBlockDecimals)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
 void BinaryParser::DecodeCommand() noexcept
 {
 	if (gb.bufferState == GCodeBufferState::parsingGCode)
@@ -26,6 +26,8 @@ public:
 	BinaryParser(GCodeBuffer& gcodeBuffer) noexcept;
 	void Init() noexcept; 														// Set it up to parse another G-code
 	void Put(const uint32_t *data, size_t len) noexcept;						// Add an entire binary code, overwriting any existing content
+	void PutFromBlock(CodeBlockHeader *block, size_t index) noexcept;			// Decode a code from a block of similar codes, overwriting any existing content
+	static bool IsValidCodeBlock(const CodeBlockHeader *block, size_t length) noexcept;	// Check that a code block received from the SBC can be decoded safely
 	void DecodeCommand() noexcept;												// Print the buffer content in debug mode and prepare for execution
 	bool Seen(char c) noexcept SPEED_CRITICAL;									// Is a character present?
 	ParameterLettersBitmap AllParameters() const noexcept { return parametersPresent; }	// Return the bitmap of all parameters seen
@@ -26,7 +26,10 @@ namespace StackUsage
 	// not counting other called functions that call CheckStack. They are obtained from file ExpressionParser.su generated by the compiler.
 	constexpr uint32_t ParseInternal = 80;
 	constexpr uint32_t ParseIdentifierExpression = 288;
-	constexpr uint32_t GetObjectValueUsingTableNumber = 48;
+	// GetObjectValueUsingCompiledPath calls GetObjectValueUsingTableNumber (48 bytes in ExpressionParser.su before compiled paths were added) without a stack check
+	// in between. Its own frame holds at most 8 saved registers (32 bytes) because its only local is the path pointer, and the path cache functions it calls
+	// have no arrays or large locals, so they need less than GetObjectValueUsingTableNumber. Replace this with the value from ObjectModel.su when it is next measured.
+	constexpr uint32_t GetObjectValueUsingCompiledPath = 48 + 32;
 	constexpr uint32_t ReadArrayFromFile = 384;
 	constexpr uint32_t ParseGeneralArray = 360;
 }
@@ -1883,8 +1886,8 @@ void ExpressionParser::ParseIdentifierExpression(ExpressionValue& rslt, bool eva
 		}
 
 		// Else assume an object model value
-		CheckStack(StackUsage::GetObjectValueUsingTableNumber);
-		rslt = reprap.GetObjectValueUsingTableNumber(context, nullptr, id.c_str(), 0);
+		CheckStack(StackUsage::GetObjectValueUsingCompiledPath);
+		rslt = reprap.GetObjectValueUsingCompiledPath(context, id.c_str());
 		if (context.ObsoleteFieldQueried() && obsoleteField.IsEmpty())
 		{
 			obsoleteField.copy(id.c_str());
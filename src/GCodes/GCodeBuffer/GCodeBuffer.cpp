@@ -302,6 +302,16 @@ void GCodeBuffer::PutBinary(const uint32_t *data, size_t len) noexcept
 	binaryParser.Put(data, len);
 }
 
+// Add the next G-Code from a block of similar codes, overwriting any existing content
+// CAUTION! This may be called with the task scheduler suspended, so don't do anything that might block or take more than a few microseconds to execute
+void GCodeBuffer::PutBinaryFromBlock(CodeBlockHeader *block, size_t index) noexcept
+{
+	machineState->lastCodeFromSbc = true;
+	isBinaryBuffer = true;
+	macroJustStarted = macroJustFinished = false;
+	binaryParser.PutFromBlock(block, index);
+}
+
 #endif
 
 // Add an entire G-Code, overwriting any existing content
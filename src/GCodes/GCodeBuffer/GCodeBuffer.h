@@ -55,6 +55,7 @@ public:
 	bool Put(char c) noexcept SPEED_CRITICAL;									// Add a character to the end
 #if HAS_SBC_INTERFACE
 	void PutBinary(const uint32_t *data, size_t len) noexcept;					// Add an entire binary G-Code, overwriting any existing content
+	void PutBinaryFromBlock(CodeBlockHeader *block, size_t index) noexcept;	// Add the next G-Code from a block of similar codes, overwriting any existing content
 #endif
 	void PutAndDecode(const char *data, size_t len) noexcept;					// Add an entire G-Code, overwriting any existing content
 	void PutAndDecode(const char *str) noexcept;								// Add a null-terminated string, overwriting any existing content
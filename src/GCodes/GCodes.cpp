@@ -178,6 +178,7 @@ void GCodes::Init() noexcept
 #endif
 
 	numExtruders = 0;
+	scanCapture = nullptr;
 
 	Reset();
 
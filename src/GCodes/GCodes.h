@@ -95,6 +95,7 @@ enum class SimulationMode : uint8_t
 };
 
 class SbcInterface;
+class ScanningProbeCapture;
 
 // The GCode interpreter
 
@@ -219,6 +220,7 @@ public:
 
 	size_t GetCurrentZProbeNumber() const noexcept { return currentZProbeNumber; }
 	void TakeScanningProbeReading() noexcept;										// Take and store a reading from a scanning Z probe
+	void TakeScanningProbeSample() noexcept;										// Take a reading from a scanning Z probe and add it to the stream for the current row
 	GCodeResult HandleM558Point1or2(GCodeBuffer& gb, const StringRef &reply, unsigned int probeNumber) THROWS(GCodeException);	// Calibrate a scanning Z probe
 
 	// These next two are public because they are used by class SbcInterface
@@ -714,6 +716,7 @@ private:
 	volatile bool zProbeTriggered;				// Set by the step ISR when a move is aborted because the Z probe is triggered
 	size_t gridAxis0Index, gridAxis1Index;		// Which grid probe point is next
 	size_t lastAxis0Index;						// The last grid probe point in this row to scan
+	ScanningProbeCapture *scanCapture;			// Collects the stream of readings when scanning the grid, or nullptr if we take one reading per grid point
 	bool doingManualBedProbe;					// true if we are waiting for the user to jog the nozzle until it touches the bed
 	bool hadProbingError;						// true if there was an error probing the last point
 	bool zDatumSetByProbing;					// true if the Z position was last set by probing, not by an endstop switch or by G92
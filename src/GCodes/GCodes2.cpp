@@ -3181,6 +3181,10 @@ bool GCodes::HandleMcode(GCodeBuffer& gb, const StringRef& reply) THROWS(GCodeEx
 					}
 				}
 				break;
+
+			case 473: // Configure file cache
+				result = MassStorage::ConfigureFileCache(gb, reply);
+				break;
 #endif
 
 			case 486: // number object or cancel object
@@ -3903,6 +3907,10 @@ bool GCodes::HandleMcode(GCodeBuffer& gb, const StringRef& reply) THROWS(GCodeEx
 				break;
 #endif
 
+			case 590: // Configure memory pool sizes
+				result = platform.ConfigureMemoryPools(gb, reply);
+				break;
+
 			case 591: // Configure filament sensor
 				{
 					const unsigned int extruder = gb.GetLimitedUIValue('D', numExtruders);
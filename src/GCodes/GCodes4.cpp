@@ -8,6 +8,7 @@
 #include <Tools/Tool.h>
 #include <Heating/Heat.h>
 #include <Endstops/ZProbe.h>
+#include <Movement/BedProbing/ScanningProbeCapture.h>
 
 #if SUPPORT_CAN_EXPANSION
 # include <CAN/CanMotion.h>
@@ -946,6 +947,10 @@ void GCodes::RunStateMachine(GCodeBuffer& gb, const StringRef& reply) noexcept
 				reprap.GetMove().SetLatestMeshDeviation(deviation);
 				reply.printf("%" PRIu32 " points probed, min error %.3f, max error %.3f, mean %.3f, deviation %.3f\n",
 								numPointsProbed, (double)minError, (double)maxError, (double)deviation.GetMean(), (double)deviation.GetDeviationFromMean());
+				if (scanCapture != nullptr)
+				{
+					scanCapture->AppendStats(reply);
+				}
 #if HAS_MASS_STORAGE || HAS_SBC_INTERFACE
 				if (TrySaveHeightMap(DefaultHeightMapFile, reply))
 				{
@@ -1026,6 +1031,28 @@ void GCodes::RunStateMachine(GCodeBuffer& gb, const StringRef& reply) noexcept
 			}
 
 			// We are over the point given by [gridAxis0index, gridAxis1index]. Scan up to [lastAxis0Index, gridAxis1index]. This may be a single point.
+			if (scanCapture != nullptr)
+			{
+				// Capture a stream of readings during a single move along the row. Take the first one here in case there is only one point in the row.
+				scanCapture->StartRow(ms.GetMsNumber(), grid.GetMin(0), grid.GetSpacing(0), gridAxis0Index, lastAxis0Index);
+				scanCapture->AddSample(grid.GetCoordinate(0, gridAxis0Index), -zp->GetCalibratedReading());
+
+				gb.AdvanceState();
+				if (lastAxis0Index != gridAxis0Index)
+				{
+					SetMoveBufferDefaults(ms);
+					ms.coords[axis0Num] = grid.GetCoordinate(0, lastAxis0Index) - zp->GetOffset(axis0Num);
+					ms.coords[axis1Num] = grid.GetCoordinate(1, gridAxis1Index) - zp->GetOffset(axis1Num);
+					ms.coords[Z_AXIS] = zp->GetStartingHeight(true);
+					ms.feedRate = zp->GetProbingSpeed(0);
+					ms.linearAxesMentioned = platform.IsAxisLinear(axis0Num);
+					ms.rotationalAxesMentioned = platform.IsAxisRotational(axis0Num);
+					reprap.GetMove().StartProbeStreaming(ms.GetMsNumber());
+					NewSingleSegmentMoveAvailable(ms);
+				}
+				break;
+			}
+
 			const float heightError = zp->GetCalibratedReading();
 			hm.SetGridHeight(gridAxis0Index, gridAxis1Index, -heightError);
 
@@ -1061,10 +1088,30 @@ void GCodes::RunStateMachine(GCodeBuffer& gb, const StringRef& reply) noexcept
 	case GCodeState::gridScanning2:		// Here when we have scanned a row
 		if (LockCurrentMovementSystemAndWaitForStandstill(gb))
 		{
+			if (scanCapture != nullptr && !reprap.GetMove().StopProbeStreaming())
+			{
+				break;										// wait until the laser task has finished with the probe and the readings
+			}
+
 			// Save the reading at the end of the scan. If there was only one point then this overwrites the value we already saved, but that doesn't matter.
 			const auto zp = platform.GetZProbeOrDefault(currentZProbeNumber);
-			zp->SetProbing(false);
 			HeightMap& hm = reprap.GetMove().AccessHeightMap();
+			if (scanCapture != nullptr)
+			{
+				// Take a last reading at the end of the row, then work out the height of each point in the row from the readings we captured
+				const GridDefinition& grid = hm.GetGrid();
+				scanCapture->AddSample(grid.GetCoordinate(0, lastAxis0Index), -zp->GetCalibratedReading());
+				scanCapture->FinishRow();
+				for (size_t i = min<size_t>(gridAxis0Index, lastAxis0Index); i <= max<size_t>(gridAxis0Index, lastAxis0Index); ++i)
+				{
+					float height;
+					if (scanCapture->GetPointHeight(i, height))
+					{
+						hm.SetGridHeight(i, gridAxis1Index, height);
+					}
+				}
+			}
+			zp->SetProbing(false);
 
 			// Advance to the start or end of the next row
 			++gridAxis1Index;
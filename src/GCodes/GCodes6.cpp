@@ -11,6 +11,7 @@
 #include "GCodeBuffer/GCodeBuffer.h"
 #include <Movement/Move.h>
 #include <Endstops/ZProbe.h>
+#include <Movement/BedProbing/ScanningProbeCapture.h>
 
 // This is called to execute a G30.
 // It sets wherever we are as the probe point P (probePointIndex) then probes the bed, or gets all its parameters from the arguments.
@@ -176,6 +177,26 @@ void GCodes::TakeScanningProbeReading() noexcept
 	}
 }
 
+// Take a reading from a scanning Z probe while we capture a stream of them, and record it against the position of the probe. Called by the Laser task.
+void GCodes::TakeScanningProbeSample() noexcept
+{
+	ScanningProbeCapture * const capture = scanCapture;
+	if (capture != nullptr)
+	{
+		const auto zp = platform.GetZProbeOrDefault(currentZProbeNumber);
+		Move& move = reprap.GetMove();
+		const size_t axis0Num = move.AccessHeightMap().GetGrid().GetAxisNumber(0);
+
+		// We don't know exactly when the probe took the reading, so use the average of the positions before and after we fetch it
+		float coords[MaxAxesPlusExtruders];
+		move.GetLiveCoordinates(capture->GetMsNumber(), nullptr, coords);
+		const float axis0Before = coords[axis0Num];
+		const float heightError = zp->GetCalibratedReading();
+		move.GetLiveCoordinates(capture->GetMsNumber(), nullptr, coords);
+		capture->AddSample(0.5 * (axis0Before + coords[axis0Num]) + zp->GetOffset(axis0Num), -heightError);
+	}
+}
+
 // Define the probing grid, called when we see an M557 command
 GCodeResult GCodes::DefineGrid(GCodeBuffer& gb, const StringRef &reply) THROWS(GCodeException)
 {
@@ -343,8 +364,21 @@ GCodeResult GCodes::ProbeGrid(GCodeBuffer& gb, const StringRef& reply) THROWS(GC
 		return GCodeResult::error;
 	}
 
+	// If an earlier scan was abandoned, the laser task may still be adding readings to the old capture object
+	if (!reprap.GetMove().StopProbeStreaming())
+	{
+		return GCodeResult::notFinished;
+	}
+
 	const auto zp = SetZProbeNumber(gb, 'K');			// may throw, so do this before changing the state
 
+	// See whether we should capture a stream of readings from a scanning Z probe and reduce them to the height of each grid point
+	ScanningProbeCapture::Mode captureMode = ScanningProbeCapture::Mode::singleReading;
+	if (zp->GetProbeType() == ZProbeType::scanningAnalog && gb.Seen('A'))
+	{
+		captureMode = (ScanningProbeCapture::Mode)gb.GetLimitedUIValue('A', (uint32_t)ScanningProbeCapture::Mode::median + 1);
+	}
+
 #if SUPPORT_ASYNC_MOVES
 	constexpr AxesBitmap XyzAxes = AxesBitmap::MakeFromBits(X_AXIS, Y_AXIS) | AxesBitmap::MakeFromBits(Z_AXIS);
 	AllocateAxes(gb, GetMovementState(gb), XyzAxes, ParameterLetterToBitmap('Z'));		// don't cache axis letters X and Y because they may be mapped
@@ -360,6 +394,12 @@ GCodeResult GCodes::ProbeGrid(GCodeBuffer& gb, const StringRef& reply) THROWS(GC
 	ClearBedMapping();
 	gridAxis0Index = gridAxis1Index = 0;
 
+	DeleteObject(scanCapture);
+	if (captureMode != ScanningProbeCapture::Mode::singleReading)
+	{
+		scanCapture = new ScanningProbeCapture(captureMode);
+	}
+
 	gb.SetState(GCodeState::gridProbing1);
 	if (zp->GetProbeType() != ZProbeType::blTouch)
 	{
@@ -38,6 +38,7 @@ constexpr ObjectModelTableEntry FopDt::objectModelTable[] =
 	{ "inverted",			OBJECT_MODEL_FUNC(self->inverted),													ObjectModelEntryFlags::none },
 	{ "maxPwm",				OBJECT_MODEL_FUNC(self->maxPwm, 2),													ObjectModelEntryFlags::none },
 	{ "pid",				OBJECT_MODEL_FUNC(self, 1),															ObjectModelEntryFlags::none },
+	{ "predictive",			OBJECT_MODEL_FUNC(self->usePredictive),												ObjectModelEntryFlags::none },
 	{ "standardVoltage",	OBJECT_MODEL_FUNC(self->standardVoltage, 1),										ObjectModelEntryFlags::none },
 
 	// 1. PID members
@@ -48,7 +49,7 @@ constexpr ObjectModelTableEntry FopDt::objectModelTable[] =
 	{ "used",				OBJECT_MODEL_FUNC(self->usePid),													ObjectModelEntryFlags::none },
 };
 
-constexpr uint8_t FopDt::objectModelTableDescriptor[] = { 2, 10, 5 };
+constexpr uint8_t FopDt::objectModelTableDescriptor[] = { 2, 11, 5 };
 
 DEFINE_GET_OBJECT_MODEL_TABLE(FopDt)
 
@@ -61,7 +62,7 @@ FopDt::FopDt() noexcept
 }
 
 // Check the model parameters are sensible, if they are then save them and return true.
-bool FopDt::SetParameters(float phr, float pbcr, float pfcr, float pcrExponent, float pdt, float pMaxPwm, float temperatureLimit, float pVoltage, bool pUsePid, bool pInverted) noexcept
+bool FopDt::SetParameters(float phr, float pbcr, float pfcr, float pcrExponent, float pdt, float pMaxPwm, float temperatureLimit, float pVoltage, bool pUsePid, bool pUsePredictive, bool pInverted) noexcept
 {
 	// DC 2017-06-20: allow S down to 0.01 for one of our OEMs (use > 0.0099 because >= 0.01 doesn't work due to rounding error)
 	const float maxTempIncrease = max<float>(1500.0, temperatureLimit + 500.0);
@@ -83,7 +84,8 @@ bool FopDt::SetParameters(float phr, float pbcr, float pfcr, float pcrExponent,
 		deadTime = pdt;
 		maxPwm = pMaxPwm;
 		standardVoltage = pVoltage;
-		usePid = pUsePid;
+		usePid = pUsePid || pUsePredictive;
+		usePredictive = pUsePredictive && !pInverted;
 		inverted = pInverted;
 		enabled = true;
 		CalcPidConstants(100.0);
@@ -118,6 +120,7 @@ bool FopDt::SetParameters(const CanMessageHeaterModelNewNew& msg, float temperat
 		maxPwm = msg.maxPwm;
 		standardVoltage = msg.standardVoltage;
 		usePid = msg.usePid;
+		usePredictive = false;
 		inverted = msg.inverted;
 		pidParametersOverridden = msg.pidParametersOverridden;
 
@@ -154,7 +157,7 @@ void FopDt::SetDefaultToolParameters() noexcept
 	maxPwm = 1.0;
 	standardVoltage = 0.0;
 	usePid = true;
-	inverted = pidParametersOverridden = false;
+	usePredictive = inverted = pidParametersOverridden = false;
 	CalcPidConstants(200.0);
 	enabled = true;
 }
@@ -170,7 +173,7 @@ void FopDt::SetDefaultBedOrChamberParameters() noexcept
 	maxPwm = 1.0;
 	standardVoltage = 0.0;
 	usePid = false;
-	inverted = pidParametersOverridden = false;
+	usePredictive = inverted = pidParametersOverridden = false;
 	CalcPidConstants(60.0);
 	enabled = true;
 }
@@ -212,7 +215,7 @@ void FopDt::AppendM307Command(unsigned int heaterNumber, const StringRef& str, b
 				(double)deadTime,
 				(double)coolingRateExponent,
 				(double)maxPwm,
-				(usePid) ? 0 : 1);
+				(usePredictive) ? 2 : (usePid) ? 0 : 1);
 	if (inverted)
 	{
 		str.cat(" I1");
@@ -238,8 +241,9 @@ void FopDt::AppendM301Command(unsigned int heaterNumber, const StringRef& str) c
 void FopDt::AppendModelParameters(unsigned int heaterNumber, const StringRef& str, bool includeVoltage) const noexcept
 {
 	const char* const mode = (!usePid) ? "bang-bang"
-								: (pidParametersOverridden) ? "custom PID"
-									: "PID";
+								: (usePredictive) ? "model predictive"
+									: (pidParametersOverridden) ? "custom PID"
+										: "PID";
 	str.catf("Heater %u: heating rate %.3f, cooling rate %.3f", heaterNumber, (double)heatingRate, (double)basicCoolingRate);
 	if (fanCoolingRate > 0.0)
 	{
@@ -43,7 +43,7 @@ public:
 	FopDt() noexcept;
 
 	void Reset() noexcept;
-	bool SetParameters(float phr, float pbcr, float pfcr, float pcrExponent, float pdt, float pMaxPwm, float temperatureLimit, float pVoltage, bool pUsePid, bool pInverted) noexcept;
+	bool SetParameters(float phr, float pbcr, float pfcr, float pcrExponent, float pdt, float pMaxPwm, float temperatureLimit, float pVoltage, bool pUsePid, bool pUsePredictive, bool pInverted) noexcept;
 	void SetDefaultToolParameters() noexcept;
 	void SetDefaultBedOrChamberParameters() noexcept;
 #if SUPPORT_REMOTE_COMMANDS
@@ -59,6 +59,7 @@ public:
 	float GetMaxPwm() const noexcept { return maxPwm; }
 	float GetVoltage() const noexcept { return standardVoltage; }
 	bool UsePid() const noexcept { return usePid; }
+	bool UsePredictive() const noexcept { return usePredictive; }
 	bool IsInverted() const noexcept { return inverted; }
 	bool IsEnabled() const noexcept { return enabled; }
 
@@ -109,6 +110,7 @@ private:
 	float standardVoltage;					// power voltage reading at which tuning was done, or 0 if unknown
 	bool enabled;
 	bool usePid;
+	bool usePredictive;						// use model-predictive control instead of PID. If this is set then usePid is set too, so remote heaters use PID.
 	bool inverted;
 	bool pidParametersOverridden;
 
@@ -52,7 +52,7 @@ Licence: GPL
 #endif
 
 #if SUPPORT_CAN_EXPANSION
-constexpr uint32_t HeaterTaskStackWords = 470;			// task stack size in dwords, must be large enough for auto tuning and a local CAN buffer
+constexpr uint32_t HeaterTaskStackWords = 500;			// task stack size in dwords, must be large enough for auto tuning and two local CAN buffers
 #else
 constexpr uint32_t HeaterTaskStackWords = 420;			// task stack size in dwords, must be large enough for auto tuning. 400 was not quite enough for one Duet WiFi user running 3.2.2.
 #endif
@@ -321,7 +321,7 @@ void Heat::SendHeatersStatus(CanMessageBuffer& buf) noexcept
 	if (heatersFound != 0)
 	{
 		buf.dataLength = msg->GetActualDataLength(heatersFound);
-		CanInterface::SendMessageNoReplyNoFree(&buf);
+		CanInterface::SendStatusReportNoFree(&buf);
 	}
 }
 
@@ -333,11 +333,16 @@ void Heat::SendHeatersStatus(CanMessageBuffer& buf) noexcept
 	for (;;)
 	{
 		// Wait until we are woken or it's time to send another regular broadcast. If we are really unlucky, we could end up waiting for one tick too long.
+		// Meanwhile, poll any sensors that are due between heater samples.
 		nextWakeTime += HeatSampleIntervalMillis;
-		int32_t delayTime = (int32_t)(nextWakeTime - millis());
-		if (delayTime > 0)
+		for (;;)
 		{
-			TaskBase::Take((uint32_t)delayTime);
+			const int32_t pollDelay = PollSensorsBetweenSamples(nextWakeTime);
+			const int32_t delayTime = (int32_t)(nextWakeTime - millis());
+			if (delayTime <= 0 || TaskBase::Take((uint32_t)min<int32_t>(delayTime, pollDelay)))
+			{
+				break;
+			}
 		}
 
 #if SUPPORT_CAN_EXPANSION
@@ -369,6 +374,31 @@ void Heat::SendHeatersStatus(CanMessageBuffer& buf) noexcept
 #if SUPPORT_REMOTE_COMMANDS
 			// Announce ourselves to the main board, if it hasn't acknowledged us already
 			CanInterface::SendAnnounce(&buf);
+
+			// Set up our board health message. If the main board accepts them, the other status reports we send below are appended to it.
+			CanMessageBuffer boardStatusBuf;
+			if (CanInterface::InExpansionMode())
+			{
+				CanMessageBoardStatus * const boardStatusMsg = boardStatusBuf.SetupStatusMessage<CanMessageBoardStatus>(CanInterface::GetCanAddress(), CanInterface::GetCurrentMasterAddress());
+				boardStatusMsg->Clear();
+
+				// We must add fields in the following order: VIN, V12, MCU temperature
+				size_t index = 0;
+# if HAS_VOLTAGE_MONITOR
+				boardStatusMsg->values[index++] = reprap.GetPlatform().GetPowerVoltages();
+				boardStatusMsg->hasVin = true;
+# endif
+# if HAS_12V_MONITOR
+				boardStatusMsg->values[index++] = reprap.GetPlatform().GetV12Voltages();
+				boardStatusMsg->hasV12 = true;
+# endif
+# if HAS_CPU_TEMP_SENSOR
+				boardStatusMsg->values[index++] = reprap.GetPlatform().GetMcuTemperatures();
+				boardStatusMsg->hasMcuTemp = true;
+# endif
+				boardStatusBuf.dataLength = boardStatusMsg->GetActualDataLength();
+				CanInterface::StartStatusReports(&boardStatusBuf);
+			}
 #endif
 
 			// Walk the sensor list and poll all sensors. The list is in increasing sensor number order.
@@ -384,10 +414,12 @@ void Heat::SendHeatersStatus(CanMessageBuffer& buf) noexcept
 					unsigned int nextUnreportedSensor = 0;
 #endif
 					ReadLocker lock(sensorsLock);
+					const uint32_t now = millis();
 					TemperatureSensor *currentSensor = sensorsRoot;
 					while (currentSensor != nullptr)
 					{
-						currentSensor->Poll();
+						(void)currentSensor->PollAtHeaterSample(nextWakeTime, now);
+						currentSensor->RecordHistory();
 #if SUPPORT_CAN_EXPANSION
 						if (currentSensor->GetBoardAddress() == CanInterface::GetCanAddress() && sensorsFound < ARRAY_SIZE(msg->temperatureReports))
 						{
@@ -416,11 +448,14 @@ void Heat::SendHeatersStatus(CanMessageBuffer& buf) noexcept
 				if (sensorsFound != 0)							// don't send an empty report
 				{
 					buf.dataLength = msg->GetActualDataLength(sensorsFound);
-					CanInterface::SendBroadcastNoFree(&buf);
+					CanInterface::SendBroadcastNoFree(&buf);			// always broadcast, never aggregated, because boards other than the main board may use the readings
 				}
 #endif
 			}
 
+			// Record the fan speeds for the object model history
+			reprap.GetFansManager().RecordHistory();
+
 			// Spin the heaters
 			{
 				ReadLocker lock(heatersLock);
@@ -474,7 +509,7 @@ void Heat::SendHeatersStatus(CanMessageBuffer& buf) noexcept
 					if (numReported != 0)
 					{
 						buf.dataLength = msg->GetActualDataLength(numReported);
-						CanInterface::SendMessageNoReplyNoFree(&buf);
+						CanInterface::SendStatusReportNoFree(&buf);
 					}
 				}
 
@@ -487,28 +522,8 @@ void Heat::SendHeatersStatus(CanMessageBuffer& buf) noexcept
 					newDriverFaultState = 0;					// we recently sent it, so send it again next time
 				}
 
-				// Send a board health message
-				{
-					CanMessageBoardStatus * const boardStatusMsg = buf.SetupStatusMessage<CanMessageBoardStatus>(CanInterface::GetCanAddress(), CanInterface::GetCurrentMasterAddress());
-					boardStatusMsg->Clear();
-
-					// We must add fields in the following order: VIN, V12, MCU temperature
-					size_t index = 0;
-#if HAS_VOLTAGE_MONITOR
-					boardStatusMsg->values[index++] = reprap.GetPlatform().GetPowerVoltages();
-					boardStatusMsg->hasVin = true;
-#endif
-#if HAS_12V_MONITOR
-					boardStatusMsg->values[index++] = reprap.GetPlatform().GetV12Voltages();
-					boardStatusMsg->hasV12 = true;
-#endif
-#if HAS_CPU_TEMP_SENSOR
-					boardStatusMsg->values[index++] = reprap.GetPlatform().GetMcuTemperatures();
-					boardStatusMsg->hasMcuTemp = true;
-#endif
-					buf.dataLength = boardStatusMsg->GetActualDataLength();
-					CanInterface::SendMessageNoReplyNoFree(&buf);
-				}
+				// Send the board health message, if we held it back to append the other status reports to it
+				CanInterface::FinishStatusReports();
 			}
 #endif
 
@@ -517,6 +532,23 @@ void Heat::SendHeatersStatus(CanMessageBuffer& buf) noexcept
 	}
 }
 
+// Poll the sensors that are due to be polled before the next heater sample. Return how long to wait in milliseconds until the next one is due.
+int32_t Heat::PollSensorsBetweenSamples(uint32_t nextSampleTime) noexcept
+{
+	ReadLocker lock(sensorsLock);
+	const uint32_t now = millis();
+	int32_t delayTime = (int32_t)(nextSampleTime - now);
+	for (TemperatureSensor *currentSensor = sensorsRoot; currentSensor != nullptr; currentSensor = currentSensor->GetNext())
+	{
+		if (currentSensor->IsPollScheduled())
+		{
+			(void)currentSensor->PollIfDue(now);
+			delayTime = min<int32_t>(delayTime, (int32_t)(currentSensor->GetNextPollTime() - now));
+		}
+	}
+	return max<int32_t>(delayTime, 1);
+}
+
 void Heat::Diagnostics(MessageType mtype) noexcept
 {
 	Platform& platform = reprap.GetPlatform();
@@ -545,6 +577,21 @@ void Heat::Diagnostics(MessageType mtype) noexcept
 			platform.MessageF(mtype, "Heater %u is on, I-accum = %.1f\n", heater, (double)acc);
 		}
 	}
+
+	// Report the polling statistics of the local sensors
+	ReadLocker lock(sensorsLock);
+	for (TemperatureSensor *sensor = sensorsRoot; sensor != nullptr; sensor = sensor->GetNext())
+	{
+#if SUPPORT_CAN_EXPANSION
+		if (sensor->GetBoardAddress() != CanInterface::GetCanAddress())
+		{
+			continue;
+		}
+#endif
+		str.printf("Sensor %u ", sensor->GetSensorNumber());
+		sensor->AppendPollStatistics(str.GetRef());
+		platform.MessageF(mtype, "%s\n", str.c_str());
+	}
 }
 
 // Configure a heater. Invoked by M950.
@@ -1104,6 +1151,12 @@ GCodeResult Heat::ConfigureSensor(GCodeBuffer& gb, const StringRef& reply) THROW
 		bool changed = false;
 		try
 		{
+			bool pollIntervalChanged = false;
+			if (!newSensor->TryConfigurePollInterval(gb, reply, pollIntervalChanged))
+			{
+				delete newSensor;
+				return GCodeResult::error;
+			}
 			const GCodeResult rslt = newSensor->Configure(gb, reply, changed);
 			if (Succeeded(rslt))
 			{
@@ -1143,8 +1196,13 @@ GCodeResult Heat::ConfigureSensor(GCodeBuffer& gb, const StringRef& reply) THROW
 	}
 #endif
 
+	bool pollIntervalChanged = false;
+	if (!sensor->TryConfigurePollInterval(gb, reply, pollIntervalChanged))
+	{
+		return GCodeResult::error;
+	}
 	bool changed = false;
-	const GCodeResult rslt = sensor->Configure(gb, reply, changed);
+	const GCodeResult rslt = sensor->Configure(gb, reply, changed);		// if only the poll interval was given then this reports the sensor details, including the new interval
 	if (changed)
 	{
 		reprap.SensorsUpdated();
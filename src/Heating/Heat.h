@@ -163,6 +163,7 @@ private:
 	ReadLockedPointer<Heater> FindHeater(int heater) const noexcept;
 	void DeleteSensor(unsigned int sn) noexcept;
 	void InsertSensor(TemperatureSensor *newSensor) noexcept;
+	int32_t PollSensorsBetweenSamples(uint32_t nextSampleTime) noexcept;
 
 #if SUPPORT_REMOTE_COMMANDS
 	void SendHeatersStatus(CanMessageBuffer& buf) noexcept;
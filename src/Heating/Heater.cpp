@@ -51,6 +51,7 @@ constexpr ObjectModelTableEntry Heater::objectModelTable[] =
 	{ "min",				OBJECT_MODEL_FUNC(self->GetLowestTemperatureLimit(), 1), 								ObjectModelEntryFlags::none },
 	{ "model",				OBJECT_MODEL_FUNC((const FopDt *)&self->GetModel()),									ObjectModelEntryFlags::none },
 	{ "monitors",			OBJECT_MODEL_FUNC_ARRAY(0), 															ObjectModelEntryFlags::none },
+	{ "residualFaultDetection", OBJECT_MODEL_FUNC(self->residualFaultDetection), 									ObjectModelEntryFlags::none },
 	{ "sensor",				OBJECT_MODEL_FUNC((int32_t)self->GetSensorNumber()), 									ObjectModelEntryFlags::none },
 	{ "standby",			OBJECT_MODEL_FUNC(self->GetStandbyTemperature(), 1), 									ObjectModelEntryFlags::live },
 	{ "state",				OBJECT_MODEL_FUNC(self->GetStatus().ToString()), 										ObjectModelEntryFlags::live },
@@ -64,7 +65,7 @@ constexpr ObjectModelTableEntry Heater::objectModelTable[] =
 	{ "sensor",			OBJECT_MODEL_FUNC((int32_t)self->monitors[context.GetLastIndex()].GetSensorNumber()), 		ObjectModelEntryFlags::none },
 };
 
-constexpr uint8_t Heater::objectModelTableDescriptor[] = { 2, 13, 4 };
+constexpr uint8_t Heater::objectModelTableDescriptor[] = { 2, 14, 4 };
 
 DEFINE_GET_OBJECT_MODEL_TABLE(Heater)
 
@@ -115,7 +116,7 @@ Heater::HeaterParameters Heater::fanOffParams, Heater::fanOnParams;
 Heater::Heater(unsigned int num) noexcept
 	: tuned(false), heaterNumber(num), sensorNumber(-1), activeTemperature(0.0), standbyTemperature(0.0),
 	  maxTempExcursion(DefaultMaxTempExcursion), maxHeatingFaultTime(DefaultMaxHeatingFaultTime), maxBadTemperatureCount(DefaultMaxBadTemperatureCount),
-	  isBedOrChamber(false),
+	  residualFaultDetection(false), isBedOrChamber(false),
 	  active(false), modelSetByUser(false), monitorsSetByUser(false)
 {
 }
@@ -146,7 +147,7 @@ GCodeResult Heater::SetOrReportModel(unsigned int heater, GCodeBuffer& gb, const
 		coolingRateExponent = model.GetCoolingRateExponent(),
 		basicCoolingRate = model.GetBasicCoolingRate(),
 		fanCoolingRate = model.GetFanCoolingRate();
-	int32_t dontUsePid = model.UsePid() ? 0 : 1;
+	int32_t controlMode = (model.UsePredictive()) ? 2 : (model.UsePid()) ? 0 : 1;		// B parameter: 0 = PID, 1 = bang-bang, 2 = model predictive
 	int32_t inversionParameter = 0;
 
 	if (gb.Seen('K'))
@@ -193,7 +194,7 @@ GCodeResult Heater::SetOrReportModel(unsigned int heater, GCodeBuffer& gb, const
 	}
 
 	gb.TryGetFValue('D', td, seen);
-	gb.TryGetIValue('B', dontUsePid, seen);
+	gb.TryGetIValue('B', controlMode, seen);
 	gb.TryGetFValue('S', maxPwm, seen);
 	gb.TryGetFValue('V', voltage, seen);
 	gb.TryGetIValue('I', inversionParameter, seen);
@@ -202,7 +203,17 @@ GCodeResult Heater::SetOrReportModel(unsigned int heater, GCodeBuffer& gb, const
 	{
 		// Set the model
 		const bool inverseTemperatureControl = (inversionParameter == 1 || inversionParameter == 3);
-		const GCodeResult rslt = SetModel(heatingRate, basicCoolingRate, fanCoolingRate, coolingRateExponent, td, maxPwm, voltage, dontUsePid == 0, inverseTemperatureControl, reply);
+		if (controlMode < 0 || controlMode > 2)
+		{
+			reply.copy("B parameter must be 0, 1 or 2");
+			return GCodeResult::error;
+		}
+		if (controlMode == 2 && inverseTemperatureControl)
+		{
+			reply.copy("model predictive control can't be used with inverted temperature control");
+			return GCodeResult::error;
+		}
+		const GCodeResult rslt = SetModel(heatingRate, basicCoolingRate, fanCoolingRate, coolingRateExponent, td, maxPwm, voltage, controlMode != 1, controlMode == 2, inverseTemperatureControl, reply);
 		if (Succeeded(rslt))
 		{
 			modelSetByUser = true;
@@ -223,10 +234,10 @@ GCodeResult Heater::SetOrReportModel(unsigned int heater, GCodeBuffer& gb, const
 }
 
 // Set the process model returning true if successful
-GCodeResult Heater::SetModel(float hr, float bcr, float fcr, float coolingRateExponent, float td, float maxPwm, float voltage, bool usePid, bool inverted, const StringRef& reply) noexcept
+GCodeResult Heater::SetModel(float hr, float bcr, float fcr, float coolingRateExponent, float td, float maxPwm, float voltage, bool usePid, bool usePredictive, bool inverted, const StringRef& reply) noexcept
 {
 	GCodeResult rslt;
-	if (model.SetParameters(hr, bcr, fcr, coolingRateExponent, td, maxPwm, GetHighestTemperatureLimit(), voltage, usePid, inverted))
+	if (model.SetParameters(hr, bcr, fcr, coolingRateExponent, td, maxPwm, GetHighestTemperatureLimit(), voltage, usePid, usePredictive, inverted))
 	{
 		if (model.IsEnabled())
 		{
@@ -422,7 +433,7 @@ void Heater::SetAndReportModelAfterTuning(bool usingFans) noexcept
 #else
 										0.0,
 #endif
-										true, false, str.GetRef());
+										true, model.UsePredictive(), false, str.GetRef());
 	if (Succeeded(rslt))
 	{
 		tuned = true;
@@ -481,6 +492,11 @@ GCodeResult Heater::ConfigureFaultDetectionParameters(GCodeBuffer& gb, const Str
 	gb.TryGetNonNegativeFValue('P', maxHeatingFaultTime, seenValue);
 	gb.TryGetNonNegativeFValue('T', maxTempExcursion, seenValue);
 	gb.TryGetLimitedUIValue('R', maxBadTemperatureCount, seenValue, 51);
+	if (gb.Seen('D'))
+	{
+		residualFaultDetection = (gb.GetLimitedUIValue('D', 2) == 1);
+		seenValue = true;
+	}
 	if (seenValue)
 	{
 		const GCodeResult rslt = UpdateFaultDetectionParameters(reply);
@@ -488,8 +504,9 @@ GCodeResult Heater::ConfigureFaultDetectionParameters(GCodeBuffer& gb, const Str
 		return rslt;
 	}
 
-	reply.printf("Heater %u allowed excursion %.1f" DEGREE_SYMBOL "C, fault trigger time %.1f seconds, max %" PRIu32 " consecutive bad readings",
-					heaterNumber, (double)maxTempExcursion, (double)maxHeatingFaultTime, maxBadTemperatureCount);
+	reply.printf("Heater %u allowed excursion %.1f" DEGREE_SYMBOL "C, fault trigger time %.1f seconds, max %" PRIu32 " consecutive bad readings, %s",
+					heaterNumber, (double)maxTempExcursion, (double)maxHeatingFaultTime, maxBadTemperatureCount,
+						(residualFaultDetection) ? "faults detected from model residuals" : "faults detected using fixed thresholds");
 	return GCodeResult::ok;
 }
 
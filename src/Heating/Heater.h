@@ -15,6 +15,7 @@
 #include <ObjectModel/ObjectModel.h>
 #include <Math/DeviationAccumulator.h>
 #include <RRF3Common.h>
+#include <Platform/Tasks.h>
 
 #if SUPPORT_CAN_EXPANSION
 # include "CanId.h"
@@ -44,6 +45,9 @@ public:
 	virtual ~Heater() noexcept;
 	Heater(const Heater&) = delete;
 
+	void* operator new(size_t sz) { Tasks::RecordAllocation(MemoryTag::heat, sz); return ::operator new(sz); }
+	void operator delete(void* p, size_t sz) noexcept { Tasks::RecordRelease(MemoryTag::heat, sz); ::operator delete(p); }
+
 	// Configuration methods
 	virtual GCodeResult ConfigurePortAndSensor(const char *portName, PwmFrequency freq, unsigned int sn, const StringRef& reply) = 0;
 	virtual GCodeResult SetPwmFrequency(PwmFrequency freq, const StringRef& reply) = 0;
@@ -135,10 +139,11 @@ protected:
 	float GetMaxTemperatureExcursion() const noexcept { return maxTempExcursion; }
 	float GetMaxHeatingFaultTime() const noexcept { return maxHeatingFaultTime; }
 	uint32_t GetMaxBadTemperatureCount() const noexcept { return maxBadTemperatureCount; }
+	bool UseResidualFaultDetection() const noexcept { return residualFaultDetection; }
 	float GetTargetTemperature() const noexcept { return (active) ? activeTemperature : standbyTemperature; }
 	bool IsBedOrChamber() const noexcept { return isBedOrChamber; }
 
-	GCodeResult SetModel(float hr, float bcr, float fcr, float coolingRateExponent, float td, float maxPwm, float voltage, bool usePid, bool inverted, const StringRef& reply) noexcept;
+	GCodeResult SetModel(float hr, float bcr, float fcr, float coolingRateExponent, float td, float maxPwm, float voltage, bool usePid, bool usePredictive, bool inverted, const StringRef& reply) noexcept;
 															// set the process model
 	void ReportTuningUpdate() noexcept;						// tell the user what's happening
 	void CalculateModel(HeaterParameters& params) noexcept;	// calculate G, td and tc from the accumulated readings
@@ -201,6 +206,7 @@ private:
 	float maxTempExcursion;							// the maximum temperature excursion permitted while maintaining the setpoint
 	float maxHeatingFaultTime;						// how long a heater fault is permitted to persist before a heater fault is raised
 	uint32_t maxBadTemperatureCount;				// the number of consecutive bad sensor readings we allow before raising a fault
+	bool residualFaultDetection;					// true to detect faults from the difference between the readings and the model instead of using fixed thresholds
 
 	bool isBedOrChamber;							// true if this was a bed or chamber heater when we were switched on
 	bool active;									// are we active or standby?
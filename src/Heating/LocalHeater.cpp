@@ -14,6 +14,8 @@
 #include <Platform/RepRap.h>
 #include <Platform/Event.h>
 #include <Tools/Tool.h>
+#include <Fans/FansManager.h>
+#include <Movement/Move.h>
 
 #if SUPPORT_REMOTE_COMMANDS
 
@@ -87,9 +89,13 @@ void LocalHeater::ResetHeater() noexcept
 	previousTemperaturesGood = 0;
 	previousTemperatureIndex = 0;
 	iAccumulator = extrusionBoost = 0.0;
+	fanPwm = 0.0;											// read from the fans on each sample
+	predictedTemperature = predictedReading = disturbanceRate = 0.0;
+	predictionValid = false;
+	residualModelValid = false;
 	badTemperatureCount = 0;
 	averagePWM = lastPwm = 0.0;
-	heatingFaultCount = 0;
+	heatingFaultCount = residualFaultCount = 0;
 	temperature = BadErrorTemperature;
 }
 
@@ -237,6 +243,17 @@ GCodeResult LocalHeater::UpdateModel(const StringRef& reply) noexcept
 	return GCodeResult::ok;
 }
 
+// This is called when the fault detection parameters have been changed by M570
+GCodeResult LocalHeater::UpdateFaultDetectionParameters(const StringRef& reply) noexcept
+{
+	if (UseResidualFaultDetection() && GetModel().IsInverted())
+	{
+		reply.printf("heater %u output is inverted so it uses fixed fault detection thresholds", GetHeaterNumber());
+		return GCodeResult::warning;
+	}
+	return GCodeResult::ok;
+}
+
 // This is the main heater control loop function
 void LocalHeater::Spin() noexcept
 {
@@ -247,6 +264,7 @@ void LocalHeater::Spin() noexcept
 	if (err != TemperatureError::ok)
 	{
 		previousTemperaturesGood <<= 1;				// this reading isn't a good one
+		residualModelValid = false;					// we can't check the next reading against the model because it won't have been corrected by this one
 		if (mode > HeaterMode::suspended)			// don't worry about errors when reading heaters that are switched off or flagged as having faults
 		{
 			// Error may be a temporary error and may correct itself after a few additional reads
@@ -281,10 +299,18 @@ void LocalHeater::Spin() noexcept
 
 		if (GetModel().IsEnabled())
 		{
+			// Model-predictive control and residual fault detection need the PWM of the fans that cool this heater to estimate the cooling rate.
+			// Read it on every sample because the fans may have been changed directly by M106 instead of through the tool.
+			fanPwm = reprap.GetFansManager().GetAveragePwm(Tool::GetFansCoolingHeater(GetHeaterNumber()));
+
 			// Get the target temperature and the error
 			const float targetTemperature = GetTargetTemperature();
 			const float error = targetTemperature - temperature;
 
+			// If we are detecting faults from the model residuals then we don't check the heating rate here, but we still check the excursion from the
+			// target in case the model itself is wrong. We can't use the model if the heater output is inverted.
+			const bool useResiduals = UseResidualFaultDetection() && !GetModel().IsInverted();
+
 			// Do the heating checks
 			switch(mode)
 			{
@@ -304,7 +330,7 @@ void LocalHeater::Spin() noexcept
 							lastTemperatureValue = temperature;
 							lastTemperatureMillis = now;
 						}
-						else if (gotDerivative)												// this is a check in case we just had a temperature spike
+						else if (gotDerivative && !useResiduals)							// this is a check in case we just had a temperature spike
 						{
 							const float expectedRate = GetExpectedHeatingRate();
 							const float minSamplingInterval = 3.0/expectedRate;				// only check the temperature when we expect at least 3C rise since last time
@@ -375,6 +401,32 @@ void LocalHeater::Spin() noexcept
 				break;
 			}
 
+			// Check the reading against the model in all modes in which we control the temperature, and also when the heater is off so that we catch
+			// a heater that is stuck on. When it is off we only look for the temperature rising above the prediction, because we are not controlling it.
+			if (useResiduals && ((mode > HeaterMode::suspended && mode < HeaterMode::tuning0) || mode == HeaterMode::off))
+			{
+				const float residual = DoResidualStep();
+				if ((mode == HeaterMode::off) ? residual > GetMaxTemperatureExcursion() : fabsf(residual) > GetMaxTemperatureExcursion())
+				{
+					++residualFaultCount;
+					if (residualFaultCount * HeatSampleIntervalMillis > GetMaxHeatingFaultTime() * SecondsToMillis)
+					{
+						RaiseHeaterFault(HeaterFaultType::exceededAllowedExcursion,
+											"temperature %.1f" DEGREE_SYMBOL "C is %.1f" DEGREE_SYMBOL "C %s than the model predicts",
+												(double)temperature, (double)fabsf(residual), (residual > 0.0) ? "higher" : "lower");
+					}
+				}
+				else if (residualFaultCount != 0)
+				{
+					--residualFaultCount;
+				}
+			}
+			else
+			{
+				residualModelValid = false;
+				residualFaultCount = 0;
+			}
+
 			// Calculate the PWM
 			if (mode >= HeaterMode::tuning0)
 			{
@@ -383,11 +435,24 @@ void LocalHeater::Spin() noexcept
 			else if (mode <= HeaterMode::suspended)
 			{
 				lastPwm = 0.0;
+				predictionValid = false;
 			}
 			else
 			{
 				// Performing normal temperature control
-				if (GetModel().UsePid())
+				const float extrusionPwm = GetExtrusionFeedForward(0.5 * GetModel().GetDeadTime(), 1.5 * GetModel().GetDeadTime());
+				if (GetModel().UsePredictive())
+				{
+					lastPwm = DoPredictiveStep(targetTemperature, extrusionPwm);
+#if HAS_VOLTAGE_MONITOR
+					// Scale the PWM based on the current voltage vs. the calibration voltage
+					if (!reprap.GetHeat().IsBedOrChamberHeater(GetHeaterNumber()))
+					{
+						lastPwm = GetModel().CorrectPwmForVoltage(lastPwm, reprap.GetPlatform().GetCurrentPowerVoltage());
+					}
+#endif
+				}
+				else if (GetModel().UsePid())
 				{
 					// Using PID mode. Determine the PID parameters to use.
 					const bool inLoadMode = (mode == HeaterMode::stable) || fabsf(error) < 3.0;		// use standard PID when maintaining temperature
@@ -416,7 +481,7 @@ void LocalHeater::Spin() noexcept
 						iAccumulator = constrain<float>
 										(iAccumulator + (errorToUse * params.kP * params.recipTi * (HeatSampleIntervalMillis * MillisToSeconds)),
 											0.0, GetModel().GetMaxPwm());
-						lastPwm = constrain<float>(pPlusD + iAccumulator + extrusionBoost, 0.0, GetModel().GetMaxPwm());
+						lastPwm = constrain<float>(pPlusD + iAccumulator + extrusionPwm, 0.0, GetModel().GetMaxPwm());
 					}
 #if HAS_VOLTAGE_MONITOR
 					// Scale the PID based on the current voltage vs. the calibration voltage
@@ -510,6 +575,145 @@ float LocalHeater::GetAveragePWM() const noexcept
 	return averagePWM;
 }
 
+// Do one step of model-predictive control and return the PWM to use, before correcting it for the supply voltage.
+// The dead time is modelled as a first-order lag between the heater temperature and the sensor reading. We run the model forward using the PWM we
+// apply, so predictedTemperature is roughly what the sensor will read one dead time from now. Each new reading corrects the model, and any
+// persistent difference between the model and the readings is treated as a heat loss or gain that the model doesn't know about.
+// We then choose the PWM that brings the predicted temperature to the target with time constant PredictiveResponseTime * dead time, so we cut
+// the power before the reading reaches the target instead of relying on the I term to undo the overshoot.
+float LocalHeater::DoPredictiveStep(float targetTemperature, float extrusionPwm) noexcept
+{
+	const FopDt& model = GetModel();
+	constexpr float sampleInterval = HeatSampleIntervalMillis * MillisToSeconds;
+	const float deadTime = max<float>(model.GetDeadTime(), sampleInterval);
+
+	if (!predictionValid)
+	{
+		// Assume the heater is in equilibrium with the sensor to begin with
+		predictedTemperature = predictedReading = temperature;
+		disturbanceRate = 0.0;
+		predictionValid = true;
+	}
+	else
+	{
+		const float readingError = temperature - predictedReading;
+		predictedTemperature += readingError;
+		predictedReading = temperature;
+		disturbanceRate = constrain<float>(disturbanceRate - readingError/(PredictiveDisturbanceTime * deadTime),
+											-0.5 * model.GetHeatingRate(), 0.5 * model.GetHeatingRate());
+	}
+
+	// Calculate the PWM needed to hold the predicted temperature, plus the PWM needed to move it towards the target.
+	// The extrusion feedforward is in PWM units already and covers the heat taken away by the filament.
+	const float temperatureRise = predictedTemperature - NormalAmbientTemperature;
+	const float holdingPwm = model.EstimateRequiredPwm(temperatureRise, fanPwm) + disturbanceRate/model.GetHeatingRate();
+	const float pwm = constrain<float>(holdingPwm + (targetTemperature - predictedTemperature)/(PredictiveResponseTime * deadTime * model.GetHeatingRate()) + extrusionPwm,
+										0.0, model.GetMaxPwm());
+
+	// Run the model forward by one sample interval using the PWM we have chosen
+	const float netHeatingRate = model.GetNetHeatingRate(temperatureRise, fanPwm, max<float>(pwm - extrusionPwm, 0.0)) - disturbanceRate;
+	predictedTemperature += netHeatingRate * sampleInterval;
+	predictedReading += (predictedTemperature - predictedReading) * min<float>(sampleInterval/deadTime, 1.0);
+	return pwm;
+}
+
+// Do one step of residual fault detection and return the residual, which is positive if the reading is higher than the model predicts, or zero if the
+// residual is not significant. We run a separate copy of the model used by model-predictive control forward over the last sample interval using the
+// PWM we applied, the PWM of the fans and the extrusion feedforward, and compare its prediction with the new reading. Unlike model-predictive control
+// we correct the model only slowly from the readings, so while the heater behaves like its model the residual stays small, but when a fault makes it
+// heat or cool faster or slower than the model says, the residual grows until it exceeds the allowed excursion.
+// The residual changes slowly except for the noise in the readings, so we estimate the noise from the differences between successive residuals.
+float LocalHeater::DoResidualStep() noexcept
+{
+	const FopDt& model = GetModel();
+	constexpr float sampleInterval = HeatSampleIntervalMillis * MillisToSeconds;
+	const float deadTime = max<float>(model.GetDeadTime(), sampleInterval);
+
+	float residual = 0.0;
+	if (!residualModelValid)
+	{
+		// Assume the heater is in equilibrium with the sensor to begin with, and don't check the residuals until that assumption no longer matters
+		residualTemperature = residualReading = temperature;
+		lastResidual = 0.0;
+		residualNoiseVariance = fsquare(MinResidualNoise);
+		residualWarmupCount = (uint16_t)min<float>(ResidualWarmupTime * deadTime/sampleInterval + 1.0, 65535.0);
+		residualModelValid = true;
+	}
+	else
+	{
+		// Run the model forward over the last sample interval and compare it with the reading
+		const float netHeatingRate = model.GetNetHeatingRate(residualTemperature - NormalAmbientTemperature, fanPwm, max<float>(GetModelEquivalentPwm() - residualExtrusionPwm, 0.0));
+		residualTemperature += netHeatingRate * sampleInterval;
+		residualReading += (residualTemperature - residualReading) * min<float>(sampleInterval/deadTime, 1.0);
+		residual = temperature - residualReading;
+		const float correction = residual * (sampleInterval/(ResidualCorrectionTime * deadTime));
+		residualTemperature += correction;
+		residualReading += correction;
+
+		// Update the noise estimate, leaving out large jumps so that a sudden fault doesn't hide itself
+		const float noiseLimit = ResidualSignificance * max<float>(sqrtf(residualNoiseVariance), MinResidualNoise);
+		const float residualChange = residual - lastResidual;
+		lastResidual = residual;
+		if (fabsf(residualChange) < noiseLimit)
+		{
+			residualNoiseVariance += (0.5 * fsquare(residualChange) - residualNoiseVariance) * (sampleInterval/ResidualNoiseTime);
+		}
+
+		if (residualWarmupCount != 0)
+		{
+			--residualWarmupCount;
+			residual = 0.0;
+		}
+		else if (fabsf(residual) < noiseLimit)
+		{
+			residual = 0.0;
+		}
+	}
+
+	// Get the extrusion feedforward for the extrusion during the next sample interval, so that we can run the model forward over it next time
+	residualExtrusionPwm = GetExtrusionFeedForward(0.0, sampleInterval);
+	return residual;
+}
+
+// Get the extrusion feedforward PWM for the extrusion between startTime and endTime seconds from now. Heat takes about one dead time to get from the
+// heater to the sensor, so when controlling the temperature we use the extrusion speed that the queued moves will have between half a dead time and
+// one and a half dead times from now. This raises the power before the extrusion speed increases, instead of waiting until the temperature starts to fall.
+// If no moves are queued then we use the feedforward for the current move.
+float LocalHeater::GetExtrusionFeedForward(float startTime, float endTime) const noexcept
+{
+	if (!IsBedOrChamber())
+	{
+		float extrusionSpeed;
+		int toolNumber;
+		if (reprap.GetMove().GetExtrusionForecast((uint32_t)(startTime * (float)StepClockRate), (uint32_t)(endTime * (float)StepClockRate), extrusionSpeed, toolNumber) && toolNumber >= 0)
+		{
+			const auto tool = Tool::GetLockedTool(toolNumber);
+			if (tool.IsNotNull())
+			{
+				return extrusionSpeed * tool->GetHeaterFeedForward(GetHeaterNumber());
+			}
+		}
+	}
+	return extrusionBoost;
+}
+
+// Get the PWM we applied during the last sample interval, corrected to the PWM that would have given the same power at the voltage at which the model was measured
+float LocalHeater::GetModelEquivalentPwm() const noexcept
+{
+#if HAS_VOLTAGE_MONITOR
+	if (!reprap.GetHeat().IsBedOrChamberHeater(GetHeaterNumber()))
+	{
+		const float standardVoltage = GetModel().GetVoltage();
+		const float actualVoltage = reprap.GetPlatform().GetCurrentPowerVoltage();
+		if (standardVoltage >= 10.0 && actualVoltage >= 10.0)
+		{
+			return lastPwm * fsquare(actualVoltage/standardVoltage);
+		}
+	}
+#endif
+	return lastPwm;
+}
+
 // Get a conservative estimate of the expected heating rate at the current temperature and average PWM. The result may be negative.
 float LocalHeater::GetExpectedHeatingRate() const noexcept
 {
@@ -555,7 +759,7 @@ GCodeResult LocalHeater::StartAutoTune(const StringRef& reply, bool seenA, float
 // Call this when the PWM of a cooling fan has changed. If there are multiple fans, caller must divide pwmChange by the number of fans.
 void LocalHeater::FeedForwardAdjustment(float fanPwmChange, float extrusionChange) noexcept
 {
-	if (mode == HeaterMode::stable)
+	if (mode == HeaterMode::stable && !GetModel().UsePredictive())
 	{
 		const float boost = GetModel().GetPwmCorrectionForFan(GetTargetTemperature() - NormalAmbientTemperature, fanPwmChange) * FanFeedForwardMultiplier;
 #if 0
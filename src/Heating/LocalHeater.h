@@ -22,6 +22,13 @@ class HeaterMonitor;
 class LocalHeater : public Heater
 {
 	static const size_t NumPreviousTemperatures = 4;		// How many samples we average the temperature derivative over
+	static constexpr float PredictiveResponseTime = 1.0;	// The closed loop time constant of model-predictive control, as a multiple of the dead time
+	static constexpr float PredictiveDisturbanceTime = 4.0;	// The time constant of the disturbance estimate used by model-predictive control, as a multiple of the dead time
+	static constexpr float ResidualCorrectionTime = 3.0;	// The time constant with which residual fault detection corrects its model from the readings, as a multiple of the dead time
+	static constexpr float ResidualNoiseTime = 30.0;		// The time constant in seconds of the reading noise estimate used by residual fault detection
+	static constexpr float MinResidualNoise = 0.05;			// The smallest standard deviation of the reading noise that residual fault detection assumes, in C
+	static constexpr float ResidualSignificance = 4.0;		// A residual must exceed this many standard deviations of the reading noise to count towards a fault
+	static constexpr float ResidualWarmupTime = 2.0;		// How long residual fault detection waits after starting the model before it checks the residuals, as a multiple of the dead time
 
 public:
 	LocalHeater(unsigned int heaterNum) noexcept;
@@ -57,7 +64,7 @@ protected:
 	HeaterMode GetMode() const noexcept override { return mode; }
 	GCodeResult SwitchOn(const StringRef& reply) noexcept override;			// Turn the heater on and set the mode
 	GCodeResult UpdateModel(const StringRef& reply) noexcept override;		// Called when the heater model has been changed
-	GCodeResult UpdateFaultDetectionParameters(const StringRef& reply) noexcept override { return GCodeResult::ok; }
+	GCodeResult UpdateFaultDetectionParameters(const StringRef& reply) noexcept override;
 	GCodeResult UpdateHeaterMonitors(const StringRef& reply) noexcept override { return GCodeResult::ok; }
 	GCodeResult StartAutoTune(const StringRef& reply, bool seenA, float ambientTemp) noexcept override;
 																			// Start an auto tune cycle for this heater
@@ -65,6 +72,10 @@ private:
 	void SetHeater(float power) const noexcept;				// Power is a fraction in [0,1]
 	TemperatureError ReadTemperature() noexcept;			// Read and store the temperature of this heater
 	void DoTuningStep() noexcept;							// Called on each temperature sample when auto tuning
+	float DoPredictiveStep(float targetTemperature, float extrusionPwm) noexcept;	// Called on each temperature sample when using model-predictive control, returns the PWM
+	float DoResidualStep() noexcept;						// Called on each temperature sample when using residual fault detection, returns the significant residual
+	float GetExtrusionFeedForward(float startTime, float endTime) const noexcept;	// Get the extrusion feedforward PWM for the extrusion between the specified times from now
+	float GetModelEquivalentPwm() const noexcept;			// Get the PWM we applied, corrected to the voltage at which the model was measured
 	float GetExpectedHeatingRate() const noexcept;			// Get the minimum heating rate we expect
 	void RaiseHeaterFault(HeaterFaultType type, const char *_ecv_array format, ...) noexcept;
 
@@ -75,17 +86,30 @@ private:
 	float iAccumulator;										// The integral LocalHeater component
 	float lastPwm;											// The last PWM value set for this heater
 	float averagePWM;										// The running average of the PWM, after scaling.
-	volatile float extrusionBoost;							// The amount of extrusion feedforward to apply
+	volatile float extrusionBoost;							// The amount of extrusion feedforward for the current move, used when no moves are queued
+	float fanPwm;											// The average PWM of the fans that cool this heater, read on each sample
+	float predictedTemperature;								// Model-predictive control: the modelled heater temperature, which the sensor reading lags by about the dead time
+	float predictedReading;									// Model-predictive control: the sensor reading that the model predicts
+	float disturbanceRate;									// Model-predictive control: the estimated rate of heat loss not accounted for by the model, in C/sec
+	float residualTemperature;								// Residual fault detection: the modelled heater temperature
+	float residualReading;									// Residual fault detection: the sensor reading that the model predicts
+	float residualExtrusionPwm;								// Residual fault detection: the extrusion feedforward PWM for the extrusion during the current sample interval
+	float lastResidual;										// Residual fault detection: the difference between the reading and the model at the previous sample
+	float residualNoiseVariance;							// Residual fault detection: the estimated variance of the reading noise, in C^2
 	float lastTemperatureValue;								// the last temperature we recorded while heating up
 	uint32_t lastTemperatureMillis;							// when we recorded the last temperature
 	uint32_t timeSetHeating;								// When we turned on the heater
 	uint32_t lastSampleTime;								// Time when the temperature was last sampled by Spin()
 
 	uint16_t heatingFaultCount;								// Count of questionable heating behaviours
+	uint16_t residualFaultCount;							// Residual fault detection: count of samples for which the residual exceeded the allowed excursion
+	uint16_t residualWarmupCount;							// Residual fault detection: how many more samples to take before we check the residuals
 
 	uint8_t previousTemperaturesGood;						// Bitmap indicating which previous temperature were good readings
 	HeaterMode mode;										// Current state of the heater
 	uint8_t badTemperatureCount;							// Count of sequential dud readings
+	bool predictionValid;									// True if predictedTemperature and predictedReading have been initialised since the heater was switched on
+	bool residualModelValid;								// True if the residual fault detection model has been initialised since the heater was switched on
 
 	static_assert(sizeof(previousTemperaturesGood) * 8 >= NumPreviousTemperatures, "too few bits in previousTemperaturesGood");
 };
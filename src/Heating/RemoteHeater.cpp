@@ -428,7 +428,14 @@ GCodeResult RemoteHeater::UpdateFaultDetectionParameters(const StringRef& reply)
 		msg->maxTempExcursion = GetMaxTemperatureExcursion();
 		msg->maxBadTemperatureCount = GetMaxBadTemperatureCount();
 		msg->version35 = true;
-		return CanInterface::SendRequestAndGetStandardReply(buf, rid, reply);
+		const GCodeResult rslt = CanInterface::SendRequestAndGetStandardReply(buf, rid, reply);
+		if (rslt == GCodeResult::ok && UseResidualFaultDetection())
+		{
+			// Expansion boards don't know about model residual fault detection, so they carry on using the fixed thresholds
+			reply.printf("heater %u is on an expansion board so it uses fixed fault detection thresholds", GetHeaterNumber());
+			return GCodeResult::warning;
+		}
+		return rslt;
 	}
 
 	reply.copy("No CAN buffer");
@@ -43,6 +43,7 @@
 #if SUPPORT_BME280
 
 constexpr uint16_t MinimumReadInterval = 1000;			// ms
+constexpr uint16_t ReadIntervalTolerance = 50;			// ms, so that polls scheduled MinimumReadInterval apart aren't skipped because the last reading was stored a little after its poll started
 constexpr uint32_t BME280_Frequency = 4000000;			// maximum for BME280 is 10MHz
 constexpr SpiMode BME280_SpiMode = SPI_MODE_0;			// BME280 does mode 0 or mode 3 depending on value of CLK at falling edge of CS
 constexpr size_t MaxRegistersToRead = 26;
@@ -745,10 +746,16 @@ TemperatureError BME280TemperatureSensor::GetLatestTemperature(float &t, uint8_t
 	return result;
 }
 
+// We don't read the sensor more often than this, so don't poll it more often by default
+uint16_t BME280TemperatureSensor::GetDefaultPollInterval() const noexcept
+{
+	return MinimumReadInterval;
+}
+
 void BME280TemperatureSensor::Poll() noexcept
 {
 	const auto now = millis();
-	if ((now - GetLastReadingTime()) >= MinimumReadInterval)
+	if ((now - GetLastReadingTime()) >= MinimumReadInterval - ReadIntervalTolerance)
 	{
 		if (bme280_get_sensor_data() == TemperatureError::ok)
 		{
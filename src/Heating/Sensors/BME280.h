@@ -32,6 +32,9 @@ public:
 
 	static constexpr const char *TypeName = "bme280";
 
+protected:
+	uint16_t GetDefaultPollInterval() const noexcept override;
+
 private:
 	TemperatureError bme280_init() noexcept;
 	TemperatureError bme280_get_regs(uint8_t reg_addr, uint8_t *reg_data, uint16_t len) const noexcept;
@@ -16,6 +16,7 @@
 
 constexpr uint16_t MinimumReadInterval = 1000;		// ms
 constexpr uint8_t  MaximumReadTime = 20;			// ms
+constexpr uint16_t ReadIntervalTolerance = 50;		// ms, so that polls scheduled MinimumReadInterval apart aren't skipped because the last reading was stored a little after its poll started
 constexpr uint8_t  MinimumOneBitLength = 50;		// microseconds
 constexpr uint32_t MinimumOneBitStepClocks = (StepClockRate * MinimumOneBitLength)/1000000;
 
@@ -156,9 +157,15 @@ void DhtTemperatureSensor::Interrupt() noexcept
 	}
 }
 
+// We can't read the sensor more often than this, so don't poll it more often by default
+uint16_t DhtTemperatureSensor::GetDefaultPollInterval() const noexcept
+{
+	return MinimumReadInterval;
+}
+
 void DhtTemperatureSensor::Poll() noexcept
 {
-	if ((millis() - GetLastReadingTime()) >= MinimumReadInterval)
+	if ((millis() - GetLastReadingTime()) >= MinimumReadInterval - ReadIntervalTolerance)
 	{
 		TakeReading();
 	}
@@ -46,6 +46,9 @@ public:
 	static constexpr const char *_ecv_array TypeNameDht21 = "dht21";
 	static constexpr const char *_ecv_array TypeNameDht22 = "dht22";
 
+protected:
+	uint16_t GetDefaultPollInterval() const noexcept override;
+
 private:
 
 #if SAME5x
@@ -8,6 +8,7 @@
 #include "RemoteSensor.h"
 #include "BME280.h"
 #include "GCodes/GCodeBuffer/GCodeBuffer.h"
+#include <Movement/StepTimer.h>
 
 #if SUPPORT_REMOTE_COMMANDS
 # include <CanMessageGenericParser.h>
@@ -37,18 +38,20 @@
 
 // Macro to build a standard lambda function that includes the necessary type conversions
 #define OBJECT_MODEL_FUNC(...) OBJECT_MODEL_FUNC_BODY(TemperatureSensor, __VA_ARGS__)
+#define OBJECT_MODEL_FUNC_IF(_condition, ...) OBJECT_MODEL_FUNC_IF_BODY(TemperatureSensor, _condition, __VA_ARGS__)
 
 constexpr ObjectModelTableEntry TemperatureSensor::objectModelTable[] =
 {
 	// Within each group, these entries must be in alphabetical order
 	// 0. TemperatureSensor members
+	{ "history",		OBJECT_MODEL_FUNC_IF(context.WantHistory(), self->history),	ObjectModelEntryFlags::live },
 	{ "lastReading",	OBJECT_MODEL_FUNC(self->lastTemperature, 2), 	ObjectModelEntryFlags::live },
 	{ "name",			OBJECT_MODEL_FUNC(self->sensorName), 			ObjectModelEntryFlags::none },
 	{ "state",			OBJECT_MODEL_FUNC(self->lastResult.ToString()),	ObjectModelEntryFlags::none },
 	{ "type",			OBJECT_MODEL_FUNC(self->GetShortSensorType()), 	ObjectModelEntryFlags::none },
 };
 
-constexpr uint8_t TemperatureSensor::objectModelTableDescriptor[] = { 1, 4 };
+constexpr uint8_t TemperatureSensor::objectModelTableDescriptor[] = { 1, 5 };
 
 DEFINE_GET_OBJECT_MODEL_TABLE(TemperatureSensor)
 
@@ -57,12 +60,15 @@ DEFINE_GET_OBJECT_MODEL_TABLE(TemperatureSensor)
 // Constructor
 TemperatureSensor::TemperatureSensor(unsigned int sensorNum, const char *_ecv_array t) noexcept
 	: next(nullptr), sensorNumber(sensorNum), sensorType(t), sensorName(nullptr),
-	  lastTemperature(0.0), whenLastRead(0), lastResult(TemperatureError::notReady), lastRealError(TemperatureError::ok) {}
+	  lastTemperature(0.0), whenLastRead(0), lastResult(TemperatureError::notReady), lastRealError(TemperatureError::ok), history(nullptr),
+	  whenNextPoll(0), lastPollStartTicks(0), numPolls(0), numJitterSamples(0), totalJitterTicks(0), maxJitterTicks(0), maxPollTicks(0),
+	  pollInterval(0), pollScheduled(false), polledSinceScheduled(false) {}
 
 // Virtual destructor
 TemperatureSensor::~TemperatureSensor() noexcept
 {
 	delete sensorName;
+	delete history;
 }
 
 // Return the latest temperature reading
@@ -130,7 +136,106 @@ void TemperatureSensor::CopyBasicDetails(const StringRef& reply) const noexcept
 	{
 		reply.catf(" (%s)", sensorName);
 	}
-	reply.catf(" type %s, reading %.1f, last error: %s", sensorType, (double)lastTemperature, lastRealError.ToString());
+	reply.catf(" type %s, reading %.1f, poll interval %ums, last error: %s", sensorType, (double)lastTemperature, GetPollInterval(), lastRealError.ToString());
+}
+
+// Configure the poll interval, if it is provided. The interval must divide or be a multiple of the heater sample interval so that polls stay in step with the heaters.
+bool TemperatureSensor::TryConfigurePollInterval(GCodeBuffer& gb, const StringRef& reply, bool& seen) THROWS(GCodeException)
+{
+	if (gb.Seen('U'))
+	{
+		const uint32_t interval = gb.GetUIValue();
+		if (   interval < MinimumPollInterval || interval > MaximumPollInterval
+			|| (HeatSampleIntervalMillis % interval != 0 && interval % HeatSampleIntervalMillis != 0)
+		   )
+		{
+			reply.printf("Poll interval must be from %" PRIu32 "ms to %" PRIu32 "ms and must divide or be a multiple of %ums",
+							MinimumPollInterval, MaximumPollInterval, (unsigned int)HeatSampleIntervalMillis);
+			return false;
+		}
+		pollInterval = (uint16_t)interval;
+		pollScheduled = false;											// the Heat task will schedule it again at the next heater sample
+		seen = true;
+	}
+	return true;
+}
+
+// Poll the sensor if it is due at a heater sample. The schedule is anchored to the time the sample was due rather than to when the Heat task got round to it,
+// so that the polls stay in step with the heaters even if the Heat task runs late.
+bool TemperatureSensor::PollAtHeaterSample(uint32_t sampleTime, uint32_t now) noexcept
+{
+	const uint32_t interval = GetPollInterval();
+	if (!pollScheduled)
+	{
+		// Sensors that are polled less often than the heaters are polled half way between heater samples, so that slow sensors don't delay the readings that the heaters use
+		whenNextPoll = (interval > HeatSampleIntervalMillis) ? sampleTime + HeatSampleIntervalMillis/2 : sampleTime;
+		pollScheduled = true;
+		polledSinceScheduled = false;
+	}
+	else if (interval <= HeatSampleIntervalMillis)
+	{
+		whenNextPoll = sampleTime;										// the heaters are about to use the reading, so make sure it is fresh
+	}
+	return PollIfDue(now);
+}
+
+// Poll the sensor if it is due. Sensors are only polled between heater samples once they have been scheduled at a heater sample.
+bool TemperatureSensor::PollIfDue(uint32_t now) noexcept
+{
+	if (!pollScheduled || (int32_t)(now - whenNextPoll) < 0)
+	{
+		return false;
+	}
+
+	const uint32_t startTicks = StepTimer::GetTimerTicks();
+	Poll();
+	const uint32_t pollTicks = StepTimer::GetTimerTicks() - startTicks;
+	if (pollTicks > maxPollTicks)
+	{
+		maxPollTicks = pollTicks;
+	}
+
+	const uint32_t interval = GetPollInterval();
+	if (polledSinceScheduled)
+	{
+		const int32_t intervalError = (int32_t)(startTicks - lastPollStartTicks) - (int32_t)((interval * StepClockRate)/1000);
+		const uint32_t jitterTicks = (intervalError < 0) ? (uint32_t)-intervalError : (uint32_t)intervalError;
+		totalJitterTicks += jitterTicks;
+		++numJitterSamples;
+		if (jitterTicks > maxJitterTicks)
+		{
+			maxJitterTicks = jitterTicks;
+		}
+	}
+	lastPollStartTicks = startTicks;
+	polledSinceScheduled = true;
+	++numPolls;
+
+	whenNextPoll += interval;
+	if ((int32_t)(now - whenNextPoll) >= 0)
+	{
+		whenNextPoll += ((now - whenNextPoll)/interval + 1) * interval;	// we fell a whole interval behind, so skip the polls we missed but keep the same phase
+	}
+	return true;
+}
+
+// Append the polling statistics to 'reply' and reset them
+void TemperatureSensor::AppendPollStatistics(const StringRef& reply) noexcept
+{
+	const auto ticksToMicroseconds = [](uint64_t ticks) noexcept -> uint32_t { return (uint32_t)((ticks * 1000000u)/StepClockRate); };
+	reply.catf("poll interval %ums, polls %" PRIu32 ", jitter mean %" PRIu32 "us max %" PRIu32 "us, longest poll %" PRIu32 "us",
+				GetPollInterval(), numPolls,
+				(numJitterSamples == 0) ? 0 : ticksToMicroseconds(totalJitterTicks/numJitterSamples), ticksToMicroseconds(maxJitterTicks), ticksToMicroseconds(maxPollTicks));
+	numPolls = numJitterSamples = maxJitterTicks = maxPollTicks = 0;
+	totalJitterTicks = 0;
+}
+
+// Record the latest reading in the history, to the nearest 0.1C. Called only by the Heat task, once per heater sample.
+void TemperatureSensor::RecordHistory() noexcept
+{
+	float t;
+	const bool valid = (GetLatestTemperature(t) == TemperatureError::ok);
+	SensorHistory::Record(history, t, valid, 0.1, 1);
 }
 
 // Configure then heater name, if it is provided
@@ -5,6 +5,8 @@
 #include <TemperatureError.h>		// for result codes
 #include <Hardware/IoPorts.h>
 #include <ObjectModel/ObjectModel.h>
+#include <Platform/Tasks.h>
+#include <Platform/SensorHistory.h>
 
 class GCodeBuffer;
 class CanMessageGenericParser;
@@ -19,6 +21,9 @@ public:
 	// Virtual destructor
 	virtual ~TemperatureSensor() noexcept;
 
+	void* operator new(size_t sz) { Tasks::RecordAllocation(MemoryTag::heat, sz); return ::operator new(sz); }
+	void operator delete(void* p, size_t sz) noexcept { Tasks::RecordRelease(MemoryTag::heat, sz); ::operator delete(p); }
+
 	// Try to get a temperature reading
 	virtual TemperatureError GetLatestTemperature(float& t, uint8_t outputNumber = 0) noexcept;
 
@@ -95,6 +100,26 @@ public:
 	// Try to get a temperature reading
 	virtual void Poll() noexcept = 0;
 
+	// Poll the sensor if it is due, returning true if we polled it. Called only by the Heat task.
+	bool PollAtHeaterSample(uint32_t sampleTime, uint32_t now) noexcept;	// called at each heater sample, which was due at sampleTime
+	bool PollIfDue(uint32_t now) noexcept;									// called between heater samples
+
+	// Return true if the sensor has been scheduled for polling, and if so when it is next due to be polled
+	bool IsPollScheduled() const noexcept { return pollScheduled; }
+	uint32_t GetNextPollTime() const noexcept { return whenNextPoll; }
+
+	// Get the interval between polls in milliseconds
+	uint16_t GetPollInterval() const noexcept { return (pollInterval != 0) ? pollInterval : GetDefaultPollInterval(); }
+
+	// Configure the poll interval if the U parameter is provided. Return false and write an error message to 'reply' if it is not valid.
+	bool TryConfigurePollInterval(GCodeBuffer& gb, const StringRef& reply, bool& seen) THROWS(GCodeException);
+
+	// Append the polling statistics to 'reply' and reset them
+	void AppendPollStatistics(const StringRef& reply) noexcept;
+
+	// Record the latest reading in the history. Called only by the Heat task, once per heater sample.
+	void RecordHistory() noexcept;
+
 	static TemperatureError GetPT100Temperature(float& t, uint16_t ohmsx100) noexcept;		// shared function used by two derived classes and the ATE
 
 protected:
@@ -103,8 +128,13 @@ protected:
 	void SetResult(float t, TemperatureError rslt) noexcept;
 	void SetResult(TemperatureError rslt) noexcept;
 
+	// Get the poll interval to use if none has been configured. Sensors that are slow to read and don't need to be read often override this.
+	virtual uint16_t GetDefaultPollInterval() const noexcept { return HeatSampleIntervalMillis; }
+
 private:
 	static constexpr uint32_t TemperatureReadingTimeout = 2000;			// any reading older than this number of milliseconds is considered unreliable
+	static constexpr uint32_t MinimumPollInterval = 25;					// the shortest poll interval in milliseconds, must divide HeatSampleIntervalMillis
+	static constexpr uint32_t MaximumPollInterval = 1000;				// the longest poll interval in milliseconds, must be well below TemperatureReadingTimeout
 
 	TemperatureSensor *_ecv_from _ecv_null next;
 	unsigned int sensorNumber;											// the number of this sensor
@@ -113,6 +143,19 @@ private:
 	float lastTemperature;
 	uint32_t whenLastRead;
 	TemperatureError lastResult, lastRealError;
+	SensorHistory *_ecv_null history;									// recent readings, or nullptr if we have none
+
+	// Polling schedule and statistics
+	uint32_t whenNextPoll;												// the millis() value at which the sensor is next due to be polled
+	uint32_t lastPollStartTicks;										// the step clock when we last started polling the sensor
+	uint32_t numPolls;													// polls since the statistics were last reported
+	uint32_t numJitterSamples;											// intervals between polls measured since the statistics were last reported
+	uint64_t totalJitterTicks;											// the sum of the differences between the measured and configured intervals between polls
+	uint32_t maxJitterTicks;											// the largest difference between a measured and the configured interval between polls
+	uint32_t maxPollTicks;												// the longest time that a poll took
+	uint16_t pollInterval;												// the configured interval between polls in milliseconds, or 0 to use the default
+	bool pollScheduled;													// true if whenNextPoll is valid
+	bool polledSinceScheduled;											// true if lastPollStartTicks is valid
 };
 
 #endif // TEMPERATURESENSOR_H
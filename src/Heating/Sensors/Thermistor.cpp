@@ -9,6 +9,7 @@
 #include "Thermistor.h"
 #include <Platform/Platform.h>
 #include <Platform/RepRap.h>
+#include <Platform/Tasks.h>
 #include <GCodes/GCodeBuffer/GCodeBuffer.h>
 
 #if HAS_VREF_MONITOR
@@ -33,14 +34,6 @@ using
 static constexpr unsigned int AdcOversampleBits = 2;							// we use 2-bit oversampling
 static constexpr int32_t OversampledAdcRange = 1u << (AdcBits + AdcOversampleBits);	// The readings we pass in should be in range 0..(AdcRange - 1)
 
-// The Steinhart-Hart equation for thermistor resistance is:
-// 1/T = A + B ln(R) + C [ln(R)]^3
-//
-// The simplified (beta) equation assumes C=0 and is:
-// 1/T = A + (1/Beta) ln(R)
-//
-// The parameters that can be configured in RRF are R25 (the resistance at 25C), Beta, and optionally C.
-
 // Macro to build a standard lambda function that includes the necessary type conversions
 #define OBJECT_MODEL_FUNC(...)					OBJECT_MODEL_FUNC_BODY(Thermistor, __VA_ARGS__)
 #define OBJECT_MODEL_FUNC_IF(_condition, ...)	OBJECT_MODEL_FUNC_IF_BODY(Thermistor, _condition, __VA_ARGS__)
@@ -61,11 +54,21 @@ DEFINE_GET_OBJECT_MODEL_TABLE_WITH_PARENT(Thermistor, SensorWithPort)
 Thermistor::Thermistor(unsigned int sensorNum, bool p_isPT1000) noexcept
 	: SensorWithPort(sensorNum, (p_isPT1000) ? "PT1000" : "Thermistor"),
 	  r25(DefaultThermistorR25), beta(DefaultThermistorBeta), shC(DefaultThermistorC), seriesR(DefaultThermistorSeriesR), adcFilterChannel(-1),
-	  isPT1000(p_isPT1000), adcLowOffset(0), adcHighOffset(0)
+	  isPT1000(p_isPT1000), adcLowOffset(0), adcHighOffset(0),
+	  lookupTable(nullptr), lookupTableFirstIndex(0), lookupTableSize(0), useLookupTable(false)
 {
 	CalcDerivedParameters();
 }
 
+Thermistor::~Thermistor() noexcept
+{
+	if (lookupTable != nullptr)
+	{
+		Tasks::RecordRelease(MemoryTag::heat, lookupTableSize * sizeof(float));
+		delete[] lookupTable;
+	}
+}
+
 // Get the ADC reading
 int32_t Thermistor::GetRawReading(bool& valid) const noexcept
 {
@@ -228,6 +231,7 @@ GCodeResult Thermistor::Configure(GCodeBuffer& gb, const StringRef& reply, bool&
 		InitPort();							// we changed the port, so clear the ADC corrections and set up the ADC filter if there is one
 	}
 
+	GCodeResult rslt = GCodeResult::ok;
 	gb.TryGetFValue('R', seriesR, changed);
 	if (!isPT1000)
 	{
@@ -240,9 +244,19 @@ GCodeResult Thermistor::Configure(GCodeBuffer& gb, const StringRef& reply, bool&
 		}
 		gb.TryGetFValue('C', shC, changed);
 		gb.TryGetFValue('T', r25, changed);
+		if (gb.Seen('X'))
+		{
+			useLookupTable = (gb.GetUIValue() != 0);
+			changed = true;
+		}
 		if (changed)
 		{
 			CalcDerivedParameters();
+			if (!BuildLookupTable())
+			{
+				reply.printf("Thermistor lookup table not used because these parameters need more than %u entries", MaxLookupTableSize);
+				rslt = GCodeResult::warning;
+			}
 		}
 	}
 
@@ -276,7 +290,7 @@ GCodeResult Thermistor::Configure(GCodeBuffer& gb, const StringRef& reply, bool&
 		}
 		else
 		{
-			reply.catf(", T:%.1f B:%.1f C:%.2e R:%.1f", (double)r25, (double)beta, (double)shC, (double)seriesR);
+			reply.catf(", T:%.1f B:%.1f C:%.2e R:%.1f X:%u", (double)r25, (double)beta, (double)shC, (double)seriesR, (lookupTable != nullptr) ? 1u : 0u);
 		}
 		reply.catf(" L:%d H:%d", adcLowOffset, adcHighOffset);
 
@@ -293,7 +307,7 @@ GCodeResult Thermistor::Configure(GCodeBuffer& gb, const StringRef& reply, bool&
 		}
 	}
 
-	return GCodeResult::ok;
+	return rslt;
 }
 
 #if SUPPORT_REMOTE_COMMANDS
@@ -312,6 +326,7 @@ GCodeResult Thermistor::Configure(const CanMessageGenericParser& parser, const S
 		InitPort();							// we changed the port, so clear the ADC corrections and set up the ADC filter if there is one
 	}
 
+	GCodeResult rslt = GCodeResult::ok;
 	changed = parser.GetFloatParam('R', seriesR) || changed;
 	if (!isPT1000)
 	{
@@ -322,9 +337,20 @@ GCodeResult Thermistor::Configure(const CanMessageGenericParser& parser, const S
 		}
 		changed = parser.GetFloatParam('C', shC) || changed;
 		changed = parser.GetFloatParam('T', r25) || changed;
+		uint8_t xVal;
+		if (parser.GetUintParam('X', xVal))
+		{
+			useLookupTable = (xVal != 0);
+			changed = true;
+		}
 		if (changed)
 		{
 			CalcDerivedParameters();
+			if (!BuildLookupTable())
+			{
+				reply.printf("Thermistor lookup table not used because these parameters need more than %u entries", MaxLookupTableSize);
+				rslt = GCodeResult::warning;
+			}
 		}
 	}
 
@@ -358,12 +384,12 @@ GCodeResult Thermistor::Configure(const CanMessageGenericParser& parser, const S
 		}
 		else
 		{
-			reply.catf(", T:%.1f B:%.1f C:%.2e R:%.1f", (double)r25, (double)beta, (double)shC, (double)seriesR);
+			reply.catf(", T:%.1f B:%.1f C:%.2e R:%.1f X:%u", (double)r25, (double)beta, (double)shC, (double)seriesR, (lookupTable != nullptr) ? 1u : 0u);
 		}
 		reply.catf(" L:%d H:%d", adcLowOffset, adcHighOffset);
 	}
 
-	return GCodeResult::ok;
+	return rslt;
 }
 
 #endif
@@ -443,9 +469,7 @@ void Thermistor::Poll() noexcept
 				else
 				{
 					// Else it's a thermistor
-					const float logResistance = logf(resistance);
-					const float recipT = shA + shB * logResistance + shC * logResistance * logResistance * logResistance;
-					const float temp =  (recipT > 0.0) ? (1.0/recipT) + ABS_ZERO : BadErrorTemperature;
+					const float temp = LookupTemperature(resistance);
 
 					// It's hard to distinguish between an open circuit and a cold high-resistance thermistor.
 					// So we treat a temperature below -5C as an open circuit, unless we are using a low-resistance thermistor. The E3D thermistor has a resistance of about 470k @ -5C.
@@ -469,12 +493,65 @@ void Thermistor::Poll() noexcept
 	}
 }
 
-// Calculate shA and shB from the other parameters
+// Set up the Steinhart-Hart equation from the other parameters
 void Thermistor::CalcDerivedParameters() noexcept
 {
-	shB = 1.0/beta;
-	const float lnR25 = logf(r25);
-	shA = 1.0/(25.0 - ABS_ZERO) - shB * lnR25 - shC * lnR25 * lnR25 * lnR25;
+	equation.SetParameters(r25, beta, shC);
+}
+
+// Get the temperature from the lookup table if we have one and the resistance is within its range, else calculate it
+float Thermistor::LookupTemperature(float resistance) const noexcept
+{
+	float temperature;
+	if (!ThermistorEquation::LookupTemperature(lookupTable, lookupTableFirstIndex, lookupTableSize, resistance, temperature))
+	{
+		temperature = equation.CalcTemperature(resistance);
+	}
+	return temperature;
+}
+
+// Build the lookup table if it is enabled, or delete it if it isn't. Called when any of the thermistor parameters have changed.
+// Return false if the table is enabled but the parameters need too large a table, in which case we calculate each temperature directly.
+bool Thermistor::BuildLookupTable() noexcept
+{
+	bool ok = true;
+	float *_ecv_array _ecv_null newTable = nullptr;
+	uint32_t firstIndex = 0;
+	size_t size = 0;
+	if (useLookupTable && !isPT1000)
+	{
+		size = equation.GetLookupTableSize(firstIndex);
+		if (size > MaxLookupTableSize)
+		{
+			size = 0;
+			ok = false;
+		}
+		else if (size != 0)
+		{
+			newTable = new float[size];
+			Tasks::RecordAllocation(MemoryTag::heat, size * sizeof(float));
+			equation.FillLookupTable(newTable, firstIndex, size);
+		}
+	}
+
+	// Swap the tables over so that Poll never sees a table and size that don't match
+	float *_ecv_array _ecv_null oldTable;
+	size_t oldSize;
+	{
+		TaskCriticalSectionLocker lock;
+		oldTable = lookupTable;
+		oldSize = lookupTableSize;
+		lookupTable = newTable;
+		lookupTableFirstIndex = firstIndex;
+		lookupTableSize = (uint16_t)size;
+	}
+
+	if (oldTable != nullptr)
+	{
+		Tasks::RecordRelease(MemoryTag::heat, oldSize * sizeof(float));
+		delete[] oldTable;
+	}
+	return ok;
 }
 
 // End
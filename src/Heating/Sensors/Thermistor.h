@@ -9,19 +9,16 @@
 #define SRC_HEATING_THERMISTOR_H_
 
 #include "SensorWithPort.h"
+#include "ThermistorEquation.h"
 
-// The Steinhart-Hart equation for thermistor resistance is:
-// 1/T = A + B ln(R) + C [ln(R)]^3
-//
-// The simplified (beta) equation assumes C=0 and is:
-// 1/T = A + (1/Beta) ln(R)
-//
-// The parameters that can be configured in RRF are R25 (the resistance at 25C), Beta, and optionally C.
+// If M308 is given the X1 parameter, we build a table of temperatures when the sensor is configured and interpolate in it instead of calculating the logarithm on every reading.
+// See ThermistorEquation.h for how the table is indexed.
 
 class Thermistor : public SensorWithPort
 {
 public:
 	Thermistor(unsigned int sensorNum, bool p_isPT1000) noexcept;					// create an instance with default values
+	~Thermistor() noexcept;
 
 	GCodeResult Configure(GCodeBuffer& gb, const StringRef& reply, bool& changed) override THROWS(GCodeException); // configure the sensor from M308 parameters
 
@@ -35,11 +32,15 @@ public:
 	static constexpr const char *_ecv_array TypeNameThermistor = "thermistor";
 	static constexpr const char *_ecv_array TypeNamePT1000 = "pt1000";
 
+	static constexpr unsigned int MaxLookupTableSize = 256;							// if the parameters need a larger table than this then we calculate the temperature directly
+
 protected:
 	DECLARE_OBJECT_MODEL
 
 private:
-	void CalcDerivedParameters() noexcept;											// calculate shA and shB
+	void CalcDerivedParameters() noexcept;											// set up the Steinhart-Hart equation
+	bool BuildLookupTable() noexcept;												// build the lookup table if it is enabled, else delete it. Return false if it is too large.
+	float LookupTemperature(float resistance) const noexcept;						// get the temperature from the lookup table if possible, else calculate it
 	int32_t GetRawReading(bool& valid) const noexcept;								// get the ADC reading
 	bool ConfigureHParam(int hVal, const StringRef& reply) noexcept;				// configure the H parameter returning true if successful, false if error
 	bool ConfigureLParam(int lVal, const StringRef& reply) noexcept;				// configure the L parameter returning true if successful, false if error
@@ -52,7 +53,11 @@ private:
 	int8_t adcLowOffset, adcHighOffset;
 
 	// The following are derived from the configurable parameters
-	float shA, shB;																	// derived parameters
+	ThermistorEquation equation;													// the Steinhart-Hart equation for these parameters
+	float *_ecv_array _ecv_null lookupTable;										// temperatures at resistances 1/8 octave apart, or nullptr if we calculate each temperature directly
+	uint32_t lookupTableFirstIndex;													// the index derived from the resistance of the first entry in the table
+	uint16_t lookupTableSize;														// the number of entries in the table
+	bool useLookupTable;															// true if the user asked for a lookup table
 };
 
 #endif /* SRC_HEATING_THERMISTOR_H_ */
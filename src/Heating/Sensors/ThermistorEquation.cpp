@@ -0,0 +1,91 @@
+/*
+ * ThermistorEquation.cpp
+ *
+ *  Created on: 19 Oct 2026
+ */
+
+#include "ThermistorEquation.h"
+
+static constexpr unsigned int LookupTableShift = 23 - ThermistorEquation::LookupTableBitsPerOctave;	// the number of float bits below the lookup table index
+
+static inline uint32_t FloatToBits(float f) noexcept
+{
+	uint32_t bits;
+	memcpy(&bits, &f, sizeof(bits));
+	return bits;
+}
+
+static inline float BitsToFloat(uint32_t bits) noexcept
+{
+	float f;
+	memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+// Calculate shA and shB from the other parameters
+void ThermistorEquation::SetParameters(float r25, float beta, float c) noexcept
+{
+	shC = c;
+	shB = 1.0/beta;
+	const float lnR25 = logf(r25);
+	shA = 1.0/(25.0 - ABS_ZERO) - shB * lnR25 - shC * lnR25 * lnR25 * lnR25;
+}
+
+// Calculate the temperature from the resistance using the Steinhart-Hart equation
+float ThermistorEquation::CalcTemperature(float resistance) const noexcept
+{
+	const float logResistance = logf(resistance);
+	const float recipT = shA + shB * logResistance + shC * logResistance * logResistance * logResistance;
+	return (recipT > 0.0) ? (1.0/recipT) + ABS_ZERO : BadErrorTemperature;
+}
+
+// Calculate the resistance at the specified temperature by solving the Steinhart-Hart equation for ln(R) using Newton's method, starting from the beta equation solution
+float ThermistorEquation::CalcResistance(float temperature) const noexcept
+{
+	const float recipT = 1.0/(temperature - ABS_ZERO);
+	float logResistance = (recipT - shA)/shB;
+	for (unsigned int i = 0; i < 8; ++i)
+	{
+		const float error = shA + shB * logResistance + shC * logResistance * logResistance * logResistance - recipT;
+		logResistance -= error/(shB + 3.0 * shC * logResistance * logResistance);
+	}
+	return expf(logResistance);
+}
+
+// Get the size of lookup table needed to span the resistances from LookupTableMaxTemperature to LookupTableMinTemperature, and the index of its first entry.
+// Return 0 if the parameters don't give a resistance that falls with temperature.
+size_t ThermistorEquation::GetLookupTableSize(uint32_t& firstIndex) const noexcept
+{
+	firstIndex = FloatToBits(CalcResistance(LookupTableMaxTemperature)) >> LookupTableShift;
+	const uint32_t lastIndex = (FloatToBits(CalcResistance(LookupTableMinTemperature)) >> LookupTableShift) + 1;
+	return (lastIndex > firstIndex) ? lastIndex - firstIndex + 1 : 0;
+}
+
+// Fill in the lookup table. Each entry holds the temperature at a resistance whose float representation has all the mantissa bits below the index clear,
+// so we can interpolate linearly between entries using those bits.
+void ThermistorEquation::FillLookupTable(float *_ecv_array table, uint32_t firstIndex, size_t size) const noexcept
+{
+	for (size_t i = 0; i < size; ++i)
+	{
+		table[i] = CalcTemperature(BitsToFloat((firstIndex + i) << LookupTableShift));
+	}
+}
+
+// Get the temperature from the lookup table if there is one and the resistance is within its range, returning true if successful
+/*static*/ bool ThermistorEquation::LookupTemperature(const float *_ecv_array null table, uint32_t firstIndex, size_t size, float resistance, float& temperature) noexcept
+{
+	if (table != nullptr)
+	{
+		const uint32_t bits = FloatToBits(resistance);
+		const uint32_t index = (bits >> LookupTableShift) - firstIndex;		// this wraps round to a large value if the resistance is below the range of the table
+		if (index + 1 < size)
+		{
+			const float fraction = (float)(bits & ((1u << LookupTableShift) - 1)) * (1.0/(float)(1u << LookupTableShift));
+			temperature = table[index] + (table[index + 1] - table[index]) * fraction;
+			return true;
+		}
+	}
+	return false;
+}
+
+// End
@@ -0,0 +1,48 @@
+/*
+ * ThermistorEquation.h
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * The Steinhart-Hart equation used by Thermistor, and the optional lookup table that replaces it when M308 is given the X1 parameter.
+ * Thermistor owns the table memory; this class only calculates its contents, so it can be tested on the host, see Scripts/HostTests.
+ */
+
+#ifndef SRC_HEATING_SENSORS_THERMISTOREQUATION_H_
+#define SRC_HEATING_SENSORS_THERMISTOREQUATION_H_
+
+#include <RepRapFirmware.h>
+
+// The Steinhart-Hart equation for thermistor resistance is:
+// 1/T = A + B ln(R) + C [ln(R)]^3
+//
+// The simplified (beta) equation assumes C=0 and is:
+// 1/T = A + (1/Beta) ln(R)
+//
+// The parameters that can be configured in RRF are R25 (the resistance at 25C), Beta, and optionally C.
+//
+// The lookup table is indexed by resistance, using the exponent and the top few bits of the mantissa of its floating point representation, so the entries are spaced at equal
+// fractions of an octave of resistance. This gives similar accuracy across the whole temperature range. The ADC reading isn't used as the index because the Vref and Vssa
+// corrections that we apply to it change at runtime.
+
+class ThermistorEquation
+{
+public:
+	ThermistorEquation() noexcept : shA(0.0), shB(0.0), shC(0.0) { }
+
+	void SetParameters(float r25, float beta, float c) noexcept;					// calculate A and B from the configured parameters
+	float CalcTemperature(float resistance) const noexcept;							// calculate the temperature from the resistance
+	float CalcResistance(float temperature) const noexcept;							// calculate the resistance at a temperature
+
+	size_t GetLookupTableSize(uint32_t& firstIndex) const noexcept;					// get the number of entries and the index of the first entry needed to cover the table temperature range
+	void FillLookupTable(float *_ecv_array table, uint32_t firstIndex, size_t size) const noexcept;
+	static bool LookupTemperature(const float *_ecv_array null table, uint32_t firstIndex, size_t size, float resistance, float& temperature) noexcept;
+
+	static constexpr unsigned int LookupTableBitsPerOctave = 3;						// the number of mantissa bits used to index the lookup table, so there are 8 entries per doubling of resistance
+	static constexpr float LookupTableMinTemperature = 0.0;							// the temperature range covered by the lookup table
+	static constexpr float LookupTableMaxTemperature = 450.0;
+
+private:
+	float shA, shB, shC;
+};
+
+#endif /* SRC_HEATING_SENSORS_THERMISTOREQUATION_H_ */
@@ -0,0 +1,185 @@
+/*
+ * ScanningProbeCapture.cpp
+ *
+ *  Created on: 19 Oct 2026
+ */
+
+#include "ScanningProbeCapture.h"
+
+// Sort a few values into ascending order
+static void SortValues(float *values, size_t count) noexcept
+{
+	for (size_t i = 1; i < count; ++i)
+	{
+		const float v = values[i];
+		size_t j = i;
+		while (j != 0 && values[j - 1] > v)
+		{
+			values[j] = values[j - 1];
+			--j;
+		}
+		values[j] = v;
+	}
+}
+
+// Return the median of some sorted values
+static float SortedMedian(const float *values, size_t count) noexcept
+{
+	return (count & 1u) ? values[count/2] : 0.5 * (values[count/2 - 1] + values[count/2]);
+}
+
+ScanningProbeCapture::ScanningProbeCapture(Mode m) noexcept
+	: axis0Min(0.0), axis0Spacing(1.0), firstIndex(0), lastIndex(0), rowActive(false), msNumber(0), mode(m)
+{
+	ResetStats();
+}
+
+void ScanningProbeCapture::ResetStats() noexcept
+{
+	totalReadings = totalSamples = rejectedSamples = pointsWithoutSamples = 0;
+	totalRowTime = 0;
+}
+
+// Start capturing readings for the points firstIndex to lastIndex inclusive of a row
+void ScanningProbeCapture::StartRow(MovementSystemNumber msNum, float p_axis0Min, float p_axis0Spacing, size_t p_firstIndex, size_t p_lastIndex) noexcept
+{
+	TaskCriticalSectionLocker lock;
+	msNumber = msNum;
+	axis0Min = p_axis0Min;
+	axis0Spacing = p_axis0Spacing;
+	firstIndex = min<size_t>(p_firstIndex, p_lastIndex);
+	lastIndex = min<size_t>(max<size_t>(p_firstIndex, p_lastIndex), MaxAxis0GridPoints - 1);
+	for (uint16_t& n : numSeen)
+	{
+		n = 0;
+	}
+	rowStartedAt = millis();
+	rowActive = true;
+}
+
+// Add a reading taken when the probe was at the specified coordinate. Readings that don't belong to a point in the current row are ignored.
+// If we already have as many readings for the point as we can store, the new one replaces the one taken furthest from the point if it is nearer.
+// So we keep the readings in a window centred on the point, whichever direction the probe crossed it in and however many readings there were.
+void ScanningProbeCapture::AddSample(float axis0Coordinate, float height) noexcept
+{
+	const float position = (axis0Coordinate - axis0Min)/axis0Spacing;
+	const int32_t index = lrintf(position);
+	const float distance = fabsf(position - (float)index);
+	TaskCriticalSectionLocker lock;
+	if (rowActive && index >= (int32_t)firstIndex && index <= (int32_t)lastIndex)
+	{
+		const unsigned int seen = numSeen[index];
+		size_t slot;
+		if (seen < MaxScanningProbeSamplesPerPoint)
+		{
+			slot = seen;
+		}
+		else
+		{
+			const float *const distances = sampleDistances[index];
+			slot = 0;
+			for (size_t i = 1; i < MaxScanningProbeSamplesPerPoint; ++i)
+			{
+				if (distances[i] > distances[slot])
+				{
+					slot = i;
+				}
+			}
+		}
+		if (seen < MaxScanningProbeSamplesPerPoint || distance < sampleDistances[index][slot])
+		{
+			samples[index][slot] = height;
+			sampleDistances[index][slot] = distance;
+		}
+		if (seen < UINT16_MAX)
+		{
+			numSeen[index] = seen + 1;
+		}
+	}
+}
+
+// Stop capturing readings for the current row and calculate the height of each point in it
+void ScanningProbeCapture::FinishRow() noexcept
+{
+	{
+		TaskCriticalSectionLocker lock;
+		rowActive = false;
+	}
+	totalRowTime += millis() - rowStartedAt;
+
+	for (size_t i = firstIndex; i <= lastIndex; ++i)
+	{
+		const size_t count = min<size_t>(numSeen[i], MaxScanningProbeSamplesPerPoint);
+		totalReadings += numSeen[i];
+		totalSamples += count;
+		if (count == 0)
+		{
+			++pointsWithoutSamples;
+		}
+		else
+		{
+			heights[i] = ReducePoint(samples[i], count);
+		}
+	}
+}
+
+// Get the height of a point in the row we have just finished, returning false if we have no readings for it
+bool ScanningProbeCapture::GetPointHeight(size_t axis0Index, float& height) const noexcept
+{
+	if (axis0Index >= firstIndex && axis0Index <= lastIndex && numSeen[axis0Index] != 0)
+	{
+		height = heights[axis0Index];
+		return true;
+	}
+	return false;
+}
+
+// Reduce the readings for a point to a single height. We use the median absolute deviation to reject outliers because it isn't distorted by the outliers themselves.
+// The readings are reordered.
+float ScanningProbeCapture::ReducePoint(float *pointSamples, size_t count) noexcept
+{
+	SortValues(pointSamples, count);
+	const float median = SortedMedian(pointSamples, count);
+
+	float deviations[MaxScanningProbeSamplesPerPoint];
+	for (size_t i = 0; i < count; ++i)
+	{
+		deviations[i] = fabsf(pointSamples[i] - median);
+	}
+	SortValues(deviations, count);
+	const float mad = max<float>(SortedMedian(deviations, count), MinMedianAbsoluteDeviation);
+	const float limit = OutlierRejectionFactor * MadToStandardDeviation * mad;
+
+	// The readings are sorted, so the ones we keep are contiguous
+	size_t first = 0, last = count;
+	while (pointSamples[first] < median - limit)
+	{
+		++first;
+	}
+	while (pointSamples[last - 1] > median + limit)
+	{
+		--last;
+	}
+	rejectedSamples += count - (last - first);
+
+	if (mode == Mode::median)
+	{
+		return SortedMedian(pointSamples + first, last - first);
+	}
+
+	float sum = 0.0;
+	for (size_t i = first; i < last; ++i)
+	{
+		sum += pointSamples[i];
+	}
+	return sum/(float)(last - first);
+}
+
+// Append the statistics of the scan to a reply
+void ScanningProbeCapture::AppendStats(const StringRef& reply) const noexcept
+{
+	reply.catf("%u readings taken (%.1f/s), %u used of which %u rejected as outliers, %u points without readings\n",
+				totalReadings, (totalRowTime == 0) ? 0.0 : (double)(totalReadings * 1000.0/totalRowTime), totalSamples, rejectedSamples, pointsWithoutSamples);
+}
+
+// End
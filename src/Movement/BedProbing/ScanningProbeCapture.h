@@ -0,0 +1,59 @@
+/*
+ * ScanningProbeCapture.h
+ *
+ *  Created on: 19 Oct 2026
+ */
+
+#ifndef SRC_MOVEMENT_BEDPROBING_SCANNINGPROBECAPTURE_H_
+#define SRC_MOVEMENT_BEDPROBING_SCANNINGPROBECAPTURE_H_
+
+#include <RepRapFirmware.h>
+
+// This class collects the readings that a scanning Z probe takes continuously while it scans a row of the height map grid.
+// Each reading is assigned to the nearest grid point in the row, which keeps the readings taken nearest to it.
+// When the row is complete, the readings for each point are reduced to a single height.
+class ScanningProbeCapture
+{
+public:
+	enum class Mode : uint8_t
+	{
+		singleReading = 0,						// one reading at each grid point, not captured by this class
+		average,								// mean of the readings after rejecting outliers
+		median									// median of the readings after rejecting outliers
+	};
+
+	explicit ScanningProbeCapture(Mode m) noexcept;
+
+	Mode GetMode() const noexcept { return mode; }
+	MovementSystemNumber GetMsNumber() const noexcept { return msNumber; }
+	void StartRow(MovementSystemNumber msNum, float axis0Min, float axis0Spacing, size_t firstIndex, size_t lastIndex) noexcept;
+	void AddSample(float axis0Coordinate, float height) noexcept;	// called by the laser task
+	void FinishRow() noexcept;
+	bool GetPointHeight(size_t axis0Index, float& height) const noexcept;
+
+	void ResetStats() noexcept;
+	void AppendStats(const StringRef& reply) const noexcept;
+
+private:
+	static constexpr float OutlierRejectionFactor = 3.0;			// we reject readings that are further than this many standard deviations from the median
+	static constexpr float MadToStandardDeviation = 1.4826;			// the standard deviation of normally-distributed data is this times the median absolute deviation
+	static constexpr float MinMedianAbsoluteDeviation = 0.002;		// in mm. If most readings are identical then the MAD is zero, but readings a probe resolution step away aren't outliers
+
+	float ReducePoint(float *pointSamples, size_t count) noexcept;
+
+	float samples[MaxAxis0GridPoints][MaxScanningProbeSamplesPerPoint];
+	float sampleDistances[MaxAxis0GridPoints][MaxScanningProbeSamplesPerPoint];	// how far from the point each of the readings we kept was taken
+	float heights[MaxAxis0GridPoints];
+	uint16_t numSeen[MaxAxis0GridPoints];						// how many readings we have had for each point in the current row, including any we didn't keep
+	float axis0Min, axis0Spacing;
+	size_t firstIndex, lastIndex;
+	volatile bool rowActive;
+	MovementSystemNumber msNumber;								// the movement system that is doing the scan
+	Mode mode;
+
+	// Statistics for the whole scan
+	unsigned int totalReadings, totalSamples, rejectedSamples, pointsWithoutSamples;
+	uint32_t rowStartedAt, totalRowTime;
+};
+
+#endif /* SRC_MOVEMENT_BEDPROBING_SCANNINGPROBECAPTURE_H_ */
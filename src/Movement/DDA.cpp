@@ -142,6 +142,7 @@ DDA::DDA(DDA* n) noexcept : next(n), prev(nullptr), state(empty)
 	activeDMs = completedDMs = nullptr;
 	segments = nullptr;
 	tool = nullptr;						// needed in case we pause before any moves have been done
+	toolNumber = -1;
 
 	// Set the endpoints to zero, because Move will ask for them.
 	// They will be wrong if we are on a delta. We take care of that when we process the M665 command in config.g.
@@ -404,6 +405,7 @@ bool DDA::InitStandardMove(DDARing& ring, const RawMove &nextMove, bool doMotorM
 
 	// 3. Store some values
 	tool = nextMove.movementTool;
+	toolNumber = (tool == nullptr) ? -1 : tool->Number();
 	filePos = nextMove.filePos;
 	virtualExtruderPosition = nextMove.moveStartVirtualExtruderPosition;
 	proportionDone = nextMove.proportionDone;
@@ -566,6 +568,7 @@ bool DDA::InitLeadscrewMove(DDARing& ring, float feedrate, const float adjustmen
 	flags.isLeadscrewAdjustmentMove = true;
 	virtualExtruderPosition = prev->virtualExtruderPosition;
 	tool = nullptr;
+	toolNumber = -1;
 	filePos = prev->filePos;
 	flags.endCoordinatesValid = prev->flags.endCoordinatesValid;
 	acceleration = deceleration = reprap.GetPlatform().NormalAcceleration(Z_AXIS);
@@ -636,6 +639,7 @@ bool DDA::InitAsyncMove(DDARing& ring, const AsyncMove& nextMove) noexcept
 	flags.all = 0;
 	virtualExtruderPosition = 0;
 	tool = nullptr;
+	toolNumber = -1;
 	filePos = noFilePosition;
 
 	startSpeed = nextMove.startSpeed;
@@ -2326,6 +2330,22 @@ float DDA::GetTotalExtrusionRate() const noexcept
 	return fraction * InverseConvertSpeedToMmPerSec(topSpeed);
 }
 
+// Return the extrusion speed averaged over the whole move in mm/sec. If the move has not been prepared yet then the result may change.
+float DDA::GetAverageExtrusionSpeed() const noexcept
+{
+	if (state == frozen || state == executing)
+	{
+		return afterPrepare.averageExtrusionSpeed;
+	}
+
+	float fraction = 0.0;
+	for (size_t i = MaxAxesPlusExtruders - reprap.GetGCodes().GetNumExtruders(); i < MaxAxesPlusExtruders; ++i)
+	{
+		fraction += directionVector[i];
+	}
+	return (clocksNeeded == 0) ? 0.0 : (fraction * totalDistance * (float)StepClockRate)/(float)clocksNeeded;
+}
+
 #if SUPPORT_LASER
 
 // Manage the laser power. Return the number of ticks until we should be called again, or 0 to be called at the start of the next move.
@@ -73,8 +73,8 @@ public:
 
 	DDA(DDA* n) noexcept;
 
-	void* operator new(size_t count) { return Tasks::AllocPermanent(count); }
-	void* operator new(size_t count, std::align_val_t align) { return Tasks::AllocPermanent(count, align); }
+	void* operator new(size_t count) { return Tasks::AllocPermanent(count, MemoryTag::move); }
+	void* operator new(size_t count, std::align_val_t align) { return Tasks::AllocPermanent(count, MemoryTag::move, align); }
 	void operator delete(void* ptr) noexcept {}
 	void operator delete(void* ptr, std::align_val_t align) noexcept {}
 
@@ -134,9 +134,11 @@ public:
 	float GetDecelerationMmPerSecSquared() const noexcept { return InverseConvertAcceleration(deceleration); }
 	float GetVirtualExtruderPosition() const noexcept { return virtualExtruderPosition; }
 	float GetTotalExtrusionRate() const noexcept;
+	float GetAverageExtrusionSpeed() const noexcept;
 
 	float AdvanceBabyStepping(DDARing& ring, size_t axis, float amount) noexcept;	// Try to push babystepping earlier in the move queue
 	const Tool *GetTool() const noexcept { return tool; }
+	int GetToolNumber() const noexcept { return toolNumber; }		// safe to call from other tasks because it doesn't dereference the tool
 	float GetTotalDistance() const noexcept { return totalDistance; }
 	void LimitSpeedAndAcceleration(float maxSpeed, float maxAcceleration) noexcept;	// Limit the speed an acceleration of this move
 
@@ -287,6 +289,7 @@ private:
 #endif
 
 	const Tool *tool;								// which tool (if any) is active
+	int16_t toolNumber;								// the number of that tool, or -1 if none, so that other tasks can look the tool up without dereferencing the pointer
 
     FilePosition filePos;							// The position in the SD card file after this move was read, or zero if not read from SD card
 
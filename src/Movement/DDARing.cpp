@@ -806,6 +806,60 @@ float DDARing::GetTotalExtrusionRate() const noexcept
 	return (cdda != nullptr) ? cdda->GetTotalExtrusionRate() : 0.0;
 }
 
+// Get the extrusion speed in mm/sec averaged over the period from startClocks to endClocks step clocks from now, and the number of the tool doing the extruding.
+// This is called by the Heat task so that heaters can apply extrusion feedforward before the extrusion speed changes. We read the moves without locking
+// the ring, which is acceptable because the result is only an estimate. We return the tool number rather than the tool because the tool may be deleted
+// by another task, so the caller must look it up under the tool list lock. Moves that have not been prepared yet may still be slowed down by lookahead.
+// If the queued moves don't extend as far as endClocks then we assume that the extrusion speed of the last one continues, unless the tool changes.
+// Return false if no moves are queued.
+bool DDARing::GetExtrusionForecast(uint32_t startClocks, uint32_t endClocks, float& averageSpeed, int& toolNumber) const noexcept
+{
+	const DDA *dda = currentDda;						// capture volatile variable
+	if (dda == nullptr)
+	{
+		dda = getPointer;
+		if (dda->GetState() != DDA::frozen && dda->GetState() != DDA::provisional)
+		{
+			return false;
+		}
+	}
+
+	toolNumber = dda->GetToolNumber();
+	uint32_t moveStart = 0;								// when the move we are looking at starts, in step clocks from now
+	float lastSpeed = 0.0;
+	float extrusion = 0.0;
+	for (unsigned int i = 0; i < numDdasInRing && moveStart < endClocks; ++i)
+	{
+		const DDA::DDAState st = dda->GetState();
+		if (st == DDA::empty)
+		{
+			break;
+		}
+		if (dda->GetToolNumber() != toolNumber)
+		{
+			lastSpeed = 0.0;							// the current tool stops extruding when the tool changes
+			break;
+		}
+		const uint32_t duration = (st == DDA::provisional) ? dda->GetClocksNeeded() : (uint32_t)max<int32_t>(dda->GetTimeLeft(), 0);
+		lastSpeed = dda->GetAverageExtrusionSpeed();
+		const uint32_t overlapStart = max<uint32_t>(moveStart, startClocks);
+		const uint32_t overlapEnd = min<uint32_t>(moveStart + duration, endClocks);
+		if (overlapEnd > overlapStart)
+		{
+			extrusion += lastSpeed * (float)(overlapEnd - overlapStart);
+		}
+		moveStart += duration;
+		dda = dda->GetNext();
+	}
+
+	if (moveStart < endClocks)
+	{
+		extrusion += lastSpeed * (float)(endClocks - max<uint32_t>(moveStart, startClocks));
+	}
+	averageSpeed = (endClocks > startClocks) ? extrusion/(float)(endClocks - startClocks) : lastSpeed;
+	return true;
+}
+
 // Pause the print as soon as we can.
 // If we are able to skip any moves, return true and update ms.pauseRestorePoint to the first move we skipped.
 // If we can't skip any moves, update just the coordinates and laser PWM in ms.pauseRestorePoint and return false.
@@ -63,6 +63,7 @@ public:
 	float GetAccelerationMmPerSecSquared() const noexcept;
 	float GetDecelerationMmPerSecSquared() const noexcept;
 	float GetTotalExtrusionRate() const noexcept;
+	bool GetExtrusionForecast(uint32_t startClocks, uint32_t endClocks, float& averageSpeed, int& toolNumber) const noexcept;
 
 	void GetCurrentMachinePosition(float m[MaxAxes], bool disableMotorMapping) const noexcept; // Get the position at the end of the last queued move in untransformed coords
 #if SUPPORT_ASYNC_MOVES
@@ -42,8 +42,8 @@ public:
 
 	DriveMovement(DriveMovement *next) noexcept;
 
-	void* operator new(size_t count) noexcept { return Tasks::AllocPermanent(count); }
-	void* operator new(size_t count, std::align_val_t align) noexcept { return Tasks::AllocPermanent(count, align); }
+	void* operator new(size_t count) noexcept { return Tasks::AllocPermanent(count, MemoryTag::move); }
+	void* operator new(size_t count, std::align_val_t align) noexcept { return Tasks::AllocPermanent(count, MemoryTag::move, align); }
 	void operator delete(void* ptr) noexcept {}
 	void operator delete(void* ptr, std::align_val_t align) noexcept {}
 
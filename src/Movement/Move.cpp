@@ -1305,6 +1305,27 @@ void Move::WakeLaserTaskFromISR() noexcept
 	}
 }
 
+// Start taking scanning Z probe readings continuously, until StopProbeStreaming is called or the move by the specified movement system has finished
+void Move::StartProbeStreaming(MovementSystemNumber msNumber) noexcept
+{
+	probeStreamingMsNumber = msNumber;
+	probeStreaming = true;
+	WakeLaserTask();
+}
+
+// Stop taking scanning Z probe readings. Return true if the laser task is no longer taking one, so that the caller may read the probe itself or discard the readings.
+// The laser task sets probeSampleInProgress before it checks probeStreaming, and we clear probeStreaming before we check probeSampleInProgress, so we can't both miss the other.
+bool Move::StopProbeStreaming() noexcept
+{
+	probeStreaming = false;
+	if (probeSampleInProgress)
+	{
+		WakeLaserTask();
+		return false;
+	}
+	return true;
+}
+
 void Move::LaserTaskRun() noexcept
 {
 	for (;;)
@@ -1318,6 +1339,32 @@ void Move::LaserTaskRun() noexcept
 			probeReadingNeeded = false;
 			gcodes.TakeScanningProbeReading();
 		}
+		else if (probeStreaming)
+		{
+			// Take scanning Z probe readings until we are told to stop or the scanning move has finished.
+			// Stop anyway if the move doesn't start, because the command that started the scan may have been abandoned.
+			constexpr uint32_t MaxScanMoveStartDelay = 1000;
+			const uint32_t startedAt = millis();
+			bool moveStarted = false;
+			do
+			{
+				probeSampleInProgress = true;
+				if (probeStreaming)
+				{
+					gcodes.TakeScanningProbeSample();
+				}
+				probeSampleInProgress = false;
+				(void)TaskBase::Take(ScanningProbeSampleInterval);
+				if (!rings[probeStreamingMsNumber].IsIdle())
+				{
+					moveStarted = true;
+				}
+				else if (moveStarted || millis() - startedAt > MaxScanMoveStartDelay)
+				{
+					probeStreaming = false;
+				}
+			} while (probeStreaming);
+		}
 # if SUPPORT_LASER
 		else if (gcodes.GetMachineType() == MachineType::laser)
 		{
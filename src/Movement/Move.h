@@ -176,6 +176,8 @@ public:
 	float GetAccelerationMmPerSecSquared() const noexcept { return rings[0].GetAccelerationMmPerSecSquared(); }
 	float GetDecelerationMmPerSecSquared() const noexcept { return rings[0].GetDecelerationMmPerSecSquared(); }
 	float GetTotalExtrusionRate() const noexcept { return rings[0].GetTotalExtrusionRate(); }
+	bool GetExtrusionForecast(uint32_t startClocks, uint32_t endClocks, float& averageSpeed, int& toolNumber) const noexcept
+		{ return rings[0].GetExtrusionForecast(startClocks, endClocks, averageSpeed, toolNumber); }
 
 	void AdjustLeadscrews(const floatc_t corrections[]) noexcept;							// Called by some Kinematics classes to adjust the leadscrews
 
@@ -192,6 +194,8 @@ public:
 
 	// Scanning Z probes
 	void SetProbeReadingNeeded() noexcept { probeReadingNeeded = true; }
+	void StartProbeStreaming(MovementSystemNumber msNumber) noexcept;						// start taking scanning Z probe readings continuously during a move
+	bool StopProbeStreaming() noexcept;														// stop taking them, returning false if the laser task is still taking one
 
 #if HAS_SMART_DRIVERS
 	uint32_t GetStepInterval(size_t axis, uint32_t microstepShift) const noexcept;			// Get the current step interval for this axis or extruder
@@ -318,8 +322,11 @@ private:
 	bool usingMesh;										// True if we are using the height map, false if we are using the random probe point set
 	bool useTaper;										// True to taper off the compensation
 	bool probeReadingNeeded = false;					// true if the laser task needs to take a Z probe reading
+	volatile bool probeStreaming = false;				// true if the laser task should take Z probe readings continuously
+	volatile bool probeSampleInProgress = false;		// true while the laser task may be taking a streamed Z probe reading
+	MovementSystemNumber probeStreamingMsNumber = 0;	// the movement system doing the move during which we take the readings
 
-	static constexpr size_t LaserTaskStackWords = 200;	// stack size in dwords for the laser and IOBits task (increased to support scanning Z probes)
+	static constexpr size_t LaserTaskStackWords = 250;	// stack size in dwords for the laser and IOBits task (increased to support scanning Z probes and reading live coordinates)
 	static Task<LaserTaskStackWords> *laserTask;		// the task used to manage laser power or IOBits
 };
 
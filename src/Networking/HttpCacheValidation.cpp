@@ -0,0 +1,70 @@
+/*
+ * HttpCacheValidation.cpp
+ *
+ *  Created on: 19 Oct 2026
+ */
+
+#include "HttpCacheValidation.h"
+
+#if SUPPORT_HTTP && HAS_MASS_STORAGE
+
+// Return true if the conditional headers show that the client already has the current version of the file.
+// If-None-Match takes precedence over If-Modified-Since, see RFC 9110 section 13.2.2.
+bool HttpCacheValidation::IsNotModified(const char *_ecv_array null ifNoneMatch, const char *_ecv_array null ifModifiedSince, const char *_ecv_array eTag, time_t lastModified) noexcept
+{
+	if (ifNoneMatch != nullptr)
+	{
+		return strcmp(ifNoneMatch, "*") == 0 || strstr(ifNoneMatch, eTag) != nullptr;		// the header may hold a list of tags, possibly with W/ prefixes
+	}
+
+	if (ifModifiedSince != nullptr && lastModified != 0)
+	{
+		struct tm timeInfo;
+		memset(&timeInfo, 0, sizeof(timeInfo));
+		if (SafeStrptime(ifModifiedSince, "%a, %d %b %Y %H:%M:%S", &timeInfo) != nullptr)
+		{
+			return lastModified <= mktime(&timeInfo);
+		}
+	}
+	return false;
+}
+
+// Return true if a web file is a script, style sheet or font whose name includes a content hash of at least 8 hex digits just before the extension,
+// e.g. "js/app.6a9c7b33.js" or "assets/index-1d7bcee1.css". Bundlers replace files named like this by files with different names when they change.
+// We only check the types of file that bundlers name this way, because other files such as reports or configuration files may have names that look
+// like this but be rewritten under the same name.
+bool HttpCacheValidation::IsImmutableFile(const char *_ecv_array fileName) noexcept
+{
+	static const char *_ecv_array const bundleExtensions[] = { ".js", ".mjs", ".css", ".woff", ".woff2", ".ttf", ".eot" };
+
+	const char *_ecv_array const extension = strrchr(fileName, '.');
+	if (extension == nullptr)
+	{
+		return false;
+	}
+	bool isBundleFile = false;
+	for (const char *_ecv_array bundleExtension : bundleExtensions)
+	{
+		if (StringEqualsIgnoreCase(extension, bundleExtension))
+		{
+			isBundleFile = true;
+			break;
+		}
+	}
+	if (!isBundleFile)
+	{
+		return false;
+	}
+	size_t numHexDigits = 0;
+	const char *_ecv_array p = extension;
+	while (p != fileName && isxdigit((unsigned char)p[-1]))
+	{
+		--p;
+		++numHexDigits;
+	}
+	return numHexDigits >= 8 && p != fileName && (p[-1] == '.' || p[-1] == '-');
+}
+
+#endif
+
+// End
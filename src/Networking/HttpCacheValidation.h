@@ -0,0 +1,29 @@
+/*
+ * HttpCacheValidation.h
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * Functions used by HttpResponder to decide whether a client's cached copy of a web file is current (RFC 9110 section 13) and whether the client
+ * may cache a web file without revalidating it. They don't use the rest of HttpResponder, so they can be tested on the host, see Scripts/HostTests.
+ */
+
+#ifndef SRC_NETWORKING_HTTPCACHEVALIDATION_H_
+#define SRC_NETWORKING_HTTPCACHEVALIDATION_H_
+
+#include <RepRapFirmware.h>
+
+#if SUPPORT_HTTP && HAS_MASS_STORAGE
+
+namespace HttpCacheValidation
+{
+	// Return true if the values of the If-None-Match and If-Modified-Since request headers, either of which may be null,
+	// show that the client already has the version of a file with the specified ETag and last modified time
+	bool IsNotModified(const char *_ecv_array null ifNoneMatch, const char *_ecv_array null ifModifiedSince, const char *_ecv_array eTag, time_t lastModified) noexcept;
+
+	// Return true if a web file has a name that shows it will never change, so that the client may cache it without revalidating it
+	bool IsImmutableFile(const char *_ecv_array fileName) noexcept;
+}
+
+#endif
+
+#endif /* SRC_NETWORKING_HTTPCACHEVALIDATION_H_ */
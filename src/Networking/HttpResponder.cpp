@@ -6,6 +6,7 @@
  */
 
 #include "HttpResponder.h"
+#include "HttpCacheValidation.h"
 
 #if SUPPORT_HTTP
 
@@ -24,6 +25,12 @@ static_assert(ARRAY_SIZE(serviceUnavailableResponse) <= OUTPUT_BUFFER_SIZE, "OUT
 
 const uint32_t HttpReceiveTimeout = 2000;
 
+#if SUPPORT_OBJECT_MODEL
+// Object model flags for WebSocket pushes. We use the same flags as the web interface uses when polling, so that the responses can be shared via the response cache.
+const char *_ecv_array const WebSocketModelFlags = "d99vno";
+const char *_ecv_array const WebSocketLiveFlags = "d99fn";
+#endif
+
 const HttpSessionKey NoSessionKey = 0;
 
 // Text for a human-readable 404 page
@@ -39,6 +46,9 @@ const char* const ErrorPagePart2 =
 	"</body>\n";
 
 HttpResponder::HttpResponder(NetworkResponder *n) noexcept : UploadingNetworkResponder(n)
+#if SUPPORT_OBJECT_MODEL
+	, modelKeepOpen(false), isWebSocket(false)
+#endif
 {
 }
 
@@ -114,6 +124,14 @@ bool HttpResponder::Spin() noexcept
 		(void)SendFileInfo(millis() - startedProcessingRequestAt >= MaxFileInfoGetTime);
 		return true;
 
+#if SUPPORT_OBJECT_MODEL
+	case ResponderState::streamingModel:
+		return SendNextModelChunk();
+
+	case ResponderState::webSocket:
+		return DoWebSocket();
+#endif
+
 #if HAS_MASS_STORAGE
 	case ResponderState::uploading:
 		DoUpload();
@@ -648,7 +666,8 @@ bool HttpResponder::GetJsonResponse(const char *_ecv_array request, OutputBuffer
 		OutputBuffer::ReleaseAll(response);
 		const char *const filterVal = GetKeyValue("key");
 		const char *const flagsVal = GetKeyValue("flags");
-		response = reprap.GetModelResponse(nullptr, filterVal, flagsVal);
+		modelCursor.Reset();
+		response = reprap.GetModelResponse(nullptr, filterVal, flagsVal, &modelCursor);
 	}
 #endif
 	else if (StringEqualsIgnoreCase(request, "config"))
@@ -825,6 +844,8 @@ void HttpResponder::SendFile(const char *_ecv_array nameOfFileToSend, bool isWeb
 #if HAS_MASS_STORAGE
 	FileStore *fileToSend = nullptr;
 	bool zip = false;
+	String<StringLength20> eTag;
+	time_t lastModified = 0;
 
 	if (isWebFile)
 	{
@@ -844,27 +865,29 @@ void HttpResponder::SendFile(const char *_ecv_array nameOfFileToSend, bool isWeb
 		// or file download requests after IP address changes
 		if (strlen(nameOfFileToSend) <= MaxExpectedWebDirFilenameLength)
 		{
+			// Find the file without opening it, so that we don't need to open it if the client already has an up-to-date copy
+			static_assert(MaxExpectedWebDirFilenameLength + 3 <= MaxFilenameLength);			// this ensures that we can append '.gz' to the filename without overflow
+			String<MaxFilenameLength> nameBuf;
+			bool found = false;
+			uint32_t fileSize;
 			for (;;)
 			{
-				// Try to open a gzipped version of the file first
+				// Look for a gzipped version of the file first
 				if (!StringEndsWithIgnoreCase(nameOfFileToSend, ".gz"))
 				{
-					static_assert(MaxExpectedWebDirFilenameLength + 3 <= MaxFilenameLength);			// this ensures that we can append '.gz' to the filename without overflow
-					String<MaxFilenameLength> nameBuf;
 					nameBuf.copy(nameOfFileToSend);
 					nameBuf.cat(".gz");
-					fileToSend = GetPlatform().OpenFile(Platform::GetWebDir(), nameBuf.c_str(), OpenMode::read);
-					if (fileToSend != nullptr)
+					if (GetPlatform().GetFileSizeAndTime(Platform::GetWebDir(), nameBuf.c_str(), fileSize, lastModified))
 					{
-						zip = true;
+						zip = found = true;
 						break;
 					}
 				}
 
-				// That failed, so try to open the normal version of the file
-				fileToSend = GetPlatform().OpenFile(Platform::GetWebDir(), nameOfFileToSend, OpenMode::read);
-				if (fileToSend != nullptr)
+				// That failed, so look for the normal version of the file
+				if (GetPlatform().GetFileSizeAndTime(Platform::GetWebDir(), nameOfFileToSend, fileSize, lastModified))
 				{
+					found = true;
 					break;
 				}
 
@@ -881,6 +904,28 @@ void HttpResponder::SendFile(const char *_ecv_array nameOfFileToSend, bool isWeb
 					break;
 				}
 			}
+
+			if (found)
+			{
+				// The entity tag only needs to change when the file does, so build it from the size and last modified time
+				eTag.printf("\"%" PRIx32 "-%" PRIx32 "\"", (uint32_t)lastModified, fileSize);
+				if (HttpCacheValidation::IsNotModified(GetHeaderValue("If-None-Match"), GetHeaderValue("If-Modified-Since"), eTag.c_str(), lastModified))
+				{
+					// A 304 reply has no body, so if the client wants to keep the connection open to revalidate more files then we let it
+					outBuf->copy("HTTP/1.1 304 Not Modified\r\n");
+					AddWebFileCacheHeaders(nameOfFileToSend, eTag.c_str(), lastModified);
+					outBuf->cat("\r\n");
+					const char *const _ecv_array null connection = GetHeaderValue("Connection");
+					const bool keepOpen = (connection != nullptr && StringEqualsIgnoreCase(connection, "keep-alive"));
+					Commit((keepOpen) ? ResponderState::reading : ResponderState::free);
+					return;
+				}
+				fileToSend = GetPlatform().OpenFile(Platform::GetWebDir(), (zip) ? nameBuf.c_str() : nameOfFileToSend, OpenMode::read);
+				if (fileToSend == nullptr)
+				{
+					eTag.Clear();
+				}
+			}
 		}
 
 		// If we still couldn't find the file and it was an HTML file, return the 404 error page
@@ -918,6 +963,10 @@ void HttpResponder::SendFile(const char *_ecv_array nameOfFileToSend, bool isWeb
 					);
 		AddCorsHeader();
 	}
+	else if (!eTag.IsEmpty())
+	{
+		AddWebFileCacheHeaders(nameOfFileToSend, eTag.c_str(), lastModified);
+	}
 
 	const char* contentType;
 	if (StringEndsWithIgnoreCase(nameOfFileToSend, ".png"))
@@ -968,6 +1017,29 @@ void HttpResponder::SendFile(const char *_ecv_array nameOfFileToSend, bool isWeb
 #endif
 }
 
+#if HAS_MASS_STORAGE
+
+// Add the headers that let the client cache a web file and revalidate it later
+void HttpResponder::AddWebFileCacheHeaders(const char *_ecv_array fileName, const char *_ecv_array eTag, time_t lastModified) noexcept
+{
+	outBuf->catf("ETag: %s\r\n", eTag);
+	if (lastModified != 0)
+	{
+		static const char *const dayNames[7] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+		tm timeInfo;
+		gmtime_r(&lastModified, &timeInfo);
+		outBuf->catf("Last-Modified: %s, %02d %s %04d %02d:%02d:%02d GMT\r\n",
+						dayNames[timeInfo.tm_wday], timeInfo.tm_mday, MassStorage::GetMonthName(timeInfo.tm_mon + 1), timeInfo.tm_year + 1900,
+						timeInfo.tm_hour, timeInfo.tm_min, timeInfo.tm_sec);
+	}
+	if (ImmutableWebFileMaxAge != 0 && HttpCacheValidation::IsImmutableFile(fileName))
+	{
+		outBuf->catf("Cache-Control: public, max-age=%" PRIu32 ", immutable\r\n", ImmutableWebFileMaxAge);
+	}
+}
+
+#endif
+
 void HttpResponder::SendGCodeReply() noexcept
 {
 	{
@@ -1029,6 +1101,14 @@ void HttpResponder::SendJsonResponse(const char *_ecv_array command) noexcept
 		Authenticate(false, dummy);
 	}
 
+#if SUPPORT_OBJECT_MODEL
+	if (StringEqualsIgnoreCase(command, "ws"))						// rr_ws, which does its own authentication because browsers can't add headers to WebSocket requests
+	{
+		StartWebSocket();
+		return;
+	}
+#endif
+
 	// Try to handle "text/plain" requests here
 	if (CheckAuthenticated())
 	{
@@ -1091,6 +1171,39 @@ void HttpResponder::SendJsonResponse(const char *_ecv_array command) noexcept
 		keepOpen = (val != nullptr && StringEqualsIgnoreCase(val, "keep-alive"));
 	}
 
+#if SUPPORT_OBJECT_MODEL
+	if (modelCursor.IsInProgress())
+	{
+		// This is the first chunk of an object model response that was too large to generate all at once, so use chunked transfer encoding
+		outBuf->copy(	"HTTP/1.1 200 OK\r\n"
+						"Cache-Control: no-cache, no-store, must-revalidate\r\n"
+						"Pragma: no-cache\r\n"
+						"Expires: 0\r\n"
+						"Content-Type: application/json\r\n"
+						"Transfer-Encoding: chunked\r\n"
+					);
+		AddCorsHeader();
+		outBuf->catf("Connection: %s\r\n\r\n", keepOpen ? "keep-alive" : "close");
+		AppendModelChunk(jsonResponse);
+		if (outBuf->HadOverflow())
+		{
+			ReportOutputBufferExhaustion(__FILE__, __LINE__);
+			modelCursor.Reset();
+			outBuf->copy(serviceUnavailableResponse);
+			Commit(ResponderState::free, false);
+			return;
+		}
+
+		modelKeepOpen = keepOpen;
+		Commit(ResponderState::streamingModel, false);
+		if (reprap.Debug(Module::Webserver))
+		{
+			debugPrintf("Sending chunked JSON reply\n");
+		}
+		return;
+	}
+#endif
+
 	// Note that when using RTOS the following response should preferably be small enough to fit in a single buffer.
 	// This is because the current task may get suspended e.g. when reading from SD card to build a file list,
 	// so other tasks may allocate buffers meanwhile, and the previous mechanism for ensuring that there is sufficient
@@ -1128,6 +1241,443 @@ void HttpResponder::SendJsonResponse(const char *_ecv_array command) noexcept
 	}
 }
 
+#if SUPPORT_OBJECT_MODEL
+
+// Report why we failed to generate the next chunk of an object model response
+void HttpResponder::ReportModelResponseAbandoned(const char *sourceFile, int line) noexcept
+{
+	if (modelCursor.ModelChanged(reprap.GetSeqsSignature()))
+	{
+		if (reprap.Debug(Module::Webserver))
+		{
+			debugPrintf("Object model changed while generating a chunked response at %s(%d)\n", sourceFile, line);
+		}
+	}
+	else
+	{
+		ReportOutputBufferExhaustion(sourceFile, line);
+	}
+}
+
+// Append a chunk of an object model response to outBuf using chunked transfer encoding. If it is the last chunk then append the terminating chunk too.
+void HttpResponder::AppendModelChunk(OutputBuffer *chunk) noexcept
+{
+	outBuf->catf("%x\r\n", chunk->Length());
+	outBuf->Append(chunk);
+	outBuf->cat((modelCursor.IsInProgress()) ? "\r\n" : "\r\n0\r\n\r\n");
+}
+
+// Generate and send the next chunk of an object model response, returning true if we did anything significant.
+// We wait until there are enough free output buffers to hold the chunk, so that one large response doesn't starve the other clients.
+bool HttpResponder::SendNextModelChunk() noexcept
+{
+	if (OutputBuffer::GetFreeBuffers() < ObjectModelChunkSize/OUTPUT_BUFFER_SIZE + RESERVED_OUTPUT_BUFFERS + 2)
+	{
+		if (millis() - timer < MaxBufferWaitTime)
+		{
+			return false;
+		}
+		ReportOutputBufferExhaustion(__FILE__, __LINE__);
+		modelCursor.Reset();
+		ConnectionLost();									// we have already sent part of the response, so all we can do is to close the connection
+		return true;
+	}
+
+	OutputBuffer *chunk = nullptr;
+	if (outBuf != nullptr || OutputBuffer::Allocate(outBuf))
+	{
+		chunk = reprap.GetModelResponse(nullptr, GetKeyValue("key"), GetKeyValue("flags"), &modelCursor);
+	}
+	if (chunk == nullptr)
+	{
+		// Either we ran out of buffers or the object model changed after we sent the first chunk. We have already sent part of the response,
+		// so in both cases all we can do is to close the connection. The client will see an incomplete response and can ask again.
+		ReportModelResponseAbandoned(__FILE__, __LINE__);
+		modelCursor.Reset();
+		ConnectionLost();
+		return true;
+	}
+
+	AppendModelChunk(chunk);
+	if (outBuf->HadOverflow())
+	{
+		ReportOutputBufferExhaustion(__FILE__, __LINE__);
+		modelCursor.Reset();
+		ConnectionLost();
+		return true;
+	}
+
+	Commit((modelCursor.IsInProgress()) ? ResponderState::streamingModel : (modelKeepOpen) ? ResponderState::reading : ResponderState::free, false);
+	return true;
+}
+
+// Upgrade the connection to a WebSocket if the client is logged in and the request is valid.
+// Browsers can't add headers to WebSocket requests, so the session key may be passed in the sessionKey qualifier instead of the X-Session-Key header.
+void HttpResponder::StartWebSocket() noexcept
+{
+	wsSessionKey = GetSessionKey();
+	const char *_ecv_array null const keyParameter = GetKeyValue("sessionKey");
+	if (wsSessionKey == NoSessionKey && keyParameter != nullptr)
+	{
+		wsSessionKey = StrToU32(keyParameter);
+	}
+	if (!RefreshWebSocketSession())
+	{
+		RejectMessage("Not authorized", 401);
+		return;
+	}
+
+	const char *_ecv_array null const upgrade = GetHeaderValue("Upgrade");
+	const char *_ecv_array null const clientKey = GetHeaderValue("Sec-WebSocket-Key");
+	const char *_ecv_array null const version = GetHeaderValue("Sec-WebSocket-Version");
+	if (upgrade == nullptr || !StringEqualsIgnoreCase(upgrade, "websocket") || clientKey == nullptr || version == nullptr || StrToU32(version) != 13)
+	{
+		RejectMessage("bad WebSocket request", 400);
+		return;
+	}
+
+	if (numWebSocketClients >= MaxWebSocketClients)
+	{
+		RejectMessage("too many WebSocket clients", 503);
+		return;
+	}
+
+	String<StringLength50> acceptKey;
+	WebSocket::MakeAcceptKey(clientKey, acceptKey.GetRef());
+	outBuf->copy(	"HTTP/1.1 101 Switching Protocols\r\n"
+					"Upgrade: websocket\r\n"
+					"Connection: Upgrade\r\n"
+				);
+	outBuf->catf("Sec-WebSocket-Accept: %s\r\n", acceptKey.c_str());
+	AddCorsHeader();
+	outBuf->cat("\r\n");
+	if (outBuf->HadOverflow())
+	{
+		OutputBuffer::ReleaseAll(outBuf);
+		ReportOutputBufferExhaustion(__FILE__, __LINE__);
+		return;
+	}
+
+	++numWebSocketClients;
+	isWebSocket = true;
+	wsReader.Reset();
+	modelCursor.Reset();
+	wsModelKey = wsModelFlags = nullptr;
+	wsReplySeq = seq;
+	wsFullModelPending = true;
+	wsCommandRejected = false;
+	wsLastLiveUpdateTime = millis();
+	Commit(ResponderState::webSocket, false);
+	if (reprap.Debug(Module::Webserver))
+	{
+		debugPrintf("WebSocket connection accepted\n");
+	}
+}
+
+// Service a WebSocket connection, returning true if we did anything significant.
+// We process any frames received from the client. Then we push the next update that is due, in this order:
+// the rest of an object model response that we have started, a command rejection, new G-code replies, the whole object model,
+// any section of the object model whose sequence number has changed, and finally the live values at regular intervals.
+// Each client sends one frame at a time, so a slow client doesn't tie up output buffers that other clients need.
+bool HttpResponder::DoWebSocket() noexcept
+{
+	bool readSomething = false;
+	char c;
+	while (skt->ReadChar(c))
+	{
+		readSomething = true;
+		if (wsReader.ProcessByte((uint8_t)c, clientMessage, WebMessageLength))
+		{
+			ProcessWebSocketFrame();
+			if (responderState != ResponderState::webSocket)
+			{
+				return true;							// we are sending a reply or the connection was closed
+			}
+		}
+	}
+
+	if (!skt->CanRead())
+	{
+		ConnectionLost();
+		return true;
+	}
+
+	if (!RefreshWebSocketSession())
+	{
+		// The client has logged out or the session has been removed, so close the connection
+		SendWebSocketFrame(WebSocket::close, true, nullptr, ResponderState::free);
+		return true;
+	}
+
+	if (wsModelKey == nullptr)
+	{
+		if (wsCommandRejected)
+		{
+			OutputBuffer *response;
+			if (OutputBuffer::Allocate(response))
+			{
+				wsCommandRejected = false;
+				response->copy("{\"err\":1}");
+				SendWebSocketFrame(WebSocket::text, true, response);
+				return true;
+			}
+			return readSomething;
+		}
+
+		if (PushGCodeReply())
+		{
+			return true;
+		}
+
+		uint16_t sectionSeq;
+		const char *_ecv_array _ecv_null sectionName;
+		if (wsFullModelPending)
+		{
+			// Record the sequence numbers before we generate the response, so that we push any section that changes while we are sending it
+			for (size_t i = 0; (sectionName = reprap.GetModelSection(i, sectionSeq)) != nullptr; ++i)
+			{
+				wsSectionSeqs[i] = sectionSeq;
+			}
+			wsFullModelPending = false;
+			wsModelKey = "";
+			wsModelFlags = WebSocketModelFlags;
+		}
+		else
+		{
+			for (size_t i = 0; (sectionName = reprap.GetModelSection(i, sectionSeq)) != nullptr; ++i)
+			{
+				if (sectionSeq != wsSectionSeqs[i])
+				{
+					wsSectionSeqs[i] = sectionSeq;
+					wsModelKey = sectionName;
+					wsModelFlags = WebSocketModelFlags;
+					break;
+				}
+			}
+
+			if (wsModelKey == nullptr && millis() - wsLastLiveUpdateTime >= WebSocketLiveUpdateInterval)
+			{
+				wsLastLiveUpdateTime = millis();
+				wsModelKey = "";
+				wsModelFlags = WebSocketLiveFlags;
+			}
+		}
+	}
+
+	return (wsModelKey != nullptr && PushModelFrame()) || readSomething;
+}
+
+// Act on a frame received from the client. Text messages are G-code commands.
+void HttpResponder::ProcessWebSocketFrame() noexcept
+{
+	const size_t length = wsReader.GetStoredLength();
+	switch (wsReader.GetOpcode())
+	{
+	case WebSocket::text:
+		// We only accept commands that arrive in a single frame and fit in our buffer.
+		// We can't reply straight away because we may be part way through sending a fragmented message, so we just remember whether the command was rejected.
+		if (wsReader.IsFinal() && !wsReader.IsTruncated() && length != 0)
+		{
+			clientMessage[length] = 0;
+			if (!reprap.GetGCodes().GetHTTPInput()->Put(HttpMessage, clientMessage))
+			{
+				wsCommandRejected = true;
+			}
+		}
+		break;
+
+	case WebSocket::ping:
+		// Reply with a pong carrying the same data
+		{
+			OutputBuffer *payload = nullptr;
+			if (length != 0 && OutputBuffer::Allocate(payload))
+			{
+				payload->copy(clientMessage, length);
+			}
+			SendWebSocketFrame(WebSocket::pong, true, payload);
+		}
+		break;
+
+	case WebSocket::close:
+		// Echo the status code and close the connection when we have sent it
+		{
+			OutputBuffer *payload = nullptr;
+			if (length >= 2 && OutputBuffer::Allocate(payload))
+			{
+				payload->copy(clientMessage, 2);
+			}
+			SendWebSocketFrame(WebSocket::close, true, payload, ResponderState::free);
+		}
+		break;
+
+	default:
+		// Ignore pongs, binary messages and continuation frames
+		break;
+	}
+}
+
+// Find the HTTP session that the WebSocket belongs to and stop it timing out, returning false if it no longer exists
+bool HttpResponder::RefreshWebSocketSession() noexcept
+{
+	const IPAddress remoteIP = GetRemoteIP();
+	for (size_t i = 0; i < numSessions; i++)
+	{
+		if (sessions[i].ip == remoteIP && sessions[i].key == wsSessionKey)
+		{
+			sessions[i].lastQueryTime = millis();
+			return true;
+		}
+	}
+	return false;
+}
+
+// If there are new G-code replies then send them to the client in a text message of the form {"reply":"..."}, returning true if we did
+bool HttpResponder::PushGCodeReply() noexcept
+{
+	if (wsReplySeq == seq)
+	{
+		return false;
+	}
+
+	OutputBuffer *payload;
+	if (!OutputBuffer::Allocate(payload))
+	{
+		return false;										// try again later
+	}
+
+	OutputStack replies;
+	{
+		MutexLocker lock(gcodeReplyMutex);
+
+		wsReplySeq = seq;
+		if (gcodeReply.IsEmpty())
+		{
+			OutputBuffer::ReleaseAll(payload);
+			return false;
+		}
+
+		// This client counts as having fetched the reply in the same way as a client that uses rr_reply
+		clientsServed++;
+		if (clientsServed < numSessions)
+		{
+			gcodeReply.IncreaseReferences(1);
+			replies.Append(gcodeReply);
+		}
+		else
+		{
+			replies.Append(gcodeReply);
+			gcodeReply.Clear();
+		}
+	}
+
+	payload->copy("{\"reply\":\"");
+	OutputBuffer *buf;
+	while ((buf = replies.Pop()) != nullptr)
+	{
+		do
+		{
+			for (size_t i = 0; i < buf->DataLength(); ++i)
+			{
+				payload->EncodeChar(buf->Data()[i]);
+			}
+			buf = OutputBuffer::Release(buf);
+		} while (buf != nullptr);
+	}
+	payload->cat("\"}");
+
+	if (payload->HadOverflow())
+	{
+		OutputBuffer::ReleaseAll(payload);
+		ReportOutputBufferExhaustion(__FILE__, __LINE__);
+		return false;
+	}
+
+	SendWebSocketFrame(WebSocket::text, true, payload);
+	return true;
+}
+
+// Generate and send the next frame of the object model response we are pushing, returning true if we did anything significant.
+// A response that is too large to generate all at once is sent as a fragmented message, one chunk per frame.
+bool HttpResponder::PushModelFrame() noexcept
+{
+	if (OutputBuffer::GetFreeBuffers() < ObjectModelChunkSize/OUTPUT_BUFFER_SIZE + RESERVED_OUTPUT_BUFFERS + 2)
+	{
+		return false;										// wait until other clients have released some buffers
+	}
+
+	const bool firstFrame = !modelCursor.IsInProgress();
+	OutputBuffer *const payload = reprap.GetModelResponse(nullptr, wsModelKey, wsModelFlags, &modelCursor);
+	if (payload == nullptr)
+	{
+		ReportModelResponseAbandoned(__FILE__, __LINE__);
+		if (!firstFrame)
+		{
+			ConnectionLost();								// we have already sent part of the message, so all we can do is to close the connection
+			return true;
+		}
+
+		// Abandon this update. If it wasn't just the live values then the client may have missed a change, so send the whole object model instead when we can.
+		if (wsModelFlags != WebSocketLiveFlags)
+		{
+			wsFullModelPending = true;
+		}
+		wsModelKey = wsModelFlags = nullptr;
+		return false;
+	}
+
+	const bool isFinal = !modelCursor.IsInProgress();
+	if (isFinal)
+	{
+		wsModelKey = wsModelFlags = nullptr;
+	}
+	SendWebSocketFrame((firstFrame) ? WebSocket::text : WebSocket::continuation, isFinal, payload);
+	return true;
+}
+
+// Send a frame with the payload provided, which may be null. If we run out of buffers then we have to close the connection, because we may have sent part of a message.
+void HttpResponder::SendWebSocketFrame(WebSocket::Opcode opcode, bool isFinal, OutputBuffer *_ecv_null payload, ResponderState nextState) noexcept
+{
+	if (outBuf == nullptr && !OutputBuffer::Allocate(outBuf))
+	{
+		OutputBuffer::ReleaseAll(payload);
+		ReportOutputBufferExhaustion(__FILE__, __LINE__);
+		ConnectionLost();
+		return;
+	}
+
+	WebSocket::AppendFrameHeader(outBuf, opcode, isFinal, (payload == nullptr) ? 0 : payload->Length());
+	if (payload != nullptr)
+	{
+		outBuf->Append(payload);
+	}
+	if (outBuf->HadOverflow())
+	{
+		ReportOutputBufferExhaustion(__FILE__, __LINE__);
+		ConnectionLost();
+		return;
+	}
+
+	if (nextState == ResponderState::free)
+	{
+		EndWebSocket();
+	}
+	Commit(nextState, false);
+}
+
+// Tidy up when a WebSocket connection ends
+void HttpResponder::EndWebSocket() noexcept
+{
+	if (isWebSocket)
+	{
+		isWebSocket = false;
+		--numWebSocketClients;
+		modelCursor.Reset();
+		wsModelKey = wsModelFlags = nullptr;
+	}
+}
+
+#endif
+
 // Process the message received. We have reached the end of the headers.
 void HttpResponder::ProcessMessage() noexcept
 {
@@ -1254,7 +1804,7 @@ void HttpResponder::ProcessRequest() noexcept
 					}
 
 					// Start a new file upload
-					if (!StartUpload(FS_PREFIX, filename, (postFileGotCrc) ? OpenMode::writeWithCrc : OpenMode::write, postFileLength))
+					if (!StartUpload(FS_PREFIX, filename, (postFileGotCrc) ? OpenMode::writeWithCrc : OpenMode::write, postFileLength, true))
 					{
 						RejectMessage("could not create file");
 						return;
@@ -1355,20 +1905,23 @@ void HttpResponder::DoUpload() noexcept
 		do
 		{
 			(void)CheckAuthenticated();						// uploading may take a long time, so make sure the requester IP is not timed out
-			timer = millis();								// reset the timer
 
-			const bool ok = dummyUpload || fileBeingUploaded.Write(buffer, len);
-			skt->Taken(len);
-			uploadedBytes += len;
-
-			if (!ok)
+			const size_t accepted = WriteUploadData(buffer, len);
+			if (uploadError)
 			{
-				uploadError = true;
 				GetPlatform().Message(ErrorMessage, "HTTP: could not write upload data\n");
 				CancelUpload();
 				SendJsonResponse("upload");
 				return;
 			}
+
+			if (accepted == 0)
+			{
+				break;										// all the upload buffers are waiting to be written, so leave the data in the socket for now
+			}
+			timer = millis();								// reset the timer
+			skt->Taken(accepted);
+			uploadedBytes += accepted;
 		} while (skt->ReadBuffer(buffer, len));
 	}
 	else if (!skt->CanRead() || millis() - timer >= HttpSessionTimeout)
@@ -1379,7 +1932,7 @@ void HttpResponder::DoUpload() noexcept
 	}
 
 	// See if the upload has finished
-	if (uploadedBytes >= postFileLength)
+	if (uploadedBytes >= postFileLength && AllUploadDataWritten())
 	{
 		// Reset POST upload state for this client
 		const HttpSessionKey key = GetSessionKey();
@@ -1429,11 +1982,20 @@ void HttpResponder::CancelUpload() noexcept
 	UploadingNetworkResponder::CancelUpload();
 }
 
+// This overrides the version in class UploadingNetworkResponder
+void HttpResponder::ConnectionLost() noexcept
+{
+#if SUPPORT_OBJECT_MODEL
+	EndWebSocket();
+#endif
+	UploadingNetworkResponder::ConnectionLost();
+}
+
 // This overrides the version in class NetworkResponder
 void HttpResponder::SendData() noexcept
 {
 	NetworkResponder::SendData();
-	if (responderState == ResponderState::reading)
+	if (responderState == ResponderState::reading || responderState == ResponderState::streamingModel)
 	{
 		timer = millis();				// restart the timer
 	}
@@ -1584,6 +2146,9 @@ void HttpResponder::Diagnostics(MessageType mt) const noexcept
 /*static*/ void HttpResponder::CommonDiagnostics(MessageType mtype) noexcept
 {
 	GetPlatform().MessageF(mtype, "HTTP sessions: %u of %u\n", numSessions, MaxHttpSessions);
+#if SUPPORT_OBJECT_MODEL
+	GetPlatform().MessageF(mtype, "WebSocket clients: %u of %u\n", numWebSocketClients, MaxWebSocketClients);
+#endif
 }
 
 void HttpResponder::AddCorsHeader() noexcept
@@ -1599,6 +2164,9 @@ void HttpResponder::AddCorsHeader() noexcept
 HttpResponder::HttpSession HttpResponder::sessions[MaxHttpSessions];
 unsigned int HttpResponder::numSessions = 0;
 unsigned int HttpResponder::clientsServed = 0;
+#if SUPPORT_OBJECT_MODEL
+unsigned int HttpResponder::numWebSocketClients = 0;
+#endif
 
 volatile uint16_t HttpResponder::seq = 0;
 volatile OutputStack HttpResponder::gcodeReply;
@@ -9,12 +9,20 @@
 #define SRC_NETWORKING_HTTPRESPONDER_H_
 
 #include "UploadingNetworkResponder.h"
+#include "WebSocket.h"
+#include <Platform/Tasks.h>
 
 typedef unsigned int HttpSessionKey;
 
 class HttpResponder : public UploadingNetworkResponder
 {
 public:
+	// HTTP responders are never deleted, so they come from the permanent memory pool like the network buffers
+	void* operator new(size_t count) noexcept { return Tasks::AllocPermanent(count, MemoryTag::network); }
+	void* operator new(size_t count, std::align_val_t align) noexcept { return Tasks::AllocPermanent(count, MemoryTag::network, align); }
+	void operator delete(void* ptr) noexcept {}
+	void operator delete(void* ptr, std::align_val_t align) noexcept {}
+
 	HttpResponder(NetworkResponder *n) noexcept;
 	bool Spin() noexcept override;								// do some work, returning true if we did anything significant
 	bool Accept(Socket *s, NetworkProtocol protocol) noexcept override;	// ask the responder to accept this connection, returns true if it did
@@ -33,6 +41,7 @@ public:
 protected:
 	void CancelUpload() noexcept override;
 	void SendData() noexcept override;
+	void ConnectionLost() noexcept override;
 
 private:
 	static const size_t MaxHttpSessions = 8;			// maximum number of simultaneous HTTP sessions
@@ -43,6 +52,8 @@ private:
 	static const uint32_t HttpSessionTimeout = 8000;	// HTTP session timeout in milliseconds
 	static const uint32_t MaxFileInfoGetTime = 2000;	// maximum length of time we spend getting file info, to avoid the client timing out (actual time will be a little longer than this)
 	static const uint32_t MaxBufferWaitTime = 1000;		// maximum length of time we spend waiting for a buffer before we discard gcodeReply buffers
+	static const size_t MaxWebSocketClients = 2;		// maximum number of simultaneous WebSocket connections, so that they can't tie up all the HTTP responders
+	static const uint32_t WebSocketLiveUpdateInterval = 250;	// how often we push the frequently-changing object model values to WebSocket clients in milliseconds
 
 	enum class HttpParseState
 	{
@@ -83,6 +94,9 @@ private:
 
 	bool CharFromClient(char c) noexcept;
 	void SendFile(const char *_ecv_array nameOfFileToSend, bool isWebFile) noexcept;
+#if HAS_MASS_STORAGE
+	void AddWebFileCacheHeaders(const char *_ecv_array fileName, const char *_ecv_array eTag, time_t lastModified) noexcept;
+#endif
 	void SendGCodeReply() noexcept;
 	void SendJsonResponse(const char *_ecv_array command) noexcept;
 	bool GetJsonResponse(const char *_ecv_array request, OutputBuffer *&response, bool& keepOpen) noexcept;
@@ -90,6 +104,20 @@ private:
 	void ProcessRequest() noexcept;
 	void RejectMessage(const char *_ecv_array s, unsigned int code = 500) noexcept;
 	bool SendFileInfo(bool quitEarly) noexcept;
+#if SUPPORT_OBJECT_MODEL
+	bool SendNextModelChunk() noexcept;
+	void AppendModelChunk(OutputBuffer *chunk) noexcept;
+	void ReportModelResponseAbandoned(const char *sourceFile, int line) noexcept;
+
+	void StartWebSocket() noexcept;
+	bool DoWebSocket() noexcept;
+	void ProcessWebSocketFrame() noexcept;
+	bool RefreshWebSocketSession() noexcept;
+	bool PushGCodeReply() noexcept;
+	bool PushModelFrame() noexcept;
+	void SendWebSocketFrame(WebSocket::Opcode opcode, bool isFinal, OutputBuffer *_ecv_null payload, ResponderState nextState = ResponderState::webSocket) noexcept;
+	void EndWebSocket() noexcept;
+#endif
 	void AddCorsHeader() noexcept;
 
 #if HAS_MASS_STORAGE
@@ -121,6 +149,24 @@ private:
 	uint32_t startedProcessingRequestAt;			// when we started processing the current HTTP request
 	// rr_fileinfo also uses fileBeingProcessed in the networkResponder class
 
+#if SUPPORT_OBJECT_MODEL
+	// rr_model requests whose response is too large to generate all at once
+	ObjectModelCursor modelCursor;					// where we got to in generating the response
+	bool modelKeepOpen;								// whether to keep the connection open when we have sent the last chunk
+
+	// WebSocket connections, which receive object model updates and G-code replies without polling
+	WebSocketFrameReader wsReader;
+	const char *_ecv_array wsModelKey;				// the key of the object model response we are pushing, which may take several frames
+	const char *_ecv_array wsModelFlags;			// the flags of the object model response we are pushing
+	uint32_t wsLastLiveUpdateTime;					// when we last pushed the live values
+	HttpSessionKey wsSessionKey;					// the key of the HTTP session that the WebSocket belongs to
+	uint16_t wsReplySeq;							// the G-code reply sequence number when we last sent the replies
+	uint16_t wsSectionSeqs[RepRap::MaxModelSections];	// the sequence numbers of the object model sections when we last pushed them
+	bool isWebSocket;
+	bool wsFullModelPending;						// true if we need to push the whole object model to this client
+	bool wsCommandRejected;							// true if we need to tell the client that we couldn't accept a command
+#endif
+
 	uint32_t postFileLength;
 	uint32_t postFileExpectedCrc;
 	time_t fileLastModified;
@@ -130,6 +176,9 @@ private:
 	static HttpSession sessions[MaxHttpSessions];
 	static unsigned int numSessions;
 	static unsigned int clientsServed;
+#if SUPPORT_OBJECT_MODEL
+	static unsigned int numWebSocketClients;
+#endif
 
 	// Responses from GCodes class
 	static volatile uint16_t seq;					// Sequence number for G-Code replies
@@ -149,7 +149,7 @@
  * (requires the LWIP_TCP option)
  */
 #if defined(__SAME70Q20B__) || defined(__SAME70Q21B__) || defined(__SAMV71Q20B__) || defined(__SAMV71Q21B__)
-# define MEMP_NUM_TCP_SEG				10
+# define MEMP_NUM_TCP_SEG				16
 #else
 # define MEMP_NUM_TCP_SEG				8
 #endif
@@ -173,8 +173,13 @@
  * MEMP_NUM_PBUF: the number of memp struct pbufs (used for PBUF_ROM and PBUF_REF).
  * If the application sends a lot of data out of ROM (or other static memory),
  * this should be set high.
+ * We send file data by reference, so each TCP segment of file data queued or awaiting acknowledgement uses one of these.
  */
-#define MEMP_NUM_PBUF                   4
+#if defined(__SAME70Q20B__) || defined(__SAME70Q21B__) || defined(__SAMV71Q20B__) || defined(__SAMV71Q21B__)
+# define MEMP_NUM_PBUF                  16
+#else
+# define MEMP_NUM_PBUF                  4
+#endif
 
 /**
  * MEMP_NUM_NETBUF: the number of struct netbufs.
@@ -267,8 +272,13 @@ extern uint32_t random32(void) noexcept;
 /**
  * TCP_SND_BUF: TCP sender buffer space (bytes).
  * To achieve good performance, this should be at least 2 * TCP_MSS.
+ * Data is not copied into this space because we pass buffers to tcp_write by reference, so on the SAME70 we allow more to be in flight.
  */
-#define TCP_SND_BUF             (2 * TCP_MSS)
+#if defined(__SAME70Q20B__) || defined(__SAME70Q21B__) || defined(__SAMV71Q20B__) || defined(__SAMV71Q21B__)
+# define TCP_SND_BUF            (4 * TCP_MSS)
+#else
+# define TCP_SND_BUF            (2 * TCP_MSS)
+#endif
 
 /**
  * TCP_SND_QUEUELEN: TCP sender buffer space (pbufs). This must be at least
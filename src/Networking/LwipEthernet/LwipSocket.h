@@ -48,6 +48,7 @@ public:
 	bool CanSend() const noexcept override;
 	size_t Send(const uint8_t *data, size_t length) noexcept override;
 	void Send() noexcept override { }
+	size_t GetUnacknowledgedLength() const noexcept override { return unAcked; }
 
 private:
 	enum class SocketState : uint8_t
@@ -12,9 +12,43 @@
 #include <Networking/Network.h>
 #include <GCodes/GCodeBuffer/GCodeBuffer.h>
 #include <Socket.h>
+#include <Storage/CRC32.h>
 
 #include "mqtt.h"
 
+// Object model flags used for telemetry values unless the F parameter is given
+static const char *const DefaultTelemetryFlags = "d99v";
+
+// Make a copy of a string on the heap
+static char *CopyString(const char *s) noexcept
+{
+	const size_t sz = strlen(s) + 1;
+	char *const copy = new char[sz];
+	SafeStrncpy(copy, s, sz);
+	return copy;
+}
+
+// Copy part of the data in an OutputBuffer chain to a contiguous buffer
+static void CopyFromChain(const OutputBuffer *buf, size_t offset, size_t length, char *dest) noexcept
+{
+	while (buf != nullptr && length != 0)
+	{
+		if (offset >= buf->DataLength())
+		{
+			offset -= buf->DataLength();
+		}
+		else
+		{
+			const size_t bytesToCopy = std::min(buf->DataLength() - offset, length);
+			memcpy(dest, buf->Data() + offset, bytesToCopy);
+			dest += bytesToCopy;
+			length -= bytesToCopy;
+			offset = 0;
+		}
+		buf = buf->Next();
+	}
+}
+
 MqttClient::MqttClient(NetworkResponder *n, NetworkClient *c) noexcept
 	: NetworkClient(n, c),
 	  prevSub(nullptr), currSub(nullptr), currBuf(nullptr), messageTimer(0), next(clients)
@@ -155,17 +189,10 @@ bool MqttClient::Spin() noexcept
 
 					if (currBuf)
 					{
-						uint8_t flags = 0;
-
 						// If not specified, publish under the hostname
 						const char *const topic = publishTopic ? publishTopic : reprap.GetNetwork().GetHostname();
 
-						flags |= (publishQos == 0) ? MQTT_PUBLISH_QOS_0 :
-									(publishQos == 1 ? MQTT_PUBLISH_QOS_1 : MQTT_PUBLISH_QOS_2);
-						flags |= (retain) ? MQTT_PUBLISH_RETAIN : 0;
-						flags |= (duplicate) ? MQTT_PUBLISH_DUP : 0;
-
-						const MQTTErrors mqttErr = mqtt_publish(&client, topic, currBuf->Data(), currBuf->DataLength(), flags);
+						const MQTTErrors mqttErr = mqtt_publish(&client, topic, currBuf->Data(), currBuf->DataLength(), GetPublishFlags(publishQos, retain, duplicate));
 						if (mqttErr == MQTT_ERROR_SEND_BUFFER_IS_FULL)
 						{
 							currBuf = nullptr; // retry to publish the same buffer on the next loop
@@ -176,6 +203,11 @@ bool MqttClient::Spin() noexcept
 						}
 					}
 				}
+
+				if (PublishTelemetry())
+				{
+					res = true;
+				}
 				break;
 
 			case ResponderState::disconnecting:
@@ -266,6 +298,13 @@ void MqttClient::ConnectionLost() noexcept
 
 /* static */ GCodeResult MqttClient::Configure(GCodeBuffer &gb, const StringRef& reply) THROWS(GCodeException)
 {
+	// Listing the published values doesn't change anything, so allow it while MQTT is active
+	if (!gb.SeenAny("UCWSPBO"))
+	{
+		ListTelemetry(reply);
+		return GCodeResult::ok;
+	}
+
 	// Since the config is shared, make sure the protocol is not active on any interface.
 	for (MqttClient *c = clients; c != nullptr; c = c->next)
 	{
@@ -491,9 +530,337 @@ void MqttClient::ConnectionLost() noexcept
 		}
 	}
 
+	if (gb.Seen('B')) // Topic for batched telemetry
+	{
+		gb.GetQuotedString(param.GetRef(), true);
+		if (param.IsEmpty())
+		{
+			clearMemb(batchTopic);
+		}
+		else if (!setMemb(batchTopic))
+		{
+			return GCodeResult::error;
+		}
+	}
+
+	if (gb.Seen('O')) // Object model value to publish
+	{
+		return ConfigureTelemetry(gb, reply);
+	}
+
 	return GCodeResult::ok;
 }
 
+// Add, change or remove an object model value to publish. The O parameter has been seen.
+//  O"key"		object model key
+//  A"topic"	topic to publish on, default <hostname>/<key>
+//  F"flags"	object model flags, default "d99v"
+//  L<ms>		minimum interval between publications, default 1000. L0 removes the value.
+//  V<qos>		QOS to publish with. This isn't Q, because Q sets the QOS of the S and P parameters.
+//  E<0|1>		E1 (default) publishes the value only when it has changed, E0 publishes it every interval
+/* static */ GCodeResult MqttClient::ConfigureTelemetry(GCodeBuffer &gb, const StringRef& reply) THROWS(GCodeException)
+{
+	String<MaxGCodeLength> key;
+	gb.GetQuotedString(key.GetRef());
+
+	TelemetryItem **pp = &telemetry;
+	while (*pp != nullptr && strcmp((*pp)->key, key.c_str()) != 0)
+	{
+		pp = &(*pp)->next;
+	}
+	TelemetryItem *item = *pp;
+
+	bool seen = false;
+	uint32_t interval = (item != nullptr) ? item->interval : DefaultTelemetryInterval;
+	gb.TryGetUIValue('L', interval, seen);
+	if (interval == 0)
+	{
+		if (item != nullptr)
+		{
+			*pp = item->next;
+			delete[] item->key;
+			delete[] item->flags;
+			delete[] item->topic;
+			delete item;
+		}
+		return GCodeResult::ok;
+	}
+
+	uint8_t qos = (item != nullptr) ? item->qos : 0;
+	if (gb.Seen('V'))
+	{
+		const int q = gb.GetIValue();
+		if (q < 0 || q > 2)
+		{
+			reply.copy("Invalid telemetry QOS");
+			return GCodeResult::badOrMissingParameter;
+		}
+		qos = q;
+	}
+
+	if (telemetryBuffer == nullptr)
+	{
+		telemetryBuffer = new char[MaxTelemetryMessageLength];
+	}
+
+	if (item == nullptr)
+	{
+		// Append new items so that they are published in the order they were configured
+		item = new TelemetryItem;
+		item->next = nullptr;
+		item->key = CopyString(key.c_str());
+		item->flags = CopyString(DefaultTelemetryFlags);
+		item->topic = nullptr;
+		item->onChangeOnly = true;
+		item->inBatch = false;
+		*pp = item;
+	}
+
+	String<MaxGCodeLength> param;
+	if (gb.Seen('F'))
+	{
+		gb.GetQuotedString(param.GetRef(), true);
+		delete[] item->flags;
+		item->flags = CopyString(param.c_str());
+	}
+
+	if (gb.Seen('A'))
+	{
+		gb.GetQuotedString(param.GetRef(), true);
+		delete[] item->topic;
+		item->topic = (param.IsEmpty()) ? nullptr : CopyString(param.c_str());
+	}
+
+	if (gb.Seen('E'))
+	{
+		item->onChangeOnly = (gb.GetIValue() != 0);
+	}
+
+	item->interval = interval;
+	item->qos = qos;
+	item->published = false;						// publish the value as soon as we are connected
+	item->lastPolled = millis() - interval;
+
+	if (reprap.Debug(Module::Webserver))
+	{
+		debugPrintf("MQTT publishing '%s' with flags '%s' every %" PRIu32 "ms\n", item->key, item->flags, item->interval);
+	}
+	return GCodeResult::ok;
+}
+
+/* static */ void MqttClient::ListTelemetry(const StringRef& reply) noexcept
+{
+	if (telemetry == nullptr)
+	{
+		reply.copy("No object model values are published");
+		return;
+	}
+
+	reply.copy("Publishing object model values");
+	if (batchTopic != nullptr)
+	{
+		reply.catf(" on topic %s", batchTopic);
+	}
+	reply.cat(':');
+	for (const TelemetryItem *item = telemetry; item != nullptr; item = item->next)
+	{
+		reply.catf("\n%s flags %s, ", item->key, item->flags);
+		if (batchTopic == nullptr)
+		{
+			if (item->topic != nullptr)
+			{
+				reply.catf("topic %s, ", item->topic);
+			}
+			else
+			{
+				reply.catf("topic %s/%s, ", reprap.GetNetwork().GetHostname(), item->key);
+			}
+		}
+		reply.catf("%s %" PRIu32 "ms, QOS %u", (item->onChangeOnly) ? "on change at most every" : "every", item->interval, item->qos);
+	}
+}
+
+// Serialise and publish the object model values that are due, returning true if we did anything significant.
+// Each value is serialised once and published to all active clients, so this does nothing when called by the other clients soon afterwards.
+// If a value can't be published because a client's send buffer is full then we try again when it is next due.
+/* static */ bool MqttClient::PublishTelemetry() noexcept
+{
+	bool didSomething = false;
+	TelemetryBatch batch(telemetryBuffer, MaxTelemetryMessageLength);
+	const uint32_t now = millis();
+	for (TelemetryItem *item = telemetry; item != nullptr; item = item->next)
+	{
+		if (now - item->lastPolled < item->interval)
+		{
+			continue;
+		}
+		item->lastPolled = now;
+		didSomething = true;
+
+		OutputBuffer *response;
+		try
+		{
+			response = reprap.GetModelResponse(nullptr, item->key, item->flags);
+		}
+		catch (const GCodeException&)
+		{
+			response = nullptr;
+		}
+
+		// The response is {"key":"<key>","flags":"<flags>","result":<value>} followed by newline, and we publish just the value
+		const size_t keyLength = strlen(item->key);
+		const size_t prefixLength = strlen("{\"key\":\"\",\"flags\":\"\",\"result\":") + keyLength + strlen(item->flags);
+		const size_t totalLength = (response == nullptr) ? 0 : response->Length();
+		if (totalLength < prefixLength + 2)
+		{
+			OutputBuffer::ReleaseAll(response);
+			++telemetryDropped;
+			continue;
+		}
+		const size_t valueLength = totalLength - prefixLength - 2;
+
+		if (batchTopic != nullptr)
+		{
+			// Add "key":value to the batch, starting a new batch if it won't fit
+			const size_t entryLength = TelemetryBatch::EntryLength(keyLength, valueLength);
+			if (!batch.Fits(entryLength))
+			{
+				if (!batch.IsEmpty())
+				{
+					(void)FlushTelemetryBatch(batch);
+				}
+				batch.Clear();
+				if (!batch.Fits(entryLength))
+				{
+					OutputBuffer::ReleaseAll(response);
+					++telemetryDropped;
+					continue;
+				}
+			}
+
+			char *const value = batch.StartEntry(item->key, keyLength);
+			CopyFromChain(response, prefixLength, valueLength, value);
+			OutputBuffer::ReleaseAll(response);
+
+			CRC32 crc;
+			crc.Update(value, valueLength);
+			if (item->onChangeOnly && item->published && crc.Get() == item->lastCrc)
+			{
+				++telemetryUnchanged;
+				continue;
+			}
+			batch.CommitEntry(entryLength, item->qos);
+			item->lastCrc = crc.Get();
+			item->published = true;
+			item->inBatch = true;
+		}
+		else
+		{
+			if (valueLength > MaxTelemetryMessageLength)
+			{
+				OutputBuffer::ReleaseAll(response);
+				++telemetryDropped;
+				continue;
+			}
+
+			CopyFromChain(response, prefixLength, valueLength, telemetryBuffer);
+			OutputBuffer::ReleaseAll(response);
+
+			CRC32 crc;
+			crc.Update(telemetryBuffer, valueLength);
+			if (item->onChangeOnly && item->published && crc.Get() == item->lastCrc)
+			{
+				++telemetryUnchanged;
+				continue;
+			}
+
+			String<MaxGCodeLength> defaultTopic;
+			if (item->topic == nullptr)
+			{
+				defaultTopic.printf("%s/%s", reprap.GetNetwork().GetHostname(), item->key);
+			}
+			item->published = PublishToAll((item->topic != nullptr) ? item->topic : defaultTopic.c_str(), telemetryBuffer, valueLength, item->qos);
+			if (item->published)
+			{
+				item->lastCrc = crc.Get();
+				++telemetryPublished;
+			}
+			else
+			{
+				++telemetryDropped;
+			}
+		}
+	}
+
+	if (!batch.IsEmpty())									// don't publish an empty batch if none of the values had changed
+	{
+		(void)FlushTelemetryBatch(batch);
+	}
+	return didSomething;
+}
+
+// Publish a batch of telemetry values, which must not be empty. Return true if successful.
+/* static */ bool MqttClient::FlushTelemetryBatch(TelemetryBatch& batch) noexcept
+{
+	const size_t length = batch.Finish();
+	const bool ok = PublishToAll(batchTopic, batch.GetData(), length, batch.GetQos());
+	if (ok)
+	{
+		++telemetryBatches;
+	}
+	for (TelemetryItem *item = telemetry; item != nullptr; item = item->next)
+	{
+		if (item->inBatch)
+		{
+			item->inBatch = false;
+			if (ok)
+			{
+				++telemetryPublished;
+			}
+			else
+			{
+				item->published = false;			// so that we publish it again next time even if it hasn't changed
+				++telemetryDropped;
+			}
+		}
+	}
+	return ok;
+}
+
+// Publish a message on all active clients, returning true if all of them accepted it
+/* static */ bool MqttClient::PublishToAll(const char *topic, const char *msg, size_t length, uint8_t qos) noexcept
+{
+	bool ok = true;
+	for (MqttClient *c = clients; c != nullptr; c = c->next)
+	{
+		if (c->responderState == ResponderState::active && mqtt_publish(&c->client, topic, msg, length, GetPublishFlags(qos, false, false)) != MQTT_OK)
+		{
+			ok = false;
+		}
+	}
+	return ok;
+}
+
+/* static */ uint8_t MqttClient::GetPublishFlags(uint8_t qos, bool retain, bool duplicate) noexcept
+{
+	uint8_t flags = (qos == 0) ? MQTT_PUBLISH_QOS_0 : (qos == 1) ? MQTT_PUBLISH_QOS_1 : MQTT_PUBLISH_QOS_2;
+	flags |= (retain) ? MQTT_PUBLISH_RETAIN : 0;
+	flags |= (duplicate) ? MQTT_PUBLISH_DUP : 0;
+	return flags;
+}
+
+/* static */ void MqttClient::CommonDiagnostics(MessageType mtype) noexcept
+{
+	size_t numItems = 0;
+	for (const TelemetryItem *item = telemetry; item != nullptr; item = item->next)
+	{
+		++numItems;
+	}
+	GetPlatform().MessageF(mtype, "MQTT telemetry: %u values, published %" PRIu32 ", unchanged %" PRIu32 ", dropped %" PRIu32 ", batches %" PRIu32 "\n",
+							numItems, telemetryPublished, telemetryUnchanged, telemetryDropped, telemetryBatches);
+	telemetryPublished = telemetryUnchanged = telemetryDropped = telemetryBatches = 0;
+}
+
 /* static */void MqttClient::Disable() noexcept
 {
 	// Nothing needed here
@@ -551,6 +918,14 @@ bool MqttClient::duplicate = false;
 bool MqttClient::retain = false;
 
 MqttClient::Subscription *MqttClient::subs = nullptr;
+
+MqttClient::TelemetryItem *MqttClient::telemetry = nullptr;
+char *MqttClient::telemetryBuffer = nullptr;
+char *MqttClient::batchTopic = nullptr;
+uint32_t MqttClient::telemetryPublished = 0;
+uint32_t MqttClient::telemetryUnchanged = 0;
+uint32_t MqttClient::telemetryDropped = 0;
+uint32_t MqttClient::telemetryBatches = 0;
 MqttClient *MqttClient::clients = nullptr;
 
 #endif
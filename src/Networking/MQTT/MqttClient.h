@@ -13,6 +13,7 @@
 
 #include "mqtt.h"
 #include "NetworkClient.h"
+#include "TelemetryBatch.h"
 #include "General/StringFunctions.h"
 
 class MqttClient : public NetworkClient
@@ -30,6 +31,7 @@ public:
 	static GCodeResult Configure(GCodeBuffer &gb, const StringRef& reply) THROWS(GCodeException);
 	static void Disable() noexcept;
 	static void Publish(const char *msg) noexcept;
+	static void CommonDiagnostics(MessageType mtype) noexcept;
 
 private:
 	static const int SendBufferSize = 2048;
@@ -37,6 +39,8 @@ private:
 	static const size_t DefaultKeepAlive = 400;
 	static const size_t MessageTimeout = 5000;
 	static const size_t ReconnectCooldown = 1000;
+	static const uint32_t DefaultTelemetryInterval = 1000;			// default minimum interval between publications of an object model value in milliseconds
+	static const size_t MaxTelemetryMessageLength = SendBufferSize - 256;	// must leave room in the send buffer for the topic and the packet header
 
 	struct Subscription
 	{
@@ -50,11 +54,34 @@ private:
 		struct Subscription *next;
 	};
 
+	// Object model values that we publish periodically, configured using M586.4 O"key"
+	struct TelemetryItem
+	{
+		TelemetryItem *next;
+		char *key;						// object model key
+		char *flags;					// object model flags
+		char *topic;					// topic to publish on, or null to publish on <hostname>/<key>
+		uint32_t interval;				// minimum interval between publications in milliseconds
+		uint32_t lastPolled;			// when we last serialised the value
+		uint32_t lastCrc;				// CRC of the value we last published
+		uint8_t qos;
+		bool onChangeOnly;				// true to publish only when the value has changed
+		bool published;					// true if lastCrc is valid
+		bool inBatch;					// true if the value is in the batch we are building
+	};
+
 	bool Start() noexcept override;
 	void Stop() noexcept override;
 	void ConnectionLost() noexcept override;
 	static void PublishCallback(void** state, struct mqtt_response_publish *published);
 
+	static GCodeResult ConfigureTelemetry(GCodeBuffer &gb, const StringRef& reply) THROWS(GCodeException);
+	static void ListTelemetry(const StringRef& reply) noexcept;
+	static bool PublishTelemetry() noexcept;
+	static bool PublishToAll(const char *topic, const char *msg, size_t length, uint8_t qos) noexcept;
+	static bool FlushTelemetryBatch(TelemetryBatch& batch) noexcept;
+	static uint8_t GetPublishFlags(uint8_t qos, bool retain, bool duplicate) noexcept;
+
 	mqtt_client client;
 	uint8_t sendBuf[SendBufferSize];
 	uint8_t recvBuf[ReceiveBufferSize];
@@ -82,6 +109,15 @@ private:
 	static bool retain;
 	static Subscription *subs;
 
+	// Object model telemetry, shared by all MqttClient's
+	static TelemetryItem *telemetry;
+	static char *telemetryBuffer;			// holds the message we are publishing, allocated when the first telemetry item is configured
+	static char *batchTopic;				// if not null, all telemetry values that are due are published together on this topic
+	static uint32_t telemetryPublished;
+	static uint32_t telemetryUnchanged;
+	static uint32_t telemetryDropped;
+	static uint32_t telemetryBatches;
+
 	static MqttClient *clients; // List of all MQTT clients
 };
 
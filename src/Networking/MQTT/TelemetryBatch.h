@@ -0,0 +1,75 @@
+/*
+ * TelemetryBatch.h
+ *
+ * Assembles object model values into a single JSON object {"key":value,...} so that they can be published as one MQTT message.
+ * This has no dependencies on the rest of the firmware so that it can be tested on the host, see Scripts/HostTests.
+ */
+#ifndef SRC_NETWORKING_MQTT_TELEMETRYBATCH_H_
+#define SRC_NETWORKING_MQTT_TELEMETRYBATCH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+class TelemetryBatch
+{
+public:
+	TelemetryBatch(char *buf, size_t size) noexcept : buffer(buf), capacity(size), length(0), qos(0) { }
+
+	// Return the number of bytes that a value of the specified length needs, including its key and separator
+	static size_t EntryLength(size_t keyLength, size_t valueLength) noexcept { return keyLength + 3 + valueLength + 1; }
+
+	// Return true if no values have been committed since the batch was last cleared, in which case there is nothing to publish
+	bool IsEmpty() const noexcept { return length <= 1; }
+
+	// Return true if an entry of the specified length fits in the space left
+	bool Fits(size_t entryLength) const noexcept { return ((length == 0) ? 1 : length) + entryLength <= capacity; }
+
+	// Write "key": to the batch and return where the value must be written. Call only if Fits returned true.
+	// The entry is not part of the batch until CommitEntry is called, so it can be abandoned e.g. if the value hasn't changed.
+	char *StartEntry(const char *key, size_t keyLength) noexcept
+	{
+		if (length == 0)
+		{
+			buffer[0] = '{';
+			length = 1;
+		}
+		char *const entry = buffer + length;
+		entry[0] = '"';
+		memcpy(entry + 1, key, keyLength);
+		entry[keyLength + 1] = '"';
+		entry[keyLength + 2] = ':';
+		return entry + keyLength + 3;
+	}
+
+	// Add the entry started by the last call to StartEntry to the batch
+	void CommitEntry(size_t entryLength, uint8_t entryQos) noexcept
+	{
+		length += entryLength;
+		buffer[length - 1] = ',';
+		if (entryQos > qos)
+		{
+			qos = entryQos;
+		}
+	}
+
+	// Terminate the JSON object and return its length. Call only if IsEmpty returned false.
+	size_t Finish() noexcept
+	{
+		buffer[length - 1] = '}';
+		return length;
+	}
+
+	void Clear() noexcept { length = 0; qos = 0; }
+
+	const char *GetData() const noexcept { return buffer; }
+	uint8_t GetQos() const noexcept { return qos; }
+
+private:
+	char *buffer;
+	size_t capacity;
+	size_t length;
+	uint8_t qos;
+};
+
+#endif /* SRC_NETWORKING_MQTT_TELEMETRYBATCH_H_ */
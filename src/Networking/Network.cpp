@@ -454,8 +454,10 @@ extern "C" [[noreturn]]void NetworkLoop(void *) noexcept
 void Network::Activate() noexcept
 {
 #if HAS_NETWORKING
+	activated = true;
+
 	// Allocate network buffers
-	NetworkBuffer::AllocateBuffers(NetworkBufferCount);
+	NetworkBuffer::AllocateBuffers(numNetworkBuffers);
 
 	// Activate the interfaces
 	for (NetworkInterface *iface : interfaces)
@@ -482,7 +484,7 @@ void Network::Activate() noexcept
 # endif
 
 # if SUPPORT_HTTP
-	for (size_t i = 0; i < NumHttpResponders; ++i)
+	for (size_t i = 0; i < numHttpResponders; ++i)
 	{
 		responders = new HttpResponder(responders);
 	}
@@ -645,6 +647,14 @@ void Network::Diagnostics(MessageType mtype) noexcept
 	HttpResponder::CommonDiagnostics(mtype);
 #endif
 
+#if (SUPPORT_HTTP || SUPPORT_FTP) && HAS_MASS_STORAGE
+	UploadingNetworkResponder::CommonDiagnostics(mtype);
+#endif
+
+#if SUPPORT_MQTT
+	MqttClient::CommonDiagnostics(mtype);
+#endif
+
 	for (NetworkInterface *iface : interfaces)
 	{
 		if (iface != nullptr)
@@ -877,4 +887,30 @@ uint32_t Network::GetHttpReplySeq() noexcept
 #endif
 }
 
+#if HAS_NETWORKING
+
+// Return how much more memory the network pools would take if they had the new sizes. The result is negative if they would take less.
+// Both pools come from the permanent memory pool, which has no per-allocation header but aligns each allocation to the default new alignment.
+ptrdiff_t Network::GetPoolMemoryChange(unsigned int newNumNetworkBuffers, unsigned int newNumHttpResponders) const noexcept
+{
+	constexpr size_t AllocAlignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+	constexpr size_t NetworkBufferAllocSize = (sizeof(NetworkBuffer) + AllocAlignment - 1) & ~(AllocAlignment - 1);
+	ptrdiff_t change = ((ptrdiff_t)newNumNetworkBuffers - (ptrdiff_t)numNetworkBuffers) * (ptrdiff_t)NetworkBufferAllocSize;
+# if SUPPORT_HTTP
+	constexpr size_t HttpResponderAllocSize = (sizeof(HttpResponder) + AllocAlignment - 1) & ~(AllocAlignment - 1);
+	change += ((ptrdiff_t)newNumHttpResponders - (ptrdiff_t)numHttpResponders) * (ptrdiff_t)HttpResponderAllocSize;
+# endif
+	return change;
+}
+
+void Network::SetPoolSizes(unsigned int newNumNetworkBuffers, unsigned int newNumHttpResponders) noexcept
+{
+	numNetworkBuffers = newNumNetworkBuffers;
+# if SUPPORT_HTTP
+	numHttpResponders = newNumHttpResponders;
+# endif
+}
+
+#endif
+
 // End
@@ -34,6 +34,7 @@ const size_t NumMqttClients = 1; 		// the number of concurrent MQTT clients
 #endif // not SAME70
 
 const size_t NumFtpResponders = 1;		// the number of concurrent FTP sessions we support
+const size_t MaxHttpResponders = 16;	// the most HTTP responders that M590 may ask for
 
 #define HAS_RESPONDERS	(SUPPORT_HTTP || SUPPORT_FTP || SUPPORT_TELNET)
 
@@ -124,6 +125,15 @@ public:
 
 	uint32_t GetHttpReplySeq() noexcept;
 
+#if HAS_NETWORKING
+	// Pool sizes. These can only be changed before the network is activated at the end of config.g.
+	bool IsActivated() const noexcept { return activated; }
+	unsigned int GetNumNetworkBuffers() const noexcept { return numNetworkBuffers; }
+	unsigned int GetNumHttpResponders() const noexcept { return numHttpResponders; }
+	ptrdiff_t GetPoolMemoryChange(unsigned int newNumNetworkBuffers, unsigned int newNumHttpResponders) const noexcept;
+	void SetPoolSizes(unsigned int newNumNetworkBuffers, unsigned int newNumHttpResponders) noexcept;
+#endif
+
 protected:
 	DECLARE_OBJECT_MODEL_WITH_ARRAYS
 
@@ -134,6 +144,13 @@ private:
 
 #if HAS_NETWORKING
 	NetworkInterface *interfaces[MaxNetworkInterfaces];
+	unsigned int numNetworkBuffers = NetworkBufferCount;
+# if SUPPORT_HTTP
+	unsigned int numHttpResponders = NumHttpResponders;
+# else
+	unsigned int numHttpResponders = 0;
+# endif
+	bool activated = false;
 #endif
 
 #if HAS_RESPONDERS
@@ -10,6 +10,7 @@
 
 #include "RepRapFirmware.h"
 #include "NetworkDefs.h"
+#include <Platform/Tasks.h>
 
 class WiFiSocket;
 class W5500Socket;
@@ -23,6 +24,11 @@ public:
 	friend class W5500Socket;
 	friend class RTOSPlusTCPEthernetSocket;
 
+	void* operator new(size_t count) noexcept { return Tasks::AllocPermanent(count, MemoryTag::network); }
+	void* operator new(size_t count, std::align_val_t align) noexcept { return Tasks::AllocPermanent(count, MemoryTag::network, align); }
+	void operator delete(void* ptr) noexcept {}
+	void operator delete(void* ptr, std::align_val_t align) noexcept {}
+
 	// Release this buffer and return the next one in the chain
 	NetworkBuffer *Release() noexcept;
 
@@ -37,6 +43,10 @@ public:
 	// Return the amount of data available, including continuation buffers
 	size_t TotalRemaining() const noexcept;
 
+	// Return the total amount of data in this buffer, and the amount that has been read
+	size_t Length() const noexcept { return dataLength; }
+	size_t AmountRead() const noexcept { return readPointer; }
+
 	// Return true if there no data left to read
 	bool IsEmpty() const noexcept { return readPointer == dataLength; }
 
@@ -93,10 +93,15 @@ constexpr TcpPort MdnsPort = 5353;
 
 #if SAME70 || SAME5x
 constexpr size_t NetworkBufferCount = 10;			// number of 2K network buffers
+constexpr size_t MaxSentFileBuffers = 3;			// how many file buffers a responder may hold while waiting for the data in them to be acknowledged
 #else
 constexpr size_t NetworkBufferCount = 6;			// number of 2K network buffers
+constexpr size_t MaxSentFileBuffers = 2;			// how many file buffers a responder may hold while waiting for the data in them to be acknowledged
 #endif
 
+constexpr size_t MinNetworkBufferCount = 4;			// the fewest network buffers that M590 may ask for
+constexpr size_t MaxNetworkBufferCount = 32;		// the most network buffers that M590 may ask for
+
 constexpr size_t SsidBufferLength = 32;				// maximum characters in an SSID
 
 #endif /* SRC_NETWORKING_NETWORKDEFS_H_ */
@@ -17,7 +17,7 @@ NetworkResponder::NetworkResponder(NetworkResponder *n) noexcept
 #if HAS_MASS_STORAGE
 	  fileBeingSent(nullptr),
 #endif
-	  fileBuffer(nullptr)
+	  fileBuffer(nullptr), sentFileBuffers(nullptr), sentFileBytes(0)
 {
 }
 
@@ -86,6 +86,41 @@ void NetworkResponder::SendData() noexcept
 	// If we get here then there are no output buffers left to send
 
 #if HAS_MASS_STORAGE
+	// If the file is being read from a file cache then we send it directly from the cache entry, which remains valid until we close the file
+	if (fileBeingSent != nullptr && fileBuffer == nullptr)
+	{
+		size_t length;
+		const char *_ecv_array _ecv_null const cachedData = fileBeingSent->GetCachedData(length);
+		if (cachedData != nullptr)
+		{
+			const size_t sent = (length == 0) ? 0 : skt->Send(reinterpret_cast<const uint8_t *>(cachedData), length);
+			if (sent != 0)
+			{
+				(void)fileBeingSent->Seek(fileBeingSent->Position() + sent);
+				return;							// return to allow other sockets to be polled
+			}
+
+			// Check whether the connection has been closed
+			if (!skt->CanSend())
+			{
+				if (reprap.Debug(Module::Webserver))
+				{
+					debugPrintf("Can't send anymore\n");
+				}
+				ConnectionLost();
+				return;
+			}
+
+			// Keep the file open until the socket has no more need to resend data from the cache entry
+			if (length != 0 || skt->GetUnacknowledgedLength() != 0)
+			{
+				return;
+			}
+			fileBeingSent->Close();
+			fileBeingSent = nullptr;
+		}
+	}
+
 	// If we have a file to send, send it
 	if (fileBeingSent != nullptr && fileBuffer == nullptr)
 	{
@@ -101,6 +136,26 @@ void NetworkResponder::SendData() noexcept
 	{
 		if (fileBuffer->IsEmpty() && fileBeingSent != nullptr)
 		{
+			if (fileBuffer->Length() != 0)
+			{
+				// The socket may still need to resend data from this buffer, so we can't refill it until that data has been acknowledged. Use another buffer instead.
+				if (!ReleaseAcknowledgedFileData() || skt->GetUnacknowledgedLength() != 0)
+				{
+					NetworkBuffer *const nextBuffer = (NetworkBuffer::Count(sentFileBuffers) < MaxSentFileBuffers) ? NetworkBuffer::Allocate() : nullptr;
+					if (nextBuffer == nullptr)
+					{
+						if (!skt->CanSend())
+						{
+							ConnectionLost();
+						}
+						return;			// try again when more data has been acknowledged or a buffer has become free
+					}
+					sentFileBytes += fileBuffer->Length();
+					NetworkBuffer::AppendToList(&sentFileBuffers, fileBuffer);
+					fileBuffer = nextBuffer;
+				}
+			}
+
 			const int bytesRead = fileBuffer->ReadFromFile(fileBeingSent);
 			if (bytesRead != (int)NetworkBuffer::bufferSize)
 			{
@@ -112,8 +167,16 @@ void NetworkResponder::SendData() noexcept
 
 		if (fileBuffer->IsEmpty())
 		{
-			// Must have sent the whole file
-			fileBuffer->Release();
+			// Must have sent the whole file, but we must keep the last buffer until its data has been acknowledged
+			if (fileBuffer->Length() == 0)
+			{
+				fileBuffer->Release();
+			}
+			else
+			{
+				sentFileBytes += fileBuffer->Length();
+				NetworkBuffer::AppendToList(&sentFileBuffers, fileBuffer);
+			}
 			fileBuffer = nullptr;
 		}
 		else
@@ -144,6 +207,16 @@ void NetworkResponder::SendData() noexcept
 			}
 		}
 	}
+
+	// Wait until we have finished with all the file data we sent
+	if (!ReleaseAcknowledgedFileData())
+	{
+		if (!skt->CanSend())
+		{
+			ConnectionLost();
+		}
+		return;
+	}
 #endif
 
 	// If we get here then there is nothing left to send
@@ -184,9 +257,30 @@ void NetworkResponder::ConnectionLost() noexcept
 		skt = nullptr;
 	}
 
+	// The socket has discarded any data that it was waiting to have acknowledged, so we can release the buffers it was held in
+	while (sentFileBuffers != nullptr)
+	{
+		sentFileBuffers = sentFileBuffers->Release();
+	}
+	sentFileBytes = 0;
+
 	responderState = ResponderState::free;
 }
 
+// Release any sent file buffers that hold only data that the socket has no more need to resend, returning true if there are none left.
+// The data that has not been acknowledged is the most recent data we sent, which comes from fileBuffer and the newest buffers in sentFileBuffers.
+bool NetworkResponder::ReleaseAcknowledgedFileData() noexcept
+{
+	const size_t unacknowledged = skt->GetUnacknowledgedLength();
+	const size_t sentFromCurrentBuffer = (fileBuffer == nullptr) ? 0 : fileBuffer->AmountRead();
+	while (sentFileBuffers != nullptr && sentFileBytes - sentFileBuffers->Length() + sentFromCurrentBuffer >= unacknowledged)
+	{
+		sentFileBytes -= sentFileBuffers->Length();
+		sentFileBuffers = sentFileBuffers->Release();
+	}
+	return sentFileBuffers == nullptr;
+}
+
 IPAddress NetworkResponder::GetRemoteIP() const noexcept
 {
 	return (skt == nullptr) ? IPAddress() : skt->GetRemoteIP();
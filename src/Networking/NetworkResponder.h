@@ -44,6 +44,8 @@ protected:
 		// HTTP responder additional states
 		processingRequest,
 		gettingFileInfo,								// getting file info
+		streamingModel,									// sending a large object model response in chunks
+		webSocket,										// connection has been upgraded to a WebSocket
 
 		// FTP responder additional states
 		waitingForPasvPort,
@@ -67,6 +69,7 @@ protected:
 	void Commit(ResponderState nextState = ResponderState::free, bool report = true) noexcept;
 	virtual void SendData() noexcept;
 	virtual void ConnectionLost() noexcept;
+	bool ReleaseAcknowledgedFileData() noexcept;
 
 	IPAddress GetRemoteIP() const noexcept;
 	void ReportOutputBufferExhaustion(const char *sourceFile, int line) noexcept;
@@ -88,6 +91,8 @@ protected:
 	FileStore *fileBeingSent;
 #endif
 	NetworkBuffer *fileBuffer;
+	NetworkBuffer *sentFileBuffers;						// file buffers that we have sent but the socket may still need to resend from, oldest first
+	size_t sentFileBytes;								// the total amount of data in sentFileBuffers
 };
 
 #endif /* SRC_NETWORKING_NETWORKRESPONDER_H_ */
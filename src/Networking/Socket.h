@@ -45,6 +45,10 @@ public:
 	virtual size_t Send(const uint8_t *data, size_t length) noexcept = 0;
 	virtual void Send() noexcept = 0;
 
+	// Return how much of the data we have sent has not yet been acknowledged. Sockets that don't copy the data passed to Send() may need to resend
+	// the most recent this many bytes from the caller's buffers, so the caller must not reuse them until then. Sockets that copy the data return zero.
+	virtual size_t GetUnacknowledgedLength() const noexcept { return 0; }
+
 protected:
 	enum class SocketState : uint8_t
 	{
@@ -0,0 +1,238 @@
+/*
+ * UploadWriter.cpp
+ *
+ *  Created on: 19 Oct 2026
+ */
+
+#include "UploadWriter.h"
+
+#if HAS_MASS_STORAGE
+
+#include <Platform/Platform.h>
+#include <Platform/RepRap.h>
+#include <Platform/Tasks.h>
+#include <Platform/TaskPriorities.h>
+#include <Storage/FileStore.h>
+#include <Storage/MassStorage.h>
+#include <Cache.h>
+
+static_assert((DefaultUploadBufferSize & (DefaultUploadBufferSize - 1)) == 0 && DefaultUploadBufferSize >= 512, "DefaultUploadBufferSize must be a power of 2 and at least one sector");
+static_assert((MaxUploadBufferSize & (MaxUploadBufferSize - 1)) == 0 && MaxUploadBufferSize >= DefaultUploadBufferSize, "MaxUploadBufferSize must be a power of 2 and at least DefaultUploadBufferSize");
+static_assert(DefaultNumUploadBuffers >= 2 && DefaultNumUploadBuffers <= MaxUploadBuffers, "At least two upload buffers are needed");
+
+constexpr size_t UploadWriterTaskStackWords = 500;		// stack size in dwords, must be large enough for FatFS, the SD card driver and deleting an abandoned upload
+static Task<UploadWriterTaskStackWords> *_ecv_null uploadWriterTask = nullptr;
+
+char *_ecv_array _ecv_null UploadWriter::storage = nullptr;
+size_t UploadWriter::numBuffers = DefaultNumUploadBuffers;
+size_t UploadWriter::bufferSize = DefaultUploadBufferSize;
+size_t UploadWriter::bufferLengths[MaxUploadBuffers];
+FileStore *_ecv_null volatile UploadWriter::file = nullptr;
+volatile size_t UploadWriter::numQueued = 0;
+volatile size_t UploadWriter::writeIndex = 0;
+size_t UploadWriter::fillLength = 0;
+volatile bool UploadWriter::writeError = false;
+volatile bool UploadWriter::cancelling = false;
+FileData UploadWriter::cancelledFile;
+String<MaxFilenameLength> UploadWriter::cancelledFileName;
+uint32_t UploadWriter::numUploads = 0;
+uint32_t UploadWriter::numStalls = 0;
+size_t UploadWriter::maxQueued = 0;
+uint64_t UploadWriter::bytesWritten = 0;
+uint32_t UploadWriter::writeMillis = 0;
+
+extern "C" [[noreturn]] void UploadWriterTaskStart(void * pvParameters) noexcept
+{
+	UploadWriter::TaskLoop();
+}
+
+// Set the number and size of the buffers. We only allow this before the buffers have been allocated, because we never free them.
+/*static*/ GCodeResult UploadWriter::Configure(uint32_t p_numBuffers, uint32_t p_bufferSize, const StringRef& reply) noexcept
+{
+	if (p_numBuffers == numBuffers && p_bufferSize == bufferSize)
+	{
+		return GCodeResult::ok;
+	}
+	if (storage != nullptr)
+	{
+		reply.copy("upload buffers can't be changed after a file has been uploaded");
+		return GCodeResult::error;
+	}
+	if (p_numBuffers < 2 || p_numBuffers > MaxUploadBuffers)
+	{
+		reply.printf("number of upload buffers must be between 2 and %u", MaxUploadBuffers);
+		return GCodeResult::error;
+	}
+	if (p_bufferSize < 512 || p_bufferSize > MaxUploadBufferSize || (p_bufferSize & (p_bufferSize - 1)) != 0)
+	{
+		reply.printf("upload buffer size must be a power of 2 between 512 and %u", MaxUploadBufferSize);
+		return GCodeResult::error;
+	}
+	numBuffers = p_numBuffers;
+	bufferSize = p_bufferSize;
+	return GCodeResult::ok;
+}
+
+// Start pipelining writes to the specified file, returning false if the pipeline is already in use or we don't have enough memory for the buffers.
+// The buffers and the task are allocated the first time we are called and never freed.
+/*static*/ bool UploadWriter::Start(FileStore *f) noexcept
+{
+	if (file != nullptr)
+	{
+		return false;
+	}
+
+	if (storage == nullptr)
+	{
+		if (Tasks::GetNeverUsedRam() < (ptrdiff_t)(numBuffers * bufferSize + MinSpareRamForUploadBuffers))
+		{
+			return false;
+		}
+		storage = new char[numBuffers * bufferSize];
+		uploadWriterTask = new Task<UploadWriterTaskStackWords>;
+		Tasks::RecordAllocation(MemoryTag::network, numBuffers * bufferSize + sizeof(Task<UploadWriterTaskStackWords>));
+		uploadWriterTask->Create(UploadWriterTaskStart, "UPLOAD", nullptr, TaskPriority::SpinPriority);
+	}
+
+	writeIndex = numQueued = fillLength = 0;
+	writeError = cancelling = false;
+	file = f;
+	++numUploads;
+	return true;
+}
+
+// Copy some data into the buffers, returning how much was accepted. We queue each buffer for writing when it is full.
+/*static*/ size_t UploadWriter::Store(const uint8_t *data, size_t length) noexcept
+{
+	size_t stored = 0;
+	while (stored < length)
+	{
+		if (numQueued == numBuffers)
+		{
+			++numStalls;
+			break;
+		}
+		const size_t bytesToCopy = min<size_t>(bufferSize - fillLength, length - stored);
+		memcpy(GetBuffer((writeIndex + numQueued) % numBuffers) + fillLength, data + stored, bytesToCopy);
+		fillLength += bytesToCopy;
+		stored += bytesToCopy;
+		if (fillLength == bufferSize)
+		{
+			QueueBuffer();
+		}
+	}
+	return stored;
+}
+
+// Queue the buffer we are filling for writing. The caller must check that there is a free buffer to fill.
+/*static*/ void UploadWriter::QueueBuffer() noexcept
+{
+	bufferLengths[(writeIndex + numQueued) % numBuffers] = fillLength;
+	fillLength = 0;
+	{
+		TaskCriticalSectionLocker lock;
+		++numQueued;
+		if (numQueued > maxQueued)
+		{
+			maxQueued = numQueued;
+		}
+	}
+	uploadWriterTask->Give();
+}
+
+// Queue any data in the buffer we are filling for writing and return true if all the data we were given has been written
+/*static*/ bool UploadWriter::Flush() noexcept
+{
+	if (fillLength != 0 && numQueued < numBuffers)
+	{
+		QueueBuffer();
+	}
+	return fillLength == 0 && numQueued == 0;
+}
+
+// Finish using the pipeline. The caller must have waited until Flush returned true.
+/*static*/ bool UploadWriter::Finish() noexcept
+{
+	file = nullptr;
+	return !writeError;
+}
+
+// Abandon the upload. The writer task may be part way through writing a buffer, so instead of waiting for it we hand the file over to it.
+// It discards the remaining buffers, then closes the file and deletes it. The pipeline stays in use until it has done that, so new uploads
+// are written directly by the network task in the meantime.
+/*static*/ void UploadWriter::Cancel(FileData& uploadFile, const char *_ecv_array fileToDelete) noexcept
+{
+	cancelledFile.MoveFrom(uploadFile);
+	cancelledFileName.copy(fileToDelete);
+	fillLength = 0;
+	cancelling = true;
+	uploadWriterTask->Give();
+}
+
+// Called by the writer task to clean up after an abandoned upload once it has discarded all the queued buffers
+/*static*/ void UploadWriter::FinishCancel() noexcept
+{
+	cancelledFile.Close();
+	if (!cancelledFileName.IsEmpty())
+	{
+		(void)MassStorage::Delete(cancelledFileName.GetRef(), ErrorMessageMode::messageAlways);
+		cancelledFileName.Clear();
+	}
+	file = nullptr;
+	cancelling = false;
+}
+
+/*static*/ void UploadWriter::TaskLoop() noexcept
+{
+	for (;;)
+	{
+		if (numQueued == 0)
+		{
+			if (cancelling)
+			{
+				FinishCancel();
+			}
+			else
+			{
+				(void)TaskBase::Take(TaskBase::TimeoutUnlimited);
+			}
+			continue;
+		}
+
+		const size_t index = writeIndex;
+		if (!writeError && !cancelling)
+		{
+			const char *_ecv_array const buffer = GetBuffer(index);
+			const size_t length = bufferLengths[index];
+			Cache::FlushBeforeDMASend(buffer, length);
+			const uint32_t startTime = millis();
+			if (file->Write(buffer, length))
+			{
+				writeMillis += millis() - startTime;
+				bytesWritten += length;
+			}
+			else
+			{
+				writeError = true;
+			}
+		}
+
+		TaskCriticalSectionLocker lock;
+		writeIndex = (index + 1) % numBuffers;
+		--numQueued;
+	}
+}
+
+/*static*/ void UploadWriter::Diagnostics(MessageType mtype) noexcept
+{
+	reprap.GetPlatform().MessageF(mtype, "Upload pipeline: %s, %u x %uKb buffers, uploads %" PRIu32 ", max queued %u, stalls %" PRIu32 ", card write speed %.2fMB/s\n",
+									(storage == nullptr) ? "not allocated" : (file == nullptr) ? "idle" : (cancelling) ? "cancelling" : "active",
+									numBuffers, bufferSize/1024, numUploads, maxQueued, numStalls,
+									(writeMillis == 0) ? 0.0 : (double)bytesWritten/((double)writeMillis * 1000.0));
+	numStalls = 0;
+	maxQueued = 0;
+}
+
+#endif
+
+// End
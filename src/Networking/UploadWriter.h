@@ -0,0 +1,72 @@
+/*
+ * UploadWriter.h
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * Pipelined writing of files uploaded over HTTP.
+ * The network task copies incoming upload data into a ring of large buffers and a separate task writes each buffer to the SD card when it is full,
+ * so that the network task can carry on receiving data while the card is busy. If all the buffers are waiting to be written then the network task
+ * leaves the data in the socket, which closes the TCP window until the card catches up.
+ * The buffer size is a power of 2 and files start on a cluster boundary, so every write except the last covers whole sectors and whole clusters
+ * or a whole fraction of a cluster. FatFS passes such writes straight to the card as multi-block writes.
+ * Only one upload at a time can use the pipeline. Other uploads are written directly by the network task.
+ * The number and size of the buffers can be changed by M590 until the first upload allocates them.
+ */
+
+#ifndef SRC_NETWORKING_UPLOADWRITER_H_
+#define SRC_NETWORKING_UPLOADWRITER_H_
+
+#include <RepRapFirmware.h>
+
+#if HAS_MASS_STORAGE
+
+#include <Storage/FileData.h>
+#include <General/String.h>
+
+class UploadWriter
+{
+public:
+	static bool Start(FileStore *f) noexcept;								// start pipelining writes to the file, returning false if we can't
+	static size_t Store(const uint8_t *data, size_t length) noexcept;		// store some data, returning how much was accepted
+	static bool Flush() noexcept;											// queue any partly filled buffer for writing and return true if all data has been written
+	static bool Finish() noexcept;											// finish pipelining writes, returning false if any write failed
+	static void Cancel(FileData& uploadFile, const char *_ecv_array fileToDelete) noexcept;	// abandon the upload, handing over the file to be closed and deleted
+	static bool HadWriteError() noexcept { return writeError; }
+
+	static GCodeResult Configure(uint32_t p_numBuffers, uint32_t p_bufferSize, const StringRef& reply) noexcept;	// set the number and size of the buffers
+	static size_t GetNumBuffers() noexcept { return numBuffers; }
+	static size_t GetBufferSize() noexcept { return bufferSize; }
+
+	static void Diagnostics(MessageType mtype) noexcept;
+
+	[[noreturn]] static void TaskLoop() noexcept;
+
+private:
+	static void QueueBuffer() noexcept;
+	static void FinishCancel() noexcept;
+	static char *_ecv_array GetBuffer(size_t index) noexcept { return storage + index * bufferSize; }
+
+	static char *_ecv_array _ecv_null storage;								// the storage for all the buffers
+	static size_t numBuffers;												// the number of buffers
+	static size_t bufferSize;												// the size of each buffer, a power of 2
+	static size_t bufferLengths[MaxUploadBuffers];							// the amount of data in each buffer that is queued for writing
+	static FileStore *_ecv_null volatile file;								// the file we are writing to, or null if the pipeline is not in use
+	static volatile size_t numQueued;										// the number of buffers waiting to be written, starting at writeIndex
+	static volatile size_t writeIndex;										// the index of the next buffer to write
+	static size_t fillLength;												// the amount of data in the buffer we are filling, which follows the queued ones
+	static volatile bool writeError;
+	static volatile bool cancelling;										// true if the upload has been abandoned and the writer task hasn't finished cleaning up yet
+	static FileData cancelledFile;											// the file of an abandoned upload, which the writer task closes
+	static String<MaxFilenameLength> cancelledFileName;					// the name of the file of an abandoned upload, which the writer task deletes
+
+	// Statistics
+	static uint32_t numUploads;
+	static uint32_t numStalls;												// how many times the network task found all the buffers waiting to be written
+	static size_t maxQueued;
+	static uint64_t bytesWritten;
+	static uint32_t writeMillis;
+};
+
+#endif
+
+#endif /* SRC_NETWORKING_UPLOADWRITER_H_ */
@@ -6,12 +6,21 @@
  */
 
 #include "UploadingNetworkResponder.h"
+#include "UploadWriter.h"
 #include "Socket.h"
 #include <Platform/Platform.h>
 
+#if HAS_MASS_STORAGE
+
+uint32_t UploadingNetworkResponder::numUploadsCompleted = 0;
+float UploadingNetworkResponder::lastUploadRate = 0.0;
+float UploadingNetworkResponder::bestUploadRate = 0.0;
+
+#endif
+
 UploadingNetworkResponder::UploadingNetworkResponder(NetworkResponder *n) noexcept : NetworkResponder(n)
 #if HAS_MASS_STORAGE
-	, uploadError(false), dummyUpload(false)
+	, uploadError(false), dummyUpload(false), pipelinedUpload(false)
 #endif
 {
 }
@@ -27,6 +36,13 @@ void UploadingNetworkResponder::ConnectionLost() noexcept
 void UploadingNetworkResponder::CancelUpload() noexcept
 {
 #if HAS_MASS_STORAGE
+	if (pipelinedUpload)
+	{
+		// The upload writer may be busy writing to the file, so it closes and deletes the file when it has finished instead of us waiting for it
+		UploadWriter::Cancel(fileBeingUploaded, filenameBeingProcessed.c_str());
+		filenameBeingProcessed.Clear();
+		pipelinedUpload = false;
+	}
 	if (fileBeingUploaded.IsLive())
 	{
 		fileBeingUploaded.Close();
@@ -41,9 +57,11 @@ void UploadingNetworkResponder::CancelUpload() noexcept
 
 #if HAS_MASS_STORAGE
 
-// Start writing to a new file, returning true if successful
-bool UploadingNetworkResponder::StartUpload(const char* folder, const char *fileName, const OpenMode mode, const uint32_t preAllocSize) noexcept
+// Start writing to a new file, returning true if successful.
+// If 'pipelined' is true then the caller must write the data using WriteUploadData and wait for AllUploadDataWritten to return true before calling FinishUpload.
+bool UploadingNetworkResponder::StartUpload(const char* folder, const char *fileName, const OpenMode mode, const uint32_t preAllocSize, bool pipelined) noexcept
 {
+	pipelinedUpload = false;
 	if (fileName[0] == 0 || StringEndsWithIgnoreCase(fileName, ".dummy"))
 	{
 		filenameBeingProcessed.Clear();
@@ -69,15 +87,59 @@ bool UploadingNetworkResponder::StartUpload(const char* folder, const char *file
 		}
 		fileBeingUploaded.Set(file);
 		dummyUpload = false;
+		pipelinedUpload = pipelined && UploadWriter::Start(file);
 	}
 	responderState = ResponderState::uploading;
 	uploadError = false;
+	uploadStartTime = millis();
 	return true;
 }
 
+// Write some upload data, returning how much of it was accepted. Pipelined uploads may accept less than all of it if the card is busy.
+// Sets uploadError if the data could not be written.
+size_t UploadingNetworkResponder::WriteUploadData(const uint8_t *data, size_t length) noexcept
+{
+	if (dummyUpload)
+	{
+		return length;
+	}
+
+	if (pipelinedUpload)
+	{
+		if (UploadWriter::HadWriteError())
+		{
+			uploadError = true;
+			return 0;
+		}
+		return UploadWriter::Store(data, length);
+	}
+
+	if (!fileBeingUploaded.Write(data, length))
+	{
+		uploadError = true;
+	}
+	return length;
+}
+
+// Return true if all the upload data we have been given has been written to the file
+bool UploadingNetworkResponder::AllUploadDataWritten() noexcept
+{
+	return !pipelinedUpload || UploadWriter::Flush();
+}
+
 // Finish a file upload. Set variable uploadError if anything goes wrong.
 void UploadingNetworkResponder::FinishUpload(uint32_t fileLength, time_t fileLastModified, bool gotCrc, uint32_t expectedCrc) noexcept
 {
+	if (pipelinedUpload)
+	{
+		if (!UploadWriter::Finish())
+		{
+			uploadError = true;
+			GetPlatform().Message(ErrorMessage, "Could not write upload data\n");
+		}
+		pipelinedUpload = false;
+	}
+
 	if (!dummyUpload)
 	{
 		// Flush remaining data for FSO
@@ -88,10 +150,11 @@ void UploadingNetworkResponder::FinishUpload(uint32_t fileLength, time_t fileLas
 		}
 
 		// Check the file length is as expected
-		if (fileLength != 0 && fileBeingUploaded.Length() != fileLength)
+		const FilePosition uploadedLength = fileBeingUploaded.Length();
+		if (fileLength != 0 && uploadedLength != fileLength)
 		{
 			uploadError = true;
-			GetPlatform().MessageF(ErrorMessage, "Uploaded file size is different (%lu vs. expected %lu bytes)\n", fileBeingUploaded.Length(), fileLength);
+			GetPlatform().MessageF(ErrorMessage, "Uploaded file size is different (%lu vs. expected %lu bytes)\n", uploadedLength, fileLength);
 		}
 		else if (gotCrc && expectedCrc != fileBeingUploaded.GetCrc32())
 		{
@@ -121,6 +184,18 @@ void UploadingNetworkResponder::FinishUpload(uint32_t fileLength, time_t fileLas
 			}
 			else
 			{
+				// Record the upload speed
+				const uint32_t uploadMillis = millis() - uploadStartTime;
+				if (uploadMillis != 0)
+				{
+					lastUploadRate = (float)uploadedLength / ((float)uploadMillis * 1000.0);
+					if (lastUploadRate > bestUploadRate)
+					{
+						bestUploadRate = lastUploadRate;
+					}
+				}
+				++numUploadsCompleted;
+
 				String<MaxFilenameLength> origFilename;
 				origFilename.copy(filenameBeingProcessed.c_str(), filenameBeingProcessed.GetRef().strlen() - strlen(UPLOAD_EXTENSION));
 
@@ -141,6 +216,12 @@ void UploadingNetworkResponder::FinishUpload(uint32_t fileLength, time_t fileLas
 	}
 }
 
+/*static*/ void UploadingNetworkResponder::CommonDiagnostics(MessageType mtype) noexcept
+{
+	reprap.GetPlatform().MessageF(mtype, "Uploads completed %" PRIu32 ", last %.2fMB/s, best %.2fMB/s\n", numUploadsCompleted, (double)lastUploadRate, (double)bestUploadRate);
+	UploadWriter::Diagnostics(mtype);
+}
+
 #endif
 
 // End
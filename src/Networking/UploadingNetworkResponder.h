@@ -12,6 +12,11 @@
 
 class UploadingNetworkResponder : public NetworkResponder
 {
+public:
+#if HAS_MASS_STORAGE
+	static void CommonDiagnostics(MessageType mtype) noexcept;
+#endif
+
 protected:
 	UploadingNetworkResponder(NetworkResponder *n) noexcept;
 
@@ -19,14 +24,24 @@ protected:
 	virtual void CancelUpload() noexcept;
 
 #if HAS_MASS_STORAGE
-	bool StartUpload(const char* folder, const char *fileName, const OpenMode mode, const uint32_t preAllocSize = 0) noexcept;
+	bool StartUpload(const char* folder, const char *fileName, const OpenMode mode, const uint32_t preAllocSize = 0, bool pipelined = false) noexcept;
+	size_t WriteUploadData(const uint8_t *data, size_t length) noexcept;
+	bool AllUploadDataWritten() noexcept;
 	void FinishUpload(uint32_t fileLength, time_t fileLastModified, bool gotCrc, uint32_t expectedCrc) noexcept;
 
 	// File uploads
 	FileData fileBeingUploaded;
 	uint32_t uploadedBytes;								// how many bytes have already been written
+	uint32_t uploadStartTime;							// when we started the upload
 	bool uploadError;
 	bool dummyUpload;
+	bool pipelinedUpload;								// true if the upload data is being written by the UploadWriter task
+
+private:
+	// Upload statistics
+	static uint32_t numUploadsCompleted;
+	static float lastUploadRate;						// in MB/sec
+	static float bestUploadRate;
 #endif
 
 	String<MaxFilenameLength> filenameBeingProcessed;	// usually the name of the file being uploaded, but also used by HttpResponder and FtpResponder
@@ -0,0 +1,259 @@
+/*
+ * WebSocket.cpp
+ *
+ *  Created on: 19 Oct 2026
+ */
+
+#include "WebSocket.h"
+
+#if SUPPORT_HTTP && SUPPORT_OBJECT_MODEL
+
+#include <Platform/OutputMemory.h>
+
+// The GUID that RFC 6455 says we must append to the client's key before hashing it
+static const char *_ecv_array const WebSocketGuid = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+// Minimal SHA-1 implementation, used only for the opening handshake
+class Sha1
+{
+public:
+	Sha1() noexcept;
+	void Update(const char *_ecv_array data, size_t length) noexcept;
+	void Finish(uint8_t digest[20]) noexcept;
+
+private:
+	void ProcessBlock() noexcept;
+	static uint32_t Rotl(uint32_t val, unsigned int bits) noexcept { return (val << bits) | (val >> (32 - bits)); }
+
+	uint32_t h[5];
+	uint8_t block[64];
+	uint64_t totalLength;
+	size_t blockLength;
+};
+
+Sha1::Sha1() noexcept : totalLength(0), blockLength(0)
+{
+	h[0] = 0x67452301;
+	h[1] = 0xEFCDAB89;
+	h[2] = 0x98BADCFE;
+	h[3] = 0x10325476;
+	h[4] = 0xC3D2E1F0;
+}
+
+void Sha1::Update(const char *_ecv_array data, size_t length) noexcept
+{
+	totalLength += length;
+	while (length != 0)
+	{
+		block[blockLength++] = (uint8_t)*data++;
+		--length;
+		if (blockLength == sizeof(block))
+		{
+			ProcessBlock();
+			blockLength = 0;
+		}
+	}
+}
+
+void Sha1::Finish(uint8_t digest[20]) noexcept
+{
+	const uint64_t totalBits = totalLength * 8;
+	block[blockLength++] = 0x80;
+	if (blockLength > 56)
+	{
+		memset(block + blockLength, 0, sizeof(block) - blockLength);
+		ProcessBlock();
+		blockLength = 0;
+	}
+	memset(block + blockLength, 0, 56 - blockLength);
+	for (size_t i = 0; i < 8; ++i)
+	{
+		block[56 + i] = (uint8_t)(totalBits >> (56 - 8 * i));
+	}
+	ProcessBlock();
+
+	for (size_t i = 0; i < 20; ++i)
+	{
+		digest[i] = (uint8_t)(h[i/4] >> (24 - 8 * (i % 4)));
+	}
+}
+
+void Sha1::ProcessBlock() noexcept
+{
+	uint32_t w[80];
+	for (size_t i = 0; i < 16; ++i)
+	{
+		w[i] = ((uint32_t)block[4 * i] << 24) | ((uint32_t)block[4 * i + 1] << 16) | ((uint32_t)block[4 * i + 2] << 8) | (uint32_t)block[4 * i + 3];
+	}
+	for (size_t i = 16; i < 80; ++i)
+	{
+		w[i] = Rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+	}
+
+	uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+	for (size_t i = 0; i < 80; ++i)
+	{
+		uint32_t f, k;
+		if (i < 20)
+		{
+			f = (b & c) | (~b & d);
+			k = 0x5A827999;
+		}
+		else if (i < 40)
+		{
+			f = b ^ c ^ d;
+			k = 0x6ED9EBA1;
+		}
+		else if (i < 60)
+		{
+			f = (b & c) | (b & d) | (c & d);
+			k = 0x8F1BBCDC;
+		}
+		else
+		{
+			f = b ^ c ^ d;
+			k = 0xCA62C1D6;
+		}
+		const uint32_t temp = Rotl(a, 5) + f + e + k + w[i];
+		e = d;
+		d = c;
+		c = Rotl(b, 30);
+		b = a;
+		a = temp;
+	}
+	h[0] += a;
+	h[1] += b;
+	h[2] += c;
+	h[3] += d;
+	h[4] += e;
+}
+
+// Make the value of the Sec-WebSocket-Accept header, which is the base64 encoding of the SHA-1 hash of the client's key followed by the GUID
+void WebSocket::MakeAcceptKey(const char *_ecv_array clientKey, const StringRef& acceptKey) noexcept
+{
+	static const char *_ecv_array const Base64Chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	Sha1 sha;
+	sha.Update(clientKey, strlen(clientKey));
+	sha.Update(WebSocketGuid, strlen(WebSocketGuid));
+	uint8_t digest[20];
+	sha.Finish(digest);
+
+	// The digest is 20 bytes long, so we encode 6 complete groups of 3 bytes followed by 2 bytes and one padding character
+	acceptKey.Clear();
+	for (size_t i = 0; i < 20; i += 3)
+	{
+		const uint32_t group = ((uint32_t)digest[i] << 16) | ((uint32_t)digest[i + 1] << 8) | ((i + 2 < 20) ? (uint32_t)digest[i + 2] : 0);
+		acceptKey.cat(Base64Chars[(group >> 18) & 0x3F]);
+		acceptKey.cat(Base64Chars[(group >> 12) & 0x3F]);
+		acceptKey.cat(Base64Chars[(group >> 6) & 0x3F]);
+		acceptKey.cat((i + 2 < 20) ? Base64Chars[group & 0x3F] : '=');
+	}
+}
+
+// Append the header of an unmasked frame to an output buffer
+void WebSocket::AppendFrameHeader(OutputBuffer *buf, Opcode opcode, bool isFinal, size_t payloadLength) noexcept
+{
+	buf->cat((char)((isFinal ? 0x80 : 0) | opcode));
+	if (payloadLength < 126)
+	{
+		buf->cat((char)payloadLength);
+	}
+	else if (payloadLength < 65536)
+	{
+		buf->cat((char)126);
+		buf->cat((char)(payloadLength >> 8));
+		buf->cat((char)payloadLength);
+	}
+	else
+	{
+		buf->cat((char)127);
+		for (int shift = 56; shift >= 0; shift -= 8)
+		{
+			buf->cat((char)((uint64_t)payloadLength >> shift));
+		}
+	}
+}
+
+void WebSocketFrameReader::Reset() noexcept
+{
+	state = State::header0;
+	payloadLength = bytesReceived = 0;
+	bytesStored = 0;
+}
+
+// Process a byte received from the client, unmasking the payload into the buffer provided.
+// Return true when we have received a complete frame. If the payload is too long for the buffer then we store as much of it as we can.
+bool WebSocketFrameReader::ProcessByte(uint8_t c, char *_ecv_array buffer, size_t bufferSize) noexcept
+{
+	switch (state)
+	{
+	case State::header0:
+		isFinal = (c & 0x80) != 0;
+		opcode = c & 0x0F;
+		payloadLength = bytesReceived = 0;
+		bytesStored = 0;
+		maskBytesReceived = 0;
+		state = State::header1;
+		return false;
+
+	case State::header1:
+		isMasked = (c & 0x80) != 0;
+		c &= 0x7F;
+		if (c >= 126)
+		{
+			extendedLengthBytesLeft = (c == 126) ? 2 : 8;
+			state = State::extendedLength;
+			return false;
+		}
+		payloadLength = c;
+		break;
+
+	case State::extendedLength:
+		payloadLength = (payloadLength << 8) | c;
+		if (--extendedLengthBytesLeft != 0)
+		{
+			return false;
+		}
+		break;
+
+	case State::mask:
+		mask[maskBytesReceived++] = c;
+		if (maskBytesReceived < sizeof(mask))
+		{
+			return false;
+		}
+		state = (payloadLength == 0) ? State::header0 : State::payload;
+		return payloadLength == 0;
+
+	case State::payload:
+		if (isMasked)
+		{
+			c ^= mask[bytesReceived & 3];
+		}
+		if (bytesStored < bufferSize)
+		{
+			buffer[bytesStored++] = (char)c;
+		}
+		++bytesReceived;
+		if (bytesReceived < payloadLength)
+		{
+			return false;
+		}
+		state = State::header0;
+		return true;
+	}
+
+	// Here when we have received the length
+	if (isMasked)
+	{
+		state = State::mask;
+		return false;
+	}
+	state = (payloadLength == 0) ? State::header0 : State::payload;
+	return payloadLength == 0;
+}
+
+#endif
+
+// End
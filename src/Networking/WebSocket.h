@@ -0,0 +1,69 @@
+/*
+ * WebSocket.h
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * Support for the WebSocket protocol (RFC 6455) used by HttpResponder to push object model updates and G-code replies to clients.
+ * We only support what we need: the opening handshake, unmasked frames from us, and masked frames from the client that fit in one buffer.
+ */
+
+#ifndef SRC_NETWORKING_WEBSOCKET_H_
+#define SRC_NETWORKING_WEBSOCKET_H_
+
+#include <RepRapFirmware.h>
+
+#if SUPPORT_HTTP && SUPPORT_OBJECT_MODEL
+
+class OutputBuffer;
+
+namespace WebSocket
+{
+	enum Opcode : uint8_t
+	{
+		continuation = 0x00,
+		text = 0x01,
+		binary = 0x02,
+		close = 0x08,
+		ping = 0x09,
+		pong = 0x0A
+	};
+
+	// Make the value of the Sec-WebSocket-Accept header that we return in response to the client's Sec-WebSocket-Key header
+	void MakeAcceptKey(const char *_ecv_array clientKey, const StringRef& acceptKey) noexcept;
+
+	// Append the header of an unmasked frame to an output buffer
+	void AppendFrameHeader(OutputBuffer *buf, Opcode opcode, bool isFinal, size_t payloadLength) noexcept;
+}
+
+// Class to collect a frame received from a client
+class WebSocketFrameReader
+{
+public:
+	WebSocketFrameReader() noexcept { Reset(); }
+
+	void Reset() noexcept;
+	bool ProcessByte(uint8_t c, char *_ecv_array buffer, size_t bufferSize) noexcept;	// process a received byte, returning true when we have a complete frame
+
+	WebSocket::Opcode GetOpcode() const noexcept { return (WebSocket::Opcode)opcode; }
+	bool IsFinal() const noexcept { return isFinal; }
+	bool IsTruncated() const noexcept { return payloadLength > bytesStored; }			// true if the payload didn't fit in the buffer
+	size_t GetStoredLength() const noexcept { return bytesStored; }
+
+private:
+	enum class State : uint8_t { header0, header1, extendedLength, mask, payload };
+
+	uint64_t payloadLength;
+	uint64_t bytesReceived;
+	size_t bytesStored;
+	uint8_t mask[4];
+	uint8_t extendedLengthBytesLeft;
+	uint8_t maskBytesReceived;
+	uint8_t opcode;
+	bool isFinal;
+	bool isMasked;
+	State state;
+};
+
+#endif
+
+#endif /* SRC_NETWORKING_WEBSOCKET_H_ */
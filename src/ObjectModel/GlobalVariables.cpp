@@ -6,6 +6,7 @@
  */
 
 #include "GlobalVariables.h"
+#include "ObjectModelChanges.h"
 #include <Platform/OutputMemory.h>
 
 // This function is not used in this class
@@ -16,6 +17,7 @@ const ObjectModelClassDescriptor *GlobalVariables::GetObjectModelClassDescriptor
 // We ignore any remaining key or flags and just report all the variables
 void GlobalVariables::ReportAsJson(OutputBuffer *buf, ObjectExplorationContext& context, const ObjectModelClassDescriptor * null classDescriptor, uint8_t tableNumber, const char *filter) const THROWS(GCodeException)
 {
+	context.DisallowStopping();									// we can't resume part way through the list of variables because it may change
 	if (*filter == 0)
 	{
 		// Report all global variables
@@ -24,13 +26,20 @@ void GlobalVariables::ReportAsJson(OutputBuffer *buf, ObjectExplorationContext&
 		{
 			{
 				ReadLocker locker(lock);			// make sure that no other task modifies the list while we are traversing it
-				vars.IterateWhile([this, buf, &context, classDescriptor, filter](unsigned int index, const Variable& v) noexcept -> bool
-									{
-										buf->catf((index != 0) ? ",\"%s\":" : "\"%s\":", v.GetName().Ptr());
-										ReportItemAsJson(buf, context, classDescriptor, v.GetValue(), filter);
-										return true;
-									}
-								 );
+				if (context.IsDeltaReport())
+				{
+					ReportChangedVariablesAsJson(buf, context);
+				}
+				else
+				{
+					vars.IterateWhile([this, buf, &context, classDescriptor, filter](unsigned int index, const Variable& v) noexcept -> bool
+										{
+											buf->catf((index != 0) ? ",\"%s\":" : "\"%s\":", v.GetName().Ptr());
+											ReportItemAsJson(buf, context, classDescriptor, v.GetValue(), filter);
+											return true;
+										}
+									 );
+				}
 			}
 			context.DecreaseDepth();
 		}
@@ -54,6 +63,35 @@ void GlobalVariables::ReportAsJson(OutputBuffer *buf, ObjectExplorationContext&
 			buf->cat("{}");
 		}
 	}
+	context.AllowStopping();
+}
+
+// Report the global variables that have changed since the client's token. Caller must hold a read lock.
+// If variables have been created or deleted then we report all of them, so that the client can tell which ones still exist.
+void GlobalVariables::ReportChangedVariablesAsJson(OutputBuffer *buf, ObjectExplorationContext& context) const THROWS(GCodeException)
+{
+	uint32_t namesHash = ObjectModelChangeTracker::InitialPathHash;
+	vars.IterateWhile([&namesHash](unsigned int index, const Variable& v) noexcept -> bool
+						{
+							namesHash = ObjectModelChangeTracker::AddToHash(namesHash, v.GetName().Ptr());
+							return true;
+						}
+					 );
+
+	const ObjectExplorationContext::DeltaState state = context.BeginDeltaItem(VariableNamesKey, ExpressionValue((int32_t)namesHash), true);
+	bool first = true;
+	vars.IterateWhile([this, buf, &context, &first](unsigned int index, const Variable& v) noexcept -> bool
+						{
+							const ReadLockedPointer<const char> name = v.GetName();
+							if (ReportChangedItemAsJson(buf, context, nullptr, ObjectModelChangeTracker::AddToHash(ObjectModelChangeTracker::InitialPathHash, name.Ptr()),
+														name.Ptr(), v.GetValue(), false, "", (first) ? "\"" : ",\""))
+							{
+								first = false;
+							}
+							return true;
+						}
+					 );
+	context.EndDeltaItem(state);
 }
 
 ReadLockedPointer<const VariableSet> GlobalVariables::GetForReading() noexcept
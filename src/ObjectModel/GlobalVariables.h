@@ -31,6 +31,10 @@ protected:
 			THROWS(GCodeException);
 
 private:
+	static constexpr uint32_t VariableNamesKey = 0xFFFFFFFE;		// key used in delta reports to track which variables exist
+
+	void ReportChangedVariablesAsJson(OutputBuffer *buf, ObjectExplorationContext& context) const THROWS(GCodeException);
+
 	VariableSet vars;
 	mutable ReadWriteLock lock;
 };
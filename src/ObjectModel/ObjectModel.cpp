@@ -9,6 +9,7 @@
 
 #if SUPPORT_OBJECT_MODEL
 
+#include "ObjectModelChanges.h"
 #include <Platform/RepRap.h>
 #include <Platform/Platform.h>
 #include <Platform/OutputMemory.h>
@@ -24,6 +25,8 @@ namespace StackUsage
 	constexpr uint32_t GetObjectValue_withTable = 48;
 }
 
+constexpr uint32_t ArrayLengthKey = 0xFFFFFFFF;		// key used in delta reports to track the length of an array
+
 ExpressionValue::ExpressionValue(const MacAddress& mac) noexcept : type((uint32_t)TypeCode::MacAddress_tc), param(mac.HighWord()), uVal(mac.LowWord())
 {
 }
@@ -494,12 +497,14 @@ ObjectModel::ObjectModel() noexcept
 
 // Constructor used when reporting the OM as JSON
 ObjectExplorationContext::ObjectExplorationContext(const GCodeBuffer *_ecv_null gbp, bool wal, const char *reportFlags, unsigned int initialMaxDepth, size_t initialBufferOffset) noexcept
-	: startMillis(millis()), initialBufOffset(initialBufferOffset), maxDepth(initialMaxDepth), currentDepth(0), startElement(0), nextElement(-1), numIndicesProvided(0), numIndicesCounted(0),
-	  line(-1), column(-1), gb(gbp),
+	: startMillis(millis64()), historySince(0), initialBufOffset(initialBufferOffset), maxDepth(initialMaxDepth), currentDepth(0), startElement(0), nextElement(-1), numIndicesProvided(0), numIndicesCounted(0),
+	  line(-1), column(-1), gb(gbp), compiledPath(nullptr), compiledPathBase(nullptr),
+	  deltaToken(0), deltaPathHash(ObjectModelChangeTracker::InitialPathHash), deltaChanges(0),
+	  cursor(nullptr), chunkLimit(0), cursorLevel(0), resumeLevels(0), noStopCount(0),
 	  shortForm(false), wantArrayLength(wal), wantExists(false),
 	  includeNonLive(true), includeImportant(false), includeNulls(false),
 	  excludeVerbose(true), excludeObsolete(true),
-	  obsoleteFieldQueried(false)
+	  obsoleteFieldQueried(false), deltaReport(false), deltaReportAll(false), wantHistory(false), stopping(false)
 {
 	while (true)
 	{
@@ -533,6 +538,24 @@ ObjectExplorationContext::ObjectExplorationContext(const GCodeBuffer *_ecv_null
 				++reportFlags;
 			}
 			break;
+		case 'c':
+			deltaReport = true;
+			deltaToken = 0;
+			while (isdigit(*reportFlags))
+			{
+				deltaToken = (10 * deltaToken) + (*reportFlags - '0');
+				++reportFlags;
+			}
+			break;
+		case 'h':
+			wantHistory = true;
+			historySince = 0;
+			while (isdigit(*reportFlags))
+			{
+				historySince = (10 * historySince) + (*reportFlags - '0');
+				++reportFlags;
+			}
+			break;
 		case 'a':
 			startElement = 0;
 			while (isdigit(*reportFlags))
@@ -553,12 +576,14 @@ ObjectExplorationContext::ObjectExplorationContext(const GCodeBuffer *_ecv_null
 
 // Constructor when evaluating expressions
 ObjectExplorationContext::ObjectExplorationContext(const GCodeBuffer *_ecv_null gbp, bool wal, bool wex, int p_line, int p_col) noexcept
-	: startMillis(millis()), initialBufOffset(0), maxDepth(99), currentDepth(0), startElement(0), nextElement(-1), numIndicesProvided(0), numIndicesCounted(0),
-	  line(p_line), column(p_col), gb(gbp),
+	: startMillis(millis64()), historySince(0), initialBufOffset(0), maxDepth(99), currentDepth(0), startElement(0), nextElement(-1), numIndicesProvided(0), numIndicesCounted(0),
+	  line(p_line), column(p_col), gb(gbp), compiledPath(nullptr), compiledPathBase(nullptr),
+	  deltaToken(0), deltaPathHash(ObjectModelChangeTracker::InitialPathHash), deltaChanges(0),
+	  cursor(nullptr), chunkLimit(0), cursorLevel(0), resumeLevels(0), noStopCount(0),
 	  shortForm(false), wantArrayLength(wal), wantExists(wex),
 	  includeNonLive(true), includeImportant(false), includeNulls(false),
 	  excludeVerbose(false), excludeObsolete(false),
-	  obsoleteFieldQueried(false)
+	  obsoleteFieldQueried(false), deltaReport(false), deltaReportAll(false), wantHistory(false), stopping(false)
 {
 }
 
@@ -598,6 +623,95 @@ bool ObjectExplorationContext::ShouldReport(const ObjectModelEntryFlags f) const
 		&& (!excludeObsolete || ((uint8_t)f & (uint8_t)ObjectModelEntryFlags::obsolete) == 0);
 }
 
+// Return the table entry that the path element starting at 'id' resolved to last time we looked up this path, if we have it and the object is of the same class
+const ObjectModelTableEntry *_ecv_null ObjectExplorationContext::LookupCompiledPath(const char *_ecv_array id, const ObjectModelClassDescriptor *_ecv_null leafDescriptor, uint8_t tableNumber,
+																					const ObjectModelClassDescriptor *_ecv_null& foundDescriptor) const noexcept
+{
+	return (compiledPath == nullptr || compiledPath->IsBeingCompiled()) ? nullptr : compiledPath->Lookup(id - compiledPathBase, leafDescriptor, tableNumber, foundDescriptor);
+}
+
+// Record the table entry that the path element starting at 'id' resolved to, if we are compiling the path
+void ObjectExplorationContext::RecordCompiledPath(const char *_ecv_array id, const ObjectModelClassDescriptor *_ecv_null leafDescriptor, uint8_t tableNumber,
+													const ObjectModelClassDescriptor *_ecv_null foundDescriptor, const ObjectModelTableEntry *entry) noexcept
+{
+	if (compiledPath != nullptr && compiledPath->IsBeingCompiled())
+	{
+		compiledPath->Record(id - compiledPathBase, leafDescriptor, tableNumber, foundDescriptor, entry);
+	}
+}
+
+// Add an item to the path of the current item and record its value. If it has changed since the client's token then count it as a change,
+// and if it is an object or array that has changed identity or length then report everything within it.
+void ObjectExplorationContext::NoteDeltaItem(uint32_t key, const ExpressionValue& val, bool reportAllIfChanged) noexcept
+{
+	deltaPathHash = ObjectModelChangeTracker::AddToHash(deltaPathHash, key);
+	if (ObjectModelChangeTracker::Update(deltaPathHash, val, deltaToken))
+	{
+		++deltaChanges;
+		if (reportAllIfChanged)
+		{
+			deltaReportAll = true;
+		}
+	}
+}
+
+// Set up to generate a chunked report, resuming from where the cursor says we stopped last time if we have already generated a chunk
+void ObjectExplorationContext::SetChunking(ObjectModelCursor *c, size_t limit) noexcept
+{
+	cursor = c;
+	chunkLimit = limit;
+	if (c->inProgress)
+	{
+		resumeLevels = c->depth;
+		startMillis = c->startMillis;				// use the same start time as the first chunk so that time-dependent values are consistent
+	}
+	else
+	{
+		resumeLevels = 0;
+		c->startMillis = startMillis;
+	}
+}
+
+// Call this when starting to report an object or array. If we are resuming at this level, set 'resumeIndex' to the index of the entry or element to resume at
+// and 'written' to true if we had already written an entry or element at this level, and return true. Otherwise set them to 0 and false and return false.
+bool ObjectExplorationContext::BeginChunkLevel(size_t& resumeIndex, bool& written) noexcept
+{
+	if (cursorLevel < resumeLevels)
+	{
+		const uint16_t pos = cursor->positions[cursorLevel];
+		resumeIndex = pos & ~ObjectModelCursor::WrittenFlag;
+		written = (pos & ObjectModelCursor::WrittenFlag) != 0;
+		++cursorLevel;
+		if (cursorLevel == resumeLevels)
+		{
+			resumeLevels = 0;								// this is the level we stopped at, so we have finished resuming
+		}
+		return true;
+	}
+
+	resumeIndex = 0;
+	written = false;
+	++cursorLevel;
+	return false;
+}
+
+// We have reached the end of the chunk before the entry or element with the specified index at the current level. Record where we are and start returning to the root.
+bool ObjectExplorationContext::Stop(size_t index, bool written) noexcept
+{
+	cursor->depth = cursorLevel;
+	cursor->inProgress = true;
+	cursor->positions[cursorLevel - 1] = (uint16_t)index | ((written) ? ObjectModelCursor::WrittenFlag : 0);
+	stopping = true;
+	return true;
+}
+
+// Record where we are at this level while returning to the root after stopping at a deeper level.
+// We were part way through the entry or element with the specified index, so we must have written something at this level.
+void ObjectExplorationContext::NoteStopped(size_t index) noexcept
+{
+	cursor->positions[cursorLevel - 1] = (uint16_t)index | ObjectModelCursor::WrittenFlag;
+}
+
 GCodeException ObjectExplorationContext::ConstructParseException(const char *msg) const noexcept
 {
 	return GCodeException(line, column, msg);
@@ -634,14 +748,37 @@ void ObjectModel::ReportAsJson(OutputBuffer* buf, ObjectExplorationContext& cont
 {
 	if (context.IncreaseDepth())
 	{
-		bool added = false;
+		bool added;													// true if we have written at least one entry, including in previous chunks
+		size_t resumeIndex;
+		(void)context.BeginChunkLevel(resumeIndex, added);
+		bool resumingEntry = context.IsResumingThrough();
 		if (classDescriptor == nullptr)
 		{
 			classDescriptor = GetObjectModelClassDescriptor();
 		}
 
+		// If the filter selects a single field and we have a compiled version of the path, use it to avoid searching the tables
+		const bool singleField = (*filter != 0 && *filter != '*');
+		const ObjectModelClassDescriptor *_ecv_null const leafDescriptor = classDescriptor;
+		const ObjectModelClassDescriptor *_ecv_null foundDescriptor;
+		const ObjectModelTableEntry *_ecv_null const compiledEntry = (singleField) ? context.LookupCompiledPath(filter, leafDescriptor, tableNumber, foundDescriptor) : nullptr;
+		if (compiledEntry != nullptr)
+		{
+			if (context.ShouldReport(compiledEntry->flags))
+			{
+				ReadLocker lock(GetObjectLock(tableNumber));
+				added = compiledEntry->ReportAsJson(buf, context, foundDescriptor, this, filter, true);
+				if (context.IsStopping())
+				{
+					context.NoteStopped(0);
+				}
+			}
+			classDescriptor = nullptr;								// skip the search
+		}
+
 		// Loop doing this object followed by its ancestors
-		while (classDescriptor != nullptr)
+		size_t index = 0;											// the index of the entry we are looking at, counting from the start of the most derived class
+		while (classDescriptor != nullptr && !context.IsStopping())
 		{
 			const uint8_t * const descriptor = classDescriptor->omd;
 			if (tableNumber < descriptor[0])
@@ -655,16 +792,31 @@ void ObjectModel::ReportAsJson(OutputBuffer* buf, ObjectExplorationContext& cont
 				size_t numEntries = descriptor[tableNumber + 1];
 				while (numEntries != 0)
 				{
-					if (tbl->Matches(filter, context))
+					if (index >= resumeIndex && tbl->Matches(filter, context))
 					{
+						if (!resumingEntry && context.ShouldStopBefore(buf, index, added))
+						{
+							break;
+						}
+						if (singleField)
+						{
+							context.RecordCompiledPath(filter, leafDescriptor, tableNumber, classDescriptor, tbl);
+						}
 						ReadLocker lock(GetObjectLock(tableNumber));
 						if (tbl->ReportAsJson(buf, context, classDescriptor, this, filter, !added))
 						{
 							added = true;
 						}
+						if (context.IsStopping())
+						{
+							context.NoteStopped(index);
+							break;
+						}
+						resumingEntry = false;
 					}
 					--numEntries;
 					++tbl;
+					++index;
 				}
 			}
 			if (tableNumber != 0)
@@ -674,17 +826,21 @@ void ObjectModel::ReportAsJson(OutputBuffer* buf, ObjectExplorationContext& cont
 			classDescriptor = classDescriptor->parent;			// do parent table too
 		}
 
-		if (added)
+		if (!context.IsStopping())
 		{
-			if (*filter == 0)
+			if (added)
 			{
-				buf->cat('}');
+				if (*filter == 0)
+				{
+					buf->cat('}');
+				}
+			}
+			else
+			{
+				buf->cat((*filter == 0) ? "{}" : "null");
 			}
 		}
-		else
-		{
-			buf->cat((*filter == 0) ? "{}" : "null");
-		}
+		context.EndChunkLevel();
 		context.DecreaseDepth();
 	}
 	else
@@ -694,15 +850,106 @@ void ObjectModel::ReportAsJson(OutputBuffer* buf, ObjectExplorationContext& cont
 }
 
 // Construct a JSON representation of those parts of the object model requested by the user. This version is called on the root of the tree.
-void ObjectModel::ReportAsJson(const GCodeBuffer *_ecv_null gb, OutputBuffer *buf, const char *_ecv_array filter, const char *_ecv_array reportFlags, bool wantArrayLength) const THROWS(GCodeException)
+// If a cursor is passed then we generate the report in chunks of about ObjectModelChunkSize bytes, returning true when we have generated the last one.
+// Delta reports are always generated in one go, because we may need to remove output that we have already generated.
+bool ObjectModel::ReportAsJson(const GCodeBuffer *_ecv_null gb, OutputBuffer *buf, const char *_ecv_array filter, const char *_ecv_array reportFlags, bool wantArrayLength,
+								ObjectModelCursor *_ecv_null cursor) const THROWS(GCodeException)
 {
 	const unsigned int defaultMaxDepth = (wantArrayLength) ? 99 : (filter[0] == 0) ? 1 : 99;
 	ObjectExplorationContext context(gb, wantArrayLength, reportFlags, defaultMaxDepth, buf->Length());
-	ReportAsJson(buf, context, nullptr, 0, filter);
+	uint32_t reportNumber = 0, startToken = 0;
+	if (context.IsDeltaReport())
+	{
+		startToken = ObjectModelChangeTracker::StartReport(reportNumber);
+		if (context.GetDeltaToken() > startToken)
+		{
+			context.SetDeltaToken(0);						// the token was issued before we were restarted, so report everything
+		}
+	}
+	else if (cursor != nullptr)
+	{
+		context.SetChunking(cursor, buf->Length() + ObjectModelChunkSize);
+	}
+	ObjectModelPath *_ecv_null const path = (filter[0] == 0) ? nullptr : ObjectModelPathCache::Acquire(filter);
+	context.SetCompiledPath(path, filter);
+	try
+	{
+		ReportAsJson(buf, context, nullptr, 0, filter);
+	}
+	catch (...)
+	{
+		if (path != nullptr)
+		{
+			ObjectModelPathCache::Release(path, false);
+		}
+		if (context.IsDeltaReport())
+		{
+			(void)ObjectModelChangeTracker::FinishReport(reportNumber, startToken);
+		}
+		throw;
+	}
+	if (path != nullptr)
+	{
+		ObjectModelPathCache::Release(path, true);
+	}
+	if (context.IsStopping())
+	{
+		return false;
+	}
+	if (cursor != nullptr)
+	{
+		cursor->Reset();
+	}
 	if (context.GetNextElement() >= 0)
 	{
 		buf->catf(",\"next\":%d", context.GetNextElement());
 	}
+	if (context.IsDeltaReport())
+	{
+		buf->catf(",\"token\":%" PRIu32, ObjectModelChangeTracker::FinishReport(reportNumber, startToken));
+	}
+	return true;
+}
+
+// Report a named value or object as part of a delta report, returning true if we reported it.
+// If it was selected by the filter then we always report it. Otherwise we report it only if it or something within it has changed since the client's token.
+bool ObjectModel::ReportChangedItemAsJson(OutputBuffer *buf, ObjectExplorationContext& context, const ObjectModelClassDescriptor *_ecv_null classDescriptor, uint32_t key,
+											const char *_ecv_array name, const ExpressionValue& val, bool selected, const char *_ecv_array filter, const char *_ecv_array prefix) const THROWS(GCodeException)
+{
+	const ObjectExplorationContext::DeltaState state = context.BeginDeltaItem(key, val);
+	bool reported = true;
+	if (selected)
+	{
+		ReportItemAsJson(buf, context, classDescriptor, val, filter);
+	}
+	else if (!val.IsObjectOrArrayType())
+	{
+		// Only write a value if it has changed. We report nulls too, so that the client knows when a value has been cleared.
+		reported = context.DeltaChangedSince(state);
+		if (reported)
+		{
+			buf->cat(prefix);
+			buf->cat(name);
+			buf->cat("\":");
+			ReportItemAsJson(buf, context, classDescriptor, val, filter);
+		}
+	}
+	else
+	{
+		// We can't tell whether anything within an object or array has changed until we have visited it, so discard what we wrote if nothing has
+		const size_t startLength = buf->Length();
+		buf->cat(prefix);
+		buf->cat(name);
+		buf->cat("\":");
+		ReportItemAsJson(buf, context, classDescriptor, val, filter);
+		if (!context.DeltaChangedSince(state))
+		{
+			buf->TruncateTo(startLength);
+			reported = false;
+		}
+	}
+	context.EndDeltaItem(state);
+	return reported;
 }
 
 void ObjectModel::ReportArrayLengthAsJson(OutputBuffer *buf, ObjectExplorationContext& context, const ExpressionValue& val) const noexcept
@@ -782,7 +1029,9 @@ void ObjectModel::ReportItemAsJsonFull(OutputBuffer *buf, ObjectExplorationConte
 						// As at release 3.1.1 this next block uses the most stack of this entire function
 						ReadLocker lock(entry->lockPointer);
 						const ExpressionValue element = entry->GetElement(this, context);
+						const ObjectExplorationContext::DeltaState elementState = context.BeginDeltaItem(index, element);
 						ReportItemAsJson(buf, context, classDescriptor, element, endptr + 1);
+						context.EndDeltaItem(elementState);
 					}
 					context.RemoveIndex();
 					if (*filter == 0)
@@ -827,7 +1076,9 @@ void ObjectModel::ReportItemAsJsonFull(OutputBuffer *buf, ObjectExplorationConte
 				{
 					buf->cat('[');
 				}
+				const ObjectExplorationContext::DeltaState elementState = context.BeginDeltaItem(index, element);
 				ReportItemAsJson(buf, context, classDescriptor, element, endptr + 1);
+				context.EndDeltaItem(elementState);
 
 				if (*filter == 0)
 				{
@@ -1061,69 +1312,125 @@ void ObjectModel::ReportPinNameAsJson(OutputBuffer *buf, const ExpressionValue&
 void ObjectModel::ReportObjectModelArrayAsJson(OutputBuffer *buf, ObjectExplorationContext& context, const ObjectModelClassDescriptor *null classDescriptor,
 												const ObjectModelArrayTableEntry *entry, const char *_ecv_array filter) const THROWS(GCodeException)
 {
-	const bool isRootArray = (buf->Length() == context.GetInitialBufferOffset());		// it's a root array if we haven't started writing to the buffer yet
+	// It's a root array if we haven't started writing to the buffer yet. Chunked reports don't need the array to be split across several requests.
+	const bool isRootArray = (buf->Length() == context.GetInitialBufferOffset() && !context.IsChunked());
 	ReadLocker lock(entry->lockPointer);
 
-	buf->cat('[');
+	size_t resumeIndex;
+	bool written;
+	if (!context.BeginChunkLevel(resumeIndex, written))
+	{
+		buf->cat('[');
+	}
+	const bool resumingElement = context.IsResumingThrough();
 	const size_t count = entry->GetNumElements(this, context);
-	const size_t startElement = (isRootArray) ? context.GetStartElement() : 0;
+	const ObjectExplorationContext::DeltaState arrayState = context.BeginDeltaItem(ArrayLengthKey, ExpressionValue((int32_t)count), true);
+	const size_t startElement = (isRootArray) ? context.GetStartElement() : resumeIndex;
 	for (size_t i = startElement; i < count; ++i)
 	{
-		// Support retrieving just part of the array in case it is too large to write all of it to the buffer
-		if (i != startElement)
+		if (i != startElement || !resumingElement)
 		{
-			if (isRootArray && buf->Length() >= (OUTPUT_BUFFER_SIZE * (OUTPUT_BUFFER_COUNT - RESERVED_OUTPUT_BUFFERS))/2)
+			if (context.ShouldStopBefore(buf, i, i != startElement || written))
 			{
-				// We've used half the buffer space already, so stop reporting
-				context.SetNextElement(i);
 				break;
 			}
-			buf->cat(',');
+
+			// Support retrieving just part of the array in case it is too large to write all of it to the buffer
+			if (i != startElement || written)
+			{
+				if (isRootArray && buf->Length() >= (OUTPUT_BUFFER_SIZE * (OutputBuffer::GetNumBuffers() - RESERVED_OUTPUT_BUFFERS))/2)
+				{
+					// We've used half the buffer space already, so stop reporting
+					context.SetNextElement(i);
+					break;
+				}
+				buf->cat(',');
+			}
 		}
 		context.AddIndex(i);
 		const ExpressionValue element = entry->GetElement(this, context);
+		const ObjectExplorationContext::DeltaState elementState = context.BeginDeltaItem(i, element);
 		ReportItemAsJson(buf, context, classDescriptor, element, filter);
+		context.EndDeltaItem(elementState);
 		context.RemoveIndex();
+		if (context.IsStopping())
+		{
+			context.NoteStopped(i);
+			break;
+		}
 	}
+	context.EndDeltaItem(arrayState);
 	if (isRootArray && context.GetNextElement() < 0)
 	{
 		context.SetNextElement(0);
 	}
-	buf->cat(']');
+	if (!context.IsStopping())
+	{
+		buf->cat(']');
+	}
+	context.EndChunkLevel();
 }
 
 // Report an entire array as JSON
 void ObjectModel::ReportHeapArrayAsJson(OutputBuffer *buf, ObjectExplorationContext& context, const ObjectModelClassDescriptor *null classDescriptor,
 											ArrayHandle ah, const char *_ecv_array filter) const THROWS(GCodeException)
 {
-	const bool isRootArray = (buf->Length() == context.GetInitialBufferOffset());		// it's a root array if we haven't started writing to the buffer yet
-	buf->cat('[');
+	// It's a root array if we haven't started writing to the buffer yet. Chunked reports don't need the array to be split across several requests.
+	const bool isRootArray = (buf->Length() == context.GetInitialBufferOffset() && !context.IsChunked());
+	size_t resumeIndex;
+	bool written;
+	if (!context.BeginChunkLevel(resumeIndex, written))
+	{
+		buf->cat('[');
+	}
+	const bool resumingElement = context.IsResumingThrough();
 
 	ReadLocker lock(Heap::heapLock);
 	const size_t count = ah.GetNumElements();
-	const size_t startElement = (isRootArray) ? context.GetStartElement() : 0;
+	const ObjectExplorationContext::DeltaState arrayState = context.BeginDeltaItem(ArrayLengthKey, ExpressionValue((int32_t)count), true);
+	const size_t startElement = (isRootArray) ? context.GetStartElement() : resumeIndex;
 	for (size_t i = startElement; i < count; ++i)
 	{
-		// Support retrieving just part of the array in case it is too large to write all of it to the buffer
-		if (i != startElement)
+		if (i != startElement || !resumingElement)
 		{
-			if (isRootArray && buf->Length() >= (OUTPUT_BUFFER_SIZE * (OUTPUT_BUFFER_COUNT - RESERVED_OUTPUT_BUFFERS))/2)
+			if (context.ShouldStopBefore(buf, i, i != startElement || written))
 			{
-				// We've used half the buffer space already, so stop reporting
-				context.SetNextElement(i);
 				break;
 			}
-			buf->cat(',');
+
+			// Support retrieving just part of the array in case it is too large to write all of it to the buffer
+			if (i != startElement || written)
+			{
+				if (isRootArray && buf->Length() >= (OUTPUT_BUFFER_SIZE * (OutputBuffer::GetNumBuffers() - RESERVED_OUTPUT_BUFFERS))/2)
+				{
+					// We've used half the buffer space already, so stop reporting
+					context.SetNextElement(i);
+					break;
+				}
+				buf->cat(',');
+			}
 		}
 		ExpressionValue element;
 		ah.GetElement(i, element);
+		const ObjectExplorationContext::DeltaState elementState = context.BeginDeltaItem(i, element);
 		ReportItemAsJson(buf, context, classDescriptor, element, filter);
+		context.EndDeltaItem(elementState);
+		if (context.IsStopping())
+		{
+			context.NoteStopped(i);
+			break;
+		}
 	}
+	context.EndDeltaItem(arrayState);
 	if (isRootArray && context.GetNextElement() < 0)
 	{
 		context.SetNextElement(0);
 	}
-	buf->cat(']');
+	if (!context.IsStopping())
+	{
+		buf->cat(']');
+	}
+	context.EndChunkLevel();
 }
 
 // Find the requested entry
@@ -1186,11 +1493,16 @@ bool ObjectModelTableEntry::ReportAsJson(OutputBuffer* buf, ObjectExplorationCon
 {
 	const char * nextElement = ObjectModel::GetNextElement(filter);
 	const ExpressionValue val = func(self, context);
+	if (context.IsDeltaReport())
+	{
+		return self->ReportChangedItemAsJson(buf, context, classDescriptor, reinterpret_cast<uint32_t>(name), name, val, *filter != 0, nextElement, (first) ? "{\"" : ",\"");
+	}
+
 	// We include nulls if either the "include nulls" flag is set or the "include important" flag is set and the field is flagged important.
 	// The latter is so that field state.messageBox gets reported to PanelDue even if null when the "important" flag is set, so that PanelDue knows when a message has been cleared.
 	if (val.GetType() != TypeCode::None || context.ShouldIncludeNulls() || (context.ShouldIncludeImportant() && ((uint8_t)flags & (uint8_t)ObjectModelEntryFlags::important)))
 	{
-		if (*filter == 0)
+		if (*filter == 0 && !context.IsResumingThrough())			// if we are resuming part way through this entry then we wrote its name in a previous chunk
 		{
 			buf->cat((first) ? "{\"" : ",\"");
 			buf->cat(name);
@@ -1230,27 +1542,39 @@ decrease(strlen(idString))	// recursion variant
 		classDescriptor = GetObjectModelClassDescriptor();
 	}
 
-	// Loop through this class and its ancestors
-	while (classDescriptor != nullptr)
+	// If we have a compiled version of this path then it tells us which table entry to use
+	const ObjectModelClassDescriptor *_ecv_null const leafDescriptor = classDescriptor;
+	const ObjectModelTableEntry *_ecv_null e = context.LookupCompiledPath(idString, leafDescriptor, tableNumber, classDescriptor);
+
+	// Otherwise loop through this class and its ancestors
+	while (e == nullptr && classDescriptor != nullptr)
 	{
-		const ObjectModelTableEntry * const e = FindObjectModelTableEntry(classDescriptor, tableNumber, idString);
+		e = FindObjectModelTableEntry(classDescriptor, tableNumber, idString);
 		if (e != nullptr)
 		{
-			if (e->IsObsolete())
-			{
-				context.SetObsoleteFieldQueried();
-			}
-			idString = GetNextElement(idString);
-			const ExpressionValue val = e->func(this, context);
-			context.CheckStack(StackUsage::GetObjectValue_noTable);
-			ReadLocker lock(GetObjectLock(tableNumber));
-			return GetObjectValue(context, classDescriptor, val, idString);
+			context.RecordCompiledPath(idString, leafDescriptor, tableNumber, classDescriptor, e);
 		}
-		if (tableNumber != 0)
+		else if (tableNumber != 0)
 		{
 			break;
 		}
-		classDescriptor = classDescriptor->parent;			// search parent class object model too
+		else
+		{
+			classDescriptor = classDescriptor->parent;			// search parent class object model too
+		}
+	}
+
+	if (e != nullptr)
+	{
+		if (e->IsObsolete())
+		{
+			context.SetObsoleteFieldQueried();
+		}
+		idString = GetNextElement(idString);
+		const ExpressionValue val = e->func(this, context);
+		context.CheckStack(StackUsage::GetObjectValue_noTable);
+		ReadLocker lock(GetObjectLock(tableNumber));
+		return GetObjectValue(context, classDescriptor, val, idString);
 	}
 
 	if (context.WantExists())
@@ -1261,6 +1585,32 @@ decrease(strlen(idString))	// recursion variant
 	throw context.ConstructParseException("unknown value '%s'", idString);
 }
 
+// Get the value of an object model path starting at this object, using a compiled version of the path if possible.
+// If we don't have a compiled version then we compile it as we look it up.
+ExpressionValue ObjectModel::GetObjectValueUsingCompiledPath(ObjectExplorationContext& context, const char *_ecv_array idString) const THROWS(GCodeException)
+{
+	ObjectModelPath *_ecv_null const path = ObjectModelPathCache::Acquire(idString);
+	if (path == nullptr)
+	{
+		return GetObjectValueUsingTableNumber(context, nullptr, idString, 0);
+	}
+
+	context.SetCompiledPath(path, idString);
+	try
+	{
+		ExpressionValue rslt = GetObjectValueUsingTableNumber(context, nullptr, idString, 0);
+		context.SetCompiledPath(nullptr, nullptr);
+		ObjectModelPathCache::Release(path, true);
+		return rslt;
+	}
+	catch (...)
+	{
+		context.SetCompiledPath(nullptr, nullptr);
+		ObjectModelPathCache::Release(path, false);
+		throw;
+	}
+}
+
 ExpressionValue ObjectModel::GetObjectValue(ObjectExplorationContext& context, const ObjectModelClassDescriptor *classDescriptor, const ExpressionValue& val, const char *_ecv_array idString) const THROWS(GCodeException)
 decrease(strlen(idString))	// recursion variant
 {
@@ -16,6 +16,7 @@
 #if SUPPORT_OBJECT_MODEL
 
 #include "TypeCode.h"
+#include "ObjectModelPath.h"
 #include <General/IPAddress.h>
 #include <General/Bitmap.h>
 #include <RTOSIface/RTOSIface.h>
@@ -137,6 +138,8 @@ struct ExpressionValue
 
 	TypeCode GetType() const noexcept { return (TypeCode)type; }
 	bool IsStringType() const noexcept { return type == (uint32_t)TypeCode::CString || type == (uint32_t)TypeCode::HeapString; }
+	bool IsObjectOrArrayType() const noexcept
+		{ return type == (uint32_t)TypeCode::ObjectModel_tc || type == (uint32_t)TypeCode::ObjectModelArray || type == (uint32_t)TypeCode::HeapArray; }
 	bool IsHeapStringArrayType() const noexcept;
 
 	void SetBool(bool b) noexcept;
@@ -193,6 +196,32 @@ enum class ObjectModelEntryFlags : uint8_t
 	obsolete = 8				// entry is deprecated and should not be used any more
 };
 
+// Cursor used to generate a large object model report in several chunks, so that we don't need enough output buffers to hold all of it at once.
+// It records where we stopped, as the index of the entry or element we had reached at each level of nesting of objects and arrays.
+// It also records when the report was started, so that all the chunks report the same up time and sensor histories, and a signature of the
+// object model sequence numbers so that we can tell if the model has changed between chunks, in which case the positions may no longer be valid.
+class ObjectModelCursor
+{
+public:
+	friend class ObjectExplorationContext;
+
+	ObjectModelCursor() noexcept { Reset(); }
+	void Reset() noexcept { depth = 0; inProgress = false; }
+	bool IsInProgress() const noexcept { return inProgress; }		// true if we have generated at least one chunk and there are more to come
+	void SetModelSignature(uint32_t sig) noexcept { modelSignature = sig; }
+	bool ModelChanged(uint32_t sig) const noexcept { return sig != modelSignature; }
+
+private:
+	static constexpr size_t MaxDepth = 12;
+	static constexpr uint16_t WrittenFlag = 0x8000;				// flag in a position to say that we had already written an entry or element at that level
+
+	uint64_t startMillis;										// the start time of the context that generated the first chunk
+	uint32_t modelSignature;									// the signature of the object model sequence numbers when we generated the first chunk
+	uint16_t positions[MaxDepth];
+	uint8_t depth;
+	bool inProgress;
+};
+
 // Context passed to object model functions
 class ObjectExplorationContext
 {
@@ -227,11 +256,59 @@ public:
 	bool ShouldIncludeNulls() const noexcept { return includeNulls; }
 	bool ShouldIncludeImportant() const noexcept { return includeImportant; }
 	uint64_t GetStartMillis() const { return startMillis; }
+	bool WantHistory() const noexcept { return wantHistory; }
+	uint64_t GetHistorySince() const noexcept { return historySince; }
 	size_t GetInitialBufferOffset() const noexcept { return initialBufOffset; }
 
 	bool ObsoleteFieldQueried() const noexcept { return obsoleteFieldQueried; }
 	void SetObsoleteFieldQueried() noexcept { obsoleteFieldQueried = true; }
 
+	// Compiled path support
+	void SetCompiledPath(ObjectModelPath *_ecv_null p, const char *_ecv_array base) noexcept { compiledPath = p; compiledPathBase = base; }
+	const ObjectModelTableEntry *_ecv_null LookupCompiledPath(const char *_ecv_array id, const ObjectModelClassDescriptor *_ecv_null leafDescriptor, uint8_t tableNumber,
+																const ObjectModelClassDescriptor *_ecv_null& foundDescriptor) const noexcept;
+	void RecordCompiledPath(const char *_ecv_array id, const ObjectModelClassDescriptor *_ecv_null leafDescriptor, uint8_t tableNumber,
+								const ObjectModelClassDescriptor *_ecv_null foundDescriptor, const ObjectModelTableEntry *entry) noexcept;
+
+	// Delta report support
+	struct DeltaState
+	{
+		uint32_t pathHash;
+		uint32_t changes;
+		bool reportAll;
+	};
+
+	bool IsDeltaReport() const noexcept { return deltaReport; }
+	uint32_t GetDeltaToken() const noexcept { return deltaToken; }
+	void SetDeltaToken(uint32_t t) noexcept { deltaToken = t; }
+
+	// Call this before reporting an item in a delta report. 'key' identifies the item within its parent. Pass the returned state to EndDeltaItem afterwards.
+	DeltaState BeginDeltaItem(uint32_t key, const ExpressionValue& val, bool reportAllIfChanged = false) noexcept
+	{
+		const DeltaState state = { deltaPathHash, deltaChanges, (bool)deltaReportAll };
+		if (deltaReport)
+		{
+			NoteDeltaItem(key, val, reportAllIfChanged || val.IsObjectOrArrayType());
+		}
+		return state;
+	}
+
+	void EndDeltaItem(const DeltaState& state) noexcept { deltaPathHash = state.pathHash; deltaReportAll = state.reportAll; }
+	bool DeltaChangedSince(const DeltaState& state) const noexcept { return deltaReportAll || deltaChanges != state.changes; }
+
+	// Chunked report support
+	void SetChunking(ObjectModelCursor *c, size_t limit) noexcept;
+	bool IsChunked() const noexcept { return cursor != nullptr; }
+	bool IsStopping() const noexcept { return stopping; }
+	bool IsResumingThrough() const noexcept { return cursorLevel < resumeLevels; }	// true if the next entry or element at this level is one that we stopped part way through
+	bool BeginChunkLevel(size_t& resumeIndex, bool& written) noexcept;
+	void EndChunkLevel() noexcept { --cursorLevel; }
+	bool ShouldStopBefore(const OutputBuffer *buf, size_t index, bool written) noexcept
+		{ return cursor != nullptr && buf->Length() >= chunkLimit && noStopCount == 0 && cursorLevel <= ObjectModelCursor::MaxDepth && Stop(index, written); }
+	void NoteStopped(size_t index) noexcept;
+	void DisallowStopping() noexcept { ++noStopCount; }
+	void AllowStopping() noexcept { --noStopCount; }
+
 	GCodeException ConstructParseException(const char *msg) const noexcept;
 	GCodeException ConstructParseException(const char *msg, const char *sparam) const noexcept;
 	void CheckStack(uint32_t calledFunctionStackUsage) const THROWS(GCodeException);
@@ -239,7 +316,11 @@ public:
 private:
 	static constexpr size_t MaxIndices = 4;			// max depth of array nesting
 
+	void NoteDeltaItem(uint32_t key, const ExpressionValue& val, bool reportAllIfChanged) noexcept;
+	bool Stop(size_t index, bool written) noexcept;
+
 	uint64_t startMillis;							// the milliseconds counter when we started exploring the OM. Stored so that upTime and msUpTime are consistent.
+	uint64_t historySince;							// when reporting sensor histories, the time of the oldest sample that the client wants
 	size_t initialBufOffset;
 	unsigned int maxDepth;
 	unsigned int currentDepth;
@@ -251,6 +332,16 @@ private:
 	int line;
 	int column;
 	const GCodeBuffer *_ecv_null gb;
+	ObjectModelPath *_ecv_null compiledPath;		// the compiled version of the path we are looking up or reporting, if any
+	const char *_ecv_array _ecv_null compiledPathBase;	// the start of the path string that the offsets in the compiled path refer to
+	uint32_t deltaToken;							// when doing a delta report, the token that the client passed
+	uint32_t deltaPathHash;							// when doing a delta report, the hash of the path to the current item
+	uint32_t deltaChanges;							// when doing a delta report, the number of changed items we have found so far
+	ObjectModelCursor *_ecv_null cursor;			// when doing a chunked report, where to resume and where to record where we stopped
+	size_t chunkLimit;								// when doing a chunked report, the buffer length at which we stop
+	unsigned int cursorLevel;						// the current level of nesting of objects and arrays
+	unsigned int resumeLevels;						// the number of levels that we are resuming through
+	unsigned int noStopCount;						// if nonzero then we must not stop here
 	unsigned int shortForm : 1,
 				wantArrayLength : 1,
 				wantExists : 1,
@@ -259,7 +350,11 @@ private:
 				includeNulls : 1,
 				excludeVerbose : 1,
 				excludeObsolete : 1,
-				obsoleteFieldQueried : 1;
+				obsoleteFieldQueried : 1,
+				deltaReport : 1,
+				deltaReportAll : 1,						// true if we are reporting everything within an object or array that has changed identity or length
+				wantHistory : 1,						// true if the client asked for sensor histories
+				stopping : 1;							// true if we have reached the end of a chunk and are returning to the root
 };
 
 // Entry to describe an array of objects or values. These must be brace-initializable into flash memory.
@@ -284,7 +379,12 @@ public:
 	const ObjectModelArrayTableEntry *FindObjectModelArrayEntry(unsigned int index) const noexcept { return GetObjectModelArrayEntry(index); }
 
 	// Construct a JSON representation of those parts of the object model requested by the user. This version is called only on the root of the tree.
-	void ReportAsJson(const GCodeBuffer *_ecv_null gb, OutputBuffer *buf, const char *_ecv_array filter, const char *_ecv_array reportFlags, bool wantArrayLength) const THROWS(GCodeException);
+	// If a cursor is passed then we generate the report in chunks, returning true when we have generated the last one.
+	bool ReportAsJson(const GCodeBuffer *_ecv_null gb, OutputBuffer *buf, const char *_ecv_array filter, const char *_ecv_array reportFlags, bool wantArrayLength,
+						ObjectModelCursor *_ecv_null cursor = nullptr) const THROWS(GCodeException);
+
+	// Get the value of an object model path starting at this object, using a compiled version of the path if possible
+	ExpressionValue GetObjectValueUsingCompiledPath(ObjectExplorationContext& context, const char *_ecv_array idString) const THROWS(GCodeException);
 
 	// Get the value of an object via the table
 	ExpressionValue GetObjectValueUsingTableNumber(ObjectExplorationContext& context, const ObjectModelClassDescriptor * null classDescriptor, const char *_ecv_array idString, uint8_t tableNumber) const THROWS(GCodeException);
@@ -293,6 +393,10 @@ public:
 	void ReportItemAsJson(OutputBuffer *buf, ObjectExplorationContext& context, const ObjectModelClassDescriptor *classDescriptor,
 							const ExpressionValue& val, const char *_ecv_array filter) const THROWS(GCodeException);
 
+	// Report a named value or object as part of a delta report, returning true if we reported it
+	bool ReportChangedItemAsJson(OutputBuffer *buf, ObjectExplorationContext& context, const ObjectModelClassDescriptor *_ecv_null classDescriptor, uint32_t key,
+									const char *_ecv_array name, const ExpressionValue& val, bool selected, const char *_ecv_array filter, const char *_ecv_array prefix) const THROWS(GCodeException);
+
 	// Skip the current element in the ID or filter string
 	static const char* GetNextElement(const char *id) noexcept;
 
@@ -0,0 +1,151 @@
+/*
+ * ObjectModelChanges.cpp
+ *
+ *  Created on: 19 Oct 2026
+ */
+
+#include "ObjectModelChanges.h"
+
+#if SUPPORT_OBJECT_MODEL
+
+#include "ObjectModel.h"
+#include <Platform/Platform.h>
+#include <Platform/RepRap.h>
+#include <Hardware/IoPorts.h>
+
+static_assert((NumObjectModelChangeSlots & (NumObjectModelChangeSlots - 1)) == 0, "NumObjectModelChangeSlots must be a power of 2");
+
+ObjectModelChangeTracker::Slot ObjectModelChangeTracker::slots[NumObjectModelChangeSlots];
+uint32_t ObjectModelChangeTracker::currentToken = 1;
+uint32_t ObjectModelChangeTracker::reportsStarted = 0;
+unsigned int ObjectModelChangeTracker::activeReports = 0;
+uint32_t ObjectModelChangeTracker::fieldsChecked = 0;
+uint32_t ObjectModelChangeTracker::fieldsChanged = 0;
+uint32_t ObjectModelChangeTracker::evictions = 0;
+
+/*static*/ uint32_t ObjectModelChangeTracker::AddToHash(uint32_t hash, const char *_ecv_array s) noexcept
+{
+	while (*s != 0)
+	{
+		hash = AddToHash(hash, (uint8_t)*s++);
+	}
+	return hash;
+}
+
+// Hash the value of a field. For objects and arrays we hash their identity, not their contents.
+/*static*/ uint32_t ObjectModelChangeTracker::HashValue(const ExpressionValue& val) noexcept
+{
+	uint32_t h = AddToHash(AddToHash(InitialPathHash, val.type), val.param);
+	switch (val.GetType())
+	{
+	case TypeCode::CString:
+		return (val.sVal == nullptr) ? h : AddToHash(h, val.sVal);
+
+	case TypeCode::HeapString:
+		return AddToHash(h, val.shVal.Get().Ptr());
+
+#if SUPPORT_CAN_EXPANSION
+	case TypeCode::CanExpansionBoardDetails:
+		return (val.sVal == nullptr) ? h : AddToHash(h, val.sVal);
+#endif
+
+	case TypeCode::Port:
+		{
+			String<StringLength50> portName;
+			val.iopVal->AppendPinName(portName.GetRef());
+			return AddToHash(h, portName.c_str());
+		}
+
+#if HAS_MASS_STORAGE || HAS_EMBEDDED_FILES || HAS_SBC_INTERFACE
+	case TypeCode::Special:
+		return AddToHash(h, reprap.GetPlatform().GetSysDir().Ptr());
+#endif
+
+	case TypeCode::None:
+		return h;
+
+	default:
+		return AddToHash(h, val.whole);
+	}
+}
+
+// Start a delta report, returning the current token
+/*static*/ uint32_t ObjectModelChangeTracker::StartReport(uint32_t& reportNumber) noexcept
+{
+	TaskCriticalSectionLocker lock;
+	++activeReports;
+	reportNumber = ++reportsStarted;
+	return currentToken;
+}
+
+// Finish a delta report, returning the token that the client should send next time.
+// If no other report was in progress while this one was, the client has seen the latest value of every field that changed, so we can return the current token.
+// Otherwise another report may have recorded a change to a field after we visited it, so we return the token when we started this report.
+/*static*/ uint32_t ObjectModelChangeTracker::FinishReport(uint32_t reportNumber, uint32_t startToken) noexcept
+{
+	TaskCriticalSectionLocker lock;
+	--activeReports;
+	return (activeReports == 0 && reportNumber == reportsStarted) ? currentToken : startToken;
+}
+
+// Record the current value of a field and return true if it has changed since the specified token
+/*static*/ bool ObjectModelChangeTracker::Update(uint32_t pathHash, const ExpressionValue& val, uint32_t sinceToken) noexcept
+{
+	if (pathHash == 0)
+	{
+		pathHash = 1;													// zero marks an unused slot
+	}
+	const uint32_t valueHash = HashValue(val);
+
+	TaskCriticalSectionLocker lock;
+	++fieldsChecked;
+	Slot *victim = nullptr;
+	for (size_t i = 0; i < SlotsPerProbe; ++i)
+	{
+		Slot& s = slots[(pathHash + i) & (NumObjectModelChangeSlots - 1)];
+		if (s.pathHash == pathHash)
+		{
+			if (s.valueHash != valueHash)
+			{
+				s.valueHash = valueHash;
+				s.changedAt = ++currentToken;
+				++fieldsChanged;
+			}
+			return (int32_t)(s.changedAt - sinceToken) > 0;
+		}
+		// Prefer an unused slot, else the one that changed least recently
+		if (victim == nullptr || (victim->pathHash != 0 && (s.pathHash == 0 || (int32_t)(s.changedAt - victim->changedAt) < 0)))
+		{
+			victim = &s;
+		}
+	}
+
+	// We don't know anything about this field, so assume that it has changed
+	if (victim->pathHash != 0)
+	{
+		++evictions;
+	}
+	victim->pathHash = pathHash;
+	victim->valueHash = valueHash;
+	victim->changedAt = ++currentToken;
+	return true;
+}
+
+/*static*/ void ObjectModelChangeTracker::Diagnostics(MessageType mtype) noexcept
+{
+	unsigned int slotsUsed = 0;
+	for (const Slot& s : slots)
+	{
+		if (s.pathHash != 0)
+		{
+			++slotsUsed;
+		}
+	}
+	reprap.GetPlatform().MessageF(mtype, "OM change tracking: %u/%u slots, token %" PRIu32 ", checked %" PRIu32 ", changed %" PRIu32 ", evictions %" PRIu32 "\n",
+									slotsUsed, NumObjectModelChangeSlots, currentToken, fieldsChecked, fieldsChanged, evictions);
+	fieldsChecked = fieldsChanged = evictions = 0;
+}
+
+#endif
+
+// End
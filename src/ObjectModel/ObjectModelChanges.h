@@ -0,0 +1,74 @@
+/*
+ * ObjectModelChanges.h
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * Change tracking for delta object model reports.
+ * A client that requests part of the object model with the 'c' flag followed by the token it received in its previous response (e.g. M409 K"heat" F"d99c1234")
+ * is sent only the fields that have changed since that token, and a new token to use next time. Token 0 requests a full report.
+ *
+ * We don't require every piece of code that changes a value to record the change. Instead, when we generate a delta report we hash the value of each field
+ * that we visit and compare it with the hash we stored the last time any client visited it. If it differs, we record that the field changed at a new token value.
+ * Fields are identified by a hash of their path through the object model, including array indices.
+ * The table has a fixed size, so if a field is not found in it we assume that it has changed. This means that a client may be sent a field that has not changed,
+ * but never misses one that has.
+ *
+ * Objects whose identity has changed and arrays whose length has changed are reported in full.
+ * A token is only valid for the same key and flags that it was issued for, and only until the firmware is restarted.
+ */
+
+#ifndef SRC_OBJECTMODEL_OBJECTMODELCHANGES_H_
+#define SRC_OBJECTMODEL_OBJECTMODELCHANGES_H_
+
+#include <RepRapFirmware.h>
+
+#if SUPPORT_OBJECT_MODEL
+
+struct ExpressionValue;
+
+class ObjectModelChangeTracker
+{
+public:
+	// Start a delta report, returning the current token. 'reportNumber' is set to a value to pass to FinishReport.
+	static uint32_t StartReport(uint32_t& reportNumber) noexcept;
+
+	// Finish a delta report, returning the token that the client should send next time
+	static uint32_t FinishReport(uint32_t reportNumber, uint32_t startToken) noexcept;
+
+	// Record the current value of a field and return true if it has changed since the specified token
+	static bool Update(uint32_t pathHash, const ExpressionValue& val, uint32_t sinceToken) noexcept;
+
+	// Functions to build the path hash of a field
+	static uint32_t AddToHash(uint32_t hash, uint32_t val) noexcept { return (hash ^ val) * 16777619u; }
+	static uint32_t AddToHash(uint32_t hash, const char *_ecv_array s) noexcept;
+
+	static void Diagnostics(MessageType mtype) noexcept;
+
+	static constexpr uint32_t InitialPathHash = 2166136261u;
+
+private:
+	struct Slot
+	{
+		uint32_t pathHash;								// hash of the path to the field, or zero if the slot is not in use
+		uint32_t valueHash;								// hash of the value of the field when we last visited it
+		uint32_t changedAt;								// the token value when we last saw the value change
+	};
+
+	static constexpr size_t SlotsPerProbe = 4;			// how many slots we look at when searching for a field
+
+	static uint32_t HashValue(const ExpressionValue& val) noexcept;
+
+	static Slot slots[NumObjectModelChangeSlots];
+	static uint32_t currentToken;
+	static uint32_t reportsStarted;
+	static unsigned int activeReports;
+
+	// Statistics
+	static uint32_t fieldsChecked;
+	static uint32_t fieldsChanged;
+	static uint32_t evictions;
+};
+
+#endif
+
+#endif /* SRC_OBJECTMODEL_OBJECTMODELCHANGES_H_ */
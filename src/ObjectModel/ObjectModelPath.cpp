@@ -0,0 +1,149 @@
+/*
+ * ObjectModelPath.cpp
+ *
+ *  Created on: 19 Oct 2026
+ */
+
+#include "ObjectModelPath.h"
+
+#if SUPPORT_OBJECT_MODEL
+
+#include <Platform/Platform.h>
+#include <Platform/RepRap.h>
+#include <RTOSIface/RTOSIface.h>
+
+ObjectModelPath ObjectModelPathCache::paths[NumCompiledObjectModelPaths];
+uint32_t ObjectModelPathCache::useClock = 0;
+uint32_t ObjectModelPathCache::hits = 0;
+uint32_t ObjectModelPathCache::misses = 0;
+
+// Return the recorded table entry for the path element at the specified offset, or nullptr if we don't have one for this class and table number
+const ObjectModelTableEntry *_ecv_null ObjectModelPath::Lookup(size_t offset, const ObjectModelClassDescriptor *_ecv_null leafDescriptor, uint8_t tableNumber,
+																	const ObjectModelClassDescriptor *_ecv_null& foundDescriptor) const noexcept
+{
+	if (state == State::valid)
+	{
+		for (size_t i = 0; i < numSteps; ++i)
+		{
+			const Step& s = steps[i];
+			if (s.offset == offset)
+			{
+				if (s.leafDescriptor == leafDescriptor && s.tableNumber == tableNumber)
+				{
+					foundDescriptor = s.foundDescriptor;
+					return s.entry;
+				}
+				break;
+			}
+		}
+	}
+	return nullptr;
+}
+
+// Record the table entry that the path element at the specified offset resolved to.
+// If we reach the same element more than once (e.g. because the path includes all elements of an array) then we keep the first one.
+void ObjectModelPath::Record(size_t offset, const ObjectModelClassDescriptor *_ecv_null leafDescriptor, uint8_t tableNumber,
+								const ObjectModelClassDescriptor *_ecv_null foundDescriptor, const ObjectModelTableEntry *entry) noexcept
+{
+	if (state == State::compiling && numSteps < MaxCompiledPathSteps && offset < strlen(path))
+	{
+		for (size_t i = 0; i < numSteps; ++i)
+		{
+			if (steps[i].offset == offset)
+			{
+				return;
+			}
+		}
+		Step& s = steps[numSteps++];
+		s.leafDescriptor = leafDescriptor;
+		s.foundDescriptor = foundDescriptor;
+		s.entry = entry;
+		s.tableNumber = tableNumber;
+		s.offset = (uint8_t)offset;
+	}
+}
+
+// FNV-1a hash of the path string
+/*static*/ uint32_t ObjectModelPathCache::Hash(const char *_ecv_array pathString) noexcept
+{
+	uint32_t h = 2166136261u;
+	while (*pathString != 0)
+	{
+		h = (h ^ (uint8_t)*pathString++) * 16777619u;
+	}
+	return h;
+}
+
+// Return the compiled path for the specified string with its use count incremented, or an empty path that the caller should compile, or nullptr if neither is available
+/*static*/ ObjectModelPath *_ecv_null ObjectModelPathCache::Acquire(const char *_ecv_array pathString) noexcept
+{
+	if (strlen(pathString) > MaxCompiledPathLength)
+	{
+		return nullptr;
+	}
+
+	const uint32_t h = Hash(pathString);
+	TaskCriticalSectionLocker lock;
+	ObjectModelPath *_ecv_null victim = nullptr;
+	for (ObjectModelPath& p : paths)
+	{
+		if (p.state == ObjectModelPath::State::valid && p.hash == h && strcmp(p.path, pathString) == 0)
+		{
+			++hits;
+			++p.useCount;
+			p.lastUsed = ++useClock;
+			return &p;
+		}
+		if (p.useCount == 0)
+		{
+			// Choose a free entry if there is one, else the least recently used entry that is not in use
+			if (victim == nullptr
+				|| (victim->state != ObjectModelPath::State::free && (p.state == ObjectModelPath::State::free || (int32_t)(p.lastUsed - victim->lastUsed) < 0))
+			   )
+			{
+				victim = &p;
+			}
+		}
+	}
+
+	++misses;
+	if (victim != nullptr)
+	{
+		victim->state = ObjectModelPath::State::compiling;
+		victim->hash = h;
+		victim->numSteps = 0;
+		victim->useCount = 1;
+		victim->lastUsed = ++useClock;
+		SafeStrncpy(victim->path, pathString, sizeof(victim->path));
+	}
+	return victim;
+}
+
+// Release a compiled path. If the caller was compiling it, it is kept only if the compilation succeeded.
+/*static*/ void ObjectModelPathCache::Release(ObjectModelPath *path, bool ok) noexcept
+{
+	TaskCriticalSectionLocker lock;
+	if (path->state == ObjectModelPath::State::compiling)
+	{
+		path->state = (ok && path->numSteps != 0) ? ObjectModelPath::State::valid : ObjectModelPath::State::free;
+	}
+	--path->useCount;
+}
+
+/*static*/ void ObjectModelPathCache::Diagnostics(MessageType mtype) noexcept
+{
+	unsigned int numValid = 0;
+	for (const ObjectModelPath& p : paths)
+	{
+		if (p.state == ObjectModelPath::State::valid)
+		{
+			++numValid;
+		}
+	}
+	reprap.GetPlatform().MessageF(mtype, "Compiled OM paths %u/%u, hits %" PRIu32 ", misses %" PRIu32 "\n", numValid, NumCompiledObjectModelPaths, hits, misses);
+	hits = misses = 0;
+}
+
+#endif
+
+// End
@@ -0,0 +1,84 @@
+/*
+ * ObjectModelPath.h
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * Compiled object model paths.
+ * Looking up a path such as "move.axes^.machinePosition" or an M409 key such as "heat.heaters[0].current" involves a binary search with string comparisons
+ * at every level of the path. The first time we look up a path, we record the table entry that each element of it resolved to, keyed by the offset of the
+ * element within the path string. Later lookups of the same path use the recorded entries, provided that the object at that level has the same class and
+ * table number as when the entry was recorded. If not (for example because the elements of an array are of different classes) we fall back to the normal search.
+ */
+
+#ifndef SRC_OBJECTMODEL_OBJECTMODELPATH_H_
+#define SRC_OBJECTMODEL_OBJECTMODELPATH_H_
+
+#include <RepRapFirmware.h>
+
+#if SUPPORT_OBJECT_MODEL
+
+class ObjectModelTableEntry;
+struct ObjectModelClassDescriptor;
+
+class ObjectModelPath
+{
+public:
+	friend class ObjectModelPathCache;
+
+	ObjectModelPath() noexcept : hash(0), lastUsed(0), useCount(0), numSteps(0), state(State::free) { path[0] = 0; }
+
+	// Return the recorded table entry for the path element at the specified offset, or nullptr if we don't have one for this class and table number
+	const ObjectModelTableEntry *_ecv_null Lookup(size_t offset, const ObjectModelClassDescriptor *_ecv_null leafDescriptor, uint8_t tableNumber,
+													const ObjectModelClassDescriptor *_ecv_null& foundDescriptor) const noexcept;
+
+	// Record the table entry that the path element at the specified offset resolved to. Only the task that is compiling the path may call this.
+	void Record(size_t offset, const ObjectModelClassDescriptor *_ecv_null leafDescriptor, uint8_t tableNumber,
+					const ObjectModelClassDescriptor *_ecv_null foundDescriptor, const ObjectModelTableEntry *entry) noexcept;
+
+	bool IsBeingCompiled() const noexcept { return state == State::compiling; }
+
+private:
+	enum class State : uint8_t { free = 0, compiling, valid };
+
+	struct Step
+	{
+		const ObjectModelClassDescriptor *_ecv_null leafDescriptor;		// the class descriptor of the object that we searched
+		const ObjectModelClassDescriptor *_ecv_null foundDescriptor;	// the class descriptor that the entry was found in, which may be an ancestor of leafDescriptor
+		const ObjectModelTableEntry *entry;								// the table entry that the element resolved to
+		uint8_t tableNumber;											// the table number within the object
+		uint8_t offset;													// the offset of the element within the path string
+	};
+
+	uint32_t hash;
+	uint32_t lastUsed;
+	unsigned int useCount;
+	uint8_t numSteps;
+	State state;
+	char path[MaxCompiledPathLength + 1];
+	Step steps[MaxCompiledPathSteps];
+};
+
+// Cache of compiled object model paths
+class ObjectModelPathCache
+{
+public:
+	// Return the compiled path for the specified string with its use count incremented, or an empty path that the caller should compile, or nullptr if neither is available
+	static ObjectModelPath *_ecv_null Acquire(const char *_ecv_array pathString) noexcept;
+
+	// Release a compiled path. If the caller was compiling it, it is kept only if the compilation succeeded.
+	static void Release(ObjectModelPath *path, bool ok) noexcept;
+
+	static void Diagnostics(MessageType mtype) noexcept;
+
+private:
+	static uint32_t Hash(const char *_ecv_array pathString) noexcept;
+
+	static ObjectModelPath paths[NumCompiledObjectModelPaths];
+	static uint32_t useClock;
+	static uint32_t hits;
+	static uint32_t misses;
+};
+
+#endif
+
+#endif /* SRC_OBJECTMODEL_OBJECTMODELPATH_H_ */
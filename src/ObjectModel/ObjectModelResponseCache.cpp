@@ -0,0 +1,112 @@
+/*
+ * ObjectModelResponseCache.cpp
+ *
+ *  Created on: 19 Oct 2026
+ */
+
+#include "ObjectModelResponseCache.h"
+
+#if SUPPORT_OBJECT_MODEL
+
+#include <Platform/Platform.h>
+#include <Platform/RepRap.h>
+#include <Platform/OutputMemory.h>
+
+Mutex ObjectModelResponseCache::mutex;
+char *_ecv_array _ecv_null ObjectModelResponseCache::storage = nullptr;
+ObjectModelResponseCache::Entry ObjectModelResponseCache::entries[NumCachedModelResponses];
+uint32_t ObjectModelResponseCache::useClock = 0;
+uint32_t ObjectModelResponseCache::hits = 0;
+uint32_t ObjectModelResponseCache::misses = 0;
+uint32_t ObjectModelResponseCache::stores = 0;
+
+/*static*/ void ObjectModelResponseCache::Init() noexcept
+{
+	mutex.Create("OMResponses");
+	for (Entry& e : entries)
+	{
+		e.length = 0;
+	}
+}
+
+// If we have a valid response for this key and flags, append it to 'buf' and return true
+/*static*/ bool ObjectModelResponseCache::Find(const char *_ecv_array key, const char *_ecv_array flags, uint32_t signature, OutputBuffer *buf) noexcept
+{
+	MutexLocker lock(mutex);
+	for (size_t i = 0; i < NumCachedModelResponses; ++i)
+	{
+		Entry& e = entries[i];
+		if (e.length != 0 && e.key.Equals(key) && e.flags.Equals(flags))
+		{
+			if (e.signature == signature && millis() - e.whenGenerated < ModelResponseCacheTime)
+			{
+				e.lastUsed = ++useClock;
+				++hits;
+				buf->cat(storage + i * ModelResponseCacheSlotSize, e.length);
+				return true;
+			}
+			e.length = 0;											// this entry is stale so free it up
+			break;
+		}
+	}
+	++misses;
+	return false;
+}
+
+// Store a response that we have just generated. 'signature' must have been fetched before we started to generate it.
+/*static*/ void ObjectModelResponseCache::Store(const char *_ecv_array key, const char *_ecv_array flags, uint32_t signature, uint32_t whenStarted, const OutputBuffer *buf) noexcept
+{
+	const size_t length = buf->Length();
+	if (length == 0 || length > ModelResponseCacheSlotSize || strlen(key) >= StringLength50 || strlen(flags) >= StringLength20)
+	{
+		return;
+	}
+
+	MutexLocker lock(mutex);
+	if (storage == nullptr)
+	{
+		storage = new char[NumCachedModelResponses * ModelResponseCacheSlotSize];
+	}
+
+	// Replace any existing entry for this key and flags, else a free entry, else the least recently used one
+	size_t victim = 0;
+	for (size_t i = 0; i < NumCachedModelResponses; ++i)
+	{
+		const Entry& e = entries[i];
+		if (e.length != 0 && e.key.Equals(key) && e.flags.Equals(flags))
+		{
+			victim = i;
+			break;
+		}
+		const Entry& v = entries[victim];
+		if (v.length != 0 && (e.length == 0 || (int32_t)(e.lastUsed - v.lastUsed) < 0))
+		{
+			victim = i;
+		}
+	}
+
+	Entry& e = entries[victim];
+	char *_ecv_array p = storage + victim * ModelResponseCacheSlotSize;
+	for (const OutputBuffer *b = buf; b != nullptr; b = b->Next())
+	{
+		memcpy(p, b->Data(), b->DataLength());
+		p += b->DataLength();
+	}
+	e.key.copy(key);
+	e.flags.copy(flags);
+	e.signature = signature;
+	e.whenGenerated = whenStarted;
+	e.lastUsed = ++useClock;
+	e.length = length;
+	++stores;
+}
+
+/*static*/ void ObjectModelResponseCache::Diagnostics(MessageType mtype) noexcept
+{
+	reprap.GetPlatform().MessageF(mtype, "OM response cache: hits %" PRIu32 ", misses %" PRIu32 ", stores %" PRIu32 "\n", hits, misses, stores);
+	hits = misses = stores = 0;
+}
+
+#endif
+
+// End
@@ -0,0 +1,60 @@
+/*
+ * ObjectModelResponseCache.h
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * Cache of recently generated object model responses.
+ * Web clients, PanelDue and monitoring software often send identical M409 or rr_model requests, for example K"state" F"d99vno", every few hundred milliseconds.
+ * When several clients are connected we would otherwise generate the same JSON several times over. Instead we keep a copy of each recent response keyed
+ * by the key and flags, and serve identical requests from it provided that the response is less than ModelResponseCacheTime old and none of the
+ * object model sequence counters has changed since we generated it. Delta reports and responses generated in chunks are never cached.
+ */
+
+#ifndef SRC_OBJECTMODEL_OBJECTMODELRESPONSECACHE_H_
+#define SRC_OBJECTMODEL_OBJECTMODELRESPONSECACHE_H_
+
+#include <RepRapFirmware.h>
+
+#if SUPPORT_OBJECT_MODEL
+
+#include <RTOSIface/RTOSIface.h>
+#include <General/String.h>
+
+class ObjectModelResponseCache
+{
+public:
+	static void Init() noexcept;
+
+	// If we have a valid response for this key and flags, append it to 'buf' and return true
+	static bool Find(const char *_ecv_array key, const char *_ecv_array flags, uint32_t signature, OutputBuffer *buf) noexcept;
+
+	// Store a response that we have just generated. 'signature' must have been fetched before we started to generate it.
+	static void Store(const char *_ecv_array key, const char *_ecv_array flags, uint32_t signature, uint32_t whenStarted, const OutputBuffer *buf) noexcept;
+
+	static void Diagnostics(MessageType mtype) noexcept;
+
+private:
+	struct Entry
+	{
+		String<StringLength50> key;
+		String<StringLength20> flags;
+		uint32_t signature;							// the combined object model sequence numbers when we started to generate the response
+		uint32_t whenGenerated;						// when we started to generate the response
+		uint32_t lastUsed;							// the value of useClock when this entry was last used
+		size_t length;								// the length of the response, or 0 if this entry is not in use
+	};
+
+	static Mutex mutex;
+	static char *_ecv_array _ecv_null storage;		// allocated when we first store a response
+	static Entry entries[NumCachedModelResponses];
+	static uint32_t useClock;
+
+	// Statistics
+	static uint32_t hits;
+	static uint32_t misses;
+	static uint32_t stores;
+};
+
+#endif
+
+#endif /* SRC_OBJECTMODEL_OBJECTMODELRESPONSECACHE_H_ */
@@ -7,24 +7,33 @@
  * The string heap uses two structures.
  * Each index block is an array of pointers to the actual data. This allows the data to be moved when the heap is compacted. The first pointer in the block points to the next index block.
  * The heap itself is a sequence of blocks. Each block comprises a 2-byte length count followed by the null-terminated string. The length count is always even and the lowest bit is set if the block is free.
+ * Free spaces at least 8 bytes long are kept on free lists, one per size class, so that most allocations can reuse them without garbage collection.
+ * The heap is compacted incrementally. Each step moves a bounded number of bytes, so the write lock is only held for a short time.
  */
 
 #include "Heap.h"
 #include <Platform/Tasks.h>
 #include <Platform/Platform.h>
 #include <Platform/RepRap.h>
+#include <Movement/StepTimer.h>
 #include <General/String.h>
 #include <atomic>
 
 constexpr size_t IndexBlockSlots = 99;				// number of 4-byte handles per index block, plus one for link to next index block
 constexpr size_t HeapBlockSize = 2048;				// the size of each heap block
+constexpr size_t MaxExactFitLength = 64;			// free spaces up to this length are kept on lists of spaces of the same length
+constexpr size_t NumFreeLists = MaxExactFitLength/4;	// one list for each length from 8 to MaxExactFitLength, plus one for longer spaces
+constexpr unsigned int MaxLargeFreeSpacesSearched = 8;	// how many entries of the list of long free spaces we look at before giving up
+constexpr size_t MaxGcBytesMovedPerStep = 256;		// how many bytes a garbage collection step may move, unless a single object is longer than this
+constexpr size_t MaxGcAdjustmentsPerStep = 8;		// how many separate runs of moved objects a garbage collection step may create
+constexpr size_t MinGcRecyclable = 512;				// don't start garbage collecting from Spin until at least this much heap can be recycled
 
 namespace Heap
 {
 	struct IndexBlock
 	{
-		void* operator new(size_t count) { return Tasks::AllocPermanent(count); }
-		void* operator new(size_t count, std::align_val_t align) { return Tasks::AllocPermanent(count, align); }
+		void* operator new(size_t count) { return Tasks::AllocPermanent(count, MemoryTag::objectModel); }
+		void* operator new(size_t count, std::align_val_t align) { return Tasks::AllocPermanent(count, MemoryTag::objectModel, align); }
 		void operator delete(void* ptr) noexcept {}
 		void operator delete(void* ptr, std::align_val_t align) noexcept {}
 
@@ -36,8 +45,8 @@ namespace Heap
 
 	struct HeapBlock
 	{
-		void* operator new(size_t count) { return Tasks::AllocPermanent(count); }
-		void* operator new(size_t count, std::align_val_t align) { return Tasks::AllocPermanent(count, align); }
+		void* operator new(size_t count) { return Tasks::AllocPermanent(count, MemoryTag::objectModel); }
+		void* operator new(size_t count, std::align_val_t align) { return Tasks::AllocPermanent(count, MemoryTag::objectModel, align); }
 		void operator delete(void* ptr) noexcept {}
 		void operator delete(void* ptr, std::align_val_t align) noexcept {}
 
@@ -47,8 +56,40 @@ namespace Heap
 		char data[HeapBlockSize];
 	};
 
+	// A free storage space that is on a free list. It overlays the StorageSpace that was released.
+	struct FreeSpace
+	{
+		uint16_t length;								// length of this space in bytes including this field, with the lowest bit set
+		uint16_t unused;
+		FreeSpace *next;								// next free space on the same list
+	};
+
+	static_assert(sizeof(FreeSpace) == 8 || sizeof(FreeSpace*) > 4);		// so that on our 32-bit targets the shortest spaces that we put on free lists can hold one
+
+	// A run of contiguous objects that a garbage collection step has moved down by the same amount
+	struct HandleAdjustment
+	{
+		char *startAddr;
+		char *endAddr;
+		size_t moveDown;
+	};
+
 	void GarbageCollectInternal() noexcept;
-	void AdjustHandles(char *startAddr, char *endAddr, size_t moveDown, unsigned int numHandles) noexcept;
+	bool GarbageCollectStep() noexcept;
+	void AdjustHandles(const HandleAdjustment *adjustments, size_t numAdjustments, unsigned int numHandles) noexcept;
+	void AddToFreeList(StorageSpace *space) noexcept;
+	StorageSpace *AllocateFromFreeList(size_t length) noexcept;
+	void ClearFreeLists() noexcept;
+
+	inline size_t GetFreeListNumber(size_t length) noexcept
+	{
+		return (length <= MaxExactFitLength) ? length/4 - 2 : NumFreeLists - 1;
+	}
+
+	inline uint32_t TicksToMicroseconds(uint32_t ticks) noexcept
+	{
+		return (uint32_t)(((uint64_t)ticks * 1000000u)/StepClockRate);
+	}
 
 	IndexBlock *indexRoot = nullptr;
 	HeapBlock *heapRoot = nullptr;
@@ -58,6 +99,19 @@ namespace Heap
 	size_t heapUsed = 0;
 	std::atomic<size_t> heapToRecycle = 0;
 	unsigned int gcCyclesDone = 0;
+
+	FreeSpace *freeLists[NumFreeLists] = { 0 };		// pushed to by DeleteSlot under the read lock, so pushes use a critical section
+	HeapBlock *gcBlock = nullptr;					// the heap block being compacted, or nullptr if no garbage collection cycle is in progress
+	size_t gcOffset = 0;							// how far gcBlock has been compacted
+
+	// Statistics, reset after each diagnostics report except where noted
+	unsigned int gcSteps = 0;
+	unsigned int gcForcedCollections = 0;
+	uint32_t gcMaxStepTicks = 0;
+	uint32_t gcTotalStepTicks = 0;
+	uint32_t gcMaxForcedTicks = 0;
+	unsigned int freeListHits = 0;
+	unsigned int freeListMisses = 0;
 }
 
 ReadWriteLock Heap::heapLock;
@@ -68,101 +122,247 @@ void Heap::GarbageCollect() noexcept
 	GarbageCollectInternal();
 }
 
+// Do a step of incremental garbage collection if a cycle is in progress or there is enough heap to recycle. Called from the main loop.
+void Heap::Spin() noexcept
+{
+	if (gcBlock != nullptr || (heapToRecycle >= MinGcRecyclable && heapToRecycle * 4 >= heapUsed))
+	{
+		WriteLocker locker(heapLock);
+		const uint32_t startTicks = StepTimer::GetTimerTicks();
+		(void)GarbageCollectStep();
+		const uint32_t ticks = StepTimer::GetTimerTicks() - startTicks;
+		++gcSteps;
+		gcTotalStepTicks += ticks;
+		if (ticks > gcMaxStepTicks)
+		{
+			gcMaxStepTicks = ticks;
+		}
+	}
+}
+
+// Complete the current garbage collection cycle, or do a whole new one if none is in progress
 void Heap::GarbageCollectInternal() noexcept
 {
 #if CHECK_HANDLES
 	heapLock.CheckHasWriteLock();
 #endif
 
-	heapUsed = 0;
-	for (HeapBlock *currentBlock = heapRoot; currentBlock != nullptr; )
+	const uint32_t startTicks = StepTimer::GetTimerTicks();
+	while (!GarbageCollectStep()) { }
+	const uint32_t ticks = StepTimer::GetTimerTicks() - startTicks;
+	++gcForcedCollections;
+	if (ticks > gcMaxForcedTicks)
+	{
+		gcMaxForcedTicks = ticks;
+	}
+}
+
+// Compact part of one heap block, moving at most MaxGcBytesMovedPerStep bytes unless a single object is longer than that. Return true if this completed the cycle.
+// Between steps the part of the block between the compacted objects and those not yet looked at is marked as a single free space, so the heap stays walkable.
+// No allocations are made from the free lists while a cycle is in progress, because the spaces on them may be moved or merged.
+bool Heap::GarbageCollectStep() noexcept
+{
+#if CHECK_HANDLES
+	heapLock.CheckHasWriteLock();
+#endif
+
+	if (gcBlock == nullptr)
+	{
+		if (heapRoot == nullptr)
+		{
+			return true;
+		}
+		gcBlock = heapRoot;
+		gcOffset = 0;
+		ClearFreeLists();
+	}
+
+	HeapBlock * const currentBlock = gcBlock;
+	char * const end = currentBlock->data + currentBlock->allocated;
+	char *dst = currentBlock->data + gcOffset;			// the objects below this have been compacted
+	char *p = dst;
+	size_t bytesMoved = 0;
+	HandleAdjustment adjustments[MaxGcAdjustmentsPerStep];
+	size_t numAdjustments = 0;
+	unsigned int numHandlesToAdjust = 0;
+
+	while (p < end)
 	{
-		// Skip any used blocks at the start because they won't be moved
-		char *p = currentBlock->data;
-		while (p < currentBlock->data + currentBlock->allocated)
+		const size_t len = reinterpret_cast<StorageSpace*>(p)->length;
+		if (len & 1u)									// if this space has been marked as free
+		{
+			p += (len & ~1u);
+		}
+		else if (p == dst)								// if this object doesn't need to move
 		{
-			const size_t len = reinterpret_cast<StorageSpace*>(p)->length;
-			if (len & 1u)					// if this slot has been marked as free
+			p += len;
+			dst = p;
+		}
+		else
+		{
+			const size_t moveDown = p - dst;
+			const bool extendsLastRun = numAdjustments != 0 && adjustments[numAdjustments - 1].endAddr == p && adjustments[numAdjustments - 1].moveDown == moveDown;
+			if (bytesMoved != 0 && (bytesMoved + len > MaxGcBytesMovedPerStep || (!extendsLastRun && numAdjustments == MaxGcAdjustmentsPerStep)))
 			{
 				break;
 			}
+
+			memmove(dst, p, len);
+			if (extendsLastRun)
+			{
+				adjustments[numAdjustments - 1].endAddr = p + len;
+			}
+			else
+			{
+				adjustments[numAdjustments++] = { p, p + len, moveDown };
+			}
+			++numHandlesToAdjust;
+			bytesMoved += len;
+			dst += len;
 			p += len;
 		}
+	}
+
+	if (numAdjustments != 0)
+	{
+		AdjustHandles(adjustments, numAdjustments, numHandlesToAdjust);
+	}
 
-		if (p < currentBlock->data + currentBlock->allocated)					// if we found an unused block before we reached the end
+	if (p < end)
+	{
+		// We ran out of time, so mark the gap as free and carry on from here next time
+		if (dst != p)
 		{
-			char* startSkip = p;
+			reinterpret_cast<StorageSpace*>(dst)->length = (p - dst) | 1u;
+		}
+		gcOffset = dst - currentBlock->data;
+		return false;
+	}
 
-			for (;;)
-			{
-				// Find the end of the unused blocks
-				while (p < currentBlock->data + currentBlock->allocated)
-				{
-					const size_t len = reinterpret_cast<StorageSpace*>(p)->length;
-					if ((len & 1u) == 0)
-					{
-						break;
-					}
-					p += (len & ~1u);
-				}
+	// We have finished this block. Any free spaces were at the end, so just change the allocated size.
+	const size_t reclaimed = end - dst;
+	currentBlock->allocated = dst - currentBlock->data;
+	heapUsed -= reclaimed;
+	heapToRecycle -= min<size_t>(reclaimed, heapToRecycle.load());
 
-				if (p >= currentBlock->data + currentBlock->allocated)
-				{
-					currentBlock->allocated = startSkip - currentBlock->data;	// the unused blocks were at the end so just change the allocated size
-					break;
-				}
-				else
+	gcBlock = currentBlock->next;
+	gcOffset = 0;
+	if (gcBlock != nullptr)
+	{
+		return false;
+	}
+
+	// Spaces freed during the cycle may have been merged, so start again with empty free lists. Those that weren't will be reclaimed next cycle.
+	ClearFreeLists();
+	++gcCyclesDone;
+	return true;
+}
+
+// Find all handles pointing to storage in the moved runs and move the pointers down by the amount that each run was moved
+void Heap::AdjustHandles(const HandleAdjustment *adjustments, size_t numAdjustments, unsigned int numHandles) noexcept
+{
+	char * const lowestAddr = adjustments[0].startAddr;
+	char * const highestAddr = adjustments[numAdjustments - 1].endAddr;
+	for (IndexBlock *indexBlock = indexRoot; indexBlock != nullptr; indexBlock = indexBlock->next)
+	{
+		for (size_t i = 0; i < IndexBlockSlots; ++i)
+		{
+			char * const p = (char *)indexBlock->slots[i].storage;
+			if (p != nullptr && p >= lowestAddr && p < highestAddr)
+			{
+				for (size_t j = 0; j < numAdjustments; ++j)
 				{
-					// Find all the contiguous blocks
-					char *startUsed = p;
-					unsigned int numHandlesToAdjust = 0;
-					while (p < currentBlock->data + currentBlock->allocated)
+					if (p >= adjustments[j].startAddr && p < adjustments[j].endAddr)
 					{
-						const size_t len = reinterpret_cast<StorageSpace*>(p)->length;
-						if (len & 1u)
+						indexBlock->slots[i].storage = reinterpret_cast<StorageSpace*>(p - adjustments[j].moveDown);
+						--numHandles;
+						if (numHandles == 0)
 						{
-							break;
+							return;
 						}
-						++numHandlesToAdjust;
-						p += len;
+						break;
 					}
-
-					// Move the contiguous blocks down
-					memmove(startSkip, startUsed, p - startUsed);
-					//TODO make this more efficient by building up a small table of several adjustments, so we need to make fewer passes through the index
-					AdjustHandles(startUsed, p, startUsed - startSkip, numHandlesToAdjust);
-					startSkip += p - startUsed;
 				}
 			}
 		}
-
-		heapUsed += currentBlock->allocated;
-		currentBlock = currentBlock->next;
 	}
+}
 
-	heapToRecycle = 0;
-	++gcCyclesDone;
+// Put a released space on the appropriate free list if it is long enough. May be called with just the read lock, so other tasks may be doing the same.
+void Heap::AddToFreeList(StorageSpace *space) noexcept
+{
+	const size_t len = space->length & ~1u;
+	if (len >= sizeof(FreeSpace))
+	{
+		FreeSpace * const fs = reinterpret_cast<FreeSpace*>(space);
+		FreeSpace *& head = freeLists[GetFreeListNumber(len)];
+		TaskCriticalSectionLocker lock;
+		fs->next = head;
+		head = fs;
+	}
 }
 
-// Find all handles pointing to storage between startAddr and endAddr and move the pointers down by amount moveDown
-void Heap::AdjustHandles(char *startAddr, char *endAddr, size_t moveDown, unsigned int numHandles) noexcept
+// Try to allocate a space of the requested length from the free lists. Must own the write lock when calling this.
+Heap::StorageSpace *Heap::AllocateFromFreeList(size_t length) noexcept
 {
-	for (IndexBlock *indexBlock = indexRoot; indexBlock != nullptr; indexBlock = indexBlock->next)
+	if (length < sizeof(FreeSpace))
 	{
-		for (size_t i = 0; i < IndexBlockSlots; ++i)
+		return nullptr;
+	}
+
+	FreeSpace *found = nullptr;
+	if (length <= MaxExactFitLength)
+	{
+		FreeSpace *& head = freeLists[GetFreeListNumber(length)];
+		found = head;
+		if (found != nullptr)
 		{
-			char * const p = (char *)indexBlock->slots[i].storage;
-			if (p != nullptr && p >= startAddr && p < endAddr)
+			head = found->next;
+		}
+	}
+	else
+	{
+		// Take the first space that is long enough from the list of long spaces, splitting it if necessary
+		unsigned int searched = 0;
+		for (FreeSpace **pp = &freeLists[NumFreeLists - 1]; *pp != nullptr && searched < MaxLargeFreeSpacesSearched; pp = &(*pp)->next)
+		{
+			const size_t len = (*pp)->length & ~1u;
+			if (len >= length)
 			{
-				indexBlock->slots[i].storage = reinterpret_cast<StorageSpace*>(p - moveDown);
-				--numHandles;
-				if (numHandles == 0)
+				found = *pp;
+				*pp = found->next;
+				if (len > length)
 				{
-					return;
+					StorageSpace * const remainder = reinterpret_cast<StorageSpace*>(reinterpret_cast<char*>(found) + length);
+					remainder->length = (len - length) | 1u;
+					AddToFreeList(remainder);
 				}
+				break;
 			}
+			++searched;
 		}
 	}
+
+	if (found == nullptr)
+	{
+		++freeListMisses;
+		return nullptr;
+	}
+
+	++freeListHits;
+	heapToRecycle -= length;
+	StorageSpace * const ret = reinterpret_cast<StorageSpace*>(found);
+	ret->length = length;
+	return ret;
+}
+
+// Empty the free lists. The spaces on them remain marked as free, so garbage collection will reclaim them. Must own the write lock when calling this.
+void Heap::ClearFreeLists() noexcept
+{
+	for (FreeSpace *& head : freeLists)
+	{
+		head = nullptr;
+	}
 }
 
 bool Heap::CheckIntegrity(const StringRef& errmsg) noexcept
@@ -293,6 +493,15 @@ Heap::StorageSpace *Heap::AllocateSpace(size_t length) noexcept
 
 	length = min<size_t>((length + 3u) & (~3u), HeapBlockSize);			// round to make the length field a multiple of 4 and limit to max size
 
+	if (gcBlock == nullptr)
+	{
+		StorageSpace * const space = AllocateFromFreeList(length);
+		if (space != nullptr)
+		{
+			return space;
+		}
+	}
+
 	bool collected = false;
 	do
 	{
@@ -330,7 +539,7 @@ Heap::StorageSpace *Heap::AllocateSpace(size_t length) noexcept
 // Check that the handle points into an index block
 void Heap::CheckSlotGood(IndexSlot *slotPtr) noexcept
 {
-	RRF_ASSERT(((uint32_t)slotPtr & 3) == 0);
+	RRF_ASSERT(((uintptr_t)slotPtr & 3) == 0);
 	bool ok = false;
 	for (IndexBlock *indexBlock = indexRoot; indexBlock != nullptr; indexBlock = indexBlock->next)
 	{
@@ -357,6 +566,7 @@ void Heap::DeleteSlot(IndexSlot *slotPtr) noexcept
 	{
 		heapToRecycle += slotPtr->storage->length;
 		slotPtr->storage->length |= 1;						// flag the space as unused
+		AddToFreeList(slotPtr->storage);
 		slotPtr->storage = nullptr;							// release the handle entry
 		--handlesUsed;
 	}
@@ -373,6 +583,11 @@ void Heap::Diagnostics(MessageType mt, Platform& p) noexcept
 	temp.catf(", handles allocated/used %u/%u, heap memory allocated/used/recyclable %u/%u/%u, gc cycles %u\n",
 					handlesAllocated, (unsigned int)handlesUsed, heapAllocated, heapUsed, (unsigned int)heapToRecycle, gcCyclesDone);
 	p.Message(mt, temp.c_str());
+	p.MessageF(mt, "GC steps %u, longest %" PRIu32 "us, average %" PRIu32 "us, forced collections %u, longest %" PRIu32 "us, free list hits/misses %u/%u\n",
+					gcSteps, TicksToMicroseconds(gcMaxStepTicks), (gcSteps == 0) ? 0 : TicksToMicroseconds(gcTotalStepTicks/gcSteps),
+					gcForcedCollections, TicksToMicroseconds(gcMaxForcedTicks), freeListHits, freeListMisses);
+	gcSteps = gcForcedCollections = freeListHits = freeListMisses = 0;
+	gcMaxStepTicks = gcTotalStepTicks = gcMaxForcedTicks = 0;
 }
 
 // End
@@ -37,6 +37,7 @@ namespace Heap
 	void IncreaseRefCount(IndexSlot *slotPtr) noexcept;
 	void DeleteSlot(IndexSlot *slotPtr) noexcept;
 	void GarbageCollect() noexcept;
+	void Spin() noexcept;
 	bool CheckIntegrity(const StringRef& errmsg) noexcept;
 	void Diagnostics(MessageType mt, Platform& p) noexcept;
 
@@ -13,6 +13,7 @@
 /*static*/ OutputBuffer * volatile OutputBuffer::freeOutputBuffers = nullptr;		// Messages may also be sent by ISRs,
 /*static*/ volatile size_t OutputBuffer::usedOutputBuffers = 0;						// so make these volatile.
 /*static*/ volatile size_t OutputBuffer::maxUsedOutputBuffers = 0;
+/*static*/ volatile size_t OutputBuffer::numOutputBuffers = 0;
 
 //*************************************************************************************************
 // OutputBuffer class implementation
@@ -62,6 +63,31 @@ size_t OutputBuffer::Length() const noexcept
 	return totalLength;
 }
 
+// Discard everything written to the chain after the first 'length' bytes, releasing any buffers that are no longer needed.
+// Used to remove partial output that we decide not to send after all. Don't call this on a chain that has already been queued for sending.
+void OutputBuffer::TruncateTo(size_t length) noexcept
+{
+	OutputBuffer *item = this;
+	while (length > item->dataLength && item->next != nullptr)
+	{
+		length -= item->dataLength;
+		item = item->next;
+	}
+
+	if (length < item->dataLength)
+	{
+		item->dataLength = length;
+	}
+	if (item->next != nullptr)
+	{
+		ReleaseAll(item->next);
+		for (OutputBuffer *p = this; p != nullptr; p = p->next)
+		{
+			p->last = item;
+		}
+	}
+}
+
 char OutputBuffer::operator[](size_t index) const noexcept
 {
 	// Get the right buffer to access
@@ -352,9 +378,20 @@ bool OutputBuffer::WriteToFile(FileData& f) const noexcept
 /*static*/ void OutputBuffer::Init() noexcept
 {
 	freeOutputBuffers = nullptr;
-	for (size_t i = 0; i < OUTPUT_BUFFER_COUNT; i++)
+	AddBuffers(OUTPUT_BUFFER_COUNT);
+}
+
+// Add more buffers to the free list. Other tasks may be using the buffers while we do this.
+/*static*/ void OutputBuffer::AddBuffers(size_t number) noexcept
+{
+	while (number != 0)
 	{
-		freeOutputBuffers = new OutputBuffer(freeOutputBuffers);
+		OutputBuffer * const buf = new OutputBuffer(nullptr);
+		TaskCriticalSectionLocker lock;
+		buf->next = freeOutputBuffers;
+		freeOutputBuffers = buf;
+		++numOutputBuffers;
+		--number;
 	}
 }
 
@@ -394,7 +431,7 @@ bool OutputBuffer::WriteToFile(FileData& f) const noexcept
 // Get the number of bytes left for continuous writing
 /*static*/ size_t OutputBuffer::GetBytesLeft(const OutputBuffer *writingBuffer) noexcept
 {
-	const size_t freeBuffers = OUTPUT_BUFFER_COUNT - usedOutputBuffers;
+	const size_t freeBuffers = numOutputBuffers - usedOutputBuffers;
 	const size_t bytesLeft = OUTPUT_BUFFER_SIZE - writingBuffer->last->DataLength();
 
 	if (freeBuffers < RESERVED_OUTPUT_BUFFERS)
@@ -476,7 +513,7 @@ bool OutputBuffer::WriteToFile(FileData& f) const noexcept
 /*static*/ void OutputBuffer::Diagnostics(MessageType mtype) noexcept
 {
 	reprap.GetPlatform().MessageF(mtype, "Used output buffers: %d of %d (%d max)\n",
-			usedOutputBuffers, OUTPUT_BUFFER_COUNT, maxUsedOutputBuffers);
+			usedOutputBuffers, numOutputBuffers, maxUsedOutputBuffers);
 }
 
 //*************************************************************************************************
@@ -10,6 +10,7 @@
 
 #include <RepRapFirmware.h>
 #include <Storage/FileData.h>
+#include <Platform/Tasks.h>
 
 #if HAS_SBC_INTERFACE
 const size_t OUTPUT_STACK_DEPTH = 64;	// Number of OutputBuffer chains that can be pushed onto one stack instance
@@ -24,6 +25,11 @@ public:
 	explicit OutputBuffer(OutputBuffer *null n) noexcept : next(n) { }
 	OutputBuffer(const OutputBuffer&) = delete;
 
+	void* operator new(size_t count) noexcept { return Tasks::AllocPermanent(count, MemoryTag::objectModel); }
+	void* operator new(size_t count, std::align_val_t align) noexcept { return Tasks::AllocPermanent(count, MemoryTag::objectModel, align); }
+	void operator delete(void* ptr) noexcept {}
+	void operator delete(void* ptr, std::align_val_t align) noexcept {}
+
 	void Append(OutputBuffer *other) noexcept;
 	OutputBuffer *null Next() const noexcept { return next; }
 	bool IsReferenced() const noexcept { return isReferenced; }
@@ -34,6 +40,7 @@ public:
 	const char *_ecv_array UnreadData() const noexcept { return data + bytesRead; }
 	size_t DataLength() const noexcept { return dataLength; }	// How many bytes have been written to this instance?
 	size_t Length() const noexcept;								// How many bytes have been written to the whole chain?
+	void TruncateTo(size_t length) noexcept;					// Discard everything written to the chain after the first 'length' bytes
 
 	char operator[](size_t index) const noexcept;
 	const char *_ecv_array Read(size_t len) noexcept;
@@ -72,6 +79,9 @@ public:
 	// Initialise the output buffers manager
 	static void Init() noexcept;
 
+	// Add more buffers to the pool. They can never be removed.
+	static void AddBuffers(size_t number) noexcept;
+
 	// Allocate an unused OutputBuffer instance. Returns true on success or false if no instance could be allocated.
 	static bool Allocate(OutputBuffer *&buf) noexcept;
 
@@ -90,7 +100,8 @@ public:
 
 	static void Diagnostics(MessageType mtype) noexcept;
 
-	static unsigned int GetFreeBuffers() noexcept { return OUTPUT_BUFFER_COUNT - usedOutputBuffers; }
+	static unsigned int GetFreeBuffers() noexcept { return numOutputBuffers - usedOutputBuffers; }
+	static unsigned int GetNumBuffers() noexcept { return numOutputBuffers; }
 
 private:
 	void Clear() noexcept;
@@ -110,6 +121,7 @@ private:
 	static OutputBuffer * volatile freeOutputBuffers;		// Messages may be sent by multiple tasks
 	static volatile size_t usedOutputBuffers;				// so make these volatile.
 	static volatile size_t maxUsedOutputBuffers;
+	static volatile size_t numOutputBuffers;
 };
 
 inline uint32_t OutputBuffer::GetAge() const noexcept
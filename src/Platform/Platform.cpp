@@ -92,6 +92,9 @@ using AnalogIn::AdcBits;			// for compatibility with CoreNG, which doesn't have
 # include "Networking/HttpResponder.h"
 # include "Networking/FtpResponder.h"
 # include "Networking/TelnetResponder.h"
+# if HAS_MASS_STORAGE
+#  include "Networking/UploadWriter.h"
+# endif
 #endif
 
 #if SUPPORT_CAN_EXPANSION
@@ -217,6 +220,12 @@ constexpr ObjectModelArrayTableEntry Platform::objectModelArrayTable[] =
 		[] (const ObjectModel *self, const ObjectExplorationContext& context) noexcept -> size_t { return NumCoordinateSystems; },
 		[] (const ObjectModel *self, ObjectExplorationContext& context) noexcept -> ExpressionValue
 				{ return ExpressionValue(reprap.GetGCodes().GetWorkplaceOffset(context.GetIndex(1), context.GetLastIndex()), 3); }
+	},
+	// 2. Memory used by each subsystem
+	{
+		nullptr,					// no lock needed
+		[] (const ObjectModel *self, const ObjectExplorationContext& context) noexcept -> size_t { return MemoryTag::NumValues; },
+		[] (const ObjectModel *self, ObjectExplorationContext& context) noexcept -> ExpressionValue { return ExpressionValue(self, 10); }
 	}
 };
 
@@ -228,6 +237,24 @@ static inline const char *_ecv_array GetFilamentName(size_t extruder) noexcept
 	return (fil == nullptr) ? "" : fil->GetName();
 }
 
+static inline unsigned int GetNumNetworkBuffers() noexcept
+{
+#if HAS_NETWORKING
+	return reprap.GetNetwork().GetNumNetworkBuffers();
+#else
+	return 0;
+#endif
+}
+
+static inline unsigned int GetNumHttpResponders() noexcept
+{
+#if HAS_NETWORKING
+	return reprap.GetNetwork().GetNumHttpResponders();
+#else
+	return 0;
+#endif
+}
+
 constexpr ObjectModelTableEntry Platform::objectModelTable[] =
 {
 	// 0. boards[0] members
@@ -255,6 +282,7 @@ constexpr ObjectModelTableEntry Platform::objectModelTable[] =
 #if HAS_CPU_TEMP_SENSOR
 	{ "mcuTemp",			OBJECT_MODEL_FUNC(self, 1),																			ObjectModelEntryFlags::live },
 #endif
+	{ "memory",				OBJECT_MODEL_FUNC_ARRAY(2),																			ObjectModelEntryFlags::verbose },
 #ifdef DUET_NG
 	{ "name",				OBJECT_MODEL_FUNC(self->GetBoardName()),															ObjectModelEntryFlags::none },
 	{ "shortName",			OBJECT_MODEL_FUNC(self->GetBoardShortName()),														ObjectModelEntryFlags::none },
@@ -262,6 +290,7 @@ constexpr ObjectModelTableEntry Platform::objectModelTable[] =
 	{ "name",				OBJECT_MODEL_FUNC_NOSELF(BOARD_NAME),																ObjectModelEntryFlags::none },
 	{ "shortName",			OBJECT_MODEL_FUNC_NOSELF(BOARD_SHORT_NAME),															ObjectModelEntryFlags::none },
 #endif
+	{ "pools",				OBJECT_MODEL_FUNC(self, 11),																		ObjectModelEntryFlags::verbose },
 	{ "supportsDirectDisplay", OBJECT_MODEL_FUNC_NOSELF(SUPPORT_DIRECT_LCD ? true : false),										ObjectModelEntryFlags::verbose },
 #if MCU_HAS_UNIQUE_ID
 	{ "uniqueId",			OBJECT_MODEL_FUNC_IF(self->uniqueId.IsValid(), self->uniqueId),										ObjectModelEntryFlags::none },
@@ -360,12 +389,22 @@ constexpr ObjectModelTableEntry Platform::objectModelTable[] =
 	{ "points",				OBJECT_MODEL_FUNC_NOSELF((int32_t)Accelerometers::GetLocalAccelerometerDataPoints()),						ObjectModelEntryFlags::none },
 	{ "runs",				OBJECT_MODEL_FUNC_NOSELF((int32_t)Accelerometers::GetLocalAccelerometerRuns()),								ObjectModelEntryFlags::none },
 #endif
+
+	// 10. boards[0].memory[] members
+	{ "name",				OBJECT_MODEL_FUNC_NOSELF(MemoryTag(context.GetLastIndex()).ToString()),										ObjectModelEntryFlags::none },
+	{ "peak",				OBJECT_MODEL_FUNC_NOSELF((int32_t)Tasks::GetPeakMemoryUsed(MemoryTag(context.GetLastIndex()))),				ObjectModelEntryFlags::none },
+	{ "used",				OBJECT_MODEL_FUNC_NOSELF((int32_t)Tasks::GetMemoryUsed(MemoryTag(context.GetLastIndex()))),					ObjectModelEntryFlags::none },
+
+	// 11. boards[0].pools members
+	{ "httpResponders",		OBJECT_MODEL_FUNC_NOSELF((int32_t)GetNumHttpResponders()),													ObjectModelEntryFlags::none },
+	{ "networkBuffers",		OBJECT_MODEL_FUNC_NOSELF((int32_t)GetNumNetworkBuffers()),													ObjectModelEntryFlags::none },
+	{ "outputBuffers",		OBJECT_MODEL_FUNC_NOSELF((int32_t)OutputBuffer::GetNumBuffers()),											ObjectModelEntryFlags::none },
 };
 
 constexpr uint8_t Platform::objectModelTableDescriptor[] =
 {
-	10,																		// number of sections
-	9 + SUPPORT_ACCELEROMETERS + HAS_SBC_INTERFACE + HAS_MASS_STORAGE + HAS_VOLTAGE_MONITOR + HAS_12V_MONITOR + HAS_CPU_TEMP_SENSOR
+	12,																		// number of sections
+	11 + SUPPORT_ACCELEROMETERS + HAS_SBC_INTERFACE + HAS_MASS_STORAGE + HAS_VOLTAGE_MONITOR + HAS_12V_MONITOR + HAS_CPU_TEMP_SENSOR
 	  + SUPPORT_CAN_EXPANSION + SUPPORT_DIRECT_LCD + MCU_HAS_UNIQUE_ID + HAS_WIFI_NETWORKING,		// section 0: boards[0]
 #if HAS_CPU_TEMP_SENSOR
 	3,																		// section 1: mcuTemp
@@ -397,6 +436,8 @@ constexpr uint8_t Platform::objectModelTableDescriptor[] =
 #else
 	0,
 #endif
+	3,																		// section 10: boards[0].memory[]
+	3,																		// section 11: boards[0].pools
 };
 
 DEFINE_GET_OBJECT_MODEL_TABLE(Platform)
@@ -4080,6 +4121,16 @@ bool Platform::FileExists(const char *_ecv_array folder, const char *_ecv_array
 	return MassStorage::CombineName(location.GetRef(), folder, filename) && MassStorage::FileExists(location.c_str());
 }
 
+#if HAS_MASS_STORAGE
+
+bool Platform::GetFileSizeAndTime(const char *_ecv_array folder, const char *_ecv_array filename, uint32_t& size, time_t& lastModified) const noexcept
+{
+	String<MaxFilenameLength> location;
+	return MassStorage::CombineName(location.GetRef(), folder, filename) && MassStorage::GetFileSizeAndTime(location.c_str(), size, lastModified);
+}
+
+#endif
+
 // Return a pointer to a string holding the directory where the system files are. Lock the sysdir lock before calling this.
 const char *_ecv_array Platform::InternalGetSysDir() const noexcept
 {
@@ -4604,6 +4655,112 @@ GCodeResult Platform::ConfigurePort(GCodeBuffer& gb, const StringRef& reply) THR
 	}
 }
 
+// Configure the sizes of the output buffer, network buffer, HTTP responder and upload buffer pools (M590). The macro and web file caches are sized by M473 instead.
+// Output buffers are allocated at startup, so their number can only be increased. The network pools are allocated when config.g has been run, so they can only be changed in config.g.
+// The upload buffers are allocated by the first upload, so they can be changed until then.
+GCodeResult Platform::ConfigureMemoryPools(GCodeBuffer& gb, const StringRef& reply) THROWS(GCodeException)
+{
+	bool seen = false;
+	uint32_t numOutputBuffers = OutputBuffer::GetNumBuffers();
+	gb.TryGetLimitedUIValue('O', numOutputBuffers, seen, MAX_OUTPUT_BUFFER_COUNT + 1);
+	if (numOutputBuffers < OutputBuffer::GetNumBuffers())
+	{
+		reply.printf("the number of output buffers can't be reduced below %u", OutputBuffer::GetNumBuffers());
+		return GCodeResult::error;
+	}
+
+#if HAS_NETWORKING
+	Network& network = reprap.GetNetwork();
+	bool seenNetwork = false;
+	uint32_t numNetworkBuffers = network.GetNumNetworkBuffers();
+	gb.TryGetLimitedUIValue('N', numNetworkBuffers, seenNetwork, MaxNetworkBufferCount + 1);
+	uint32_t numHttpResponders = network.GetNumHttpResponders();
+# if SUPPORT_HTTP
+	gb.TryGetLimitedUIValue('H', numHttpResponders, seenNetwork, MaxHttpResponders + 1);
+# endif
+	if (seenNetwork)
+	{
+		if (network.IsActivated())
+		{
+			reply.copy("network pools can only be configured in config.g");
+			return GCodeResult::error;
+		}
+		if (numNetworkBuffers < MinNetworkBufferCount)
+		{
+			reply.printf("at least %u network buffers are needed", MinNetworkBufferCount);
+			return GCodeResult::error;
+		}
+# if SUPPORT_HTTP
+		if (numHttpResponders == 0)
+		{
+			reply.copy("at least one HTTP responder is needed");
+			return GCodeResult::error;
+		}
+# endif
+		seen = true;
+	}
+#endif
+
+#if HAS_NETWORKING && HAS_MASS_STORAGE
+	// The upload buffers are allocated when the first file is uploaded, so we don't need to check the memory for them here
+	bool seenUpload = false;
+	uint32_t numUploadBuffers = UploadWriter::GetNumBuffers();
+	uint32_t uploadBufferSize = UploadWriter::GetBufferSize();
+	gb.TryGetUIValue('U', numUploadBuffers, seenUpload);
+	gb.TryGetUIValue('V', uploadBufferSize, seenUpload);
+	if (seenUpload)
+	{
+		seen = true;
+	}
+#endif
+
+	if (!seen)
+	{
+		reply.printf("Output buffers %u", OutputBuffer::GetNumBuffers());
+#if HAS_NETWORKING
+		reply.catf(", network buffers %u, HTTP responders %u", network.GetNumNetworkBuffers(), network.GetNumHttpResponders());
+# if HAS_MASS_STORAGE
+		reply.catf(", upload buffers %u of %u bytes", UploadWriter::GetNumBuffers(), UploadWriter::GetBufferSize());
+# endif
+#endif
+		reply.catf(", never used RAM %d", Tasks::GetNeverUsedRam());
+		return GCodeResult::ok;
+	}
+
+	ptrdiff_t memoryNeeded = (ptrdiff_t)((numOutputBuffers - OutputBuffer::GetNumBuffers()) * sizeof(OutputBuffer));
+#if HAS_NETWORKING
+	memoryNeeded += network.GetPoolMemoryChange(numNetworkBuffers, numHttpResponders);
+#endif
+	if (memoryNeeded > 0)
+	{
+		memoryNeeded += 1024;					// allow some margin
+		const ptrdiff_t memoryAvailable = Tasks::GetNeverUsedRam();
+		if (memoryNeeded >= memoryAvailable)
+		{
+			reply.printf("insufficient RAM (available %d, needed %d)", memoryAvailable, memoryNeeded);
+			return GCodeResult::error;
+		}
+	}
+
+#if HAS_NETWORKING && HAS_MASS_STORAGE
+	if (seenUpload)
+	{
+		const GCodeResult rslt = UploadWriter::Configure(numUploadBuffers, uploadBufferSize, reply);
+		if (rslt != GCodeResult::ok)
+		{
+			return rslt;
+		}
+	}
+#endif
+
+	OutputBuffer::AddBuffers(numOutputBuffers - OutputBuffer::GetNumBuffers());
+#if HAS_NETWORKING
+	network.SetPoolSizes(numNetworkBuffers, numHttpResponders);
+#endif
+	reprap.BoardsUpdated();
+	return GCodeResult::ok;
+}
+
 // Process M425
 GCodeResult Platform::ConfigureBacklashCompensation(GCodeBuffer& gb, const StringRef& reply) THROWS(GCodeException)
 {
@@ -5405,7 +5562,7 @@ void Platform::SendDriversStatus(CanMessageBuffer& buf) noexcept
 	}
 # endif
 	buf.dataLength = msg->GetActualDataLength();
-	CanInterface::SendMessageNoReplyNoFree(&buf);
+	CanInterface::SendStatusReportNoFree(&buf);
 }
 
 #endif	// SUPPORT_REMOTE_COMMANDS
@@ -390,6 +390,9 @@ public:
 #if HAS_MASS_STORAGE || HAS_SBC_INTERFACE || HAS_EMBEDDED_FILES
 	FileStore* OpenFile(const char *_ecv_array folder, const char *_ecv_array fileName, OpenMode mode, uint32_t preAllocSize = 0) const noexcept;
 	bool FileExists(const char *_ecv_array folder, const char *_ecv_array filename) const noexcept;
+# if HAS_MASS_STORAGE
+	bool GetFileSizeAndTime(const char *_ecv_array folder, const char *_ecv_array filename, uint32_t& size, time_t& lastModified) const noexcept;
+# endif
 # if HAS_MASS_STORAGE || HAS_SBC_INTERFACE
 	bool Delete(const char *_ecv_array folder, const char *_ecv_array filename) const noexcept;
 # endif
@@ -628,6 +631,7 @@ public:
 
 	// Misc
 	GCodeResult ConfigurePort(GCodeBuffer& gb, const StringRef& reply) THROWS(GCodeException);
+	GCodeResult ConfigureMemoryPools(GCodeBuffer& gb, const StringRef& reply) THROWS(GCodeException);	// process M590
 
 	GpOutputPort& GetGpOutPort(size_t gpoutPortNumber) noexcept
 		pre(gpoutPortNumber < MaxGpOutPorts)	{ return gpoutPorts[gpoutPortNumber]; }
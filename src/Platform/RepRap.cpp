@@ -17,11 +17,14 @@
 #include <Tools/Filament.h>
 #include <Endstops/ZProbe.h>
 #include "Tasks.h"
+#include "Heap.h"
 #include <Cache.h>
 #include <Fans/FansManager.h>
 #include <Hardware/SoftwareReset.h>
 #include <Hardware/ExceptionHandlers.h>
 #include <Accelerometers/Accelerometers.h>
+#include <ObjectModel/ObjectModelChanges.h>
+#include <ObjectModel/ObjectModelResponseCache.h>
 #include "Version.h"
 
 #ifdef DUET_NG
@@ -447,6 +450,9 @@ DEFINE_GET_OBJECT_MODEL_TABLE(RepRap)
 RepRap::RepRap() noexcept
 	: boardsSeq(0), directoriesSeq(0), fansSeq(0), heatSeq(0), inputsSeq(0), jobSeq(0), ledStripsSeq(0), moveSeq(0), globalSeq(0),
 	  networkSeq(0), scannerSeq(0), sensorsSeq(0), spindlesSeq(0), stateSeq(0), toolsSeq(0), volumesSeq(0),
+#if SUPPORT_OBJECT_MODEL
+	  maxModelResponseLength(0), numChunkedModelResponses(0), numAbandonedModelResponses(0),
+#endif
 	  lastWarningMillis(0),
 	  ticksInSpinState(0), heatTaskIdleTicks(0),
 	  beepFrequency(0), beepDuration(0), beepTimer(0),
@@ -492,6 +498,9 @@ static void CheckWatchBuffer(unsigned int module) noexcept
 void RepRap::Init() noexcept
 {
 	OutputBuffer::Init();
+#if SUPPORT_OBJECT_MODEL
+	ObjectModelResponseCache::Init();
+#endif
 	platform = new Platform();
 #if HAS_SBC_INTERFACE
 	sbcInterface = new SbcInterface();				// needs to be allocated early on Duet 2 so as to avoid using any of the last 64K of RAM
@@ -671,6 +680,7 @@ void RepRap::Init() noexcept
 		{
 			platform->DeleteSysFile(GCodes::RUNONCE_G);
 		}
+		MassStorage::AutoConfigureWebFileCache();		// do this after running config.g so that M473 can override it
 #endif
 	}
 	processingConfig = false;
@@ -781,6 +791,7 @@ void RepRap::Spin() noexcept
 
 	ticksInSpinState = 0;
 	spinningModule = Module::none;
+	Heap::Spin();
 
 	// Check if we need to send diagnostics
 	if (diagnosticsDestination != MessageType::NoDestinationMessage)
@@ -924,6 +935,14 @@ void RepRap::Diagnostics(MessageType mtype) noexcept
 
 	// Show the used and free buffer counts. Do this early in case we are running out of them and the diagnostics get truncated.
 	OutputBuffer::Diagnostics(mtype);
+#if SUPPORT_OBJECT_MODEL
+	ObjectModelPathCache::Diagnostics(mtype);
+	ObjectModelChangeTracker::Diagnostics(mtype);
+	ObjectModelResponseCache::Diagnostics(mtype);
+	platform->MessageF(mtype, "OM responses: max buffered %u bytes, chunked %" PRIu32 ", abandoned because the model changed %" PRIu32 "\n",
+						maxModelResponseLength, numChunkedModelResponses, numAbandonedModelResponses);
+	maxModelResponseLength = 0;
+#endif
 
 	// If there was an error running config.g, print it
 	if (!configErrorMessage.IsNull())
@@ -2312,9 +2331,56 @@ void RepRap::AppendStringArray(OutputBuffer *buf, const char *name, size_t numVa
 
 #if SUPPORT_OBJECT_MODEL
 
+// Return a value that changes whenever any of the object model sequence numbers changes. Each sequence number only ever increases, so we can just add them.
+uint32_t RepRap::GetSeqsSignature() const noexcept
+{
+	return (uint32_t)boardsSeq + directoriesSeq + fansSeq + heatSeq + inputsSeq + jobSeq + ledStripsSeq + moveSeq + globalSeq
+			+ networkSeq + scannerSeq + sensorsSeq + spindlesSeq + stateSeq + toolsSeq + volumesSeq;
+}
+
+// Return the name and sequence number of the top-level object model section with the specified index, or nullptr if the index is out of range
+const char *_ecv_array _ecv_null RepRap::GetModelSection(size_t index, uint16_t& seq) const noexcept
+{
+	static const struct { const char *_ecv_array name; uint16_t RepRap::*seq; } sections[] =
+	{
+		{ "boards", &RepRap::boardsSeq },
+#if HAS_MASS_STORAGE || HAS_EMBEDDED_FILES || HAS_SBC_INTERFACE
+		{ "directories", &RepRap::directoriesSeq },
+#endif
+		{ "fans", &RepRap::fansSeq },
+		{ "global", &RepRap::globalSeq },
+		{ "heat", &RepRap::heatSeq },
+		{ "inputs", &RepRap::inputsSeq },
+		{ "job", &RepRap::jobSeq },
+#if SUPPORT_LED_STRIPS
+		{ "ledStrips", &RepRap::ledStripsSeq },
+#endif
+		{ "move", &RepRap::moveSeq },
+		{ "network", &RepRap::networkSeq },
+		{ "sensors", &RepRap::sensorsSeq },
+		{ "spindles", &RepRap::spindlesSeq },
+		{ "state", &RepRap::stateSeq },
+		{ "tools", &RepRap::toolsSeq },
+#if HAS_MASS_STORAGE
+		{ "volumes", &RepRap::volumesSeq },
+#endif
+	};
+	static_assert(ARRAY_SIZE(sections) <= MaxModelSections);
+
+	if (index >= ARRAY_SIZE(sections))
+	{
+		return nullptr;
+	}
+	seq = this->*(sections[index].seq);
+	return sections[index].name;
+}
+
 // Return a query into the object model, or return nullptr if no buffer available
 // We append a newline to help PanelDue resync after receiving corrupt or incomplete data. DWC ignores it.
-OutputBuffer *RepRap::GetModelResponse(const GCodeBuffer *_ecv_null gb, const char *key, const char *flags) const THROWS(GCodeException)
+// If a cursor is passed then the response may be generated in several chunks. The caller should keep calling this with the same key, flags and cursor
+// until cursor->IsInProgress() returns false. The response is the concatenation of the chunks. If the object model changes between chunks then we
+// return nullptr and reset the cursor, because the rest of the response would not be consistent with the chunks already generated.
+OutputBuffer *RepRap::GetModelResponse(const GCodeBuffer *_ecv_null gb, const char *key, const char *flags, ObjectModelCursor *_ecv_null cursor) const THROWS(GCodeException)
 {
 	OutputBuffer *outBuf;
 	if (OutputBuffer::Allocate(outBuf))
@@ -2322,7 +2388,40 @@ OutputBuffer *RepRap::GetModelResponse(const GCodeBuffer *_ecv_null gb, const ch
 		if (key == nullptr) { key = ""; }
 		if (flags == nullptr) { flags = ""; }
 
-		outBuf->printf("{\"key\":\"%.s\",\"flags\":\"%.s\",\"result\":", key, flags);
+		const bool firstChunk = (cursor == nullptr || !cursor->IsInProgress());
+
+		// Identical requests from several clients are often received close together, so see if we generated this response very recently.
+		// We can't cache delta reports because the response depends on the token and updates the change tracker.
+		const bool cacheable = firstChunk && strchr(flags, 'c') == nullptr;
+		const uint32_t signature = GetSeqsSignature();
+		const uint32_t whenStarted = millis();
+		if (cacheable && ObjectModelResponseCache::Find(key, flags, signature, outBuf))
+		{
+			if (outBuf->HadOverflow())
+			{
+				OutputBuffer::ReleaseAll(outBuf);
+			}
+			return outBuf;
+		}
+
+		const char *_ecv_array const originalKey = key;
+		if (firstChunk)
+		{
+			outBuf->printf("{\"key\":\"%.s\",\"flags\":\"%.s\",\"result\":", key, flags);
+			if (cursor != nullptr)
+			{
+				cursor->SetModelSignature(signature);
+			}
+		}
+		else if (cursor->ModelChanged(signature))
+		{
+			// Objects or array elements may have been added or removed since we generated the first chunk, so the cursor may no longer point to
+			// the place where we stopped. We can't take back the chunks already sent, so abandon the response and let the caller close the connection.
+			++numAbandonedModelResponses;
+			cursor->Reset();
+			OutputBuffer::ReleaseAll(outBuf);
+			return nullptr;
+		}
 
 		const bool wantArrayLength = (*key == '#');
 		if (wantArrayLength)
@@ -2332,16 +2431,38 @@ OutputBuffer *RepRap::GetModelResponse(const GCodeBuffer *_ecv_null gb, const ch
 
 		try
 		{
-			reprap.ReportAsJson(gb, outBuf, key, flags, wantArrayLength);
-			outBuf->cat("}\n");
+			if (reprap.ReportAsJson(gb, outBuf, key, flags, wantArrayLength, cursor))
+			{
+				outBuf->cat("}\n");
+				if (!firstChunk)
+				{
+					++numChunkedModelResponses;
+				}
+				else if (cacheable && !outBuf->HadOverflow())
+				{
+					ObjectModelResponseCache::Store(originalKey, flags, signature, whenStarted, outBuf);
+				}
+			}
 			if (outBuf->HadOverflow())
 			{
 				OutputBuffer::ReleaseAll(outBuf);
+				if (cursor != nullptr)
+				{
+					cursor->Reset();
+				}
+			}
+			else if (outBuf->Length() > maxModelResponseLength)
+			{
+				maxModelResponseLength = outBuf->Length();
 			}
 		}
 		catch (...)
 		{
 			OutputBuffer::ReleaseAll(outBuf);
+			if (cursor != nullptr)
+			{
+				cursor->Reset();
+			}
 			throw;
 		}
 	}
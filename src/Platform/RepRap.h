@@ -117,7 +117,11 @@ public:
 	GCodeResult GetFileInfoResponse(const char *filename, OutputBuffer *&response, bool quitEarly) noexcept;
 
 #if SUPPORT_OBJECT_MODEL
-	OutputBuffer *GetModelResponse(const GCodeBuffer *_ecv_null gb, const char *key, const char *flags) const THROWS(GCodeException);
+	OutputBuffer *GetModelResponse(const GCodeBuffer *_ecv_null gb, const char *key, const char *flags, ObjectModelCursor *_ecv_null cursor = nullptr) const THROWS(GCodeException);
+	uint32_t GetSeqsSignature() const noexcept;
+	const char *_ecv_array _ecv_null GetModelSection(size_t index, uint16_t& seq) const noexcept;
+
+	static constexpr size_t MaxModelSections = 16;			// the maximum number of top-level object model sections that have sequence numbers
 #endif
 
 	void Beep(unsigned int freq, unsigned int ms) noexcept;
@@ -218,6 +222,13 @@ private:
 
 	GlobalVariables globalVariables;
 
+#if SUPPORT_OBJECT_MODEL
+	// Object model response statistics
+	mutable size_t maxModelResponseLength;
+	mutable uint32_t numChunkedModelResponses;
+	mutable uint32_t numAbandonedModelResponses;
+#endif
+
 	uint32_t lastWarningMillis;					// when we last sent a warning message for things that can happen very often
 
 	uint16_t ticksInSpinState;
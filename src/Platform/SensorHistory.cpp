@@ -0,0 +1,236 @@
+/*
+ * SensorHistory.cpp
+ *
+ *  Created on: 19 Oct 2026
+ */
+
+#include "SensorHistory.h"
+
+#if SUPPORT_OBJECT_MODEL
+
+// Object model table and functions
+// Note: if using GCC version 7.3.1 20180622 and lambda functions are used in this table, you must compile this file with option -std=gnu++17.
+// Otherwise the table will be allocated in RAM instead of flash, which wastes too much RAM.
+
+// Macro to build a standard lambda function that includes the necessary type conversions
+#define OBJECT_MODEL_FUNC(...) OBJECT_MODEL_FUNC_BODY(SensorHistory, __VA_ARGS__)
+
+constexpr ObjectModelArrayTableEntry SensorHistory::objectModelArrayTable[] =
+{
+	// 0. Values
+	{
+		nullptr,
+		[] (const ObjectModel *self, const ObjectExplorationContext& context) noexcept -> size_t
+			{ return ((const SensorHistory*)self)->SamplesToReport(context) - ((const SensorHistory*)self)->FirstSampleToReport(context); },
+		[] (const ObjectModel *self, ObjectExplorationContext& context) noexcept -> ExpressionValue
+			{ return ((const SensorHistory*)self)->GetSample(((const SensorHistory*)self)->FirstSampleToReport(context) + context.GetLastIndex()); }
+	}
+};
+
+DEFINE_GET_OBJECT_MODEL_ARRAY_TABLE(SensorHistory)
+
+constexpr ObjectModelTableEntry SensorHistory::objectModelTable[] =
+{
+	// These entries must be in alphabetical order
+	{ "interval",		OBJECT_MODEL_FUNC((int32_t)HeatSampleIntervalMillis),						ObjectModelEntryFlags::none },
+	{ "start",			OBJECT_MODEL_FUNC(self->GetReportStartTime(context)),						ObjectModelEntryFlags::live },
+	{ "values",			OBJECT_MODEL_FUNC_ARRAY(0),													ObjectModelEntryFlags::live },
+};
+
+constexpr uint8_t SensorHistory::objectModelTableDescriptor[] = { 1, 3 };
+
+DEFINE_GET_OBJECT_MODEL_TABLE(SensorHistory)
+
+#endif
+
+size_t SensorHistory::memoryUsed = 0;
+
+SensorHistory::SensorHistory(float p_resolution, uint8_t p_decimals) noexcept
+	: numSamples(0), lastValue(0), resolution(p_resolution), decimals(p_decimals)
+{
+}
+
+// Allocate a history from the memory set aside for them, returning nullptr if there isn't enough left
+void* SensorHistory::operator new(size_t sz) noexcept
+{
+	{
+		TaskCriticalSectionLocker lock;
+		if (memoryUsed + sz > SensorHistoryMemory)
+		{
+			return nullptr;
+		}
+		memoryUsed += sz;
+	}
+	Tasks::RecordAllocation(MemoryTag::objectModel, sz);
+	return ::operator new(sz);
+}
+
+void SensorHistory::operator delete(void* p, size_t sz) noexcept
+{
+	Tasks::RecordRelease(MemoryTag::objectModel, sz);
+	{
+		TaskCriticalSectionLocker lock;
+		memoryUsed -= sz;
+	}
+	::operator delete(p);
+}
+
+// Record a reading, creating the history if we don't already have one and there is memory available for it.
+// This is called by the heat task once per sample interval, with the lock held that prevents the owner of the history being deleted.
+/*static*/ void SensorHistory::Record(SensorHistory *_ecv_null& history, float value, bool valid, float resolution, uint8_t decimals) noexcept
+{
+	if (history == nullptr && valid)
+	{
+		history = new SensorHistory(resolution, decimals);
+	}
+	if (history != nullptr)
+	{
+		history->Record(value, valid);
+	}
+}
+
+// Record the reading for this sample interval
+void SensorHistory::Record(float value, bool valid) noexcept
+{
+	const unsigned int position = numSamples % SamplesPerBlock;
+	Block& block = blocks[(numSamples/SamplesPerBlock) % NumBlocks];
+	const uint16_t earlierSamplesMask = (1u << position) - 1;
+	const uint32_t now = (uint32_t)millis64();
+
+	TaskCriticalSectionLocker lock;							// don't let a report read this block while we are changing it
+	if (position == 0)
+	{
+		block.firstSampleMillis = now;
+		block.nullSamples = 0;
+	}
+
+	if (!valid)
+	{
+		block.nullSamples |= 1u << position;
+		if (position == 0)
+		{
+			block.firstValue = 0;
+		}
+		else
+		{
+			block.deltas[position - 1] = 0;
+		}
+	}
+	else
+	{
+		const int32_t newValue = constrain<int32_t>(lrintf(value/resolution), -std::numeric_limits<int16_t>::max(), std::numeric_limits<int16_t>::max());
+		if (position == 0 || (block.nullSamples & earlierSamplesMask) == earlierSamplesMask)
+		{
+			// This is the first valid sample in the block, so no earlier sample depends on the first value and we can set it to this one.
+			// The differences of the invalid samples before this one are all zero.
+			block.firstValue = (int16_t)newValue;
+			if (position != 0)
+			{
+				block.deltas[position - 1] = 0;
+			}
+			lastValue = newValue;
+		}
+		else
+		{
+			const int32_t delta = constrain<int32_t>(newValue - lastValue, -MaxDelta, MaxDelta);
+			block.deltas[position - 1] = (int8_t)delta;
+			lastValue += delta;
+		}
+	}
+	++numSamples;
+}
+
+// Return the number of the oldest sample that we hold and won't overwrite soon, given the number of samples recorded.
+// We hold the newest NumBlocks blocks, but the oldest of those is the next one to be overwritten. Don't report from it, in case it is overwritten while we are reporting.
+/*static*/ uint32_t SensorHistory::OldestSampleHeld(uint32_t recorded) noexcept
+{
+	const uint32_t blocksRecorded = (recorded + SamplesPerBlock - 1)/SamplesPerBlock;
+	return (blocksRecorded >= NumBlocks) ? (blocksRecorded - (NumBlocks - 1)) * SamplesPerBlock : 0;
+}
+
+// Return the time at which a sample was recorded. We store only the low 32 bits of the time of each block, so we extend it using a 64-bit time that is
+// within 24 days of it, which is always the case because we don't keep samples for that long.
+uint64_t SensorHistory::GetSampleTime(uint32_t sampleNumber, uint64_t now) const noexcept
+{
+	const uint32_t blockMillis = blocks[(sampleNumber/SamplesPerBlock) % NumBlocks].firstSampleMillis;
+	return now + (int64_t)(int32_t)(blockMillis - (uint32_t)now) + (uint64_t)(sampleNumber % SamplesPerBlock) * HeatSampleIntervalMillis;
+}
+
+// Return the number of the first sample from 'first' to 'last' - 1 that was recorded after 'when', or 'last' if there isn't one.
+// The sample times increase with the sample number, so we can do a binary search.
+uint32_t SensorHistory::FirstSampleAfter(uint64_t when, uint32_t first, uint32_t last, uint64_t now) const noexcept
+{
+	while (first < last)
+	{
+		const uint32_t middle = first + (last - first)/2;
+		if (GetSampleTime(middle, now) > when)
+		{
+			last = middle;
+		}
+		else
+		{
+			first = middle + 1;
+		}
+	}
+	return first;
+}
+
+// Return the time of the first sample we report. If there are none then return the time at which we expect to record the next one.
+uint64_t SensorHistory::GetReportStartTime(const ObjectExplorationContext& context) const noexcept
+{
+	const uint32_t samplesToReport = SamplesToReport(context);
+	const uint32_t first = FirstSampleToReport(context);
+	return (first < samplesToReport) ? GetSampleTime(first, context.GetStartMillis())
+			: (samplesToReport != 0) ? GetSampleTime(samplesToReport - 1, context.GetStartMillis()) + HeatSampleIntervalMillis
+				: context.GetStartMillis();
+}
+
+// Return the number of samples that had been recorded when the report was started. All the values in one report are based on this, so they are consistent
+// even if the heat task records more samples while we are generating the report. The start time is kept in the cursor of a chunked report, so this is
+// also the same for all the chunks.
+uint32_t SensorHistory::SamplesToReport(const ObjectExplorationContext& context) const noexcept
+{
+	const uint32_t recorded = numSamples;
+	return FirstSampleAfter(context.GetStartMillis(), OldestSampleHeld(recorded), recorded, context.GetStartMillis());
+}
+
+// Return the number of the first sample that the client asked for, which is the first one recorded at or after the time it passed.
+// If we no longer have that sample then return the oldest one we hold. If the report is not chunked then return no more than MaxUnchunkedHistorySamples.
+uint32_t SensorHistory::FirstSampleToReport(const ObjectExplorationContext& context) const noexcept
+{
+	const uint32_t samplesToReport = SamplesToReport(context);
+	uint32_t first = min<uint32_t>(OldestSampleHeld(samplesToReport), samplesToReport);
+	if (context.GetHistorySince() != 0)
+	{
+		first = FirstSampleAfter(context.GetHistorySince() - 1, first, samplesToReport, context.GetStartMillis());
+	}
+	if (!context.IsChunked() && samplesToReport - first > MaxUnchunkedHistorySamples)
+	{
+		first = samplesToReport - MaxUnchunkedHistorySamples;
+	}
+	return first;
+}
+
+// Get the value of a sample, or null if the reading was not valid
+ExpressionValue SensorHistory::GetSample(uint32_t sampleNumber) const noexcept
+{
+	const unsigned int position = sampleNumber % SamplesPerBlock;
+	const Block& block = blocks[(sampleNumber/SamplesPerBlock) % NumBlocks];
+	int32_t value;
+	{
+		TaskCriticalSectionLocker lock;
+		if (block.nullSamples & (1u << position))
+		{
+			return ExpressionValue(nullptr);
+		}
+
+		value = block.firstValue;
+		for (unsigned int i = 0; i < position; ++i)
+		{
+			value += block.deltas[i];
+		}
+	}
+	return ExpressionValue((float)value * resolution, decimals);
+}
+
+// End
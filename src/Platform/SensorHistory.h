@@ -0,0 +1,73 @@
+/*
+ * SensorHistory.h
+ *
+ *  Created on: 19 Oct 2026
+ */
+
+#ifndef SRC_PLATFORM_SENSORHISTORY_H_
+#define SRC_PLATFORM_SENSORHISTORY_H_
+
+#include <RepRapFirmware.h>
+#include <ObjectModel/ObjectModel.h>
+#include <Platform/Tasks.h>
+
+// Class to record the recent history of a sensor reading, so that a client can fetch it in one object model request instead of polling for each reading.
+// The heat task records a sample every HeatSampleIntervalMillis. Samples are stored in blocks of SamplesPerBlock, each holding the time and the first value
+// as a 16-bit integer and the rest as 8-bit differences from the previous value, so the history for SensorHistorySeconds fits in a few kilobytes.
+// The times of the other samples in a block are taken to be HeatSampleIntervalMillis apart.
+// Histories are long, so a report that is not generated in chunks returns only the newest MaxUnchunkedHistorySamples of each.
+// A difference too large to store is limited, so the stored value catches up over the following samples and is corrected at the start of the next block.
+// Samples taken while the reading is not valid are recorded as null.
+// The histories share a fixed amount of memory. A sensor that is created when it has all been used doesn't get a history.
+class SensorHistory INHERIT_OBJECT_MODEL
+{
+public:
+	SensorHistory(float p_resolution, uint8_t p_decimals) noexcept;
+	SensorHistory(const SensorHistory&) = delete;
+
+	void* operator new(size_t sz) noexcept;											// returns nullptr if the histories have used all their memory
+	void operator delete(void* p, size_t sz) noexcept;
+
+	void Record(float value, bool valid) noexcept;									// record the reading for this sample interval
+
+	// Record a reading, creating the history if we don't already have one and there is memory available for it
+	static void Record(SensorHistory *_ecv_null& history, float value, bool valid, float resolution, uint8_t decimals) noexcept;
+
+	static size_t GetMemoryUsed() noexcept { return memoryUsed; }
+
+protected:
+	DECLARE_OBJECT_MODEL_WITH_ARRAYS
+
+private:
+	static constexpr unsigned int SamplesPerBlock = 16;
+	static constexpr size_t SamplesToKeep = (SensorHistorySeconds * 1000)/HeatSampleIntervalMillis;
+	static constexpr size_t NumBlocks = (SamplesToKeep + SamplesPerBlock - 1)/SamplesPerBlock + 2;	// the newest block may be partly filled and we don't report from the oldest one
+	static constexpr int8_t MaxDelta = 127;											// the largest difference we can store
+
+	struct Block
+	{
+		uint32_t firstSampleMillis;													// the low 32 bits of the millis64() time at which we recorded the first sample
+		int16_t firstValue;															// the value of the first sample
+		uint16_t nullSamples;														// bitmap of samples that were not valid
+		int8_t deltas[SamplesPerBlock - 1];											// the difference between each subsequent sample and the one before it
+	};
+
+	uint32_t SamplesToReport(const ObjectExplorationContext& context) const noexcept;		// return the number of samples recorded when the report was started
+	uint32_t FirstSampleToReport(const ObjectExplorationContext& context) const noexcept;	// return the number of the first sample that the client asked for
+	uint64_t GetSampleTime(uint32_t sampleNumber, uint64_t now) const noexcept;				// return the time of a sample that we still hold
+	uint64_t GetReportStartTime(const ObjectExplorationContext& context) const noexcept;
+	uint32_t FirstSampleAfter(uint64_t when, uint32_t first, uint32_t last, uint64_t now) const noexcept;
+	ExpressionValue GetSample(uint32_t sampleNumber) const noexcept;
+
+	static uint32_t OldestSampleHeld(uint32_t recorded) noexcept;
+
+	static size_t memoryUsed;														// how much of the SensorHistoryMemory the existing histories use
+
+	uint32_t numSamples;															// how many samples we have recorded since we were created
+	int32_t lastValue;																// the stored value of the last sample, in units of the resolution
+	float resolution;																// the value of one unit of a stored sample
+	uint8_t decimals;																// how many decimal places to report values to
+	Block blocks[NumBlocks];
+};
+
+#endif /* SRC_PLATFORM_SENSORHISTORY_H_ */
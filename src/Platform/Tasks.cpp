@@ -52,6 +52,10 @@ constexpr unsigned int MainTaskStackWords = max<unsigned int>(1370, (MaxAxes * M
 #endif
 
 static Task<MainTaskStackWords> mainTask;
+
+// Memory accounting by subsystem
+static size_t memoryUsed[MemoryTag::NumValues] = { 0 };
+static size_t peakMemoryUsed[MemoryTag::NumValues] = { 0 };
 extern "C" [[noreturn]] void MainTask(void * pvParameters) noexcept;
 extern DeviceVectors exception_table;
 
@@ -292,14 +296,43 @@ const char* Tasks::GetHeapTop() noexcept
 
 // Allocate memory permanently. Using this saves about 8 bytes per object. You must not call free() on the returned object.
 // It doesn't try to allocate from the free list maintained by malloc, only from virgin memory.
-void *Tasks::AllocPermanent(size_t sz, std::align_val_t align) noexcept
+void *Tasks::AllocPermanent(size_t sz, MemoryTag tag, std::align_val_t align) noexcept
 {
 	GetMallocMutex();
 	void * const ret = CoreAllocPermanent(sz, align);
 	ReleaseMallocMutex();
+	RecordAllocation(tag, sz);
 	return ret;
 }
 
+// Account for memory allocated to a subsystem. This may be called by any task.
+void Tasks::RecordAllocation(MemoryTag tag, size_t sz) noexcept
+{
+	TaskCriticalSectionLocker lock;
+	const size_t used = (memoryUsed[tag.ToBaseType()] += sz);
+	if (used > peakMemoryUsed[tag.ToBaseType()])
+	{
+		peakMemoryUsed[tag.ToBaseType()] = used;
+	}
+}
+
+// Account for memory that a subsystem has released
+void Tasks::RecordRelease(MemoryTag tag, size_t sz) noexcept
+{
+	TaskCriticalSectionLocker lock;
+	memoryUsed[tag.ToBaseType()] -= min<size_t>(sz, memoryUsed[tag.ToBaseType()]);
+}
+
+size_t Tasks::GetMemoryUsed(MemoryTag tag) noexcept
+{
+	return memoryUsed[tag.ToBaseType()];
+}
+
+size_t Tasks::GetPeakMemoryUsed(MemoryTag tag) noexcept
+{
+	return peakMemoryUsed[tag.ToBaseType()];
+}
+
 // Function called by FreeRTOS and internally to reset the run-time counter and return the number of timer ticks since it was last reset
 extern "C" uint32_t TaskResetRunTimeCounter() noexcept
 {
@@ -329,6 +362,13 @@ void Tasks::Diagnostics(MessageType mtype) noexcept
 		p.MessageF(mtype, "Dynamic ram: %d of which %d recycled\n", mi.uordblks, mi.fordblks);
 		p.MessageF(mtype, "Never used RAM %d, free system stack %d words\n", GetNeverUsedRam(), GetHandlerFreeStack()/4);
 
+		p.Message(mtype, "Memory used/peak by subsystem:");
+		for (unsigned int i = 0; i < MemoryTag::NumValues; ++i)
+		{
+			p.MessageF(mtype, " %s %u/%u", MemoryTag(i).ToString(), GetMemoryUsed(MemoryTag(i)), GetPeakMemoryUsed(MemoryTag(i)));
+		}
+		p.Message(mtype, "\n");
+
 		//DEBUG
 		//p.MessageF(mtype, "heap top %.08" PRIx32 ", limit %.08" PRIx32 "\n", (uint32_t)heapTop, (uint32_t)heapLimit);
 		//ENDDB
@@ -436,7 +476,7 @@ extern "C" void _tzset_unlocked() noexcept { }
 // Functions called by CanMessageBuffer in CANlib
 void *MessageBufferAlloc(size_t sz, std::align_val_t align) noexcept
 {
-	return Tasks::AllocPermanent(sz, align);
+	return Tasks::AllocPermanent(sz, MemoryTag::can, align);
 }
 
 void MessageBufferDelete(void *ptr, std::align_val_t align) noexcept { }
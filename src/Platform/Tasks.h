@@ -11,13 +11,20 @@
 #include <RepRapFirmware.h>
 #include <RTOSIface/RTOSIface.h>
 
+// Subsystems that memory allocations are accounted to in the M122 report and in boards[0].memory in the object model
+NamedEnum(MemoryTag, uint8_t, move, network, heat, storage, objectModel, can, other);
+
 namespace Tasks
 {
 	void Diagnostics(MessageType mtype) noexcept;
 	TaskHandle GetMainTask() noexcept;
 	void TerminateMainTask() noexcept;
 	ptrdiff_t GetNeverUsedRam() noexcept;
-	void *AllocPermanent(size_t sz, std::align_val_t align = (std::align_val_t)__STDCPP_DEFAULT_NEW_ALIGNMENT__) noexcept;
+	void *AllocPermanent(size_t sz, MemoryTag tag, std::align_val_t align = (std::align_val_t)__STDCPP_DEFAULT_NEW_ALIGNMENT__) noexcept;
+	void RecordAllocation(MemoryTag tag, size_t sz) noexcept;
+	void RecordRelease(MemoryTag tag, size_t sz) noexcept;
+	size_t GetMemoryUsed(MemoryTag tag) noexcept;
+	size_t GetPeakMemoryUsed(MemoryTag tag) noexcept;
 	const char* GetHeapTop() noexcept;
 	Mutex *GetI2CMutex() noexcept;
 	void *GetNVMBuffer(const uint32_t *_ecv_array null stk) noexcept;
@@ -400,23 +400,35 @@ __nocache TransferHeader DataTransfer::rxHeader;
 __nocache TransferHeader DataTransfer::txHeader;
 __nocache uint32_t DataTransfer::rxResponse;
 __nocache uint32_t DataTransfer::txResponse;
-alignas(4) __nocache char DataTransfer::rxBuffer[SbcTransferBufferSize];
-alignas(4) __nocache char DataTransfer::txBuffer[SbcTransferBufferSize];
+alignas(4) __nocache char DataTransfer::rxBuffers[SbcNumTransferBuffers][SbcMaxTransferBufferSize];
+alignas(4) __nocache char DataTransfer::txBuffers[SbcNumTransferBuffers][SbcMaxTransferBufferSize];
 #endif
 
-DataTransfer::DataTransfer() noexcept : state(InternalTransferState::ExchangingData), lastTransferNumber(0), failedTransfers(0), checksumErrors(0),
-#if SAME5x
-	rxBuffer(nullptr), txBuffer(nullptr),
-#endif
-	rxPointer(0), txPointer(0), packetId(0)
+DataTransfer::DataTransfer() noexcept : state(InternalTransferState::ExchangingData), lastTransferNumber(0), remoteProtocolVersion(0), failedTransfers(0), checksumErrors(0),
+	transferBufferSize(SbcTransferBufferSize), numTransferBuffers(1), sbcTransferBufferSize(SbcTransferBufferSize), sbcNumTransferBuffers(1),
+	transferParametersAnnounced(false), transferParametersSent(false), sbcTransferParametersReceived(false), pipelined(false),
+	numTransfers(0), bytesReceived(0), bytesSent(0), lastTransferFinishedAt(0), totalTurnaroundTime(0), maxTurnaroundTime(0),
+	rxIndex(0), writeIndex(0), readLength(0), readNumPackets(0), rxPointer(0), txPointer(0), packetId(0)
 {
+#if SAME70
+	rxBuffer = rxBuffers[0];
+	txBuffer = writeBuffer = txBuffers[0];
+#else
+	for (size_t i = 0; i < SbcNumTransferBuffers; ++i)
+	{
+		rxBuffers[i] = txBuffers[i] = nullptr;
+	}
+	rxBuffer = txBuffer = writeBuffer = nullptr;
+#endif
+	readBuffer = rxBuffer;
+
 	rxResponse = TransferResponse::Success;
 	txResponse = TransferResponse::Success;
 
 	// Prepare RX header
 	rxHeader.sequenceNumber = 0;
 
-	// Prepare TX header
+	// Prepare TX header. Until we know which protocol version the SBC speaks, announce the newest one we support
 	txHeader.formatCode = SbcFormatCode;
 	txHeader.protocolVersion = SbcProtocolVersion;
 	txHeader.numPackets = 0;
@@ -432,8 +444,13 @@ void DataTransfer::Init() noexcept
 	if (reprap.UsingSbcInterface())
 	{
 		// Allocate buffers in SBC mode
-		rxBuffer = (char *)new uint32_t[(SbcTransferBufferSize + 3)/4];
-		txBuffer = (char *)new uint32_t[(SbcTransferBufferSize + 3)/4];
+		for (size_t i = 0; i < SbcNumTransferBuffers; ++i)
+		{
+			rxBuffers[i] = (char *)new uint32_t[(SbcMaxTransferBufferSize + 3)/4];
+			txBuffers[i] = (char *)new uint32_t[(SbcMaxTransferBufferSize + 3)/4];
+		}
+		readBuffer = rxBuffer = rxBuffers[0];
+		txBuffer = writeBuffer = txBuffers[0];
 	}
 	else
 	{
@@ -515,30 +532,38 @@ void DataTransfer::Diagnostics(MessageType mtype) noexcept
 	reprap.GetPlatform().MessageF(mtype, "Transfer state: %d, failed transfers: %u, checksum errors: %u\n", (int)state, failedTransfers, checksumErrors);
 	reprap.GetPlatform().MessageF(mtype, "RX/TX seq numbers: %d/%d\n", (int)rxHeader.sequenceNumber, (int)txHeader.sequenceNumber);
 	reprap.GetPlatform().MessageF(mtype, "SPI underruns %u, overruns %u\n", spiTxUnderruns, spiRxOverruns);
+	reprap.GetPlatform().MessageF(mtype, "Protocol version %u, max transfer size %u, %s\n",
+									remoteProtocolVersion, transferBufferSize, (numTransferBuffers > 1) ? "pipelined" : "not pipelined");
+
+	// Report the throughput since the last time we were called
+	reprap.GetPlatform().MessageF(mtype, "Transfers %" PRIu32 ", bytes RX/TX %" PRIu32 "/%" PRIu32 ", turnaround avg/max %" PRIu32 "/%" PRIu32 "ms\n",
+									numTransfers, bytesReceived, bytesSent, (numTransfers == 0) ? 0 : totalTurnaroundTime/numTransfers, maxTurnaroundTime);
+	numTransfers = bytesReceived = bytesSent = 0;
+	totalTurnaroundTime = maxTurnaroundTime = 0;
 }
 
 const PacketHeader *DataTransfer::ReadPacket() noexcept
 {
-	if (rxPointer >= rxHeader.dataLength)
+	if (rxPointer >= readLength)
 	{
 		return nullptr;
 	}
 
-	const PacketHeader *header = reinterpret_cast<const PacketHeader*>(rxBuffer + rxPointer);
+	const PacketHeader *header = reinterpret_cast<const PacketHeader*>(readBuffer + rxPointer);
 	rxPointer += sizeof(PacketHeader);
 	return header;
 }
 
 const char *DataTransfer::ReadData(size_t dataLength) noexcept
 {
-	const char *data = rxBuffer + rxPointer;
+	const char *data = readBuffer + rxPointer;
 	rxPointer += AddPadding(dataLength);
 	return data;
 }
 
 template<typename T> const T *DataTransfer::ReadDataHeader() noexcept
 {
-	const T *header = reinterpret_cast<const T*>(rxBuffer + rxPointer);
+	const T *header = reinterpret_cast<const T*>(readBuffer + rxPointer);
 	rxPointer += sizeof(T);
 	return header;
 }
@@ -701,6 +726,32 @@ int DataTransfer::ReadFileData(char *buffer, size_t length) noexcept
 	return bytesToRead;
 }
 
+void DataTransfer::ReadTransferParameters() noexcept
+{
+	const TransferParametersHeader *header = ReadDataHeader<TransferParametersHeader>();
+
+	// Use the smaller of the two sizes, but never less than what protocol version 6 supports
+	sbcTransferBufferSize = constrain<size_t>(header->maxTransferSize & ~3u, SbcTransferBufferSize, SbcMaxTransferBufferSize);
+	sbcNumTransferBuffers = constrain<size_t>(header->numBuffers, 1, SbcNumTransferBuffers);
+	sbcTransferParametersReceived = true;
+	ApplyTransferParameters();
+}
+
+// Switch to the negotiated transfer parameters once both sides know the parameters of the other one.
+// Until then we keep exchanging single transfers of the size that protocol version 6 supports.
+void DataTransfer::ApplyTransferParameters() noexcept
+{
+	if (transferParametersSent && sbcTransferParametersReceived)
+	{
+		transferBufferSize = sbcTransferBufferSize;
+		numTransferBuffers = sbcNumTransferBuffers;
+		if (reprap.Debug(Module::SbcInterface))
+		{
+			debugPrintf("Negotiated transfer size %u, buffers %u\n", transferBufferSize, numTransferBuffers);
+		}
+	}
+}
+
 void DataTransfer::ExchangeHeader() noexcept
 {
 	Cache::FlushBeforeDMASend(&txHeader, sizeof(txHeader));
@@ -734,7 +785,7 @@ void DataTransfer::RestartTransfer(bool ownRequest) noexcept
 	failedTransfers++;
 	if (ownRequest)
 	{
-		if (rxHeader.dataLength > 0 || txPointer > 0)
+		if (rxHeader.dataLength > 0 || txHeader.dataLength > 0)
 		{
 			// Transfer bad data response and restart the transfer
 			txResponse = TransferResponse::BadResponse;
@@ -820,12 +871,12 @@ TransferState DataTransfer::DoTransfer() noexcept
 				ExchangeResponse(TransferResponse::BadFormat);
 				break;
 			}
-			if (rxHeader.protocolVersion != SbcProtocolVersion)
+			if (rxHeader.protocolVersion < SbcMinProtocolVersion || rxHeader.protocolVersion > SbcProtocolVersion)
 			{
 				ExchangeResponse(TransferResponse::BadProtocolVersion);
 				break;
 			}
-			if (rxHeader.dataLength > SbcTransferBufferSize)
+			if (rxHeader.dataLength > (transferParametersAnnounced ? SbcMaxTransferBufferSize : SbcTransferBufferSize))
 			{
 				ExchangeResponse(TransferResponse::BadDataLength);
 				break;
@@ -848,9 +899,7 @@ TransferState DataTransfer::DoTransfer() noexcept
 				else
 				{
 					// Everything OK
-					rxPointer = txPointer = 0;
-					packetId = 0;
-					state = InternalTransferState::ProcessingData;
+					TransferFinished();
 					return IsConnectionReset() ? TransferState::connectionReset : TransferState::finished;
 				}
 			}
@@ -898,9 +947,7 @@ TransferState DataTransfer::DoTransfer() noexcept
 			if (rxResponse == TransferResponse::Success && txResponse == TransferResponse::Success)
 			{
 				// Everything OK
-				rxPointer = txPointer = 0;
-				packetId = 0;
-				state = InternalTransferState::ProcessingData;
+				TransferFinished();
 				return IsConnectionReset() ? TransferState::connectionReset : TransferState::finished;
 			}
 
@@ -962,9 +1009,53 @@ TransferState DataTransfer::DoTransfer() noexcept
 	return (state == InternalTransferState::ExchangingHeader) ? TransferState::doingFullTransfer : TransferState::doingPartialTransfer;
 }
 
+// Called when a transfer has completed successfully. Make the received data available for processing.
+void DataTransfer::TransferFinished() noexcept
+{
+	if (remoteProtocolVersion != rxHeader.protocolVersion)
+	{
+		// The SBC has been restarted or replaced, so we need to negotiate the transfer parameters again. Talk to it in the older of our two protocol versions
+		remoteProtocolVersion = rxHeader.protocolVersion;
+		txHeader.protocolVersion = min<uint16_t>(remoteProtocolVersion, SbcProtocolVersion);
+		ResetTransferParameters();
+	}
+	else if (transferParametersAnnounced && !transferParametersSent)
+	{
+		// Our transfer parameters were written before this transfer started, so the SBC has them now
+		transferParametersSent = true;
+		ApplyTransferParameters();
+	}
+
+	readBuffer = rxBuffer;
+	readLength = rxHeader.dataLength;
+	readNumPackets = rxHeader.numPackets;
+	rxPointer = 0;
+
+	// If transfers are pipelined then the next transfer will be received into the other buffer while we process this one
+	pipelined = (numTransferBuffers > 1);
+	if (pipelined)
+	{
+		rxIndex = (rxIndex + 1) % SbcNumTransferBuffers;
+		rxBuffer = rxBuffers[rxIndex];
+	}
+	state = InternalTransferState::ProcessingData;
+
+	++numTransfers;
+	bytesReceived += rxHeader.dataLength;
+	bytesSent += txHeader.dataLength;
+	lastTransferFinishedAt = millis();
+}
+
 void DataTransfer::StartNextTransfer() noexcept
 {
 	lastTransferNumber = rxHeader.sequenceNumber;
+	if (lastTransferFinishedAt != 0)
+	{
+		const uint32_t turnaroundTime = millis() - lastTransferFinishedAt;
+		totalTurnaroundTime += turnaroundTime;
+		maxTurnaroundTime = max<uint32_t>(maxTurnaroundTime, turnaroundTime);
+		lastTransferFinishedAt = 0;
+	}
 
 	// Reset RX transfer header
 	rxHeader.formatCode = InvalidFormatCode;
@@ -975,12 +1066,22 @@ void DataTransfer::StartNextTransfer() noexcept
 	rxHeader.crcHeader = 0;
 
 	// Set up TX transfer header
+	txBuffer = writeBuffer;
 	txHeader.numPackets = packetId;
 	txHeader.sequenceNumber++;
 	txHeader.dataLength = txPointer;
 	txHeader.crcData = CalcCRC32(txBuffer, txPointer);
 	txHeader.crcHeader = CalcCRC32(reinterpret_cast<const char *>(&txHeader), sizeof(TransferHeader) - sizeof(uint32_t));
 
+	// Start writing the next packets to the other buffer if we are allowed to pipeline transfers. Otherwise nothing may be written until this transfer is complete
+	if (numTransferBuffers > 1)
+	{
+		writeIndex = (writeIndex + 1) % SbcNumTransferBuffers;
+		writeBuffer = txBuffers[writeIndex];
+	}
+	txPointer = 0;
+	packetId = 0;
+
 	// Begin SPI transfer
 	ExchangeHeader();
 }
@@ -991,7 +1092,9 @@ void DataTransfer::ResetConnection(bool fullReset) noexcept
 	disable_spi();
 	dataReceived = false;
 	rxPointer = txPointer = 0;
+	readLength = readNumPackets = 0;
 	packetId = 0;
+	lastTransferFinishedAt = 0;
 
 	// Reset the TfrRdy pin level and the seq numbers only if no communication is taking place
 	if (fullReset)
@@ -1000,10 +1103,24 @@ void DataTransfer::ResetConnection(bool fullReset) noexcept
 		lastTransferNumber = rxHeader.sequenceNumber = txHeader.sequenceNumber = 0;
 	}
 
+	// DSF may have been restarted, so fall back to the transfer parameters of protocol version 6 until they have been negotiated again
+	remoteProtocolVersion = 0;
+	txHeader.protocolVersion = SbcProtocolVersion;
+	ResetTransferParameters();
+
 	// Kick off a new transfer
 	StartNextTransfer();
 }
 
+void DataTransfer::ResetTransferParameters() noexcept
+{
+	transferBufferSize = SbcTransferBufferSize;
+	numTransferBuffers = 1;
+	sbcTransferBufferSize = SbcTransferBufferSize;
+	sbcNumTransferBuffers = 1;
+	transferParametersAnnounced = transferParametersSent = sbcTransferParametersReceived = false;
+}
+
 bool DataTransfer::WriteObjectModel(OutputBuffer *data) noexcept
 {
 	// Try to write the packet header. This packet type cannot deal with truncated messages
@@ -1692,7 +1809,7 @@ bool DataTransfer::WriteReadFile(FileHandle handle, size_t bufferSize) noexcept
 	// Write data header
 	ReadFileHeader *header = WriteDataHeader<ReadFileHeader>();
 	header->handle = handle;
-	header->maxLength = min<uint32_t>(bufferSize, SbcTransferBufferSize - sizeof(FileDataHeader));
+	header->maxLength = min<uint32_t>(bufferSize, transferBufferSize - sizeof(FileDataHeader));
 	return true;
 }
 
@@ -1772,13 +1889,33 @@ bool DataTransfer::WriteCloseFile(FileHandle handle) noexcept
 	return true;
 }
 
+bool DataTransfer::WriteTransferParameters() noexcept
+{
+	// Check if it fits
+	if (!CanWritePacket(sizeof(TransferParametersHeader)))
+	{
+		return false;
+	}
+
+	// Write packet header
+	(void)WritePacketHeader(FirmwareRequest::TransferParameters, sizeof(TransferParametersHeader));
+
+	// Write data header. From now on the SBC may send transfers of up to the size we announce
+	TransferParametersHeader *header = WriteDataHeader<TransferParametersHeader>();
+	header->maxTransferSize = SbcMaxTransferBufferSize;
+	header->numBuffers = SbcNumTransferBuffers;
+	header->padding = 0;
+	transferParametersAnnounced = true;
+	return true;
+}
+
 PacketHeader *DataTransfer::WritePacketHeader(FirmwareRequest request, size_t dataLength, uint16_t resendPacketId) noexcept
 {
 	// Make sure to stay aligned if the last packet ended with a string
 	txPointer = AddPadding(txPointer);
 
 	// Write the next packet data
-	PacketHeader *header = reinterpret_cast<PacketHeader*>(txBuffer + txPointer);
+	PacketHeader *header = reinterpret_cast<PacketHeader*>(writeBuffer + txPointer);
 	header->request = static_cast<uint16_t>(request);
 	header->id = packetId++;
 	header->length = dataLength;
@@ -1790,13 +1927,13 @@ PacketHeader *DataTransfer::WritePacketHeader(FirmwareRequest request, size_t da
 void DataTransfer::WriteData(const char *data, size_t length) noexcept
 {
 	// Strings can be concatenated here, don't add any padding yet
-	memcpy(txBuffer + txPointer, data, length);
+	memcpy(writeBuffer + txPointer, data, length);
 	txPointer += length;
 }
 
 template<typename T> T *DataTransfer::WriteDataHeader() noexcept
 {
-	T *header = reinterpret_cast<T*>(txBuffer + txPointer);
+	T *header = reinterpret_cast<T*>(writeBuffer + txPointer);
 	txPointer += sizeof(T);
 	return header;
 }
@@ -47,6 +47,10 @@ public:
 	void StartNextTransfer() noexcept;														// Kick off the next transfer
 	void ResetConnection(bool fullReset) noexcept;											// Reset the connection after a longer timeout
 
+	bool IsPipelined() const noexcept { return pipelined; }								// True if the next transfer is to be started before the last one is processed
+	size_t GetTransferBufferSize() const noexcept { return transferBufferSize; }			// Get the maximum length of a transfer in either direction
+	bool ShouldAnnounceTransferParameters() const noexcept;
+
 	size_t PacketsToRead() const noexcept;
 	const PacketHeader *ReadPacket() noexcept;												// Attempt to read the next packet header or return null. Advances the read pointer to the next packet or the packet's data
 	const char *ReadData(size_t packetLength) noexcept;										// Read the packet data and advance to the next packet (if any)
@@ -63,6 +67,7 @@ public:
 	GCodeChannel ReadDeleteLocalVariable(const StringRef& varName) noexcept;				// Read a variable deletion request
 	FileHandle ReadOpenFileResult(FilePosition& fileLength) noexcept;						// Read the result of a file open request
 	int ReadFileData(char *buffer, size_t length) noexcept;									// Read file data from the SBC
+	void ReadTransferParameters() noexcept;													// Read the transfer parameters of the SBC
 
 	void ResendPacket(const PacketHeader *packet) noexcept;
 	bool WriteObjectModel(OutputBuffer *data) noexcept;
@@ -91,6 +96,7 @@ public:
 	bool WriteSeekFile(FileHandle handle, FilePosition offset) noexcept;
 	bool WriteTruncateFile(FileHandle handle) noexcept;
 	bool WriteCloseFile(FileHandle handle) noexcept;
+	bool WriteTransferParameters() noexcept;
 
 private:
 	enum class InternalTransferState
@@ -107,7 +113,20 @@ private:
 
 	// Transfer properties
 	uint16_t lastTransferNumber;
+	uint16_t remoteProtocolVersion;
 	unsigned int failedTransfers, checksumErrors;
+	size_t transferBufferSize;						// negotiated maximum transfer length
+	size_t numTransferBuffers;						// negotiated number of transfer buffers, 1 if transfers are not pipelined
+	size_t sbcTransferBufferSize;					// maximum transfer length announced by the SBC
+	size_t sbcNumTransferBuffers;					// number of transfer buffers announced by the SBC
+	bool transferParametersAnnounced;				// whether we have written our transfer parameters
+	bool transferParametersSent;					// whether a completed transfer has delivered our transfer parameters to the SBC
+	bool sbcTransferParametersReceived;
+	bool pipelined;									// whether the last transfer was done in pipelined mode
+
+	// Statistics for M122
+	uint32_t numTransfers, bytesReceived, bytesSent;
+	uint32_t lastTransferFinishedAt, totalTurnaroundTime, maxTurnaroundTime;
 
 	// Transfer buffers
 #if SAME70
@@ -118,8 +137,8 @@ private:
 	static __nocache TransferHeader txHeader;
 	static __nocache uint32_t rxResponse;
 	static __nocache uint32_t txResponse;
-	alignas(4) static __nocache char rxBuffer[SbcTransferBufferSize];
-	alignas(4) static __nocache char txBuffer[SbcTransferBufferSize];
+	alignas(4) static __nocache char rxBuffers[SbcNumTransferBuffers][SbcMaxTransferBufferSize];
+	alignas(4) static __nocache char txBuffers[SbcNumTransferBuffers][SbcMaxTransferBufferSize];
 #else
 	// The other processors we support have write-through cache
 	// Allocate the buffers in the object so that we can delete the object and recycle the memory if the SBC interface is not being used
@@ -128,9 +147,17 @@ private:
 	alignas(16) TransferHeader txHeader;
 	uint32_t rxResponse;
 	uint32_t txResponse;
-	char *rxBuffer;				// not allocated until we know we need it
-	char *txBuffer;				// not allocated until we know we need it
+	char *rxBuffers[SbcNumTransferBuffers];		// not allocated until we know we need them
+	char *txBuffers[SbcNumTransferBuffers];		// not allocated until we know we need them
 #endif
+
+	// The SPI transfer uses rxBuffer and txBuffer. We process the packets in readBuffer and write new packets to writeBuffer.
+	// Unless transfers are pipelined, these are the same pairs of buffers.
+	char *rxBuffer, *txBuffer;
+	const char *readBuffer;
+	char *writeBuffer;
+	size_t rxIndex, writeIndex;
+	size_t readLength, readNumPackets;
 	size_t rxPointer, txPointer;
 
 	// Packet properties
@@ -142,12 +169,15 @@ private:
 	void ExchangeResponse(uint32_t response) noexcept;
 	void ExchangeData() noexcept;
 	void RestartTransfer(bool ownRequest) noexcept;
+	void TransferFinished() noexcept;
+	void ResetTransferParameters() noexcept;
+	void ApplyTransferParameters() noexcept;
 	uint32_t CalcCRC32(const char *buffer, size_t length) const noexcept;
 
 	template<typename T> const T *ReadDataHeader() noexcept;
 
 	// Always keep enough tx space to allow resend requests in case RRF runs out of resources and cannot process an incoming request right away
-	size_t FreeTxSpace() const noexcept { return SbcTransferBufferSize - AddPadding(txPointer) - rxHeader.numPackets * sizeof(PacketHeader); }
+	size_t FreeTxSpace() const noexcept { return transferBufferSize - AddPadding(txPointer) - readNumPackets * sizeof(PacketHeader); }
 
 	bool CanWritePacket(size_t dataLength = 0) const noexcept;
 	PacketHeader *WritePacketHeader(FirmwareRequest request, size_t dataLength = 0, uint16_t resendPacktId = 0) noexcept;
@@ -163,9 +193,14 @@ inline bool DataTransfer::IsConnectionReset() const noexcept
 	return (rxHeader.formatCode == SbcFormatCode) && (rxHeader.sequenceNumber != nextTransferNumber);
 }
 
+inline bool DataTransfer::ShouldAnnounceTransferParameters() const noexcept
+{
+	return remoteProtocolVersion >= 7 && !transferParametersAnnounced;
+}
+
 inline size_t DataTransfer::PacketsToRead() const noexcept
 {
-	return rxHeader.numPackets;
+	return readNumPackets;
 }
 
 inline void DataTransfer::ResendPacket(const PacketHeader *packet) noexcept
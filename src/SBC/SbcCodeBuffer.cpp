@@ -0,0 +1,149 @@
+/*
+ * SbcCodeBuffer.cpp
+ *
+ *  Created on: 19 Oct 2026
+ */
+
+#include "SbcCodeBuffer.h"
+
+#if HAS_SBC_INTERFACE
+
+void SbcCodeBuffer::Init() noexcept
+{
+	buffer = (char *)new uint32_t[(SpiCodeBufferSize + 3)/4];
+	Reset();
+}
+
+// Discard all buffered codes and put all the segments in the free list
+void SbcCodeBuffer::Reset() noexcept
+{
+	for (size_t i = 0; i < NumSegments; ++i)
+	{
+		nextSegment[i] = (i + 1 < NumSegments) ? i + 1 : NoSegment;
+		segmentReadOffset[i] = segmentWriteOffset[i] = 0;
+	}
+	firstFreeSegment = 0;
+	numFreeSegments = NumSegments;
+
+	for (size_t i = 0; i < NumGCodeChannels; ++i)
+	{
+		firstSegment[i] = lastSegment[i] = NoSegment;
+		numChannelSegments[i] = 0;
+	}
+}
+
+// Store a code or code block at the end of the buffered codes of its channel, returning false if there is no space for it
+bool SbcCodeBuffer::Store(size_t chan, const char *code, uint16_t length, bool isBlock) noexcept
+{
+	const size_t bufferedCodeSize = sizeof(BufferedCodeHeader) + length;
+	if (bufferedCodeSize > SpiCodeSegmentSize)
+	{
+		return false;
+	}
+
+	uint8_t segment = lastSegment[chan];
+	if (segment == NoSegment || segmentWriteOffset[segment] + bufferedCodeSize > SpiCodeSegmentSize)
+	{
+		// The code doesn't fit in the last segment of this channel, so append a free one
+		if (firstFreeSegment == NoSegment)
+		{
+			return false;
+		}
+
+		const uint8_t newSegment = firstFreeSegment;
+		firstFreeSegment = nextSegment[newSegment];
+		--numFreeSegments;
+
+		nextSegment[newSegment] = NoSegment;
+		segmentReadOffset[newSegment] = segmentWriteOffset[newSegment] = 0;
+		if (segment == NoSegment)
+		{
+			firstSegment[chan] = newSegment;
+		}
+		else
+		{
+			nextSegment[segment] = newSegment;
+		}
+		lastSegment[chan] = segment = newSegment;
+		++numChannelSegments[chan];
+	}
+
+	// Store the buffer header
+	char * const dst = buffer + segment * SpiCodeSegmentSize + segmentWriteOffset[segment];
+	BufferedCodeHeader * const bufHeader = reinterpret_cast<BufferedCodeHeader *>(dst);
+	bufHeader->isPending = true;
+	bufHeader->blockIndex = (isBlock) ? 0 : NotACodeBlock;
+	bufHeader->length = length;
+
+	// Store the corresponding code. Binary codes are always aligned on a 4-byte boundary
+	memcpyu32(reinterpret_cast<uint32_t *>(dst + sizeof(BufferedCodeHeader)), reinterpret_cast<const uint32_t *>(code), length / sizeof(uint32_t));
+	segmentWriteOffset[segment] += bufferedCodeSize;
+	return true;
+}
+
+// Get the header of the next code of a channel, which is followed by the code itself
+BufferedCodeHeader *_ecv_null SbcCodeBuffer::GetFirst(size_t chan) const noexcept
+{
+	const uint8_t segment = firstSegment[chan];
+	return (segment == NoSegment) ? nullptr : reinterpret_cast<BufferedCodeHeader*>(buffer + segment * SpiCodeSegmentSize + segmentReadOffset[segment]);
+}
+
+// Move on to the next code of a channel and free the segment if we have processed all the codes in it. Return true if we freed a segment.
+bool SbcCodeBuffer::RemoveFirst(size_t chan) noexcept
+{
+	const uint8_t segment = firstSegment[chan];
+	const BufferedCodeHeader * const bufHeader = reinterpret_cast<const BufferedCodeHeader*>(buffer + segment * SpiCodeSegmentSize + segmentReadOffset[segment]);
+	segmentReadOffset[segment] += sizeof(BufferedCodeHeader) + bufHeader->length;
+	if (segmentReadOffset[segment] != segmentWriteOffset[segment])
+	{
+		return false;
+	}
+
+	firstSegment[chan] = nextSegment[segment];
+	if (firstSegment[chan] == NoSegment)
+	{
+		lastSegment[chan] = NoSegment;
+	}
+	--numChannelSegments[chan];
+
+	nextSegment[segment] = firstFreeSegment;
+	firstFreeSegment = segment;
+	++numFreeSegments;
+	return true;
+}
+
+// Discard all the buffered codes of a channel by moving its segments to the free list. Return true if it had any.
+bool SbcCodeBuffer::Discard(size_t chan) noexcept
+{
+	if (firstSegment[chan] == NoSegment)
+	{
+		return false;
+	}
+
+	nextSegment[lastSegment[chan]] = firstFreeSegment;
+	firstFreeSegment = firstSegment[chan];
+	numFreeSegments += numChannelSegments[chan];
+
+	firstSegment[chan] = lastSegment[chan] = NoSegment;
+	numChannelSegments[chan] = 0;
+	return true;
+}
+
+// Get the buffer space to report to the SBC. A code fits if it is no longer than this, unless it has to go in a partly-filled segment
+// of another channel than the one with the most space left. If a code doesn't fit after all then we ask the SBC to send it again later.
+uint16_t SbcCodeBuffer::GetSpace() const noexcept
+{
+	size_t tailSpace = 0;
+	for (size_t i = 0; i < NumGCodeChannels; ++i)
+	{
+		if (lastSegment[i] != NoSegment)
+		{
+			tailSpace = max<size_t>(tailSpace, SpiCodeSegmentSize - segmentWriteOffset[lastSegment[i]]);
+		}
+	}
+	return (numFreeSegments != 0) ? numFreeSegments * SpiCodeSegmentSize : tailSpace;
+}
+
+#endif
+
+// End
@@ -0,0 +1,50 @@
+/*
+ * SbcCodeBuffer.h
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * Storage for the codes that the SBC has sent us but we haven't processed yet.
+ * The buffer is divided into segments. Each channel has a list of segments holding its codes in the order in which they are to be processed, so codes
+ * never need to be moved and we can discard all the codes of a channel by returning its segments to the free list.
+ * This class doesn't lock anything; SbcInterface protects it by suspending the task scheduler.
+ */
+
+#ifndef SRC_SBC_SBCCODEBUFFER_H_
+#define SRC_SBC_SBCCODEBUFFER_H_
+
+#include <RepRapFirmware.h>
+
+#if HAS_SBC_INTERFACE
+
+#include "GCodes/GCodeChannel.h"
+#include "SbcMessageFormats.h"
+
+class SbcCodeBuffer
+{
+public:
+	static constexpr size_t NumSegments = SpiCodeBufferSize/SpiCodeSegmentSize;
+
+	SbcCodeBuffer() noexcept : buffer(nullptr) { }
+
+	void Init() noexcept;																	// allocate the buffer and make all of it free
+	void Reset() noexcept;																	// discard all the codes
+	bool Store(size_t chan, const char *code, uint16_t length, bool isBlock) noexcept;		// store a code at the end of the codes of a channel, returning false if there is no space
+	BufferedCodeHeader *_ecv_null GetFirst(size_t chan) const noexcept;						// get the next code of a channel, or nullptr if it has none
+	bool RemoveFirst(size_t chan) noexcept;													// remove the next code of a channel, returning true if this freed a segment
+	bool Discard(size_t chan) noexcept;														// discard all the codes of a channel, returning true if it had any
+	uint16_t GetSpace() const noexcept;														// get the space to report to the SBC
+	unsigned int GetNumFreeSegments() const noexcept { return numFreeSegments; }
+
+private:
+	static constexpr uint8_t NoSegment = 0xFF;
+
+	char *buffer;
+	uint16_t segmentReadOffset[NumSegments], segmentWriteOffset[NumSegments];
+	uint8_t nextSegment[NumSegments];
+	uint8_t firstSegment[NumGCodeChannels], lastSegment[NumGCodeChannels], numChannelSegments[NumGCodeChannels];
+	uint8_t firstFreeSegment, numFreeSegments;
+};
+
+#endif
+
+#endif /* SRC_SBC_SBCCODEBUFFER_H_ */
@@ -53,7 +53,7 @@ extern "C" [[noreturn]] void SBCTaskStart(void * pvParameters) noexcept
 SbcInterface::SbcInterface() noexcept : isConnected(false), numDisconnects(0), numTimeouts(0), numSbcTimeouts(0), lastTransferTime(0),
 	maxDelayBetweenTransfers(SpiTransferDelay), maxFileOpenDelay(SpiFileOpenDelay), numMaxEvents(SpiEventsRequired),
 	delaying(false), numEvents(0), reportPause(false), reportPauseWritten(false), printAborted(false),
-	codeBuffer(nullptr), rxPointer(0), txPointer(0), txEnd(0), sendBufferUpdate(true), waitingForFileChunk(false),
+	sendBufferUpdate(true), waitingForFileChunk(false),
 	fileMutex(), numOpenFiles(0), fileSemaphore(), fileOperation(FileOperation::none), fileOperationPending(false)
 #ifdef TRACK_FILE_CODES
 	, fileCodesRead(0), fileCodesHandled(0), fileMacrosRunning(0), fileMacrosClosing(0)
@@ -67,7 +67,7 @@ void SbcInterface::Init() noexcept
 	{
 		fileMutex.Create("SBCFile");
 		gcodeReplyMutex.Create("SBCReply");
-		codeBuffer = (char *)new uint32_t[(SpiCodeBufferSize + 3)/4];
+		codeBuffer.Init();
 		transfer.Init();
 		sbcTask = new Task<SBCTaskStackWords>();
 		sbcTask->Create(SBCTaskStart, "SBC", nullptr, TaskPriority::SbcPriority);
@@ -174,9 +174,18 @@ void SbcInterface::Spin() noexcept
 				reprap.GetPlatform().Message(NetworkInfoMessage, "Connection to SBC established!\n");
 			}
 
-			// Handle exchanged data and kick off the next transfer
-			ExchangeData();
-			transfer.StartNextTransfer();
+			// Handle exchanged data and kick off the next transfer. If transfers are pipelined then we start the next one first,
+			// so that the SBC can exchange it while we are processing the data we just received
+			if (transfer.IsPipelined())
+			{
+				transfer.StartNextTransfer();
+				ExchangeData();
+			}
+			else
+			{
+				ExchangeData();
+				transfer.StartNextTransfer();
+			}
 		}
 		else if (hadTimeout || hadReset)
 		{
@@ -188,6 +197,12 @@ void SbcInterface::Spin() noexcept
 
 void SbcInterface::ExchangeData() noexcept
 {
+	// Tell the SBC how large our transfers may be if it supports that
+	if (transfer.ShouldAnnounceTransferParameters())
+	{
+		(void)transfer.WriteTransferParameters();
+	}
+
 	// Process incoming packets
 	bool codeBufferAvailable = true;
 	for (size_t i = 0; i < transfer.PacketsToRead(); i++)
@@ -222,8 +237,9 @@ void SbcInterface::ExchangeData() noexcept
 			SoftwareReset(SoftwareResetReason::userFromSbc);
 			break;
 
-		// Perform a G/M/T-code
+		// Perform a G/M/T-code or a block of similar codes
 		case SbcRequest::Code:
+		case SbcRequest::CodeBlock:
 		{
 			// Read the next code
 			if (packet->length == 0)
@@ -232,8 +248,14 @@ void SbcInterface::ExchangeData() noexcept
 				break;
 			}
 
+			const bool isBlock = (packet->request == (uint16_t)SbcRequest::CodeBlock);
 			const CodeHeader *code = reinterpret_cast<const CodeHeader*>(transfer.ReadData(packet->length));
-			const GCodeChannel channel(code->channel);
+			if (isBlock && !BinaryParser::IsValidCodeBlock(reinterpret_cast<const CodeBlockHeader*>(code), packet->length))
+			{
+				reprap.GetPlatform().Message(WarningMessage, "Received invalid code block, discarding\n");
+				break;
+			}
+			const GCodeChannel channel(code->channel);						// this works for code blocks too
 			GCodeBuffer * const gb = reprap.GetGCodes().GetGCodeBuffer(channel);
 			if (gb->IsInvalidated())
 			{
@@ -261,37 +283,11 @@ void SbcInterface::ExchangeData() noexcept
 			}
 
 			TaskCriticalSectionLocker locker;
-
-			// Make sure no existing codes are overwritten
-			uint16_t bufferedCodeSize = sizeof(BufferedCodeHeader) + packet->length;
-			if ((txEnd == 0 && bufferedCodeSize > max<uint16_t>(rxPointer, SpiCodeBufferSize - txPointer)) ||
-				(txEnd != 0 && bufferedCodeSize > rxPointer - txPointer))
+			if (!codeBuffer.Store(channel.ToBaseType(), reinterpret_cast<const char *>(code), packet->length, isBlock))
 			{
-#if false
-				// This isn't enabled because the debug call plus critical section would lead to software resets
-				debugPrintf("Failed to store code, RX/TX %d/%d-%d\n", rxPointer, txPointer, txEnd);
-#endif
 				packetAcknowledged = codeBufferAvailable = false;
 				break;
 			}
-
-			// Overlap if necessary
-			if (txPointer + bufferedCodeSize > SpiCodeBufferSize)
-			{
-				txEnd = txPointer;
-				txPointer = 0;
-			}
-
-			// Store the buffer header
-			BufferedCodeHeader *bufHeader = reinterpret_cast<BufferedCodeHeader *>(codeBuffer + txPointer);
-			bufHeader->isPending = true;
-			bufHeader->length = packet->length;
-
-			// Store the corresponding code. Binary codes are always aligned on a 4-byte boundary
-			uint32_t *dst = reinterpret_cast<uint32_t *>(codeBuffer + txPointer + sizeof(BufferedCodeHeader));
-			const uint32_t *src = reinterpret_cast<const uint32_t *>(code);
-			memcpyu32(dst, src, packet->length / sizeof(uint32_t));
-			txPointer += bufferedCodeSize;
 			sendBufferUpdate = true;
 			break;
 		}
@@ -306,7 +302,7 @@ void SbcInterface::ExchangeData() noexcept
 			try
 			{
 				OutputBuffer *outBuf = reprap.GetModelResponse(nullptr, key.c_str(), flags.c_str());
-				if (outBuf != nullptr && outBuf->Length() > SbcTransferBufferSize - sizeof(PacketHeader) - sizeof(StringHeader))
+				if (outBuf != nullptr && outBuf->Length() > transfer.GetTransferBufferSize() - sizeof(PacketHeader) - sizeof(StringHeader))
 				{
 					if (!transfer.WriteObjectModel(nullptr))
 					{
@@ -953,6 +949,11 @@ void SbcInterface::ExchangeData() noexcept
 			}
 			break;
 
+		// Transfer parameters of the SBC
+		case SbcRequest::TransferParameters:
+			transfer.ReadTransferParameters();
+			break;
+
 		// Invalid request
 		default:
 #ifdef DEBUG
@@ -969,8 +970,9 @@ void SbcInterface::ExchangeData() noexcept
 		}
 	}
 
-	// Check if we can wait a short moment to reduce CPU load on the SBC
-	if (!skipNextDelay && numEvents < numMaxEvents && !waitingForFileChunk &&
+	// Check if we can wait a short moment to reduce CPU load on the SBC. We don't do this if transfers are pipelined,
+	// because the next transfer is already under way and the SBC decides when to perform it
+	if (!transfer.IsPipelined() && !skipNextDelay && numEvents < numMaxEvents && !waitingForFileChunk &&
 		!fileOperationPending && fileOperation == FileOperation::none)
 	{
 		delaying = true;
@@ -999,13 +1001,11 @@ void SbcInterface::ExchangeData() noexcept
 	}
 
 	// Notify DSF about the available buffer space
-	DefragmentBufferedCodes();
 	{
 		TaskCriticalSectionLocker locker;
 		if (!codeBufferAvailable || sendBufferUpdate)
 		{
-			const uint16_t bufferSpace = (txEnd == 0) ? max<uint16_t>(rxPointer, SpiCodeBufferSize - txPointer) : rxPointer - txPointer;
-			sendBufferUpdate = !transfer.WriteCodeBufferUpdate(bufferSpace);
+			sendBufferUpdate = !transfer.WriteCodeBufferUpdate(codeBuffer.GetSpace());
 		}
 	}
 
@@ -1258,7 +1258,7 @@ void SbcInterface::ExchangeData() noexcept
 
 void SbcInterface::InvalidateResources() noexcept
 {
-	rxPointer = txPointer = txEnd = 0;
+	ResetBufferedCodes();
 	sendBufferUpdate = true;
 
 	if (!requestedFileName.IsEmpty())
@@ -1312,7 +1312,7 @@ void SbcInterface::Diagnostics(MessageType mtype) noexcept
 	reprap.GetPlatform().Message(mtype, "=== SBC interface ===\n");
 	transfer.Diagnostics(mtype);
 	reprap.GetPlatform().MessageF(mtype, "State: %d, disconnects: %" PRIu32 ", timeouts: %" PRIu32 " total, %" PRIu32 " by SBC, IAP RAM available 0x%05" PRIx32 "\n", (int)state, numDisconnects, numTimeouts, numSbcTimeouts, iapRamAvailable);
-	reprap.GetPlatform().MessageF(mtype, "Buffer RX/TX: %d/%d-%d, open files: %u\n", (int)rxPointer, (int)txPointer, (int)txEnd, numOpenFiles);
+	reprap.GetPlatform().MessageF(mtype, "Code buffer segments free: %u of %u, open files: %u\n", codeBuffer.GetNumFreeSegments(), SbcCodeBuffer::NumSegments, numOpenFiles);
 #ifdef TRACK_FILE_CODES
 	reprap.GetPlatform().MessageF(mtype, "File codes read/handled: %d/%d, file macros open/closing: %d %d\n", (int)fileCodesRead, (int)fileCodesHandled, (int)fileMacrosRunning, (int)fileMacrosClosing);
 #endif
@@ -1371,92 +1371,59 @@ bool SbcInterface::FillBuffer(GCodeBuffer &gb) noexcept
 
 	bool gotCommand = false;
 	{
-		//TODO can we take the lock inside the loop body instead, if we re-read readPointer and writePointer after taking it?
 		TaskCriticalSectionLocker locker;
-		if (rxPointer != txPointer || txEnd != 0)
+		const size_t chan = gb.GetChannel().ToBaseType();
+		BufferedCodeHeader * const bufHeader = codeBuffer.GetFirst(chan);
+		if (bufHeader != nullptr)
 		{
-			bool updateRxPointer = true;
-			uint16_t readPointer = rxPointer;
-			do
-			{
-				BufferedCodeHeader *bufHeader = reinterpret_cast<BufferedCodeHeader*>(codeBuffer + readPointer);
-				readPointer += sizeof(BufferedCodeHeader);
-				const CodeHeader *codeHeader = reinterpret_cast<const CodeHeader*>(codeBuffer + readPointer);
-				readPointer += bufHeader->length;
-
-				RRF_ASSERT(bufHeader->length > 0);
-				RRF_ASSERT(readPointer <= SpiCodeBufferSize);
+			char * const codeData = reinterpret_cast<char *>(bufHeader) + sizeof(BufferedCodeHeader);
+			RRF_ASSERT(bufHeader->length > 0);
 
-				if (bufHeader->isPending)
+#ifdef TRACK_FILE_CODES
+			if (gb.IsFileChannel() && gb.GetCommandLetter() != 'Q')
+			{
+				fileMacrosRunning -= fileMacrosClosing;
+				fileMacrosClosing = 0;
+				if (fileCodesRead > fileCodesHandled + fileMacrosRunning)
 				{
-					if (gb.GetChannel().RawValue() == codeHeader->channel)
+					// Note that we cannot use MessageF here because the task scheduler is suspended
+					OutputBuffer *buf;
+					if (OutputBuffer::Allocate(buf))
 					{
-#ifdef TRACK_FILE_CODES
-						if (gb.IsFileChannel() && gb.GetCommandLetter() != 'Q')
-						{
-							fileMacrosRunning -= fileMacrosClosing;
-							fileMacrosClosing = 0;
-							if (fileCodesRead > fileCodesHandled + fileMacrosRunning)
-							{
-								// Note that we cannot use MessageF here because the task scheduler is suspended
-								OutputBuffer *buf;
-								if (OutputBuffer::Allocate(buf))
-								{
-									String<SHORT_GCODE_LENGTH> codeString;
-									gb.PrintCommand(codeString.GetRef());
-									buf->printf("Code %s did not return a code result, delta %d, running macros %d\n", codeString.c_str(), fileCodesRead - fileCodesHandled - fileMacrosRunning, fileMacrosRunning);
-									gcodeReply.Push(buf, WarningMessage);
-								}
-								fileCodesRead = fileCodesHandled - fileMacrosRunning;
-							}
-							fileCodesRead++;
-						}
-#endif
-
-						// Process the next binary G-code
-						gb.PutBinary(reinterpret_cast<const uint32_t *>(codeHeader), bufHeader->length / sizeof(uint32_t));
-						bufHeader->isPending = false;
-
-						// Check if we can reset the ring buffer pointers
-						if (updateRxPointer)
-						{
-							sendBufferUpdate = true;
-							if (readPointer == txPointer && txEnd == 0)
-							{
-								// Buffer completely read, reset RX/TX pointers
-								rxPointer = txPointer = 0;
-							}
-							else if (readPointer == txEnd)
-							{
-								// Read last code before overlapping, restart from the beginning
-								rxPointer = txEnd = 0;
-							}
-							else
-							{
-								// Code has been read, move on to the next one
-								rxPointer = readPointer;
-							}
-						}
-
-						gotCommand = true;
-						break;
+						String<SHORT_GCODE_LENGTH> codeString;
+						gb.PrintCommand(codeString.GetRef());
+						buf->printf("Code %s did not return a code result, delta %d, running macros %d\n", codeString.c_str(), fileCodesRead - fileCodesHandled - fileMacrosRunning, fileMacrosRunning);
+						gcodeReply.Push(buf, WarningMessage);
 					}
-					updateRxPointer = false;
+					fileCodesRead = fileCodesHandled - fileMacrosRunning;
 				}
+				fileCodesRead++;
+			}
+#endif
 
-				if (readPointer == txEnd)
-				{
-					if (updateRxPointer)
-					{
-						// Skipped non-pending codes, restart from the beginning
-						rxPointer = txEnd = 0;
-						sendBufferUpdate = true;
-					}
+			// Process the next binary G-code. A code block stays pending until we have processed all the codes in it
+			if (bufHeader->blockIndex == NotACodeBlock)
+			{
+				gb.PutBinary(reinterpret_cast<const uint32_t *>(codeData), bufHeader->length / sizeof(uint32_t));
+				bufHeader->isPending = false;
+			}
+			else
+			{
+				CodeBlockHeader * const block = reinterpret_cast<CodeBlockHeader*>(codeData);
+				gb.PutBinaryFromBlock(block, bufHeader->blockIndex);
+				++bufHeader->blockIndex;
+				bufHeader->isPending = (bufHeader->blockIndex < block->numCodes);
+			}
 
-					// About to overlap, continue from the start
-					readPointer = 0;
+			if (!bufHeader->isPending)
+			{
+				// Move on to the next code. If this frees a segment then tell the SBC that there is more space.
+				if (codeBuffer.RemoveFirst(chan))
+				{
+					sendBufferUpdate = true;
 				}
-			} while (readPointer != txPointer);
+			}
+			gotCommand = true;
 		}
 	}
 
@@ -1822,139 +1789,20 @@ void SbcInterface::EventOccurred(bool timeCritical) noexcept
 	}
 }
 
-void SbcInterface::DefragmentBufferedCodes() noexcept
+// Discard all buffered codes
+void SbcInterface::ResetBufferedCodes() noexcept
 {
 	TaskCriticalSectionLocker locker;
-	if (rxPointer != txPointer || txEnd != 0)
-	{
-		const uint16_t bufferSpace = (txEnd == 0) ? max<uint16_t>(rxPointer, SpiCodeBufferSize - txPointer) : rxPointer - txPointer;
-		if (bufferSpace > MaxCodeBufferSize)
-		{
-			// There is still enough space left for at least one more code, don't worry about fragmentation yet
-			return;
-		}
-
-		if (txEnd == 0)
-		{
-			// Ring buffer data is sequential (rxPointer..txPointer, txEnd=0)
-			(void)DefragmentCodeBlock(rxPointer, txPointer);
-		}
-		else
-		{
-			// Ring buffer overlapped (rxPointer..txEnd, 0..txPointer)
-			if (!DefragmentCodeBlock(rxPointer, txEnd) &&
-				!DefragmentCodeBlock(0, txPointer) &&
-				SpiCodeBufferSize - (size_t)txEnd > MaxCodeBufferSize)
-			{
-				size_t endBufferSize = txEnd - rxPointer;
-				memmoveu32(reinterpret_cast<uint32_t*>(codeBuffer + SpiCodeBufferSize - endBufferSize), reinterpret_cast<uint32_t*>(codeBuffer + rxPointer), endBufferSize / sizeof(uint32_t));
-				rxPointer = SpiCodeBufferSize - endBufferSize;
-				txEnd = SpiCodeBufferSize;
-				sendBufferUpdate = true;
-			}
-		}
-	}
-}
-
-// Defragment a specific block of the code buffer and update the end of it
-bool SbcInterface::DefragmentCodeBlock(uint16_t start, volatile uint16_t &end) noexcept
-{
-	char *gapStart = nullptr;
-	for (uint16_t readPointer = start; readPointer != end;)
-	{
-		BufferedCodeHeader *bufHeader = reinterpret_cast<BufferedCodeHeader *>(codeBuffer + readPointer);
-		size_t bufSize = sizeof(BufferedCodeHeader) + bufHeader->length;
-		readPointer += bufSize;
-
-		if (bufHeader->isPending)
-		{
-			if (gapStart != nullptr)
-			{
-				size_t gapSize = reinterpret_cast<const char *>(bufHeader) - gapStart;
-				if (gapSize >= bufSize)
-				{
-					// Gap size is big enough to accommodate the next code
-					memcpyu32(reinterpret_cast<uint32_t*>(gapStart), reinterpret_cast<uint32_t *>(bufHeader), bufSize / sizeof(uint32_t));		// requires incrementing copy order
-					gapStart += bufSize;
-				}
-				else
-				{
-					// Gap size is too small. Move the remaining buffer but only once per run
-					memcpyu32(reinterpret_cast<uint32_t*>(gapStart), reinterpret_cast<uint32_t *>(bufHeader), (codeBuffer + end - gapStart) / sizeof(uint32_t));
-					readPointer = (uint16_t)(gapStart - codeBuffer + bufSize);
-					gapStart = nullptr;
-					end -= gapSize;
-					sendBufferUpdate = true;
-					return true;
-				}
-			}
-		}
-		else if (gapStart == nullptr)
-		{
-			gapStart = reinterpret_cast<char *>(bufHeader);
-		}
-	}
-
-	if (gapStart != nullptr)
-	{
-		end = (uint16_t)(gapStart - codeBuffer);
-		sendBufferUpdate = true;
-		return true;
-	}
-	return false;
+	codeBuffer.Reset();
 }
 
+// Discard all the buffered codes of a channel by moving its segments to the free list
 void SbcInterface::InvalidateBufferedCodes(GCodeChannel channel) noexcept
 {
 	TaskCriticalSectionLocker locker;
-	if (rxPointer != txPointer || txEnd != 0)
+	if (codeBuffer.Discard(channel.ToBaseType()))
 	{
-		bool updateRxPointer = true;
-		uint16_t readPointer = rxPointer;
-		do
-		{
-			BufferedCodeHeader *bufHeader = reinterpret_cast<BufferedCodeHeader *>(codeBuffer + readPointer);
-			if (bufHeader->isPending)
-			{
-				const CodeHeader *codeHeader = reinterpret_cast<const CodeHeader*>(codeBuffer + readPointer + sizeof(BufferedCodeHeader));
-				if (codeHeader->channel == channel.RawValue())
-				{
-					bufHeader->isPending = false;
-				}
-				else
-				{
-					updateRxPointer = false;
-				}
-			}
-			readPointer += sizeof(BufferedCodeHeader) + bufHeader->length;
-
-			if (updateRxPointer)
-			{
-				sendBufferUpdate = true;
-				if (readPointer == txPointer && txEnd == 0)
-				{
-					// Buffer is empty again, reset the pointers
-					rxPointer = txPointer = 0;
-					break;
-				}
-				else if (readPointer == txEnd)
-				{
-					// Invalidated last code before overlapping, continue from the beginning
-					readPointer = 0;
-					rxPointer = txEnd = 0;
-				}
-				else
-				{
-					// Invalidated next code
-					rxPointer = readPointer;
-				}
-			}
-			else if (readPointer == txEnd)
-			{
-				// About to overlap, continue from the start
-				readPointer = 0;
-			}
-		} while (readPointer != txPointer);
+		sendBufferUpdate = true;
 	}
 }
 
@@ -18,6 +18,7 @@
 #include "GCodes/GCodeChannel.h"
 #include "GCodes/GCodeFileInfo.h"
 #include "SbcMessageFormats.h"
+#include "SbcCodeBuffer.h"
 #include "DataTransfer.h"
 
 class Platform;
@@ -87,8 +88,7 @@ private:
 	PrintPausedReason pauseReason;
 	bool reportPause, reportPauseWritten, printAborted;
 
-	char *codeBuffer;
-	volatile uint16_t rxPointer, txPointer, txEnd;
+	SbcCodeBuffer codeBuffer;											// protected by suspending the task scheduler
 	volatile bool sendBufferUpdate;
 
 	uint32_t iapRamAvailable;											// must be at least 32Kb otherwise the SPI IAP can't work
@@ -145,9 +145,8 @@ private:
 	void ExchangeData() noexcept;											// Exchange data between RRF and the SBC
 	[[noreturn]] void ReceiveAndStartIap(const char *iapChunk, size_t length) noexcept;	// Receive and start the IAP binary
 	void InvalidateResources() noexcept;									// Invalidate local resources on connection errors
-	void DefragmentBufferedCodes() noexcept;								// Attempt to defragment the code buffer ring to avoid stalls
-	bool DefragmentCodeBlock(uint16_t start, volatile uint16_t &end) noexcept;	// Defragment a specific code buffer region returning true if anything was defragmented
-	void InvalidateBufferedCodes(GCodeChannel channel) noexcept;           	// Invalidate every buffered G-code of the corresponding channel from the buffer ring
+	void ResetBufferedCodes() noexcept;										// Discard all buffered codes
+	void InvalidateBufferedCodes(GCodeChannel channel) noexcept;           	// Invalidate every buffered G-code of the corresponding channel
 	bool DoFileOperation(FileOperation f) noexcept;							// Ask the SBC task to do a file operation
 };
 
@@ -21,11 +21,32 @@ constexpr uint8_t SbcFormatCode = 0x5F;				// standard format code for RRF SPI p
 constexpr uint8_t SbcFormatCodeStandalone = 0x60;	// used to indicate that RRF is running in stand-alone mode
 constexpr uint8_t InvalidFormatCode = 0xC9;			// must be different from any other format code
 
-constexpr uint16_t SbcProtocolVersion = 6;
-
-constexpr size_t SbcTransferBufferSize = 8192;		// maximum length of a data transfer. Must be a multiple of 4 and kept in sync with Duet Control Server!
+constexpr uint16_t SbcProtocolVersion = 7;
+constexpr uint16_t SbcMinProtocolVersion = 6;		// oldest protocol version we still talk to
+
+// Protocol version 7 adds the TransferParameters requests. Once each side has received the parameters of the other, each transfer may be as long as the
+// smaller of the two maximum transfer sizes. If both sides have more than one transfer buffer then transfers are pipelined: RRF starts the next
+// transfer before it processes the data of the last one, so the data it sends in a transfer is the response to the transfer before the last one.
+// This also applies to resend requests, so DSF must keep the packets of its last two transfers and number them uniquely.
+// After a connection reset both sides fall back to the limits of protocol version 6 until the parameters have been announced again.
+// RRF puts the older of the two protocol versions in its transfer headers once it knows the version of the SBC.
+// Version 7 also adds the CodeBlock request, which DSF may use to send a run of similar codes in a compact form.
+constexpr size_t SbcTransferBufferSize = 8192;		// maximum length of a data transfer until the transfer parameters have been negotiated. Must be a multiple of 4 and kept in sync with Duet Control Server!
 static_assert(SbcTransferBufferSize % sizeof(uint32_t) == 0, "SbcTransferBufferSize must be a whole number of dwords");
 
+#if SAME70
+constexpr size_t SbcMaxTransferBufferSize = 8192;	// the transfer buffers must be in non-cached memory, of which we have little
+constexpr size_t SbcNumTransferBuffers = 2;
+#elif SAME5x
+constexpr size_t SbcMaxTransferBufferSize = 12288;	// maximum length of a data transfer once the transfer parameters have been negotiated
+constexpr size_t SbcNumTransferBuffers = 2;
+#else
+constexpr size_t SbcMaxTransferBufferSize = 8192;
+constexpr size_t SbcNumTransferBuffers = 1;			// not enough RAM to pipeline transfers
+#endif
+static_assert(SbcMaxTransferBufferSize >= SbcTransferBufferSize && SbcMaxTransferBufferSize <= 65532, "SbcMaxTransferBufferSize must fit in the transfer header");
+static_assert(SbcMaxTransferBufferSize % sizeof(uint32_t) == 0, "SbcMaxTransferBufferSize must be a whole number of dwords");
+
 constexpr size_t MaxCodeBufferSize = 256;			// maximum length of a G/M/T-code in binary encoding
 static_assert(MaxCodeBufferSize % sizeof(uint32_t) == 0, "MaxCodeBufferSize must be a whole number of dwords");
 
@@ -37,7 +58,9 @@ constexpr uint32_t SpiMaxRequestTime = 3000;		// maximum time to wait a blocking
 constexpr uint32_t SpiTransferTimeout = 500;		// maximum allowed delay between data exchanges during a full transfer (in ms)
 constexpr uint32_t SpiMaxTransferTime = 50;			// maximum allowed time for a single SPI transfer
 constexpr uint32_t SpiConnectionTimeout = 4000;		// maximum time to wait for the next transfer (in ms)
-constexpr uint16_t SpiCodeBufferSize = 4096;		// number of bytes available for G-code caching
+constexpr uint16_t SpiCodeBufferSize = 8192;		// number of bytes available for G-code caching
+constexpr size_t SpiCodeSegmentSize = 512;			// the code buffer is divided into segments of this size, each holding codes of a single channel
+static_assert(SpiCodeBufferSize % SpiCodeSegmentSize == 0 && SpiCodeBufferSize/SpiCodeSegmentSize < 255, "Bad code buffer segment size");
 
 // Shared structures
 enum class DataType : uint8_t
@@ -112,6 +135,13 @@ struct TransferHeader
 	uint32_t crcHeader;
 };
 
+struct TransferParametersHeader
+{
+	uint16_t maxTransferSize;
+	uint8_t numBuffers;
+	uint8_t padding;
+};
+
 enum TransferResponse : uint32_t
 {
 	Success = 1,
@@ -226,7 +256,8 @@ enum class FirmwareRequest : uint16_t
 	SeekFile = 22,							// Seek in a file
 	TruncateFile = 23,						// Truncate a file
 	CloseFile = 24,							// Close a file again
-	DeleteFileOrDirectoryRecursively = 25	// Delete a file or directory recursively
+	DeleteFileOrDirectoryRecursively = 25,	// Delete a file or directory recursively
+	TransferParameters = 26					// Announce the maximum transfer size and number of transfer buffers (protocol version 7 and later)
 };
 
 struct PrintPausedHeader
@@ -269,8 +300,10 @@ enum class SbcRequest : uint16_t
 	FileWriteResult = 26,						// Result of a file write request
 	FileSeekResult = 27,						// Result of a file seek request
 	FileTruncateResult = 28,					// Result of a file truncate request
+	TransferParameters = 29,					// Announce the maximum transfer size and number of transfer buffers (protocol version 7 and later)
+	CodeBlock = 30,								// Request execution of a block of similar G/M/T-codes (protocol version 7 and later)
 
-	InvalidRequest = 29
+	InvalidRequest = 31
 };
 
 struct BooleanHeader
@@ -292,10 +325,15 @@ enum CodeFlags : uint8_t
 struct BufferedCodeHeader
 {
 	bool isPending;
-	uint8_t padding;
+	uint8_t blockIndex;			// if this holds a code block, the index of the next code in it to be processed
 	uint16_t length;
 };
 
+constexpr uint8_t NotACodeBlock = 0xFF;			// value of blockIndex if the buffered code is not a code block
+
+constexpr size_t MaxCodeBlockLength = SpiCodeSegmentSize - sizeof(BufferedCodeHeader);	// maximum length of a code block. Must be kept in sync with Duet Control Server!
+static_assert(MaxCodeBufferSize <= MaxCodeBlockLength, "A code buffer segment must be able to hold the longest code");
+
 struct CodeHeader
 {
 	uint8_t channel;
@@ -308,6 +346,48 @@ struct CodeHeader
 	int32_t lineNumber;
 };
 
+// A block of codes that differ only in their parameter values. The parameter values of the first code are stored in a table of
+// CodeBlockParameter entries. Each following code is described by a CodeBlockRecord followed by the difference of each parameter
+// value from that of the previous code as an int16_t, padded to a whole number of dwords.
+struct CodeBlockHeader
+{
+	uint8_t channel;			// must be the first field, as in CodeHeader
+	CodeFlags flags;
+	uint8_t numParameters;
+	char letter;
+	uint8_t numCodes;
+	uint8_t paddingA;
+	uint16_t paddingB;
+	int32_t majorCode;
+	int32_t minorCode;
+	uint32_t filePosition;		// file position and line number of the first code
+	int32_t lineNumber;
+};
+
+struct CodeBlockParameter
+{
+	char letter;
+	DataType type;				// must be Int, UInt or Float
+	uint8_t decimals;			// Float values are sent as fixed point numbers with this many decimal places
+	uint8_t padding;
+	int32_t value;				// value in the first code
+};
+
+struct CodeBlockRecord
+{
+	uint16_t filePositionDelta;
+	uint8_t lineNumberDelta;
+	uint8_t padding;
+};
+
+constexpr size_t MaxCodeBlockDecimals = 6;
+constexpr size_t MaxCodesPerBlock = 254;		// so that blockIndex never reaches NotACodeBlock
+
+constexpr size_t CodeBlockRecordSize(size_t numParameters) noexcept
+{
+	return sizeof(CodeBlockRecord) + ((numParameters * sizeof(int16_t) + 3u) & ~3u);
+}
+
 struct CodeParameter
 {
 	char letter;
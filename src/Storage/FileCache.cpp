@@ -0,0 +1,255 @@
+/*
+ * FileCache.cpp
+ *
+ *  Created on: 19 Oct 2026
+ */
+
+#include "FileCache.h"
+
+#if HAS_MASS_STORAGE
+
+#include <Platform/Platform.h>
+#include <Platform/RepRap.h>
+#include <Platform/Tasks.h>
+
+FileCache::FileCache(const char *p_name) noexcept
+	: name(p_name), slots(nullptr), storage(nullptr), numSlots(0), slotSize(0), useClock(0), invalidateCount(0),
+	  hits(0), misses(0), loads(0), evictions(0), invalidations(0)
+{
+}
+
+void FileCache::Init() noexcept
+{
+	mutex.Create(name);
+}
+
+// Allocate the cache storage. We only allow this when no entries are in use, because we free the old storage.
+GCodeResult FileCache::Configure(size_t totalSize, size_t p_slotSize, const StringRef& reply) noexcept
+{
+	p_slotSize = (p_slotSize + 3u) & ~3u;								// keep each slot 4-byte aligned
+	const size_t newNumSlots = (p_slotSize == 0) ? 0 : totalSize/p_slotSize;
+
+	MutexLocker lock(mutex);
+	for (size_t i = 0; i < numSlots; ++i)
+	{
+		if (slots[i].useCount != 0)
+		{
+			reply.printf("%s cannot be reconfigured while files are open from it", name);
+			return GCodeResult::error;
+		}
+	}
+
+	delete[] slots;
+	delete[] storage;
+	Tasks::RecordRelease(MemoryTag::storage, numSlots * (slotSize + sizeof(Entry)));
+	slots = nullptr;
+	storage = nullptr;
+	numSlots = 0;
+	slotSize = 0;
+
+	if (newNumSlots != 0)
+	{
+		storage = new char[newNumSlots * p_slotSize];
+		slots = new Entry[newNumSlots];
+		for (size_t i = 0; i < newNumSlots; ++i)
+		{
+			slots[i].data = storage + i * p_slotSize;
+		}
+		numSlots = newNumSlots;
+		slotSize = p_slotSize;
+		Tasks::RecordAllocation(MemoryTag::storage, numSlots * (slotSize + sizeof(Entry)));
+	}
+	hits = misses = loads = evictions = invalidations = 0;
+	return GCodeResult::ok;
+}
+
+void FileCache::AppendConfiguration(const StringRef& reply) const noexcept
+{
+	MutexLocker lock(mutex);
+	if (numSlots == 0)
+	{
+		reply.catf("%s disabled", name);
+	}
+	else
+	{
+		reply.catf("%s has %u slots of %u bytes", name, numSlots, slotSize);
+	}
+}
+
+// Strip the volume specifier from a path if it refers to volume 0, because "0:/sys/foo.g" and "/sys/foo.g" are the same file
+/*static*/ const char *_ecv_array FileCache::SkipVolumeZero(const char *_ecv_array filePath) noexcept
+{
+	return (filePath[0] == '0' && filePath[1] == ':') ? filePath + 2 : filePath;
+}
+
+// Find the entry for a file, valid or not. Caller must own the mutex.
+FileCache::Entry *_ecv_null FileCache::FindEntry(const char *_ecv_array filePath) const noexcept
+{
+	filePath = SkipVolumeZero(filePath);
+	for (size_t i = 0; i < numSlots; ++i)
+	{
+		Entry& e = slots[i];
+		if (e.valid && StringEqualsIgnoreCase(e.path.c_str(), filePath))		// FAT filenames are not case sensitive
+		{
+			return &e;
+		}
+	}
+	return nullptr;
+}
+
+// Look up a file, returning the entry with its use count incremented if found.
+// We must own the mutex even to read numSlots, because Configure may be replacing the slots.
+FileCache::Entry *_ecv_null FileCache::Find(const char *_ecv_array filePath) noexcept
+{
+	MutexLocker lock(mutex);
+	if (numSlots == 0)
+	{
+		return nullptr;
+	}
+
+	Entry *const e = FindEntry(filePath);
+	if (e == nullptr)
+	{
+		++misses;
+	}
+	else
+	{
+		++hits;
+		++e->useCount;
+		e->lastUsed = ++useClock;
+	}
+	return e;
+}
+
+// Reserve the least recently used free slot for loading a file. The caller must copy the file data into the entry and then call FinishLoad.
+FileCache::Entry *_ecv_null FileCache::StartLoad(const char *_ecv_array filePath, size_t length) noexcept
+{
+	MutexLocker lock(mutex);
+	if (length > slotSize || strlen(filePath) > MaxFilenameLength)
+	{
+		return nullptr;
+	}
+
+	Entry *_ecv_null victim = nullptr;
+	for (size_t i = 0; i < numSlots; ++i)
+	{
+		Entry& e = slots[i];
+		if (e.useCount == 0)
+		{
+			if (!e.valid)
+			{
+				victim = &e;								// an empty slot is always the best choice
+				break;
+			}
+			if (victim == nullptr || (int32_t)(e.lastUsed - victim->lastUsed) < 0)
+			{
+				victim = &e;
+			}
+		}
+	}
+
+	if (victim != nullptr)
+	{
+		if (victim->valid)
+		{
+			++evictions;
+			victim->valid = false;
+		}
+		victim->path.copy(SkipVolumeZero(filePath));
+		victim->length = length;
+		victim->useCount = 1;
+		victim->invalidateCountWhenLoaded = invalidateCount;
+	}
+	return victim;
+}
+
+// Finish loading an entry. If the load failed or the file was written while we were loading it, release the entry and return false.
+bool FileCache::FinishLoad(Entry *entry, bool ok) noexcept
+{
+	MutexLocker lock(mutex);
+	if (ok && entry->invalidateCountWhenLoaded == invalidateCount)
+	{
+		entry->valid = true;
+		entry->lastUsed = ++useClock;
+		++loads;
+		return true;
+	}
+	--entry->useCount;
+	return false;
+}
+
+void FileCache::AddReference(Entry *entry) noexcept
+{
+	MutexLocker lock(mutex);
+	++entry->useCount;
+}
+
+void FileCache::Release(Entry *entry) noexcept
+{
+	MutexLocker lock(mutex);
+	if (entry->useCount != 0)
+	{
+		--entry->useCount;
+	}
+}
+
+// Invalidate the entry for a file that is being written, deleted or renamed.
+// Any files already open on that entry continue to read the old data, just as they would if the file had been replaced on the card.
+void FileCache::Invalidate(const char *_ecv_array filePath) noexcept
+{
+	MutexLocker lock(mutex);
+	if (numSlots != 0)
+	{
+		++invalidateCount;								// abandon any loads in progress, in case they are of this file
+		Entry *const e = FindEntry(filePath);
+		if (e != nullptr)
+		{
+			e->valid = false;
+			++invalidations;
+		}
+	}
+}
+
+// Invalidate all entries, e.g. when a directory has been renamed or deleted or a card has been unmounted
+void FileCache::InvalidateAll() noexcept
+{
+	MutexLocker lock(mutex);
+	if (numSlots != 0)
+	{
+		++invalidateCount;
+		for (size_t i = 0; i < numSlots; ++i)
+		{
+			if (slots[i].valid)
+			{
+				slots[i].valid = false;
+				++invalidations;
+			}
+		}
+	}
+}
+
+void FileCache::Diagnostics(MessageType mtype) noexcept
+{
+	size_t entriesUsed = 0, bytesUsed = 0, slotsConfigured;
+	{
+		MutexLocker lock(mutex);
+		slotsConfigured = numSlots;
+		for (size_t i = 0; i < numSlots; ++i)
+		{
+			if (slots[i].valid)
+			{
+				++entriesUsed;
+				bytesUsed += slots[i].length;
+			}
+		}
+	}
+	if (slotsConfigured != 0)
+	{
+		reprap.GetPlatform().MessageF(mtype, "%s: %u/%u entries, %u bytes, hits %" PRIu32 ", misses %" PRIu32 ", loads %" PRIu32 ", evictions %" PRIu32 ", invalidations %" PRIu32 "\n",
+										name, entriesUsed, slotsConfigured, bytesUsed, hits, misses, loads, evictions, invalidations);
+	}
+}
+
+#endif
+
+// End
@@ -0,0 +1,90 @@
+/*
+ * FileCache.h
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * A small LRU cache of whole files held in RAM. It is used to avoid reopening and rereading small files that are read frequently,
+ * for example the tool change, pause/resume and homing macros, and the small files that make up the web interface.
+ * For web files we cache the .gz version if there is one, because that is what HttpResponder sends.
+ * The cache is a single block of memory divided into a fixed number of equal-sized slots, so there is no heap fragmentation when entries are replaced.
+ * A file larger than the slot size is never cached.
+ */
+
+#ifndef SRC_STORAGE_FILECACHE_H_
+#define SRC_STORAGE_FILECACHE_H_
+
+#include <RepRapFirmware.h>
+
+#if HAS_MASS_STORAGE
+
+#include <RTOSIface/RTOSIface.h>
+#include <General/String.h>
+
+class FileCache
+{
+public:
+	class Entry
+	{
+	public:
+		friend class FileCache;
+
+		const char *_ecv_array Data() const noexcept { return data; }
+		size_t Length() const noexcept { return length; }
+		char *_ecv_array WritableData() noexcept { return data; }
+
+	private:
+		Entry() noexcept : data(nullptr), lastUsed(0), length(0), useCount(0), invalidateCountWhenLoaded(0), valid(false) { }
+
+		String<MaxFilenameLength> path;				// the path with any "0:" prefix removed
+		char *_ecv_array data;						// pointer to the slot storage
+		uint32_t lastUsed;							// the value of useClock when this entry was last used
+		uint32_t length;							// the number of bytes of file data
+		unsigned int useCount;						// the number of open files using this entry plus one if it is being loaded
+		unsigned int invalidateCountWhenLoaded;		// the value of invalidateCount when we started loading this entry
+		bool valid;									// true if the entry holds valid data for the file it names
+	};
+
+	explicit FileCache(const char *p_name) noexcept;
+
+	void Init() noexcept;
+	GCodeResult Configure(size_t totalSize, size_t slotSize, const StringRef& reply) noexcept;
+	void AppendConfiguration(const StringRef& reply) const noexcept;
+	bool IsEnabled() const noexcept { return numSlots != 0; }
+	size_t GetSlotSize() const noexcept { return slotSize; }
+	size_t GetTotalSize() const noexcept { return numSlots * slotSize; }
+
+	Entry *_ecv_null Find(const char *_ecv_array filePath) noexcept;					// look up a file, returning the entry with its use count incremented if found
+	Entry *_ecv_null StartLoad(const char *_ecv_array filePath, size_t length) noexcept;	// reserve an entry for loading a file, or return null if none is available
+	bool FinishLoad(Entry *entry, bool ok) noexcept;									// mark a loaded entry valid if loading succeeded and it has not been invalidated, releasing it if not
+	void AddReference(Entry *entry) noexcept;
+	void Release(Entry *entry) noexcept;
+
+	void Invalidate(const char *_ecv_array filePath) noexcept;
+	void InvalidateAll() noexcept;
+
+	void Diagnostics(MessageType mtype) noexcept;
+
+private:
+	static const char *_ecv_array SkipVolumeZero(const char *_ecv_array filePath) noexcept;
+	Entry *_ecv_null FindEntry(const char *_ecv_array filePath) const noexcept;
+
+	const char *name;
+	mutable Mutex mutex;
+	Entry *_ecv_array _ecv_null slots;
+	char *_ecv_array _ecv_null storage;
+	size_t numSlots;
+	size_t slotSize;
+	uint32_t useClock;
+	unsigned int invalidateCount;
+
+	// Statistics
+	uint32_t hits;
+	uint32_t misses;
+	uint32_t loads;
+	uint32_t evictions;
+	uint32_t invalidations;
+};
+
+#endif
+
+#endif /* SRC_STORAGE_FILECACHE_H_ */
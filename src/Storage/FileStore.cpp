@@ -44,7 +44,11 @@ void FileStore::Init() noexcept
 	handle = noFileHandle;
 	length = 0;
 #endif
-#if HAS_EMBEDDED_FILES || HAS_SBC_INTERFACE
+#if HAS_MASS_STORAGE
+	cache = nullptr;
+	cacheEntry = nullptr;
+#endif
+#if HAS_EMBEDDED_FILES || HAS_SBC_INTERFACE || HAS_MASS_STORAGE
 	offset = 0;
 #endif
 }
@@ -126,21 +130,40 @@ bool FileStore::Open(const char *_ecv_array filePath, OpenMode mode, uint32_t pr
 # endif
 # if HAS_MASS_STORAGE
 	{
-		const FRESULT openReturn = f_open(&file, filePath,
-											(mode == OpenMode::write || mode == OpenMode::writeWithCrc) ? FA_CREATE_ALWAYS | FA_WRITE
-												: (mode == OpenMode::append) ? FA_READ | FA_WRITE | FA_OPEN_ALWAYS | FA_OPEN_APPEND
-													: FA_OPEN_EXISTING | FA_READ);
-		if (openReturn == FR_OK)
+		// Small macro and web files that are read frequently may be held in a file cache
+		cache = (mode == OpenMode::read) ? MassStorage::GetCacheFor(filePath) : nullptr;
+		if (cache != nullptr)
 		{
-			fileOpened = true;
+			cacheEntry = cache->Find(filePath);
+			if (cacheEntry != nullptr)
+			{
+				offset = 0;
+				fileOpened = true;
+			}
 		}
-		else
+
+		if (!fileOpened)
 		{
-			// We no longer report an error if opening a file in read mode fails unless debugging is enabled, because sometimes that is quite normal.
-			// It is up to the caller to report an error if necessary.
-			if (reprap.Debug(Module::Storage))
+			const FRESULT openReturn = f_open(&file, filePath,
+												(mode == OpenMode::write || mode == OpenMode::writeWithCrc) ? FA_CREATE_ALWAYS | FA_WRITE
+													: (mode == OpenMode::append) ? FA_READ | FA_WRITE | FA_OPEN_ALWAYS | FA_OPEN_APPEND
+														: FA_OPEN_EXISTING | FA_READ);
+			if (openReturn == FR_OK)
 			{
-				reprap.GetPlatform().MessageF(WarningMessage, "Failed to open %s to %s, error code %d\n", filePath, (writing) ? "write" : "read", (int)openReturn);
+				fileOpened = true;
+				if (cache != nullptr)
+				{
+					TryLoadIntoCache(filePath);
+				}
+			}
+			else
+			{
+				// We no longer report an error if opening a file in read mode fails unless debugging is enabled, because sometimes that is quite normal.
+				// It is up to the caller to report an error if necessary.
+				if (reprap.Debug(Module::Storage))
+				{
+					reprap.GetPlatform().MessageF(WarningMessage, "Failed to open %s to %s, error code %d\n", filePath, (writing) ? "write" : "read", (int)openReturn);
+				}
 			}
 		}
 	}
@@ -264,6 +287,11 @@ bool FileStore::Seek(FilePosition pos) noexcept
 		}
 #endif
 #if HAS_MASS_STORAGE
+		if (cacheEntry != nullptr)
+		{
+			offset = min<FilePosition>(pos, cacheEntry->Length());
+			return true;
+		}
 		return f_lseek(&file, pos) == FR_OK;
 #elif HAS_EMBEDDED_FILES
 		offset = min<FilePosition>(pos, EmbeddedFiles::Length(fileIndex));
@@ -287,7 +315,9 @@ FilePosition FileStore::Position() const noexcept
 	}
 #endif
 #if HAS_MASS_STORAGE
-	return (usageMode == FileUseMode::readOnly || usageMode == FileUseMode::readWrite) ? file.fptr : 0;
+	return (usageMode == FileUseMode::readOnly || usageMode == FileUseMode::readWrite)
+			? ((cacheEntry != nullptr) ? offset : file.fptr)
+				: 0;
 #elif HAS_EMBEDDED_FILES
 	return offset;
 #else
@@ -311,7 +341,7 @@ FilePosition FileStore::Length() const noexcept
 		}
 #endif
 #if HAS_MASS_STORAGE
-		return f_size(&file);
+		return (cacheEntry != nullptr) ? cacheEntry->Length() : f_size(&file);
 #elif HAS_EMBEDDED_FILES
 		return EmbeddedFiles::Length(fileIndex);
 #else
@@ -402,6 +432,13 @@ int FileStore::Read(char *_ecv_array extBuf, size_t nBytes) noexcept
 		}
 #endif
 #if HAS_MASS_STORAGE
+		if (cacheEntry != nullptr)
+		{
+			const size_t bytesToCopy = min<size_t>(nBytes, cacheEntry->Length() - offset);
+			memcpy(extBuf, cacheEntry->Data() + offset, bytesToCopy);
+			offset += bytesToCopy;
+			return (int)bytesToCopy;
+		}
 		{
 			UINT bytes_read;
 			const FRESULT readStatus = f_read(&file, extBuf, nBytes, &bytes_read);
@@ -494,7 +531,16 @@ bool FileStore::ForceClose() noexcept
 #endif
 
 #if HAS_MASS_STORAGE
-	const FRESULT fr = f_close(&file);
+	FRESULT fr = FR_OK;
+	if (cacheEntry != nullptr)
+	{
+		cache->Release(cacheEntry);
+		cacheEntry = nullptr;
+	}
+	else
+	{
+		fr = f_close(&file);
+	}
 	usageMode = FileUseMode::free;
 	closeRequested = false;
 	openCount = 0;
@@ -584,6 +630,24 @@ bool FileStore::Write(const char *_ecv_array b) noexcept
 	return Write(b, strlen(b));
 }
 
+// Return true if a block of this length should be written directly instead of being copied through the write buffer first.
+// We write large blocks directly if the write buffer is empty, so that the card driver can use a multi-block write without copying the data first.
+// Called only when we have a write buffer.
+bool FileStore::ShouldWriteDirectly(size_t len) const noexcept
+{
+#if HAS_MASS_STORAGE
+# if HAS_SBC_INTERFACE
+	if (reprap.UsingSbcInterface())
+	{
+		return false;
+	}
+# endif
+	return writeBuffer->BytesStored() == 0 && len >= writeBuffer->BytesLeft();
+#else
+	return false;
+#endif
+}
+
 bool FileStore::Write(const char *_ecv_array s, size_t len) noexcept
 {
 	switch (usageMode)
@@ -597,7 +661,7 @@ bool FileStore::Write(const char *_ecv_array s, size_t len) noexcept
 		{
 			size_t totalBytesWritten = 0;
 			bool writeOk = true;
-			if (writeBuffer == nullptr)
+			if (writeBuffer == nullptr || ShouldWriteDirectly(len))
 			{
 				writeOk = Store(s, len, &totalBytesWritten);
 			}
@@ -696,10 +760,18 @@ bool FileStore::Flush() noexcept
 #if HAS_SBC_INTERFACE			// these functions are only supported in SBC mode
 
 // Invalidate the file. Don't free the write buffer because another task may be using it.
+// Closing an invalidated file doesn't release a file cache entry, so release it here the way Close() does.
 void FileStore::Invalidate() noexcept
 {
 	usageMode = FileUseMode::invalidated;
 	handle = noFileHandle;
+#if HAS_MASS_STORAGE
+	if (cacheEntry != nullptr)
+	{
+		cache->Release(cacheEntry);
+		cacheEntry = nullptr;
+	}
+#endif
 }
 
 #endif
@@ -709,7 +781,7 @@ void FileStore::Invalidate() noexcept
 // Invalidate the file if it uses the specified FATFS object
 bool FileStore::Invalidate(const FATFS *fs) noexcept
 {
-	if (file.obj.fs == fs)
+	if (cacheEntry == nullptr && file.obj.fs == fs)		// files being read from the cache don't depend on the file system
 	{
 		usageMode = FileUseMode::invalidated;
 		return true;
@@ -720,18 +792,54 @@ bool FileStore::Invalidate(const FATFS *fs) noexcept
 // Return true if the file is open on the specified file system
 bool FileStore::IsOpenOn(const FATFS *fs) const noexcept
 {
-	return openCount != 0 && file.obj.fs == fs;
+	return openCount != 0 && cacheEntry == nullptr && file.obj.fs == fs;
 }
 
 // Return true if the passed file is the same as ours
 bool FileStore::IsSameFile(const FIL& otherFile) const noexcept
 {
-	return file.obj.fs == otherFile.obj.fs && file.dir_sect == otherFile.dir_sect && file.dir_ptr == otherFile.dir_ptr;
+	return cacheEntry == nullptr && file.obj.fs == otherFile.obj.fs && file.dir_sect == otherFile.dir_sect && file.dir_ptr == otherFile.dir_ptr;
+}
+
+// If the file is being read from a file cache then return a pointer to the unread data and set 'length' to the amount of it, else return nullptr.
+// The data remains valid until the file is closed.
+const char *_ecv_array _ecv_null FileStore::GetCachedData(size_t& length) const noexcept
+{
+	if (cacheEntry == nullptr || (usageMode != FileUseMode::readOnly && usageMode != FileUseMode::readWrite))
+	{
+		return nullptr;
+	}
+	length = cacheEntry->Length() - offset;
+	return cacheEntry->Data() + offset;
 }
 
 uint32_t FileStore::ClusterSize() const noexcept
 {
-	return (usageMode == FileUseMode::readOnly || usageMode == FileUseMode::readWrite) ? file.obj.fs->csize * 512u : 1;	// we divide by the cluster size so return 1 not 0 if there is an error
+	return (usageMode != FileUseMode::readOnly && usageMode != FileUseMode::readWrite) ? 1		// we divide by the cluster size so return 1 not 0 if there is an error
+			: (cacheEntry != nullptr) ? 512u
+				: file.obj.fs->csize * 512u;
+}
+
+// Try to copy a file we have just opened for reading into the file cache.
+// If successful then we close the underlying file and read from the cache entry instead.
+void FileStore::TryLoadIntoCache(const char *_ecv_array filePath) noexcept
+{
+	FileCache::Entry *_ecv_null const entry = cache->StartLoad(filePath, f_size(&file));
+	if (entry != nullptr)
+	{
+		UINT bytesRead;
+		const bool ok = f_read(&file, entry->WritableData(), entry->Length(), &bytesRead) == FR_OK && bytesRead == entry->Length();
+		if (cache->FinishLoad(entry, ok))
+		{
+			(void)f_close(&file);
+			cacheEntry = entry;
+			offset = 0;
+		}
+		else
+		{
+			(void)f_lseek(&file, 0);
+		}
+	}
 }
 
 
@@ -784,6 +892,13 @@ void FileStore::CopyFrom(const FileStore *f) noexcept
 	fileIndex = f->fileIndex;
 #else
 	file = f->file;
+	cache = f->cache;
+	cacheEntry = f->cacheEntry;
+	offset = f->offset;
+	if (cacheEntry != nullptr)
+	{
+		cache->AddReference(cacheEntry);
+	}
 	writeBuffer = nullptr;
 	crc.Reset();
 	calcCrc = false;
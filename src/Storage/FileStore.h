@@ -10,6 +10,9 @@
 #if HAS_MASS_STORAGE || HAS_SBC_INTERFACE
 # include "CRC32.h"
 #endif
+#if HAS_MASS_STORAGE
+# include "FileCache.h"
+#endif
 
 class Platform;
 class FileWriteBuffer;
@@ -84,6 +87,7 @@ public:
 	bool Invalidate(const FATFS *fs) noexcept;					// Invalidate the file if it uses the specified FATFS object
 	bool IsOpenOn(const FATFS *fs) const noexcept;				// Return true if the file is open on the specified file system
 	bool IsSameFile(const FIL& otherFile) const noexcept;		// Return true if the passed file is the same as ours
+	const char *_ecv_array _ecv_null GetCachedData(size_t& length) const noexcept;	// If the file is being read from a file cache, return the unread data
 # if 0	// not currently used
 	bool SetClusterMap(uint32_t[]) noexcept;					// Provide a cluster map for fast seeking
 # endif
@@ -96,6 +100,10 @@ public:
 private:
 	void Init() noexcept;
 	bool Store(const char *_ecv_array s, size_t len, size_t *bytesWritten) noexcept;	// Write data to the non-volatile storage
+	bool ShouldWriteDirectly(size_t len) const noexcept;								// Return true if a block of this length should bypass the write buffer
+#if HAS_MASS_STORAGE
+	void TryLoadIntoCache(const char *_ecv_array filePath) noexcept;					// Copy a file we just opened for reading into the file cache
+#endif
 
 	volatile unsigned int openCount;
 
@@ -106,6 +114,8 @@ private:
 
 #if HAS_MASS_STORAGE
     FIL file;
+	FileCache *_ecv_null cache;									// the cache that this file may be held in
+	FileCache::Entry *_ecv_null cacheEntry;						// if not null then the file is being read from this cache entry instead of from 'file'
 	static uint32_t longestWriteTime;
 #endif
 
@@ -118,7 +128,7 @@ private:
 	FileIndex fileIndex;
 #endif
 
-#if HAS_EMBEDDED_FILES || HAS_SBC_INTERFACE
+#if HAS_EMBEDDED_FILES || HAS_SBC_INTERFACE || HAS_MASS_STORAGE
 	FilePosition offset;
 #endif
 
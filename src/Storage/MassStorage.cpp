@@ -2,6 +2,7 @@
 #include <Platform/Platform.h>
 #include <Platform/RepRap.h>
 #include <ObjectModel/ObjectModel.h>
+#include <Platform/Tasks.h>
 
 #if HAS_MASS_STORAGE
 # include <Libraries/Fatfs/diskio.h>
@@ -19,7 +20,7 @@ static_assert(SD_MMC_MEM_CNT == NumSdCards);
 # include <SBC/SbcInterface.h>
 #endif
 
-#ifdef DUET3_MB6HC
+#if HAS_MASS_STORAGE
 # include <GCodes/GCodeBuffer/GCodeBuffer.h>
 #endif
 
@@ -134,6 +135,22 @@ DEFINE_GET_OBJECT_MODEL_TABLE(SdCardInfo)
 
 static SdCardInfo info[NumSdCards];
 static DIR findDir;
+static FileCache macroCache("Macro cache");
+static FileCache webFileCache("Web file cache");
+static bool webCacheConfigured = false;					// true if M473 has been used to configure the web file cache
+
+// Invalidate a file in whichever cache it may be held in
+static void InvalidateCachedFile(const char *_ecv_array filePath) noexcept
+{
+	macroCache.Invalidate(filePath);
+	webFileCache.Invalidate(filePath);
+}
+
+static void InvalidateAllCachedFiles() noexcept
+{
+	macroCache.InvalidateAll();
+	webFileCache.InvalidateAll();
+}
 #endif
 
 #if HAS_MASS_STORAGE || HAS_EMBEDDED_FILES
@@ -264,6 +281,7 @@ static unsigned int InternalUnmount(size_t card) noexcept
 	MutexLocker lock1(fsMutex);
 	MutexLocker lock2(inf.volMutex);
 	const unsigned int invalidated = MassStorage::InvalidateFiles(&inf.fileSystem);
+	InvalidateAllCachedFiles();
 	const char path[3] = { (char)('0' + card), ':', 0 };
 	f_mount(nullptr, path, 0);
 	inf.Clear(card);
@@ -353,6 +371,7 @@ void MassStorage::Init() noexcept
 		freeWriteBuffers = new FileWriteBuffer(freeWriteBuffers);
 #  endif
 	}
+	Tasks::RecordAllocation(MemoryTag::storage, NumFileWriteBuffers * sizeof(FileWriteBuffer));
 # endif
 
 # if HAS_MASS_STORAGE
@@ -370,6 +389,8 @@ void MassStorage::Init() noexcept
 		inf.cardState = (inf.cdPin == NoPin) ? CardDetectState::present : CardDetectState::notPresent;
 		inf.volMutex.Create(VolMutexNames[card]);
 	}
+	macroCache.Init();
+	webFileCache.Init();
 
 	sd_mmc_init(SdWriteProtectPins, SdSpiCSPins);		// initialize SD MMC stack
 
@@ -463,9 +484,13 @@ FileStore* MassStorage::OpenFile(const char* filePath, OpenMode mode, uint32_t p
 			{
 				FileStore * const ret = (fs.Open(filePath, mode, preAllocSize)) ? &fs: nullptr;
 # if HAS_MASS_STORAGE
-				if (ret != nullptr && (mode == OpenMode::write || mode == OpenMode::writeWithCrc))
+				if (ret != nullptr && mode != OpenMode::read)
 				{
-					(void)VolumeUpdated(filePath);
+					InvalidateCachedFile(filePath);
+					if (mode != OpenMode::append)
+					{
+						(void)VolumeUpdated(filePath);
+					}
 				}
 # endif
 				return ret;
@@ -772,6 +797,7 @@ bool MassStorage::Delete(const StringRef& filePath, ErrorMessageMode errorMessag
 		DIR dir;
 		if (f_opendir(&dir, filePath.c_str()) == FR_OK)
 		{
+			InvalidateAllCachedFiles();							// we don't keep track of which directories cached files are in
 			const bool ok = DeleteContents(dir, filePath, errorMessageMode);
 			f_closedir(&dir);
 			if (!ok)
@@ -785,6 +811,7 @@ bool MassStorage::Delete(const StringRef& filePath, ErrorMessageMode errorMessag
 	const bool ok = InternalDelete(filePath.c_str(), errorMessageMode);
 	if (ok)
 	{
+		InvalidateCachedFile(filePath.c_str());
 		(void)VolumeUpdated(filePath.c_str());
 	}
 	return ok;
@@ -1006,6 +1033,16 @@ bool MassStorage::Rename(const char *oldFilename, const char *newFilename, bool
 		return false;
 	}
 
+	if (FileExists(newFilename))
+	{
+		InvalidateCachedFile(oldFilename);
+		InvalidateCachedFile(newFilename);
+	}
+	else
+	{
+		InvalidateAllCachedFiles();							// we renamed a directory, so any cached file within it now has a different path
+	}
+
 	if (!VolumeUpdated(oldFilename))				// only update the sequence number once
 	{
 		(void)VolumeUpdated(newFilename);
@@ -1049,6 +1086,19 @@ time_t MassStorage::GetLastModifiedTime(const char *filePath) noexcept
 	return 0;
 }
 
+// Get the size and last modified time of a file without opening it, returning true if successful
+bool MassStorage::GetFileSizeAndTime(const char *filePath, uint32_t& size, time_t& lastModified) noexcept
+{
+	FILINFO fil;
+	if (f_stat(filePath, &fil) == FR_OK && (fil.fattrib & AM_DIR) == 0)
+	{
+		size = fil.fsize;
+		lastModified = ConvertTimeStamp(fil.fdate, fil.ftime);
+		return true;
+	}
+	return false;
+}
+
 bool MassStorage::SetLastModifiedTime(const char *filePath, time_t time) noexcept
 {
 	tm timeInfo;
@@ -1186,6 +1236,7 @@ GCodeResult MassStorage::Mount(size_t card, const StringRef& reply, bool reportS
 	}
 
 	inf.isMounted = true;
+	InvalidateAllCachedFiles();
 	reprap.VolumesUpdated();
 	if (reportSuccess)
 	{
@@ -1283,6 +1334,8 @@ void MassStorage::Diagnostics(MessageType mtype) noexcept
 	// Show the longest SD card write time
 	platform.MessageF(mtype, "SD card longest read time %.1fms, write time %.1fms, max retries %u\n",
 								(double)DiskioGetAndClearLongestReadTime(), (double)DiskioGetAndClearLongestWriteTime(), DiskioGetAndClearMaxRetryCount());
+	macroCache.Diagnostics(mtype);
+	webFileCache.Diagnostics(mtype);
 # endif
 }
 
@@ -1383,6 +1436,73 @@ Mutex& MassStorage::GetVolumeMutex(size_t vol) noexcept
 	return info[vol].volMutex;
 }
 
+// Return the cache that a file may be held in, or nullptr if it may not be cached.
+// We cache macro files because they are read repeatedly, and small web files because clients fetch them whenever they load the web interface.
+FileCache *_ecv_null MassStorage::GetCacheFor(const char *_ecv_array filePath) noexcept
+{
+	if (StringEndsWithIgnoreCase(filePath, ".g"))
+	{
+		return (macroCache.IsEnabled()) ? &macroCache : nullptr;
+	}
+	if (StringStartsWithIgnoreCase(filePath, WEB_DIR))
+	{
+		return (webFileCache.IsEnabled()) ? &webFileCache : nullptr;
+	}
+	return nullptr;
+}
+
+// Configure a file cache. The P parameter selects the cache (0 = macro files, 1 = web files).
+// The S parameter is the total amount of memory to use and the L parameter is the maximum size of file that can be cached.
+// If the total memory is not a multiple of the maximum file size then the remainder is not used.
+GCodeResult MassStorage::ConfigureFileCache(GCodeBuffer& gb, const StringRef& reply) THROWS(GCodeException)
+{
+	bool seenCacheNumber = false;
+	uint32_t cacheNumber = 0;
+	gb.TryGetLimitedUIValue('P', cacheNumber, seenCacheNumber, 2);
+	FileCache& cache = (cacheNumber == 1) ? webFileCache : macroCache;
+	const size_t defaultFileSize = (cacheNumber == 1) ? DefaultWebCacheFileSize : DefaultMacroCacheFileSize;
+	const size_t maxSize = (cacheNumber == 1) ? MaxWebCacheSize : MaxMacroCacheSize;
+
+	bool seen = false;
+	uint32_t totalSize = cache.GetTotalSize();
+	uint32_t slotSize = (cache.IsEnabled()) ? cache.GetSlotSize() : defaultFileSize;
+	gb.TryGetLimitedUIValue('S', totalSize, seen, maxSize + 1);
+	gb.TryGetLimitedUIValue('L', slotSize, seen, maxSize + 1);
+	if (seen)
+	{
+		if (cacheNumber == 1)
+		{
+			webCacheConfigured = true;
+		}
+		return cache.Configure(totalSize, slotSize, reply);
+	}
+
+	cache.AppendConfiguration(reply);
+	if (!seenCacheNumber)
+	{
+		reply.cat(", ");
+		webFileCache.AppendConfiguration(reply);
+	}
+	return GCodeResult::ok;
+}
+
+// If the web file cache was not configured by M473 in config.g, give it a share of the RAM that has never been used.
+// This is only worthwhile on processors with plenty of RAM.
+void MassStorage::AutoConfigureWebFileCache() noexcept
+{
+#if SAME70
+	if (!webCacheConfigured)
+	{
+		const ptrdiff_t spareRam = Tasks::GetNeverUsedRam();
+		if (spareRam > (ptrdiff_t)(2 * MinSpareRamForWebCache))
+		{
+			String<StringLength50> reply;
+			(void)webFileCache.Configure(min<size_t>((spareRam - MinSpareRamForWebCache)/2, MaxWebCacheSize), DefaultWebCacheFileSize, reply.GetRef());
+		}
+	}
+#endif
+}
+
 # if SUPPORT_OBJECT_MODEL
 
 const ObjectModel * MassStorage::GetVolume(size_t vol) noexcept
@@ -6,6 +6,7 @@
 #include <Libraries/Fatfs/ff.h>
 #include "FileStore.h"
 #include "FileInfoParser.h"
+#include "FileCache.h"
 #include <RTOSIface/RTOSIface.h>
 
 #include <ctime>
@@ -98,6 +99,7 @@ namespace MassStorage
 	bool MakeDirectory(const char *_ecv_array directory, bool messageIfFailed) noexcept;
 	bool Rename(const char *_ecv_array oldFilePath, const char *_ecv_array newFilePath, bool deleteExisting, bool messageIfFailed) noexcept;
 	time_t GetLastModifiedTime(const char *_ecv_array filePath) noexcept;
+	bool GetFileSizeAndTime(const char *_ecv_array filePath, uint32_t& size, time_t& lastModified) noexcept;	// Get the size and last modified time of a file without opening it
 	bool SetLastModifiedTime(const char *_ecv_array file, time_t t) noexcept;
 	bool CheckDriveMounted(const char* path) noexcept;
 	bool IsCardDetected(size_t card) noexcept;
@@ -125,6 +127,10 @@ namespace MassStorage
 
 	InfoResult GetCardInfo(size_t slot, SdCardReturnedInfo& returnedInfo) noexcept;
 
+	FileCache *_ecv_null GetCacheFor(const char *_ecv_array filePath) noexcept;			// Return the cache that the file may be held in, or nullptr
+	GCodeResult ConfigureFileCache(GCodeBuffer& gb, const StringRef& reply) THROWS(GCodeException);		// Configure a file cache
+	void AutoConfigureWebFileCache() noexcept;												// Size the web file cache from spare RAM if M473 didn't configure it
+
 # ifdef DUET3_MB6HC
 	GCodeResult ConfigureSdCard(GCodeBuffer& gb, const StringRef& reply) THROWS(GCodeException);		// Configure additional SD card slots
 # endif
@@ -417,6 +417,21 @@ uint16_t Tool::numToolsToReport = 0;
 	return false;
 }
 
+// Return the fans that are mapped to any of the tools that use the specified heater
+/*static*/ FansBitmap Tool::GetFansCoolingHeater(int8_t heater) noexcept
+{
+	FansBitmap fans;
+	ReadLocker lock(toolListLock);
+	for (const Tool *tool = toolList; tool != nullptr; tool = tool->Next())
+	{
+		if (tool->UsesHeater(heater))
+		{
+			fans |= tool->fanMapping;
+		}
+	}
+	return fans;
+}
+
 /*static*/ GCodeResult Tool::SetAllToolsFirmwareRetraction(GCodeBuffer& gb, const StringRef& reply, OutputBuffer*& outBuf) THROWS(GCodeException)
 {
 	GCodeResult rslt = GCodeResult::ok;
@@ -932,6 +947,19 @@ void Tool::ApplyFeedForward(float extrusionSpeed) const noexcept
 	}
 }
 
+// Get the feedforward coefficient for the specified heater in PWM per mm/sec of extrusion, or 0 if this tool doesn't use that heater
+float Tool::GetHeaterFeedForward(int heater) const noexcept
+{
+	for (size_t i = 0; i < heaterCount; ++i)
+	{
+		if (heaters[i] == heater)
+		{
+			return heaterFeedForward[i];
+		}
+	}
+	return 0.0;
+}
+
 // Stop applying feedforward to the current tool. Called from an ISR context or with BASEPRI set high.
 void Tool::StopFeedForward() const noexcept
 {
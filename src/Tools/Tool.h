@@ -82,6 +82,7 @@ public:
 	static bool ExtruderMovementAllowed(const Tool *tool, bool extruding, unsigned int extruder) noexcept;
 	static bool DisplayColdExtrusionWarnings() noexcept;
 	static bool IsHeaterAssignedToTool(int8_t heater) noexcept;
+	static FansBitmap GetFansCoolingHeater(int8_t heater) noexcept;
 	static GCodeResult SetAllToolsFirmwareRetraction(GCodeBuffer& gb, const StringRef& reply, OutputBuffer*& outBuf) THROWS(GCodeException);
 
 	float GetOffset(size_t axis) const noexcept pre(axis < MaxAxes);
@@ -140,6 +141,7 @@ public:
 	void HeatersToActiveOrStandby(bool active) const noexcept;
 
 	void ApplyFeedForward(float extrusionSpeed) const noexcept;
+	float GetHeaterFeedForward(int heater) const noexcept;
 	void StopFeedForward() const noexcept;
 
 	void Activate() noexcept;